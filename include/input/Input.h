@@ -803,6 +803,14 @@ public:
 
     float getHistoricalAxisValue(int32_t axis, size_t pointerIndex, size_t historicalIndex) const;
 
+    /**
+     * Writes the value of the axis for the pointer in every sample of the event, from the oldest
+     * historical sample to the current one. Same as calling getHistoricalAxisValue for each
+     * sample, but looks up the pointer and the transform only once.
+     * outValues must have room for getHistorySize() + 1 values.
+     */
+    void getAxisValueHistory(int32_t axis, size_t pointerIndex, float* outValues) const;
+
     inline float getHistoricalX(size_t pointerIndex, size_t historicalIndex) const {
         return getHistoricalAxisValue(
                 AMOTION_EVENT_AXIS_X, pointerIndex, historicalIndex);
@@ -869,6 +877,9 @@ public:
             nsecs_t eventTime,
             const PointerCoords* pointerCoords);
 
+    // Makes room for the given number of samples to be added without reallocating.
+    void reserveSamples(size_t sampleCount);
+
     void offsetLocation(float xOffset, float yOffset);
 
     void scale(float globalScaleFactor);
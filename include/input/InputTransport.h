@@ -226,21 +226,35 @@ struct InputMessage {
     void getSanitizedCopy(InputMessage* msg) const;
 };
 
+class InputChannelRing;
+
 /*
  * An input channel consists of a local unix domain socket used to send and receive
  * input messages across processes.  Each channel has a descriptive name for debugging purposes.
  *
  * Each endpoint has its own InputChannel object that specifies its file descriptor.
  *
+ * Optionally, the messages from the server to the client go through a ring buffer in shared
+ * memory instead. The server end writes to the ring and the client end reads from it. The socket
+ * then only carries a doorbell from the server, which wakes up the client when the ring stops
+ * being empty, and the messages from the client to the server.
+ *
  * The input channel is closed when all references to it are released.
  */
 class InputChannel : public Parcelable {
 public:
+    enum class Transport {
+        // Every message is sent through the socket.
+        SOCKET,
+        // Messages from the server to the client are written to a shared memory ring.
+        SHARED_MEMORY_RING,
+    };
+
     static std::unique_ptr<InputChannel> create(const std::string& name,
                                                 android::base::unique_fd fd, sp<IBinder> token);
     InputChannel() = default;
     InputChannel(const InputChannel& other)
-          : mName(other.mName), mFd(other.dupFd()), mToken(other.mToken){};
+          : mName(other.mName), mFd(other.dupFd()), mToken(other.mToken), mRing(other.mRing){};
     InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token);
     ~InputChannel() override;
     /**
@@ -254,9 +268,18 @@ public:
                                          std::unique_ptr<InputChannel>& outServerChannel,
                                          std::unique_ptr<InputChannel>& outClientChannel);
 
+    /**
+     * Create a pair of input channels using the given transport. The version above uses a shared
+     * memory ring when the input_channel_shared_memory_ring flag is enabled.
+     */
+    static status_t openInputChannelPair(const std::string& name, Transport transport,
+                                         std::unique_ptr<InputChannel>& outServerChannel,
+                                         std::unique_ptr<InputChannel>& outClientChannel);
+
     inline std::string getName() const { return mName; }
     inline const android::base::unique_fd& getFd() const { return mFd; }
     inline sp<IBinder> getToken() const { return mToken; }
+    Transport getTransport() const;
 
     /* Send a message to the other endpoint.
      *
@@ -276,6 +299,10 @@ public:
      * If there is no message present, try again after poll() indicates that the fd
      * is readable.
      *
+     * When the messages come from a shared memory ring, the fd stays readable until the ring has
+     * been drained, but messages that raced with draining it may not make it readable again. Keep
+     * receiving until this returns WOULD_BLOCK before waiting for the fd.
+     *
      * Return OK on success.
      * Return WOULD_BLOCK if there is no message present.
      * Return DEAD_OBJECT if the channel's peer has been closed.
@@ -321,10 +348,18 @@ public:
 private:
     base::unique_fd dupFd() const;
 
+    status_t sendSocketMessage(const InputMessage* msg, size_t msgLength);
+    status_t receiveSocketMessage(InputMessage* msg);
+    status_t sendRingMessage(const InputMessage* msg, size_t msgLength);
+    status_t receiveRingMessage(InputMessage* msg);
+
     std::string mName;
     base::unique_fd mFd;
 
     sp<IBinder> mToken;
+
+    // Set with Transport::SHARED_MEMORY_RING. Shared by copies of this channel.
+    std::shared_ptr<InputChannelRing> mRing;
 };
 
 /*
@@ -482,6 +517,10 @@ public:
      *
      * The returned sequence number is never 0 unless the operation failed.
      *
+     * Keep calling this until it returns WOULD_BLOCK before waiting for the channel's fd to become
+     * readable again. With a shared memory ring, some messages may be pending without the fd being
+     * readable; see InputChannel::receiveMessage.
+     *
      * Returns OK on success.
      * Returns WOULD_BLOCK if there is no event present.
      * Returns DEAD_OBJECT if the channel's peer has been closed.
@@ -175,6 +175,12 @@ protected:
     // protected const field.
     static constexpr uint32_t HISTORY_SIZE = 20;
 
+    // Called for each movement that enters or leaves the history of a pointer, for strategies
+    // that keep state derived from the history up to date as it changes. Not called when the
+    // whole history of a pointer is cleared.
+    virtual void onMovementAdded(int32_t /*pointerId*/, const Movement& /*movement*/) {}
+    virtual void onMovementRemoved(int32_t /*pointerId*/, const Movement& /*movement*/) {}
+
     /**
      * Duration, in nanoseconds, since the latest movement where a movement may be considered for
      * velocity calculation.
@@ -212,25 +218,56 @@ public:
     LeastSquaresVelocityTrackerStrategy(uint32_t degree, Weighting weighting = Weighting::NONE);
     ~LeastSquaresVelocityTrackerStrategy() override;
 
+    void addMovement(nsecs_t eventTime, int32_t pointerId, float position) override;
+    void clearPointer(int32_t pointerId) override;
     std::optional<float> getVelocity(int32_t pointerId) const override;
 
+protected:
+    void onMovementAdded(int32_t pointerId, const Movement& movement) override;
+    void onMovementRemoved(int32_t pointerId, const Movement& movement) override;
+
 private:
     // Sample horizon.
     // We don't use too much history by default since we want to react to quick
     // changes in direction.
     static const nsecs_t HORIZON = 100 * 1000000; // 100 ms
 
+    // How far the latest movement may get from the origin of the running sums before they are
+    // recomputed from the history, to keep the powers of time small enough for subtracting the
+    // movements that leave the history to be accurate.
+    static constexpr nsecs_t REBASE_INTERVAL = 2 * HORIZON;
+
+    /**
+     * Sums over the history of a pointer for the unweighted second-order fit, kept up to date as
+     * movements are added and removed, so that computing the velocity doesn't have to go through
+     * the whole history. x is the time of a movement since `origin` in seconds, and y its
+     * position.
+     */
+    struct RunningSums {
+        nsecs_t origin = 0;
+        size_t count = 0;
+        double sx = 0, sx2 = 0, sx3 = 0, sx4 = 0, sy = 0, sxy = 0, sx2y = 0;
+
+        void add(const Movement& movement, double sign);
+    };
+
+    // Whether the velocity may be computed by `solveUnweightedLeastSquaresDeg2`, and so the
+    // running sums have to be kept.
+    bool usesRunningSums() const;
+    void rebuildRunningSums(int32_t pointerId);
+
     float chooseWeight(int32_t pointerId, uint32_t index) const;
     /**
      * An optimized least-squares solver for degree 2 and no weight (i.e. `Weighting.NONE`).
      * The provided container of movements shall NOT be empty, and shall have the movements in
      * chronological order.
      */
-    std::optional<float> solveUnweightedLeastSquaresDeg2(
-            const RingBuffer<Movement>& movements) const;
+    std::optional<float> solveUnweightedLeastSquaresDeg2(const RunningSums& sums,
+                                                         nsecs_t latestEventTime) const;
 
     const uint32_t mDegree;
     const Weighting mWeighting;
+    std::map<int32_t /*pointerId*/, RunningSums> mRunningSums;
 };
 
 /*
@@ -21,6 +21,7 @@
 #include <binder/Binder.h>
 #include <binder/BpBinder.h>
 #include <binder/TextOutput.h>
+#include <binder/TransactionStats.h>
 
 #include <cutils/sched_policy.h>
 #include <utils/CallStack.h>
@@ -815,6 +816,9 @@ status_t IPCThreadState::transact(int32_t handle,
 
     flags |= TF_ACCEPT_FDS;
 
+    const bool recordStats = binder::debug::TransactionStats::isEnabled();
+    const nsecs_t startTime = recordStats ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+
     IF_LOG_TRANSACTIONS() {
         std::ostringstream logStream;
         logStream << "BC_TRANSACTION thr " << (void*)pthread_self() << " / hand " << handle
@@ -879,6 +883,8 @@ status_t IPCThreadState::transact(int32_t handle,
         err = waitForResponse(nullptr, nullptr);
     }
 
+    if (recordStats) recordTransactionStats(false /*incoming*/, code, data, startTime);
+
     return err;
 }
 
@@ -1415,6 +1421,8 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 std::string message = logStream.str();
                 ALOGI("%s", message.c_str());
             }
+            const bool recordStats = binder::debug::TransactionStats::isEnabled();
+            const nsecs_t startTime = recordStats ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
             if (tr.target.ptr) {
                 // We only have a weak reference on the target object, so we must first try to
                 // safely acquire a strong reference before doing anything else with it.
@@ -1430,6 +1438,7 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
             } else {
                 error = the_context_object->transact(tr.code, buffer, &reply, tr.flags);
             }
+            if (recordStats) recordTransactionStats(true /*incoming*/, tr.code, buffer, startTime);
 
             //ALOGI("<<<< TRANSACT from pid %d restore pid %d sid %s uid %d\n",
             //     mCallingPid, origPid, (origSid ? origSid : "<N/A>"), origUid);
@@ -1600,6 +1609,17 @@ void IPCThreadState::logExtendedError() {
              ee.id, ee.command, ee.param);
 }
 
+void IPCThreadState::recordTransactionStats(bool incoming, uint32_t code, const Parcel& data,
+                                            int64_t startTime) {
+    using binder::debug::TransactionStats;
+    size_t interfaceLen = 0;
+    const char16_t* interface = data.peekInterfaceToken(&interfaceLen);
+    TransactionStats::record(incoming ? TransactionStats::Direction::INCOMING
+                                      : TransactionStats::Direction::OUTGOING,
+                             interface, interface ? interfaceLen : 0, code,
+                             systemTime(SYSTEM_TIME_MONOTONIC) - startTime, data.dataSize());
+}
+
 void IPCThreadState::freeBuffer(const uint8_t* data, size_t /*dataSize*/,
                                 const binder_size_t* /*objects*/, size_t /*objectsSize*/) {
     //ALOGI("Freeing parcel %p", &parcel);
@@ -33,6 +33,17 @@ status_t getRandomBytes(uint8_t* data, size_t size);
 
 status_t dupFileDescriptor(int oldFd, int* newFd);
 
+// Creates an anonymous shared memory region of |size| bytes, mapped read-write in this process.
+// The region's size is sealed, so it can't change once it has been shared.
+status_t createSharedMemory(const char* name, size_t size, unique_fd* outFd, void** outData);
+
+// Maps |size| bytes of a shared memory region created by another process, read-only. Fails
+// unless the region was created by createSharedMemory, with at least |size| bytes. Its contents
+// can still be changed by the other process.
+status_t mapSharedMemory(borrowed_fd fd, size_t size, void** outData);
+
+void unmapSharedMemory(void* data, size_t size);
+
 std::unique_ptr<RpcTransportCtxFactory> makeDefaultRpcTransportCtxFactory();
 
 ssize_t sendMessageOnSocket(const RpcTransportFd& socket, iovec* iovs, int niovs,
@@ -21,7 +21,9 @@
 #include <binder/RpcTransportRaw.h>
 #include <log/log.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 
 using android::binder::ReadFully;
 
@@ -65,6 +67,74 @@ status_t dupFileDescriptor(int oldFd, int* newFd) {
     return OK;
 }
 
+constexpr int kSharedMemorySeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+status_t createSharedMemory(const char* name, size_t size, unique_fd* outFd, void** outData) {
+    unique_fd fd(memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!fd.ok()) {
+        PLOGE("Failed createSharedMemory: memfd_create");
+        return -errno;
+    }
+    if (TEMP_FAILURE_RETRY(ftruncate(fd.get(), static_cast<off_t>(size))) == -1) {
+        PLOGE("Failed createSharedMemory: ftruncate to %zu", size);
+        return -errno;
+    }
+    // The region is reused for many transactions, so its contents can't be sealed, but its
+    // size is: the peer must be able to rely on it, and on nobody else sealing it further.
+    if (fcntl(fd.get(), F_ADD_SEALS, kSharedMemorySeals) == -1) {
+        PLOGE("Failed createSharedMemory: F_ADD_SEALS");
+        return -errno;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        PLOGE("Failed createSharedMemory: mmap of %zu bytes", size);
+        return -errno;
+    }
+
+    *outFd = std::move(fd);
+    *outData = data;
+    return OK;
+}
+
+status_t mapSharedMemory(borrowed_fd fd, size_t size, void** outData) {
+    // Without these seals, the peer could shrink the region once it is mapped, and accessing
+    // it would then raise SIGBUS.
+    int seals = fcntl(fd.get(), F_GET_SEALS);
+    if (seals == -1) {
+        PLOGE("Failed mapSharedMemory: F_GET_SEALS");
+        return -errno;
+    }
+    if ((seals & kSharedMemorySeals) != kSharedMemorySeals) {
+        ALOGE("Failed mapSharedMemory: region has seals 0x%x, expected 0x%x", seals,
+              kSharedMemorySeals);
+        return BAD_VALUE;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) == -1) {
+        PLOGE("Failed mapSharedMemory: fstat");
+        return -errno;
+    }
+    if (st.st_size < 0 || static_cast<uint64_t>(st.st_size) < size) {
+        ALOGE("Failed mapSharedMemory: region has %lld bytes, expected %zu",
+              static_cast<long long>(st.st_size), size);
+        return BAD_VALUE;
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        PLOGE("Failed mapSharedMemory: mmap of %zu bytes", size);
+        return -errno;
+    }
+
+    *outData = data;
+    return OK;
+}
+
+void unmapSharedMemory(void* data, size_t size) {
+    if (munmap(data, size) == -1) {
+        PLOGE("Failed unmapSharedMemory: munmap of %zu bytes", size);
+    }
+}
+
 std::unique_ptr<RpcTransportCtxFactory> makeDefaultRpcTransportCtxFactory() {
     return RpcTransportCtxFactoryRaw::make();
 }
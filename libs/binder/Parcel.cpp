@@ -48,6 +48,7 @@
 #include <utils/String8.h>
 
 #include "OS.h"
+#include "ParcelBufferPool.h"
 #include "RpcState.h"
 #include "Static.h"
 #include "Utils.h"
@@ -408,6 +409,10 @@ size_t Parcel::getGlobalAllocCount() {
     return gParcelGlobalAllocCount.load();
 }
 
+Parcel::BufferPoolStats Parcel::getBufferPoolStats() {
+    return ParcelBufferPool::stats();
+}
+
 const uint8_t* Parcel::data() const
 {
     return mData;
@@ -485,6 +490,17 @@ status_t Parcel::setDataCapacity(size_t size)
     return NO_ERROR;
 }
 
+status_t Parcel::reserveForWrite(size_t len) {
+    if (len > INT32_MAX) {
+        // don't accept size_t values which may have come from an
+        // inadvertent conversion from a negative int.
+        return BAD_VALUE;
+    }
+
+    if (len > SIZE_MAX - mDataPos) return NO_MEMORY; // overflow
+    return setDataCapacity(mDataPos + len);
+}
+
 status_t Parcel::setData(const uint8_t* buffer, size_t len)
 {
     if (len > INT32_MAX) {
@@ -931,6 +947,25 @@ status_t Parcel::writeInterfaceToken(const char16_t* str, size_t len) {
     return writeString16(str, len);
 }
 
+const char16_t* Parcel::peekInterfaceToken(size_t* outLen) const {
+    const size_t pos = mDataPos;
+    mDataPos = 0;
+
+    const char16_t* interface = nullptr;
+    if (maybeKernelFields()) {
+#ifdef BINDER_WITH_KERNEL_IPC
+        (void)readInt32(); // StrictModePolicy
+        (void)readInt32(); // WorkSource
+        if (readInt32() == kHeader) interface = readString16Inplace(outLen);
+#endif // BINDER_WITH_KERNEL_IPC
+    } else {
+        interface = readString16Inplace(outLen);
+    }
+
+    mDataPos = pos;
+    return interface;
+}
+
 bool Parcel::replaceCallingWorkSourceUid(uid_t uid)
 {
     auto* kernelFields = maybeKernelFields();
@@ -2879,7 +2914,7 @@ void Parcel::freeDataNoInit()
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
             }
-            free(mData);
+            ParcelBufferPool::release(mData, mDataCapacity);
         }
         auto* kernelFields = maybeKernelFields();
         if (kernelFields && kernelFields->mObjects) free(kernelFields->mObjects);
@@ -2902,21 +2937,6 @@ status_t Parcel::growData(size_t len)
             : continueWrite(std::max(newSize, (size_t) 128));
 }
 
-static uint8_t* reallocZeroFree(uint8_t* data, size_t oldCapacity, size_t newCapacity, bool zero) {
-    if (!zero) {
-        return (uint8_t*)realloc(data, newCapacity);
-    }
-    uint8_t* newData = (uint8_t*)malloc(newCapacity);
-    if (!newData) {
-        return nullptr;
-    }
-
-    memcpy(newData, data, std::min(oldCapacity, newCapacity));
-    zeroMemory(data, oldCapacity);
-    free(data);
-    return newData;
-}
-
 status_t Parcel::restartWrite(size_t desired)
 {
     if (desired > INT32_MAX) {
@@ -2930,7 +2950,7 @@ status_t Parcel::restartWrite(size_t desired)
         return continueWrite(desired);
     }
 
-    uint8_t* data = reallocZeroFree(mData, mDataCapacity, desired, mDeallocZero);
+    uint8_t* data = ParcelBufferPool::resize(mData, mDataCapacity, desired, mDeallocZero);
     if (!data && desired > mDataCapacity) {
         mError = NO_MEMORY;
         return NO_MEMORY;
@@ -3016,7 +3036,7 @@ status_t Parcel::continueWrite(size_t desired)
 
         // If there is a different owner, we need to take
         // posession.
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = ParcelBufferPool::acquire(desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -3026,7 +3046,7 @@ status_t Parcel::continueWrite(size_t desired)
         if (kernelFields && objectsSize) {
             objects = (binder_size_t*)calloc(objectsSize, sizeof(binder_size_t));
             if (!objects) {
-                free(data);
+                ParcelBufferPool::release(data, desired);
 
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -3041,7 +3061,7 @@ status_t Parcel::continueWrite(size_t desired)
         }
         if (rpcFields) {
             if (status_t status = truncateRpcObjects(objectsSize); status != OK) {
-                free(data);
+                ParcelBufferPool::release(data, desired);
                 return status;
             }
         }
@@ -3118,9 +3138,9 @@ status_t Parcel::continueWrite(size_t desired)
             }
         }
 
-        // We own the data, so we can just do a realloc().
+        // We own the data, so we can just resize it.
         if (desired > mDataCapacity) {
-            uint8_t* data = reallocZeroFree(mData, mDataCapacity, desired, mDeallocZero);
+            uint8_t* data = ParcelBufferPool::resize(mData, mDataCapacity, desired, mDeallocZero);
             if (data) {
                 LOG_ALLOC("Parcel %p: continue from %zu to %zu capacity", this, mDataCapacity,
                         desired);
@@ -3145,7 +3165,7 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = ParcelBufferPool::acquire(desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ParcelBufferPool"
+
+#include "ParcelBufferPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include "Utils.h"
+
+namespace android {
+
+// the smallest buffer Parcel::growData asks for
+constexpr size_t kMinPooledSize = 128;
+constexpr size_t kNumSizeClasses = 8;
+static_assert((kMinPooledSize << (kNumSizeClasses - 1)) == ParcelBufferPool::kMaxPooledSize);
+
+// Binder threadpool threads each get a cache, so keep them small.
+constexpr size_t kMaxCachedPerClass = 4;
+constexpr size_t kMaxCachedSizePerThread = 64 * 1024;
+
+static std::atomic<size_t> gPoolHits;
+static std::atomic<size_t> gPoolMisses;
+static std::atomic<size_t> gPoolCachedCount;
+static std::atomic<size_t> gPoolCachedSize;
+
+namespace {
+
+// Trivially destructible, so that it can still be used by Parcels destroyed
+// after ThreadCacheReleaser runs (e.g. in IPCThreadState's TLS destructor).
+struct ThreadCache {
+    uint8_t* buffers[kNumSizeClasses][kMaxCachedPerClass];
+    size_t counts[kNumSizeClasses];
+    size_t cachedSize;
+    // the thread is exiting, so nothing more is cached
+    bool disabled;
+};
+
+#ifdef BINDER_RPC_SINGLE_THREADED
+ThreadCache tCache;
+#else
+thread_local ThreadCache tCache;
+
+struct ThreadCacheReleaser {
+    bool registered = false;
+    ~ThreadCacheReleaser();
+};
+thread_local ThreadCacheReleaser tReleaser;
+
+ThreadCacheReleaser::~ThreadCacheReleaser() {
+    for (size_t i = 0; i < kNumSizeClasses; i++) {
+        for (size_t j = 0; j < tCache.counts[i]; j++) {
+            free(tCache.buffers[i][j]);
+        }
+        gPoolCachedCount.fetch_sub(tCache.counts[i], std::memory_order_relaxed);
+        tCache.counts[i] = 0;
+    }
+    gPoolCachedSize.fetch_sub(tCache.cachedSize, std::memory_order_relaxed);
+    tCache.cachedSize = 0;
+    tCache.disabled = true;
+}
+#endif // BINDER_RPC_SINGLE_THREADED
+
+} // namespace
+
+// only for sizes returned by allocationSize() which are pooled
+static size_t sizeClassIndex(size_t size) {
+    size_t index = 0;
+    while ((kMinPooledSize << index) < size) index++;
+    return index;
+}
+
+size_t ParcelBufferPool::allocationSize(size_t capacity) {
+    if (capacity > kMaxPooledSize) return capacity;
+
+    size_t size = kMinPooledSize;
+    while (size < capacity) size <<= 1;
+    return size;
+}
+
+uint8_t* ParcelBufferPool::acquire(size_t capacity) {
+    size_t size = allocationSize(capacity);
+    if (size <= kMaxPooledSize) {
+        ThreadCache& cache = tCache;
+        size_t index = sizeClassIndex(size);
+        if (cache.counts[index] > 0) {
+            cache.cachedSize -= size;
+            gPoolHits.fetch_add(1, std::memory_order_relaxed);
+            gPoolCachedCount.fetch_sub(1, std::memory_order_relaxed);
+            gPoolCachedSize.fetch_sub(size, std::memory_order_relaxed);
+            return cache.buffers[index][--cache.counts[index]];
+        }
+    }
+
+    gPoolMisses.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<uint8_t*>(malloc(size));
+}
+
+uint8_t* ParcelBufferPool::resize(uint8_t* data, size_t oldCapacity, size_t newCapacity,
+                                  bool zero) {
+    if (data == nullptr) return acquire(newCapacity);
+
+    size_t oldSize = allocationSize(oldCapacity);
+    size_t newSize = allocationSize(newCapacity);
+    if (oldSize == newSize) return data;
+
+    // neither buffer is pooled, so realloc may be able to avoid the copy
+    if (!zero && oldSize > kMaxPooledSize && newSize > kMaxPooledSize) {
+        return static_cast<uint8_t*>(realloc(data, newSize));
+    }
+
+    uint8_t* newData = acquire(newCapacity);
+    if (newData == nullptr) return nullptr;
+
+    memcpy(newData, data, std::min(oldCapacity, newCapacity));
+    if (zero) zeroMemory(data, oldCapacity);
+    release(data, oldCapacity);
+    return newData;
+}
+
+void ParcelBufferPool::release(uint8_t* data, size_t capacity) {
+    if (data == nullptr) return;
+
+    size_t size = allocationSize(capacity);
+    if (size <= kMaxPooledSize) {
+        ThreadCache& cache = tCache;
+        size_t index = sizeClassIndex(size);
+        if (!cache.disabled && cache.counts[index] < kMaxCachedPerClass &&
+            cache.cachedSize + size <= kMaxCachedSizePerThread) {
+#ifndef BINDER_RPC_SINGLE_THREADED
+            // first use on this thread registers its destructor
+            tReleaser.registered = true;
+#endif
+            cache.buffers[index][cache.counts[index]++] = data;
+            cache.cachedSize += size;
+            gPoolCachedCount.fetch_add(1, std::memory_order_relaxed);
+            gPoolCachedSize.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    free(data);
+}
+
+Parcel::BufferPoolStats ParcelBufferPool::stats() {
+    return Parcel::BufferPoolStats{
+            .hits = gPoolHits.load(std::memory_order_relaxed),
+            .misses = gPoolMisses.load(std::memory_order_relaxed),
+            .cachedCount = gPoolCachedCount.load(std::memory_order_relaxed),
+            .cachedSize = gPoolCachedSize.load(std::memory_order_relaxed),
+    };
+}
+
+std::string Parcel::BufferPoolStats::toString() const {
+    return "Parcel buffer pool: " + std::to_string(hits) + " hits, " + std::to_string(misses) +
+            " misses, " + std::to_string(cachedCount) + " buffers (" + std::to_string(cachedSize) +
+            " bytes) cached";
+}
+
+} // namespace android
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <binder/Parcel.h>
+
+namespace android {
+
+/**
+ * Allocator for the data buffers of Parcels which own their data.
+ *
+ * Buffers up to kMaxPooledSize are rounded up to a power of two size class,
+ * and freed buffers are kept in a small per-thread cache for each class.
+ * Transactions on a thread tend to use Parcels of about the same size, so in
+ * steady state, writing a Parcel doesn't touch malloc at all.
+ *
+ * Parcel keeps its capacity as requested, rather than the size of the
+ * buffer, so the size class is always found again from the capacity. Callers
+ * must pass the capacity a buffer currently has to resize() and release().
+ */
+class ParcelBufferPool {
+public:
+    // larger buffers are allocated and freed directly
+    static constexpr size_t kMaxPooledSize = 16 * 1024;
+
+    // Size of the buffer backing 'capacity' bytes.
+    static size_t allocationSize(size_t capacity);
+
+    // Returns nullptr if out of memory.
+    static uint8_t* acquire(size_t capacity);
+    // Like realloc. On failure, returns nullptr and 'data' is unchanged. If
+    // 'zero', the old buffer is cleared when the data moves.
+    static uint8_t* resize(uint8_t* data, size_t oldCapacity, size_t newCapacity, bool zero);
+    static void release(uint8_t* data, size_t capacity);
+
+    static Parcel::BufferPoolStats stats();
+};
+
+} // namespace android
@@ -384,6 +384,14 @@ uint32_t RecordedTransaction::getVersion() const {
     return mData.mHeader.version;
 }
 
+android::status_t RecordedTransaction::replay(const sp<IBinder>& binder, Parcel* reply) const {
+    Parcel data;
+    if (status_t status = data.setData(mSent.data(), mSent.dataBufferSize()); status != OK) {
+        return status;
+    }
+    return binder->transact(getCode(), data, reply, getFlags());
+}
+
 const Parcel& RecordedTransaction::getDataParcel() const {
     return mSent;
 }
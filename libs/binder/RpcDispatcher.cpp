@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcDispatcher"
+
+#include "RpcDispatcher.h"
+
+#include <array>
+#include <chrono>
+
+#include <inttypes.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "FdTrigger.h"
+#include "OS.h"
+#include "RpcState.h"
+
+namespace android {
+
+using namespace std::chrono_literals;
+using android::binder::borrowed_fd;
+using android::binder::unique_fd;
+
+// epoll data for mWake
+constexpr uint64_t kWakeId = 0;
+
+// How many commands to process from one connection before letting other
+// connections queued on the same thread run.
+constexpr size_t kMaxCommandsPerTurn = 16;
+
+// Waits for more of a command to arrive on 'fd', for RpcConnection's
+// incomingCommandPoll.
+static status_t pollForCommand(int fd, int triggerFd,
+                               std::chrono::steady_clock::time_point deadline) {
+    while (true) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+        if (remaining <= 0ms) {
+            ALOGE("Timed out reading a command on fd %d, terminating session", fd);
+            return TIMED_OUT;
+        }
+        pollfd pfd[]{
+                {.fd = fd, .events = POLLIN, .revents = 0},
+                {.fd = triggerFd, .events = 0, .revents = 0},
+        };
+        int ret = TEMP_FAILURE_RETRY(
+                poll(pfd, std::size(pfd), static_cast<int>(remaining.count())));
+        if (ret < 0) return -errno;
+        if (pfd[1].revents & POLLHUP) return DEAD_OBJECT;
+        if (pfd[0].revents != 0) return OK;
+    }
+}
+
+std::unique_ptr<RpcDispatcher> RpcDispatcher::make(size_t numThreads,
+                                                   std::chrono::milliseconds commandReadTimeout) {
+    LOG_ALWAYS_FATAL_IF(numThreads == 0, "RpcDispatcher needs at least one thread");
+
+    std::unique_ptr<RpcDispatcher> dispatcher(new RpcDispatcher());
+    dispatcher->mCommandReadTimeout = commandReadTimeout;
+    dispatcher->mEpoll.reset(epoll_create1(EPOLL_CLOEXEC));
+    if (!dispatcher->mEpoll.ok()) {
+        ALOGE("Could not create epoll: %s", strerror(errno));
+        return nullptr;
+    }
+    dispatcher->mWake.reset(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!dispatcher->mWake.ok()) {
+        ALOGE("Could not create eventfd: %s", strerror(errno));
+        return nullptr;
+    }
+    epoll_event event{.events = EPOLLIN, .data = {.u64 = kWakeId}};
+    if (epoll_ctl(dispatcher->mEpoll.get(), EPOLL_CTL_ADD, dispatcher->mWake.get(), &event) != 0) {
+        ALOGE("Could not watch eventfd: %s", strerror(errno));
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < numThreads; i++) {
+        dispatcher->mWorkers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < numThreads; i++) {
+        dispatcher->mWorkers[i]->thread =
+                RpcMaybeThread(&RpcDispatcher::workerLoop, dispatcher.get(), i);
+    }
+    dispatcher->mEventThread = RpcMaybeThread(&RpcDispatcher::eventLoop, dispatcher.get());
+    return dispatcher;
+}
+
+RpcDispatcher::~RpcDispatcher() {
+    mStopping = true;
+
+    if (mWake.ok()) {
+        uint64_t one = 1;
+        if (TEMP_FAILURE_RETRY(write(mWake.get(), &one, sizeof(one))) != sizeof(one)) {
+            ALOGE("Could not wake event loop: %s", strerror(errno));
+        }
+    }
+    {
+        RpcMutexLockGuard _l(mIdleLock);
+    }
+    mIdleCv.notify_all();
+
+    // threads are only started once make() can no longer fail
+    if (mWorkers.empty()) return;
+
+    // The last reference to the server may be dropped while serving a
+    // transaction, on one of our own threads.
+    auto joinOrDetach = [](RpcMaybeThread& thread) {
+        if (thread.get_id() == rpc_this_thread::get_id()) {
+            thread.detach();
+        } else {
+            thread.join();
+        }
+    };
+    joinOrDetach(mEventThread);
+    for (auto& worker : mWorkers) {
+        joinOrDetach(worker->thread);
+    }
+}
+
+void RpcDispatcher::add(sp<RpcSession>&& session, RpcSession::PreJoinSetupResult&& setupResult,
+                        borrowed_fd fd) {
+    sp<RpcSession::RpcConnection>& connection = setupResult.connection;
+
+    if (setupResult.status != OK) {
+        ALOGE("Connection failed to init, closing with status %s",
+              statusToString(setupResult.status).c_str());
+        RpcSession::releaseIncomingConnection(std::move(session), connection);
+        return;
+    }
+    LOG_ALWAYS_FATAL_IF(!connection, "must have connection if setup succeeded");
+
+    // assigned to whichever thread serves it, as it is processed
+    session->clearConnectionTid(connection);
+
+    uint64_t id;
+    bool watched;
+    {
+        RpcMutexLockGuard _l(mLock);
+        id = mNextId++;
+        mWatches[id] = Watch{.session = session, .connection = connection, .fd = fd.get()};
+
+        auto& [triggerId, numConnections] = mSessionTriggers[session.get()];
+        if (numConnections++ == 0) {
+            // Only reports EPOLLHUP, once the session is shut down. This wakes
+            // up idle connections of the session, so that they notice.
+            triggerId = mNextId++;
+            int triggerFd = session->mShutdownTrigger->readFd().get();
+            mWatches[triggerId] = Watch{.session = session, .fd = triggerFd};
+            epoll_event event{.events = EPOLLONESHOT, .data = {.u64 = triggerId}};
+            if (epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, triggerFd, &event) != 0) {
+                ALOGE("Could not watch session shutdown trigger: %s", strerror(errno));
+            }
+        }
+
+        epoll_event event{.events = EPOLLIN | EPOLLONESHOT, .data = {.u64 = id}};
+        watched = epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, fd.get(), &event) == 0;
+        if (!watched) {
+            ALOGE("Could not watch connection fd %d: %s", fd.get(), strerror(errno));
+        }
+    }
+
+    if (!watched) finish(id);
+}
+
+void RpcDispatcher::eventLoop() {
+    std::array<epoll_event, 64> events;
+    while (!mStopping) {
+        int numEvents =
+                TEMP_FAILURE_RETRY(epoll_wait(mEpoll.get(), events.data(), events.size(), -1));
+        if (numEvents < 0) {
+            ALOGE("epoll_wait failed, no longer serving connections: %s", strerror(errno));
+            return;
+        }
+
+        std::vector<uint64_t> ready;
+        {
+            RpcMutexLockGuard _l(mLock);
+            for (int i = 0; i < numEvents; i++) {
+                uint64_t id = events[i].data.u64;
+                if (id == kWakeId) continue;
+
+                auto it = mWatches.find(id);
+                if (it == mWatches.end()) continue;
+
+                if (it->second.connection != nullptr) {
+                    it->second.busy = true;
+                    ready.push_back(id);
+                    continue;
+                }
+
+                // The session is shutting down. Connections being processed
+                // check for this before they are watched again.
+                for (auto& [otherId, watch] : mWatches) {
+                    if (watch.session == it->second.session && watch.connection != nullptr &&
+                        !watch.busy) {
+                        watch.busy = true;
+                        ready.push_back(otherId);
+                    }
+                }
+            }
+        }
+
+        for (uint64_t id : ready) {
+            submit(id, std::nullopt);
+        }
+    }
+}
+
+void RpcDispatcher::workerLoop(size_t index) {
+    RpcSession::runAttachedToJavaVm([&] {
+        while (true) {
+            if (std::optional<uint64_t> id = takeWork(index); id.has_value()) {
+                serve(*id, index);
+                continue;
+            }
+
+            RpcMutexUniqueLock _l(mIdleLock);
+            mIdleCv.wait(_l, [&] { return mStopping || mPending > 0; });
+            if (mStopping) return;
+        }
+    });
+}
+
+void RpcDispatcher::submit(uint64_t id, std::optional<size_t> preferredWorker) {
+    size_t index = preferredWorker.value_or(mNextWorker++ % mWorkers.size());
+    {
+        RpcMutexLockGuard _l(mWorkers[index]->lock);
+        mWorkers[index]->queue.push_back(id);
+    }
+    mPending++;
+
+    {
+        RpcMutexLockGuard _l(mIdleLock);
+    }
+    mIdleCv.notify_one();
+}
+
+std::optional<uint64_t> RpcDispatcher::takeWork(size_t index) {
+    {
+        Worker& self = *mWorkers[index];
+        RpcMutexLockGuard _l(self.lock);
+        if (!self.queue.empty()) {
+            uint64_t id = self.queue.front();
+            self.queue.pop_front();
+            mPending--;
+            return id;
+        }
+    }
+
+    // steal the most recently queued work from another thread, which is the
+    // work that thread would get to last
+    for (size_t i = 1; i < mWorkers.size(); i++) {
+        Worker& victim = *mWorkers[(index + i) % mWorkers.size()];
+        RpcMutexLockGuard _l(victim.lock);
+        if (victim.queue.empty()) continue;
+        uint64_t id = victim.queue.back();
+        victim.queue.pop_back();
+        mPending--;
+        return id;
+    }
+    return std::nullopt;
+}
+
+void RpcDispatcher::serve(uint64_t id, size_t index) {
+    sp<RpcSession> session;
+    sp<RpcSession::RpcConnection> connection;
+    int fd;
+    {
+        RpcMutexLockGuard _l(mLock);
+        auto it = mWatches.find(id);
+        LOG_ALWAYS_FATAL_IF(it == mWatches.end(), "Serving unknown connection %" PRIu64, id);
+        session = it->second.session;
+        connection = it->second.connection;
+        fd = it->second.fd;
+    }
+    int triggerFd = session->mShutdownTrigger->readFd().get();
+
+    // for nested transactions, see RpcSession::ExclusiveConnection::find
+    {
+        RpcMutexLockGuard _l(session->mMutex);
+        connection->exclusiveTid = binder::os::GetThreadId();
+    }
+
+    status_t status = OK;
+    bool more = false;
+    for (size_t i = 0; i < kMaxCommandsPerTurn; i++) {
+        // A client which stops partway through a command holds this thread
+        // until it times out. Connections are only queued once they are
+        // readable, so an idle client never does.
+        auto deadline = std::chrono::steady_clock::now() + mCommandReadTimeout;
+        connection->incomingCommandPoll = [fd, triggerFd, deadline]() {
+            return pollForCommand(fd, triggerFd, deadline);
+        };
+        status = session->state()->getAndExecuteCommand(connection, session,
+                                                        RpcState::CommandType::ANY);
+        connection->incomingCommandPoll.reset();
+        if (status != OK) break;
+        // also covers data buffered by the transport, which epoll can't see
+        more = connection->rpcTransport->pollRead() == OK;
+        if (!more) break;
+    }
+
+    session->clearConnectionTid(connection);
+
+    if (status != OK) {
+        LOG_RPC_DETAIL("Binder connection closing w/ status %s", statusToString(status).c_str());
+        finish(id);
+        return;
+    }
+
+    if (more) {
+        // stay busy, and let idle threads steal it
+        submit(id, index);
+        return;
+    }
+
+    bool shutdown;
+    {
+        RpcMutexLockGuard _l(mLock);
+        auto it = mWatches.find(id);
+        shutdown = session->mShutdownTrigger->isTriggered();
+        if (!shutdown) {
+            it->second.busy = false;
+            epoll_event event{.events = EPOLLIN | EPOLLONESHOT, .data = {.u64 = id}};
+            if (epoll_ctl(mEpoll.get(), EPOLL_CTL_MOD, it->second.fd, &event) != 0) {
+                ALOGE("Could not watch connection fd %d: %s", it->second.fd, strerror(errno));
+                shutdown = true;
+            }
+        }
+    }
+    if (shutdown) finish(id);
+}
+
+void RpcDispatcher::finish(uint64_t id) {
+    sp<RpcSession> session;
+    sp<RpcSession::RpcConnection> connection;
+    {
+        RpcMutexLockGuard _l(mLock);
+        auto it = mWatches.find(id);
+        LOG_ALWAYS_FATAL_IF(it == mWatches.end(), "Finishing unknown connection %" PRIu64, id);
+        session = std::move(it->second.session);
+        connection = std::move(it->second.connection);
+        // may fail if it was never added
+        (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, it->second.fd, nullptr);
+        mWatches.erase(it);
+
+        auto trigger = mSessionTriggers.find(session.get());
+        LOG_ALWAYS_FATAL_IF(trigger == mSessionTriggers.end(), "Session trigger not watched");
+        auto& [triggerId, numConnections] = trigger->second;
+        if (--numConnections == 0) {
+            auto triggerWatch = mWatches.find(triggerId);
+            (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, triggerWatch->second.fd, nullptr);
+            mWatches.erase(triggerWatch);
+            mSessionTriggers.erase(trigger);
+        }
+    }
+
+    RpcSession::releaseIncomingConnection(std::move(session), connection);
+}
+
+} // namespace android
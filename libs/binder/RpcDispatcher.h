@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <binder/RpcSession.h>
+#include <binder/RpcThreads.h>
+#include <binder/unique_fd.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace android {
+
+/**
+ * Serves the incoming connections of an RpcServer with a fixed pool of
+ * threads, instead of a thread per connection. See
+ * RpcServer::setDispatchThreads.
+ *
+ * One thread waits with epoll for connections to become readable, and queues
+ * them to the pool. Each pool thread has its own queue, and steals from the
+ * others when it runs out of work. A connection is not watched while a pool
+ * thread is processing it, so commands on each connection are still processed
+ * one at a time, in order. Once a pool thread starts reading a command, the
+ * client has a limited time to send the rest of it, so that slow clients
+ * can't hold on to the pool.
+ *
+ * Only available on multi-threaded libbinder.
+ */
+class RpcDispatcher {
+public:
+    /**
+     * 'commandReadTimeout' is how long a client has to send the rest of a
+     * command once a pool thread has started reading it. Past this, its
+     * session is shut down.
+     */
+    static std::unique_ptr<RpcDispatcher> make(size_t numThreads,
+                                               std::chrono::milliseconds commandReadTimeout);
+    ~RpcDispatcher();
+
+    /**
+     * Takes over serving a connection set up by RpcSession::preJoinSetup, in
+     * place of RpcSession::join. 'fd' is the connection's socket, which is
+     * owned by its RpcTransport.
+     */
+    void add(sp<RpcSession>&& session, RpcSession::PreJoinSetupResult&& setupResult,
+             binder::borrowed_fd fd);
+
+private:
+    struct Watch {
+        sp<RpcSession> session;
+        // null when watching the session's shutdown trigger
+        sp<RpcSession::RpcConnection> connection;
+        int fd = -1;
+        // whether a pool thread is processing this connection
+        bool busy = false;
+    };
+
+    struct Worker {
+        RpcMutex lock; // for queue
+        std::deque<uint64_t> queue;
+        RpcMaybeThread thread;
+    };
+
+    RpcDispatcher() = default;
+
+    void eventLoop();
+    void workerLoop(size_t index);
+    // Queues a connection (by watch id) to be processed by the pool.
+    void submit(uint64_t id, std::optional<size_t> preferredWorker);
+    std::optional<uint64_t> takeWork(size_t index);
+    void serve(uint64_t id, size_t index);
+    // Stops watching a connection, and releases it from its session.
+    void finish(uint64_t id);
+
+    std::chrono::milliseconds mCommandReadTimeout{0};
+    binder::unique_fd mEpoll;
+    binder::unique_fd mWake; // eventfd, to stop the event loop
+
+    RpcMutex mLock; // for below
+    uint64_t mNextId = 1;
+    std::map<uint64_t, Watch> mWatches;
+    // watch id of each session's shutdown trigger, and how many of its
+    // connections are being served
+    std::map<RpcSession*, std::pair<uint64_t, size_t>> mSessionTriggers;
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    RpcMutex mIdleLock; // for mIdleCv
+    RpcConditionVariable mIdleCv;
+    std::atomic<size_t> mPending = 0;
+    std::atomic<size_t> mNextWorker = 0;
+    std::atomic<bool> mStopping = false;
+    RpcMaybeThread mEventThread;
+};
+
+} // namespace android
@@ -34,6 +34,9 @@
 #include "BuildFlags.h"
 #include "FdTrigger.h"
 #include "OS.h"
+#ifndef BINDER_RPC_SINGLE_THREADED
+#include "RpcDispatcher.h"
+#endif
 #include "RpcSocketAddress.h"
 #include "RpcState.h"
 #include "RpcTransportUtils.h"
@@ -141,6 +144,25 @@ void RpcServer::setSupportedFileDescriptorTransportModes(
     }
 }
 
+void RpcServer::setSharedMemoryTransactionThreshold(size_t bytes) {
+    mSharedMemoryTransactionThreshold = bytes;
+}
+
+void RpcServer::setDispatchThreads(size_t threads) {
+    LOG_ALWAYS_FATAL_IF(!kEnableRpcThreads && threads > 0,
+                        "Dispatch threads are not supported on single-threaded libbinder");
+    RpcMutexLockGuard _l(mLock);
+    LOG_ALWAYS_FATAL_IF(mShutdownTrigger != nullptr, "Must set dispatch threads before join()");
+    mDispatchThreads = threads;
+}
+
+void RpcServer::setDispatchCommandTimeout(std::chrono::milliseconds timeout) {
+    RpcMutexLockGuard _l(mLock);
+    LOG_ALWAYS_FATAL_IF(mShutdownTrigger != nullptr,
+                        "Must set dispatch command timeout before join()");
+    mDispatchCommandTimeout = timeout;
+}
+
 void RpcServer::setRootObject(const sp<IBinder>& binder) {
     RpcMutexLockGuard _l(mLock);
     mRootObjectFactory = nullptr;
@@ -247,6 +269,12 @@ void RpcServer::join() {
         mJoinThreadRunning = true;
         mShutdownTrigger = FdTrigger::make();
         LOG_ALWAYS_FATAL_IF(mShutdownTrigger == nullptr, "Cannot create join signaler");
+#ifndef BINDER_RPC_SINGLE_THREADED
+        if (mDispatchThreads > 0 && mDispatcher == nullptr) {
+            mDispatcher = RpcDispatcher::make(mDispatchThreads, mDispatchCommandTimeout);
+            LOG_ALWAYS_FATAL_IF(mDispatcher == nullptr, "Cannot create dispatcher");
+        }
+#endif
     }
 
     status_t status;
@@ -424,17 +452,28 @@ void RpcServer::establishConnection(
     bool incoming = false;
     uint32_t protocolVersion = 0;
     bool requestingNewSession = false;
+    bool useSharedMemory = false;
 
     if (status == OK) {
         incoming = header.options & RPC_CONNECTION_OPTION_INCOMING;
         protocolVersion = std::min(header.version,
                                    server->mProtocolVersion.value_or(RPC_WIRE_PROTOCOL_VERSION));
         requestingNewSession = sessionId.empty();
+        useSharedMemory = (header.options & RPC_CONNECTION_OPTION_SHARED_MEMORY) &&
+                server->mSharedMemoryTransactionThreshold != 0 &&
+                header.fileDescriptorTransportMode ==
+                        static_cast<uint8_t>(RpcSession::FileDescriptorTransportMode::UNIX);
 
         if (requestingNewSession) {
             RpcNewSessionResponse response{
                     .version = protocolVersion,
             };
+            if (useSharedMemory) {
+                response.options |= RPC_NEW_SESSION_RESPONSE_OPTION_SHARED_MEMORY;
+            }
+            if (header.options & RPC_CONNECTION_OPTION_ONEWAY_BATCH) {
+                response.options |= RPC_NEW_SESSION_RESPONSE_OPTION_ONEWAY_BATCH;
+            }
 
             iovec iov{&response, sizeof(response)};
             status = client->interruptableWriteFully(server->mShutdownTrigger.get(), &iov, 1,
@@ -509,6 +548,10 @@ void RpcServer::establishConnection(
                       header.fileDescriptorTransportMode);
                 return;
             }
+            if (useSharedMemory) {
+                session->setSharedMemoryTransactionThreshold(
+                        server->mSharedMemoryTransactionThreshold);
+            }
 
             // if null, falls back to server root
             sp<IBinder> sessionSpecificRoot;
@@ -546,12 +589,24 @@ void RpcServer::establishConnection(
             return;
         }
 
-        detachGuard.release();
-        session->preJoinThreadOwnership(std::move(thisThread));
+        // with a dispatcher, this thread only finishes setting up the
+        // connection, and is detached by the guard
+        if (server->mDispatcher == nullptr) {
+            detachGuard.release();
+            session->preJoinThreadOwnership(std::move(thisThread));
+        }
     }
 
     auto setupResult = session->preJoinSetup(std::move(client));
 
+#ifndef BINDER_RPC_SINGLE_THREADED
+    if (std::shared_ptr<RpcDispatcher> dispatcher = server->mDispatcher) {
+        server = nullptr;
+        dispatcher->add(std::move(session), std::move(setupResult), clientFdForLog);
+        return;
+    }
+#endif
+
     // avoid strong cycle
     server = nullptr;
 
@@ -62,6 +62,8 @@ RpcSession::RpcSession(std::unique_ptr<RpcTransportCtx> ctx) : mCtx(std::move(ct
 RpcSession::~RpcSession() {
     LOG_RPC_DETAIL("RpcSession destroyed %p", this);
 
+    stopOnewayBatching();
+
     RpcMutexLockGuard _l(mMutex);
     LOG_ALWAYS_FATAL_IF(mConnections.mIncoming.size() != 0,
                         "Should not be able to destroy a session with servers in use.");
@@ -140,6 +142,92 @@ RpcSession::FileDescriptorTransportMode RpcSession::getFileDescriptorTransportMo
     return mFileDescriptorTransportMode;
 }
 
+void RpcSession::setSharedMemoryTransactionThreshold(size_t bytes) {
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup,
+                        "Must set shared memory transaction threshold before setting up "
+                        "connections");
+    mSharedMemoryTransactionThreshold = bytes;
+}
+
+size_t RpcSession::getSharedMemoryTransactionThreshold() {
+    return mSharedMemoryTransactionThreshold;
+}
+
+status_t RpcSession::setOnewayBatching(size_t maxBatchBytes, std::chrono::microseconds maxDelay) {
+    // a batch is received in one allocation, see RpcState::CommandData
+    constexpr size_t kMaxOnewayBatchBytes = 64 * 1024;
+
+    if constexpr (!kEnableRpcThreads) {
+        ALOGE("Oneway batching is not supported on single-threaded libbinder");
+        return INVALID_OPERATION;
+    }
+    if (maxBatchBytes > kMaxOnewayBatchBytes || maxDelay.count() < 0) {
+        ALOGE("Invalid oneway batching parameters: %zu bytes, %lldus", maxBatchBytes,
+              static_cast<long long>(maxDelay.count()));
+        return BAD_VALUE;
+    }
+
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup, "Must set oneway batching before setting up connections");
+    mOnewayBatchMaxBytes = maxBatchBytes;
+    mOnewayBatchMaxDelay = maxDelay;
+    return OK;
+}
+
+void RpcSession::onewayBatchFlusherLoop(const wp<RpcSession>& weakSession,
+                                        const std::shared_ptr<RpcOnewayBatch>& batch) {
+    // how long to wait before trying again when a batch couldn't be sent
+    constexpr std::chrono::milliseconds kRetryDelay(10);
+
+    while (true) {
+        std::chrono::steady_clock::time_point deadline;
+        {
+            RpcMutexUniqueLock _l(batch->mutex);
+            batch->cv.wait(_l, [&] { return batch->stopped || batch->deadline.has_value(); });
+            if (batch->stopped) return;
+
+            // the batch may be sent by a transaction in the meantime, in which
+            // case the deadline is cleared
+            deadline = *batch->deadline;
+            if (batch->cv.wait_for(_l, deadline - std::chrono::steady_clock::now(), [&] {
+                    return batch->stopped || batch->deadline != deadline;
+                })) {
+                continue;
+            }
+        }
+
+        sp<RpcSession> session = weakSession.promote();
+        if (session == nullptr) return;
+
+        ExclusiveConnection connection;
+        if (status_t status =
+                    ExclusiveConnection::find(session, ConnectionUse::CLIENT_ASYNC, &connection);
+            status != OK) {
+            ALOGE("Could not find connection to send oneway batch: %s",
+                  statusToString(status).c_str());
+            // the batch is still queued, so don't spin on its deadline
+            RpcMutexLockGuard _l(batch->mutex);
+            if (batch->deadline == deadline) {
+                batch->deadline = std::chrono::steady_clock::now() + kRetryDelay;
+            }
+            continue;
+        }
+        if (status_t status = session->state()->flushOnewayBatch(connection.get(), session);
+            status != OK) {
+            // later batches are still sent until the session stops batching
+            ALOGE("Failed to send oneway batch: %s", statusToString(status).c_str());
+        }
+    }
+}
+
+void RpcSession::stopOnewayBatching() {
+    if (mOnewayBatch == nullptr) return;
+    RpcMutexLockGuard _l(mOnewayBatch->mutex);
+    mOnewayBatch->stopped = true;
+    mOnewayBatch->cv.notify_all();
+}
+
 status_t RpcSession::setupUnixDomainClient(const char* path) {
     return setupSocketClient(UnixSocketAddress(path));
 }
@@ -244,6 +332,7 @@ bool RpcSession::shutdownAndWait(bool wait) {
     LOG_ALWAYS_FATAL_IF(mShutdownTrigger == nullptr, "Shutdown trigger not installed");
 
     mShutdownTrigger->trigger();
+    stopOnewayBatching();
 
     if (wait) {
         LOG_ALWAYS_FATAL_IF(mShutdownListener == nullptr, "Shutdown listener not installed");
@@ -423,6 +512,11 @@ private:
 #endif
 } // namespace
 
+void RpcSession::runAttachedToJavaVm(const std::function<void()>& fn) {
+    [[maybe_unused]] JavaThreadAttacher javaThreadAttacher;
+    fn();
+}
+
 void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult) {
     sp<RpcConnection>& connection = setupResult.connection;
 
@@ -443,14 +537,22 @@ void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult
               statusToString(setupResult.status).c_str());
     }
 
-    sp<RpcSession::EventListener> listener;
     {
         RpcMutexLockGuard _l(session->mMutex);
         auto it = session->mConnections.mThreads.find(rpc_this_thread::get_id());
         LOG_ALWAYS_FATAL_IF(it == session->mConnections.mThreads.end());
         it->second.detach();
         session->mConnections.mThreads.erase(it);
+    }
 
+    releaseIncomingConnection(std::move(session), connection);
+}
+
+void RpcSession::releaseIncomingConnection(sp<RpcSession>&& session,
+                                           const sp<RpcConnection>& connection) {
+    sp<RpcSession::EventListener> listener;
+    {
+        RpcMutexLockGuard _l(session->mMutex);
         listener = session->mEventListener.promote();
     }
 
@@ -528,12 +630,20 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
             return status;
 
         uint32_t version;
+        uint8_t options;
         if (status_t status =
                     state()->readNewSessionResponse(connection.get(),
-                                                    sp<RpcSession>::fromExisting(this), &version);
+                                                    sp<RpcSession>::fromExisting(this), &version,
+                                                    &options);
             status != OK)
             return status;
         if (!setProtocolVersionInternal(version, false)) return BAD_VALUE;
+        if (!(options & RPC_NEW_SESSION_RESPONSE_OPTION_SHARED_MEMORY)) {
+            mSharedMemoryTransactionThreshold = 0;
+        }
+        if (!(options & RPC_NEW_SESSION_RESPONSE_OPTION_ONEWAY_BATCH)) {
+            mOnewayBatchMaxBytes = 0;
+        }
     }
 
     // TODO(b/189955605): we should add additional sessions dynamically
@@ -577,6 +687,14 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
 
     cleanup.release();
 
+    if (mOnewayBatchMaxBytes != 0) {
+        mOnewayBatch = std::make_shared<RpcOnewayBatch>(mOnewayBatchMaxBytes, mOnewayBatchMaxDelay);
+        if constexpr (kEnableRpcThreads) {
+            RpcMaybeThread(&RpcSession::onewayBatchFlusherLoop, wp<RpcSession>(this), mOnewayBatch)
+                    .detach();
+        }
+    }
+
     return OK;
 }
 
@@ -687,6 +805,13 @@ status_t RpcSession::initAndAddConnection(RpcTransportFd fd, const std::vector<u
     if (incoming) {
         header.options |= RPC_CONNECTION_OPTION_INCOMING;
     }
+    if (mSharedMemoryTransactionThreshold != 0 &&
+        mFileDescriptorTransportMode == FileDescriptorTransportMode::UNIX) {
+        header.options |= RPC_CONNECTION_OPTION_SHARED_MEMORY;
+    }
+    if (mOnewayBatchMaxBytes != 0) {
+        header.options |= RPC_CONNECTION_OPTION_ONEWAY_BATCH;
+    }
 
     iovec headerIov{&header, sizeof(header)};
     auto sendHeaderStatus = server->interruptableWriteFully(mShutdownTrigger.get(), &headerIov, 1,
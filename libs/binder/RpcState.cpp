@@ -24,11 +24,13 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "OS.h"
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
 #include <random>
 #include <sstream>
+#include <utility>
 
 #include <inttypes.h>
 
@@ -357,6 +359,76 @@ RpcState::CommandData::CommandData(size_t size) : mSize(size) {
     mData.reset(new (std::nothrow) uint8_t[size]);
 }
 
+RpcState::CommandData RpcState::CommandData::borrow(uint8_t* data, size_t size) {
+    CommandData borrowed;
+    borrowed.mData.reset(data);
+    borrowed.mSize = size;
+    borrowed.mBorrowed = true;
+    return borrowed;
+}
+
+RpcState::CommandData RpcState::CommandData::copy(const uint8_t* data, size_t size) {
+    CommandData copied;
+    copied.mSize = size;
+    if (size == 0) return copied;
+    copied.mData.reset(new (std::nothrow) uint8_t[size]);
+    if (copied.mData == nullptr) return copied;
+    memcpy(copied.mData.get(), data, size);
+    return copied;
+}
+
+RpcState::CommandData& RpcState::CommandData::operator=(CommandData&& other) {
+    if (this == &other) return *this;
+    if (mBorrowed) (void)mData.release();
+    mData = std::move(other.mData);
+    mSize = std::exchange(other.mSize, 0);
+    mBorrowed = std::exchange(other.mBorrowed, false);
+    return *this;
+}
+
+RpcState::CommandData::~CommandData() {
+    if (mBorrowed) (void)mData.release();
+}
+
+// Transactions in an RPC_COMMAND_TRANSACT_BATCH start at aligned offsets.
+static size_t alignToBatch(size_t size) {
+    return (size + RPC_WIRE_BATCH_ALIGNMENT - 1) & ~(RPC_WIRE_BATCH_ALIGNMENT - 1);
+}
+
+// Large enough for a handful of nested transactions at the socket size limit.
+// The region is only backed by memory as it is used.
+constexpr size_t kSharedMemoryRegionSize = 16 * 1024 * 1024;
+// Don't let a peer make us map arbitrarily large regions.
+constexpr size_t kMaxIncomingSharedMemoryRegionSize = 64 * 1024 * 1024;
+
+std::shared_ptr<RpcSharedMemoryRegion> RpcSharedMemoryRegion::create(size_t size) {
+    unique_fd fd;
+    void* data;
+    if (status_t status = binder::os::createSharedMemory("binder_rpc_shm", size, &fd, &data);
+        status != OK) {
+        ALOGE("Failed to create RPC shared memory region of %zu bytes: %s", size,
+              statusToString(status).c_str());
+        return nullptr;
+    }
+    return std::shared_ptr<RpcSharedMemoryRegion>(
+            new RpcSharedMemoryRegion(std::move(fd), static_cast<uint8_t*>(data), size));
+}
+
+std::shared_ptr<RpcSharedMemoryRegion> RpcSharedMemoryRegion::map(unique_fd fd, size_t size) {
+    void* data;
+    if (status_t status = binder::os::mapSharedMemory(fd, size, &data); status != OK) {
+        ALOGE("Failed to map RPC shared memory region of %zu bytes: %s", size,
+              statusToString(status).c_str());
+        return nullptr;
+    }
+    return std::shared_ptr<RpcSharedMemoryRegion>(
+            new RpcSharedMemoryRegion(std::move(fd), static_cast<uint8_t*>(data), size));
+}
+
+RpcSharedMemoryRegion::~RpcSharedMemoryRegion() {
+    binder::os::unmapSharedMemory(mData, mSize);
+}
+
 status_t RpcState::rpcSend(const sp<RpcSession::RpcConnection>& connection,
                            const sp<RpcSession>& session, const char* what, iovec* iovs, int niovs,
                            const std::optional<SmallFunction<status_t()>>& altPoll,
@@ -386,7 +458,8 @@ status_t RpcState::rpcRec(const sp<RpcSession::RpcConnection>& connection,
                           std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
     if (status_t status =
                 connection->rpcTransport->interruptableReadFully(session->mShutdownTrigger.get(),
-                                                                 iovs, niovs, std::nullopt,
+                                                                 iovs, niovs,
+                                                                 connection->incomingCommandPoll,
                                                                  ancillaryFds);
         status != OK) {
         LOG_RPC_DETAIL("Failed to read %s (%d iovs) on RpcTransport %p, error: %s", what, niovs,
@@ -428,7 +501,8 @@ bool RpcState::validateProtocolVersion(uint32_t version) {
 }
 
 status_t RpcState::readNewSessionResponse(const sp<RpcSession::RpcConnection>& connection,
-                                          const sp<RpcSession>& session, uint32_t* version) {
+                                          const sp<RpcSession>& session, uint32_t* version,
+                                          uint8_t* options) {
     RpcNewSessionResponse response;
     iovec iov{&response, sizeof(response)};
     if (status_t status = rpcRec(connection, session, "new session response", &iov, 1, nullptr);
@@ -436,6 +510,7 @@ status_t RpcState::readNewSessionResponse(const sp<RpcSession::RpcConnection>& c
         return status;
     }
     *version = response.version;
+    *options = response.options;
     return OK;
 }
 
@@ -591,9 +666,8 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     // Oneway calls have no sync point, so if many are sent before, whether this
     // is a twoway or oneway transaction, they may have filled up the socket.
     // So, make sure we drain them before polling
-    constexpr size_t kWaitMaxUs = 1000000;
-    constexpr size_t kWaitLogUs = 10000;
     size_t waitUs = 0;
+    auto altPoll = [&] { return drainCommandsWithBackoff(connection, session, &waitUs); };
 
     iovec iovs[]{
             {&command, sizeof(RpcWireHeader)},
@@ -601,23 +675,36 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
             {const_cast<uint8_t*>(data.data()), data.dataSize()},
             objectTableSpan.toIovec(),
     };
-    auto altPoll = [&] {
-        if (waitUs > kWaitLogUs) {
-            ALOGE("Cannot send command, trying to process pending refcounts. Waiting "
-                  "%zuus. Too many oneway calls?",
-                  waitUs);
+
+    if (RpcOnewayBatch* batch = session->mOnewayBatch.get(); batch != nullptr) {
+        bool hasFds = rpcFields->mFds != nullptr && !rpcFields->mFds->empty();
+        if ((flags & IBinder::FLAG_ONEWAY) && !hasFds &&
+            alignToBatch(sizeof(RpcWireHeader) + bodySize) <= batch->maxBytes) {
+            return queueOnewayTransaction(connection, session, iovs, countof(iovs),
+                                          std::ref(altPoll));
         }
+        // keep queued oneway transactions ahead of this one
+        if (status_t status = flushOnewayBatch(connection, session); status != OK) return status;
+    }
 
-        if (waitUs > 0) {
-            usleep(waitUs);
-            waitUs = std::min(kWaitMaxUs, waitUs * 2);
-        } else {
-            waitUs = 1;
+    // Large twoway transactions go through shared memory when the session
+    // negotiated it. Oneway transactions always use the socket, since without a
+    // reply we can't tell when the receiver is done with the memory.
+    std::optional<size_t> sharedMemoryOffset;
+    size_t threshold = session->getSharedMemoryTransactionThreshold();
+    if (threshold != 0 && !(flags & IBinder::FLAG_ONEWAY) && bodySize >= threshold) {
+        if (status_t status =
+                    sendTransactionBySharedMemory(connection, session, transaction, data,
+                                                  objectTableSpan, std::ref(altPoll),
+                                                  rpcFields->mFds.get(), &sharedMemoryOffset);
+            status != OK) {
+            return status;
         }
+    }
 
-        return drainCommands(connection, session, CommandType::CONTROL_ONLY);
-    };
-    if (status_t status = rpcSend(connection, session, "transaction", iovs, countof(iovs),
+    if (sharedMemoryOffset.has_value()) {
+        // already sent
+    } else if (status_t status = rpcSend(connection, session, "transaction", iovs, countof(iovs),
                                   std::ref(altPoll), rpcFields->mFds.get());
         status != OK) {
         // rpcSend calls shutdownAndWait, so all refcounts should be reset. If we ever tolerate
@@ -636,7 +723,198 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
 
     LOG_ALWAYS_FATAL_IF(reply == nullptr, "Reply parcel must be used for synchronous transaction.");
 
-    return waitForReply(connection, session, reply);
+    status_t status = waitForReply(connection, session, reply);
+    if (sharedMemoryOffset.has_value()) {
+        // The peer is done with the transaction once it replies, and any nested
+        // transactions sent while waiting have already released their space.
+        connection->outgoingSharedMemory->used = *sharedMemoryOffset;
+    }
+    return status;
+}
+
+status_t RpcState::drainCommandsWithBackoff(const sp<RpcSession::RpcConnection>& connection,
+                                            const sp<RpcSession>& session, size_t* waitUs) {
+    constexpr size_t kWaitMaxUs = 1000000;
+    constexpr size_t kWaitLogUs = 10000;
+
+    if (*waitUs > kWaitLogUs) {
+        ALOGE("Cannot send command, trying to process pending refcounts. Waiting "
+              "%zuus. Too many oneway calls?",
+              *waitUs);
+    }
+
+    if (*waitUs > 0) {
+        usleep(*waitUs);
+        *waitUs = std::min(kWaitMaxUs, *waitUs * 2);
+    } else {
+        *waitUs = 1;
+    }
+
+    return drainCommands(connection, session, CommandType::CONTROL_ONLY);
+}
+
+// Whether this thread is writing a oneway batch. Commands drained while it
+// waits to write may release binders, which must not wait for that same batch.
+static thread_local bool tSendingOnewayBatch = false;
+
+// Called once a batch taken out of batch->data has been written, or failed to.
+static void finishSendingOnewayBatch(RpcOnewayBatch* batch) {
+    RpcMutexLockGuard _l(batch->mutex);
+    batch->sending--;
+    batch->cv.notify_all();
+}
+
+status_t RpcState::queueOnewayTransaction(const sp<RpcSession::RpcConnection>& connection,
+                                          const sp<RpcSession>& session, iovec* iovs, int niovs,
+                                          const std::optional<SmallFunction<status_t()>>& altPoll) {
+    RpcOnewayBatch* batch = session->mOnewayBatch.get();
+
+    size_t size = 0;
+    for (int i = 0; i < niovs; i++) size += iovs[i].iov_len;
+    size_t alignedSize = alignToBatch(size);
+
+    std::vector<uint8_t> full;
+    {
+        RpcMutexLockGuard _l(batch->mutex);
+        if (batch->stopped) return DEAD_OBJECT;
+
+        if (batch->data.size() + alignedSize > batch->maxBytes) {
+            full.swap(batch->data);
+            batch->data.reserve(batch->maxBytes);
+            batch->deadline.reset();
+            batch->sending++;
+        }
+
+        size_t offset = batch->data.size();
+        batch->data.resize(offset + alignedSize); // zero padding
+        for (int i = 0; i < niovs; i++) {
+            if (iovs[i].iov_len == 0) continue;
+            memcpy(batch->data.data() + offset, iovs[i].iov_base, iovs[i].iov_len);
+            offset += iovs[i].iov_len;
+        }
+
+        if (!batch->deadline.has_value()) {
+            batch->deadline = std::chrono::steady_clock::now() + batch->maxDelay;
+            batch->cv.notify_all();
+        }
+    }
+
+    if (full.empty()) return OK;
+    status_t status = sendOnewayBatch(connection, session, &full, altPoll);
+    finishSendingOnewayBatch(batch);
+    return status;
+}
+
+status_t RpcState::flushOnewayBatch(const sp<RpcSession::RpcConnection>& connection,
+                                    const sp<RpcSession>& session) {
+    RpcOnewayBatch* batch = session->mOnewayBatch.get();
+    if (batch == nullptr) return OK;
+
+    std::vector<uint8_t> data;
+    {
+        RpcMutexLockGuard _l(batch->mutex);
+        if (batch->data.empty()) return OK;
+        data.swap(batch->data);
+        batch->data.reserve(batch->maxBytes);
+        batch->deadline.reset();
+        batch->sending++;
+    }
+
+    size_t waitUs = 0;
+    auto altPoll = [&] { return drainCommandsWithBackoff(connection, session, &waitUs); };
+    status_t status = sendOnewayBatch(connection, session, &data, std::ref(altPoll));
+    finishSendingOnewayBatch(batch);
+    return status;
+}
+
+status_t RpcState::sendOnewayBatch(const sp<RpcSession::RpcConnection>& connection,
+                                   const sp<RpcSession>& session, std::vector<uint8_t>* data,
+                                   const std::optional<SmallFunction<status_t()>>& altPoll) {
+    RpcWireHeader command{
+            .command = RPC_COMMAND_TRANSACT_BATCH,
+            // bounded by RpcSession::setOnewayBatching
+            .bodySize = static_cast<uint32_t>(data->size()),
+    };
+    iovec iovs[]{
+            {&command, sizeof(command)},
+            {data->data(), data->size()},
+    };
+    bool wasSending = std::exchange(tSendingOnewayBatch, true);
+    status_t status = rpcSend(connection, session, "oneway batch", iovs, countof(iovs), altPoll);
+    tSendingOnewayBatch = wasSending;
+    return status;
+}
+
+status_t RpcState::sendTransactionBySharedMemory(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        const RpcWireTransaction& transaction, const Parcel& data,
+        Span<const uint32_t> objectTableSpan,
+        const std::optional<SmallFunction<status_t()>>& altPoll,
+        const std::vector<std::variant<unique_fd, borrowed_fd>>* parcelFds,
+        std::optional<size_t>* outOffset) {
+    if (connection->outgoingSharedMemory == nullptr) {
+        connection->outgoingSharedMemory = RpcSharedMemoryRegion::create(kSharedMemoryRegionSize);
+        // fall back to the socket
+        if (connection->outgoingSharedMemory == nullptr) return OK;
+    }
+    RpcSharedMemoryRegion* region = connection->outgoingSharedMemory.get();
+
+    size_t size = sizeof(RpcWireTransaction) + data.dataSize() + objectTableSpan.byteSize();
+    size_t offset = (region->used + alignof(RpcWireTransaction) - 1) &
+            ~(alignof(RpcWireTransaction) - 1);
+    if (offset > region->size() || region->size() - offset < size) {
+        LOG_RPC_DETAIL("No room for %zu byte transaction in shared memory (%zu used)", size,
+                       region->used);
+        return OK;
+    }
+
+    uint8_t* dest = region->data() + offset;
+    memcpy(dest, &transaction, sizeof(RpcWireTransaction));
+    dest += sizeof(RpcWireTransaction);
+    memcpy(dest, data.data(), data.dataSize());
+    dest += data.dataSize();
+    memcpy(dest, objectTableSpan.data, objectTableSpan.byteSize());
+
+    RpcWireSharedMemory body{
+            .offset = offset,
+            // bodySize didn't overflow in transactAddress => this cast is safe
+            .size = static_cast<uint32_t>(size),
+    };
+    RpcWireHeader command{
+            .command = RPC_COMMAND_TRANSACT_SHARED_MEMORY,
+            .bodySize = sizeof(RpcWireSharedMemory),
+    };
+
+    // The Parcel's file descriptors are sent as usual. The region's file
+    // descriptor follows them the first time the region is used.
+    std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+    const std::vector<std::variant<unique_fd, borrowed_fd>>* sendFds = parcelFds;
+    if (!region->sentToPeer) {
+        if (parcelFds != nullptr) {
+            for (const auto& fd : *parcelFds) {
+                fds.push_back(std::visit([](const auto& fd) { return borrowed_fd(fd); }, fd));
+            }
+        }
+        fds.push_back(region->fd());
+        sendFds = &fds;
+        body.options |= RPC_WIRE_SHARED_MEMORY_OPTION_NEW_REGION;
+        body.regionSize = region->size();
+    }
+
+    iovec iovs[]{
+            {&command, sizeof(command)},
+            {&body, sizeof(body)},
+    };
+    if (status_t status = rpcSend(connection, session, "shared memory transaction", iovs,
+                                  countof(iovs), altPoll, sendFds);
+        status != OK) {
+        return status;
+    }
+
+    region->sentToPeer = true;
+    *outOffset = region->used;
+    region->used = offset + size;
+    return OK;
 }
 
 static void cleanup_reply_data(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
@@ -755,6 +1033,18 @@ status_t RpcState::sendDecStrongToTarget(const sp<RpcSession::RpcConnection>& co
         // LOCK ALREADY RELEASED
     }
 
+    // Oneway transactions queued for this binder must reach the peer before
+    // the refcount which may let it drop the binder. Another thread may have
+    // taken them out of the batch already, on another connection, so also wait
+    // for it to finish writing them.
+    if (RpcOnewayBatch* batch = session->mOnewayBatch.get(); batch != nullptr) {
+        if (status_t status = flushOnewayBatch(connection, session); status != OK) return status;
+        if (!tSendingOnewayBatch) {
+            RpcMutexUniqueLock _l(batch->mutex);
+            batch->cv.wait(_l, [&] { return batch->sending == 0; });
+        }
+    }
+
     RpcWireHeader cmd = {
             .command = RPC_COMMAND_DEC_STRONG,
             .bodySize = sizeof(RpcDecStrong),
@@ -822,6 +1112,13 @@ status_t RpcState::processCommand(
             return processTransact(connection, session, command, std::move(ancillaryFds));
         case RPC_COMMAND_DEC_STRONG:
             return processDecStrong(connection, session, command);
+        case RPC_COMMAND_TRANSACT_BATCH:
+            if (type != CommandType::ANY) return BAD_TYPE;
+            return processTransactBatch(connection, session, command);
+        case RPC_COMMAND_TRANSACT_SHARED_MEMORY:
+            if (type != CommandType::ANY) return BAD_TYPE;
+            return processTransactSharedMemory(connection, session, command,
+                                               std::move(ancillaryFds));
     }
 
     // We should always know the version of the opposing side, and since the
@@ -852,6 +1149,115 @@ status_t RpcState::processTransact(
                                    std::move(ancillaryFds));
 }
 
+status_t RpcState::processTransactBatch(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<RpcSession>& session,
+                                        const RpcWireHeader& command) {
+    LOG_ALWAYS_FATAL_IF(command.command != RPC_COMMAND_TRANSACT_BATCH, "command: %d",
+                        command.command);
+
+    CommandData batchData(command.bodySize);
+    if (!batchData.valid()) {
+        return NO_MEMORY;
+    }
+    iovec iov{batchData.data(), batchData.size()};
+    if (status_t status = rpcRec(connection, session, "transaction batch", &iov, 1, nullptr);
+        status != OK)
+        return status;
+
+    // Transactions are processed in place. Any which have to wait for an
+    // earlier transaction to the same binder are copied out by
+    // processTransactInternal.
+    size_t offset = 0;
+    while (offset < batchData.size()) {
+        RpcWireHeader header;
+        bool valid = batchData.size() - offset >= sizeof(RpcWireHeader);
+        if (valid) {
+            memcpy(&header, batchData.data() + offset, sizeof(RpcWireHeader));
+            offset += sizeof(RpcWireHeader);
+            valid = header.command == RPC_COMMAND_TRANSACT &&
+                    header.bodySize >= sizeof(RpcWireTransaction) &&
+                    header.bodySize <= batchData.size() - offset &&
+                    (reinterpret_cast<RpcWireTransaction*>(batchData.data() + offset)->flags &
+                     IBinder::FLAG_ONEWAY);
+        }
+        if (!valid) {
+            ALOGE("Malformed transaction batch at offset %zu of %zu. Terminating!", offset,
+                  batchData.size());
+            (void)session->shutdownAndWait(false);
+            return BAD_VALUE;
+        }
+
+        if (status_t status =
+                    processTransactInternal(connection, session,
+                                            CommandData::borrow(batchData.data() + offset,
+                                                                header.bodySize),
+                                            {});
+            status != OK)
+            return status;
+
+        offset = std::min(batchData.size(), alignToBatch(offset + header.bodySize));
+    }
+    return OK;
+}
+
+status_t RpcState::processTransactSharedMemory(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        const RpcWireHeader& command,
+        std::vector<std::variant<unique_fd, borrowed_fd>>&& ancillaryFds) {
+    LOG_ALWAYS_FATAL_IF(command.command != RPC_COMMAND_TRANSACT_SHARED_MEMORY, "command: %d",
+                        command.command);
+
+    if (session->getSharedMemoryTransactionThreshold() == 0 ||
+        command.bodySize != sizeof(RpcWireSharedMemory)) {
+        ALOGE("Unexpected shared memory transaction (body size %" PRIu32 "). Terminating!",
+              command.bodySize);
+        (void)session->shutdownAndWait(false);
+        return BAD_VALUE;
+    }
+
+    RpcWireSharedMemory body;
+    iovec iov{&body, sizeof(body)};
+    if (status_t status = rpcRec(connection, session, "shared memory transaction", &iov, 1,
+                                 nullptr);
+        status != OK)
+        return status;
+
+    if (body.options & RPC_WIRE_SHARED_MEMORY_OPTION_NEW_REGION) {
+        if (ancillaryFds.empty() ||
+            !std::holds_alternative<unique_fd>(ancillaryFds.back()) ||
+            body.regionSize > kMaxIncomingSharedMemoryRegionSize) {
+            ALOGE("Invalid shared memory region (%zu fds, size %" PRIu64 "). Terminating!",
+                  ancillaryFds.size(), body.regionSize);
+            (void)session->shutdownAndWait(false);
+            return BAD_VALUE;
+        }
+        unique_fd fd = std::move(std::get<unique_fd>(ancillaryFds.back()));
+        ancillaryFds.pop_back();
+        connection->incomingSharedMemory =
+                RpcSharedMemoryRegion::map(std::move(fd), body.regionSize);
+    }
+
+    // keep the region mapped until we are done, even if the peer replaces it
+    std::shared_ptr<RpcSharedMemoryRegion> region = connection->incomingSharedMemory;
+    if (region == nullptr || body.offset > region->size() ||
+        region->size() - body.offset < body.size ||
+        body.offset % alignof(RpcWireTransaction) != 0) {
+        ALOGE("Shared memory transaction out of bounds (offset %" PRIu64 " size %" PRIu32
+              "). Terminating!",
+              body.offset, body.size);
+        (void)session->shutdownAndWait(false);
+        return BAD_VALUE;
+    }
+
+    // The peer can still write to the region, so the transaction is copied
+    // out of it before it is validated and parsed.
+    CommandData transactionData = CommandData::copy(region->data() + body.offset, body.size);
+    if (!transactionData.valid()) return NO_MEMORY;
+
+    return processTransactInternal(connection, session, std::move(transactionData),
+                                   std::move(ancillaryFds));
+}
+
 static void do_nothing_to_transact_data(const uint8_t* data, size_t dataSize,
                                         const binder_size_t* objects, size_t objectsCount) {
     (void)data;
@@ -864,6 +1270,10 @@ status_t RpcState::processTransactInternal(
         const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
         CommandData transactionData,
         std::vector<std::variant<unique_fd, borrowed_fd>>&& ancillaryFds) {
+    // The whole command has been read. Replies to nested transactions made
+    // while executing it may take as long as they need.
+    connection->incomingCommandPoll.reset();
+
     // for 'recursive' calls to this, we have already read and processed the
     // binder from the transaction data and taken reference counts into account,
     // so it is cached here.
@@ -915,6 +1325,14 @@ processTransactInternalTailCall:
             } else if (transaction->asyncNumber != it->second.asyncNumber) {
                 // we need to process some other asynchronous transaction
                 // first
+                if (transactionData.borrowed()) {
+                    // the data will be gone by the time this is processed
+                    CommandData copy(transactionData.size());
+                    if (!copy.valid()) return NO_MEMORY;
+                    memcpy(copy.data(), transactionData.data(), transactionData.size());
+                    transactionData = std::move(copy);
+                    transaction = reinterpret_cast<RpcWireTransaction*>(transactionData.data());
+                }
                 it->second.asyncTodo.push(BinderNode::AsyncTodo{
                         .ref = target,
                         .data = std::move(transactionData),
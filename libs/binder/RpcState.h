@@ -22,7 +22,9 @@
 #include <binder/RpcThreads.h>
 #include <binder/unique_fd.h>
 
+#include <chrono>
 #include <map>
+#include <memory>
 #include <optional>
 #include <queue>
 
@@ -31,6 +33,64 @@
 namespace android {
 
 struct RpcWireHeader;
+struct RpcWireTransaction;
+
+/**
+ * A memory region shared between the two ends of an RpcConnection, used to
+ * pass large transactions by reference. The sender writes transactions into
+ * its own region and the receiver maps it read-only, and copies transactions
+ * out of it before reading them since the sender can still write to it.
+ */
+class RpcSharedMemoryRegion {
+public:
+    static std::shared_ptr<RpcSharedMemoryRegion> create(size_t size);
+    static std::shared_ptr<RpcSharedMemoryRegion> map(binder::unique_fd fd, size_t size);
+    ~RpcSharedMemoryRegion();
+
+    uint8_t* data() const { return mData; }
+    size_t size() const { return mSize; }
+    binder::borrowed_fd fd() const { return mFd; }
+
+    // Transactions on a connection (including nested ones) complete in LIFO
+    // order, so the sender allocates from the region like a stack. This is
+    // the number of bytes still referenced by transactions the peer has not
+    // replied to yet.
+    size_t used = 0;
+    // Whether the region's file descriptor has been sent to the peer.
+    bool sentToPeer = false;
+
+private:
+    RpcSharedMemoryRegion(binder::unique_fd fd, uint8_t* data, size_t size)
+          : mFd(std::move(fd)), mData(data), mSize(size) {}
+
+    binder::unique_fd mFd;
+    uint8_t* mData;
+    size_t mSize;
+};
+
+/**
+ * Oneway transactions waiting to be written together, see
+ * RpcSession::setOnewayBatching. Shared with the thread which sends them when
+ * their latency budget runs out, which may outlive the session.
+ */
+struct RpcOnewayBatch {
+    RpcOnewayBatch(size_t maxBytes, std::chrono::microseconds maxDelay)
+          : maxBytes(maxBytes), maxDelay(maxDelay) {}
+
+    const size_t maxBytes;
+    const std::chrono::microseconds maxDelay;
+
+    RpcMutex mutex; // for below
+    RpcConditionVariable cv;
+    // RPC_COMMAND_TRANSACT commands, laid out as in RPC_COMMAND_TRANSACT_BATCH
+    std::vector<uint8_t> data;
+    // when 'data' must be sent by, if it isn't empty
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    // batches taken out of 'data' which are still being written, see
+    // RpcState::sendDecStrongToTarget
+    size_t sending = 0;
+    bool stopped = false;
+};
 
 /**
  * Log a lot more information about RPC calls, when debugging issues. Usually,
@@ -67,7 +127,8 @@ public:
     [[nodiscard]] static bool validateProtocolVersion(uint32_t version);
 
     [[nodiscard]] status_t readNewSessionResponse(const sp<RpcSession::RpcConnection>& connection,
-                                                  const sp<RpcSession>& session, uint32_t* version);
+                                                  const sp<RpcSession>& session, uint32_t* version,
+                                                  uint8_t* options);
     [[nodiscard]] status_t sendConnectionInit(const sp<RpcSession::RpcConnection>& connection,
                                               const sp<RpcSession>& session);
     [[nodiscard]] status_t readConnectionInit(const sp<RpcSession::RpcConnection>& connection,
@@ -122,6 +183,12 @@ public:
     [[nodiscard]] status_t drainCommands(const sp<RpcSession::RpcConnection>& connection,
                                          const sp<RpcSession>& session, CommandType type);
 
+    /**
+     * Sends any oneway transactions queued in the session's batch.
+     */
+    [[nodiscard]] status_t flushOnewayBatch(const sp<RpcSession::RpcConnection>& connection,
+                                            const sp<RpcSession>& session);
+
     /**
      * Called by Parcel for outgoing binders. This implies one refcount of
      * ownership to the outgoing binder.
@@ -178,14 +245,27 @@ private:
     // large allocations to avoid being requested from allocating too much data.
     struct CommandData {
         explicit CommandData(size_t size);
+        // Refers to data owned elsewhere which must outlive this object.
+        static CommandData borrow(uint8_t* data, size_t size);
+        // Copies data which the peer may still be writing to. Unlike
+        // CommandData(size_t), this doesn't limit the size of the allocation,
+        // so the caller must.
+        static CommandData copy(const uint8_t* data, size_t size);
+        CommandData(CommandData&& other) { *this = std::move(other); }
+        CommandData& operator=(CommandData&& other);
+        ~CommandData();
         bool valid() { return mSize == 0 || mData != nullptr; }
+        bool borrowed() { return mBorrowed; }
         size_t size() { return mSize; }
         uint8_t* data() { return mData.get(); }
         uint8_t* release() { return mData.release(); }
 
     private:
+        CommandData() = default;
+
         std::unique_ptr<uint8_t[]> mData;
-        size_t mSize;
+        size_t mSize = 0;
+        bool mBorrowed = false;
     };
 
     [[nodiscard]] status_t rpcSend(
@@ -200,6 +280,30 @@ private:
                                   std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>*
                                           ancillaryFds = nullptr);
 
+    // Used while waiting to send, in case the other side is blocked sending
+    // us refcounts. Sleeps between attempts, starting at *waitUs.
+    [[nodiscard]] status_t drainCommandsWithBackoff(const sp<RpcSession::RpcConnection>& connection,
+                                                    const sp<RpcSession>& session, size_t* waitUs);
+    // Adds a serialized oneway transaction to the session's batch, sending the
+    // batch first if there isn't room for it.
+    [[nodiscard]] status_t queueOnewayTransaction(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            iovec* iovs, int niovs,
+            const std::optional<binder::impl::SmallFunction<status_t()>>& altPoll);
+    [[nodiscard]] status_t sendOnewayBatch(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            std::vector<uint8_t>* data,
+            const std::optional<binder::impl::SmallFunction<status_t()>>& altPoll);
+    // Writes the transaction into the connection's shared memory region and
+    // sends a reference to it. If the region can't be used, *outOffset is left
+    // empty and the caller should send the transaction on the socket instead.
+    [[nodiscard]] status_t sendTransactionBySharedMemory(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const RpcWireTransaction& transaction, const Parcel& data,
+            Span<const uint32_t> objectTableSpan,
+            const std::optional<binder::impl::SmallFunction<status_t()>>& altPoll,
+            const std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>* parcelFds,
+            std::optional<size_t>* outOffset);
     [[nodiscard]] status_t waitForReply(const sp<RpcSession::RpcConnection>& connection,
                                         const sp<RpcSession>& session, Parcel* reply);
     [[nodiscard]] status_t processCommand(
@@ -210,6 +314,13 @@ private:
             const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
             const RpcWireHeader& command,
             std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>&& ancillaryFds);
+    [[nodiscard]] status_t processTransactBatch(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const RpcWireHeader& command);
+    [[nodiscard]] status_t processTransactSharedMemory(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const RpcWireHeader& command,
+            std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>&& ancillaryFds);
     [[nodiscard]] status_t processTransactInternal(
             const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
             CommandData transactionData,
@@ -21,6 +21,10 @@ namespace android {
 #pragma clang diagnostic error "-Wpadded"
 
 constexpr uint8_t RPC_CONNECTION_OPTION_INCOMING = 0x1; // default is outgoing
+// requests that large transactions be passed through shared memory, see RpcWireSharedMemory
+constexpr uint8_t RPC_CONNECTION_OPTION_SHARED_MEMORY = 0x2;
+// asks whether RPC_COMMAND_TRANSACT_BATCH is supported
+constexpr uint8_t RPC_CONNECTION_OPTION_ONEWAY_BATCH = 0x4;
 
 constexpr uint32_t RPC_WIRE_ADDRESS_OPTION_CREATED = 1 << 0; // distinguish from '0' address
 constexpr uint32_t RPC_WIRE_ADDRESS_OPTION_FOR_SERVER = 1 << 1;
@@ -57,9 +61,13 @@ static_assert(sizeof(RpcConnectionHeader) == 16);
  * In response to an RpcConnectionHeader which corresponds to a new session,
  * this returns information to the server.
  */
+constexpr uint8_t RPC_NEW_SESSION_RESPONSE_OPTION_SHARED_MEMORY = 0x1;
+constexpr uint8_t RPC_NEW_SESSION_RESPONSE_OPTION_ONEWAY_BATCH = 0x2;
+
 struct RpcNewSessionResponse {
     uint32_t version; // maximum supported by callee <= maximum supported by caller
-    uint8_t reserved[4];
+    uint8_t options;  // RPC_NEW_SESSION_RESPONSE_OPTION_*
+    uint8_t reserved[3];
 };
 static_assert(sizeof(RpcNewSessionResponse) == 8);
 
@@ -93,8 +101,23 @@ enum : uint32_t {
      * want to create a 'Parcel' object for every decref)
      */
     RPC_COMMAND_DEC_STRONG,
+    /**
+     * follows is RpcWireSharedMemory, which refers to an RpcWireTransaction
+     * in the sender's shared memory region. A reply is always expected. Only
+     * sent on sessions which negotiated RPC_CONNECTION_OPTION_SHARED_MEMORY.
+     */
+    RPC_COMMAND_TRANSACT_SHARED_MEMORY,
+    /**
+     * follows is a sequence of oneway RPC_COMMAND_TRANSACT commands (each an
+     * RpcWireHeader and RpcWireTransaction), each starting at an offset aligned
+     * to RPC_WIRE_BATCH_ALIGNMENT. Only sent on sessions which negotiated
+     * RPC_CONNECTION_OPTION_ONEWAY_BATCH.
+     */
+    RPC_COMMAND_TRANSACT_BATCH,
 };
 
+constexpr size_t RPC_WIRE_BATCH_ALIGNMENT = 8;
+
 /**
  * These commands are used when the address in an RpcWireTransaction is zero'd
  * out (no address). This allows the transact/reply flow to be used for
@@ -145,6 +168,24 @@ struct RpcWireTransaction {
 };
 static_assert(sizeof(RpcWireTransaction) == 40);
 
+// The last file descriptor sent with this command is the sender's shared
+// memory region for the connection. It is only sent once per connection.
+constexpr uint32_t RPC_WIRE_SHARED_MEMORY_OPTION_NEW_REGION = 1 << 0;
+
+struct RpcWireSharedMemory {
+    // Location of the RpcWireTransaction (followed by its Parcel data and
+    // object table) in the sender's shared memory region.
+    uint64_t offset;
+    uint32_t size;
+    uint32_t options; // RPC_WIRE_SHARED_MEMORY_OPTION_*
+
+    // Size of the shared memory region, if RPC_WIRE_SHARED_MEMORY_OPTION_NEW_REGION.
+    uint64_t regionSize;
+
+    uint32_t reserved[2];
+};
+static_assert(sizeof(RpcWireSharedMemory) == 32);
+
 struct RpcWireReply {
     int32_t status; // transact return
 
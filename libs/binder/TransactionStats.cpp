@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionStats"
+
+#include <binder/TransactionStats.h>
+
+#include <binder/Parcel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
+#include <log/log.h>
+#include <utils/String8.h>
+
+#include "file.h"
+
+namespace android::binder::debug {
+
+using Direction = TransactionStats::Direction;
+
+// Distinct interface/code/direction combinations recorded per thread.
+constexpr size_t kMaxKeysPerThread = 64;
+
+namespace {
+
+// Only ever written by the thread owning its Shard. Readers may see a
+// transaction partially recorded, which is fine for statistics.
+struct Slot {
+    // 0 while unused. Set last, so that the fields below are visible to
+    // readers which see it.
+    std::atomic<uint64_t> key = 0;
+    std::string interface;
+    uint32_t code = 0;
+    Direction direction = Direction::OUTGOING;
+
+    std::atomic<uint64_t> count = 0;
+    std::atomic<int64_t> totalLatency = 0;
+    std::atomic<int64_t> maxLatency = 0;
+    std::atomic<uint64_t> totalSize = 0;
+    std::array<std::atomic<uint64_t>, TransactionStats::kNumLatencyBuckets> latencyBuckets{};
+    std::array<std::atomic<uint64_t>, TransactionStats::kNumSizeBuckets> sizeBuckets{};
+};
+
+struct Shard {
+    // whether a live thread records into this
+    std::atomic<bool> owned = false;
+    std::array<Slot, kMaxKeysPerThread> slots;
+    // transactions which didn't fit in 'slots'
+    std::atomic<uint64_t> dropped = 0;
+};
+
+// Not trivially destructible, so kept apart from tShard, which may still be
+// used by transactions made from TLS destructors that run after this.
+struct ShardReleaser {
+    Shard* shard = nullptr;
+    ~ShardReleaser();
+};
+
+} // namespace
+
+static std::atomic<bool> gEnabled = false;
+
+static std::mutex gShardsLock;
+// never freed, since readers may be looking at them
+static std::vector<std::unique_ptr<Shard>> gShards;
+
+static thread_local Shard* tShard = nullptr;
+static thread_local bool tShardReleased = false;
+static thread_local ShardReleaser tShardReleaser;
+
+ShardReleaser::~ShardReleaser() {
+    if (shard == nullptr) return;
+    // another thread may take it over from here
+    tShard = nullptr;
+    tShardReleased = true;
+    shard->owned.store(false, std::memory_order_release);
+}
+
+// The only writer, so this doesn't need an atomic read-modify-write.
+template <typename T>
+static void add(std::atomic<T>& value, T amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+template <size_t N>
+static size_t bucketFor(uint64_t value) {
+    size_t bits = 0;
+    while (value != 0 && bits < N - 1) {
+        value >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+static uint64_t makeKey(Direction direction, const char16_t* interface, size_t interfaceLen,
+                        uint32_t code) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    for (size_t i = 0; i < interfaceLen; i++) mix(interface[i]);
+    mix(code);
+    mix(static_cast<uint64_t>(direction));
+    return hash == 0 ? 1 : hash;
+}
+
+static Shard* currentShard() {
+    if (tShard != nullptr || tShardReleased) return tShard;
+
+    std::lock_guard<std::mutex> _l(gShardsLock);
+    for (auto& shard : gShards) {
+        bool owned = false;
+        if (shard->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+            tShard = shard.get();
+            break;
+        }
+    }
+    if (tShard == nullptr) {
+        gShards.push_back(std::make_unique<Shard>());
+        tShard = gShards.back().get();
+        tShard->owned.store(true, std::memory_order_relaxed);
+    }
+    tShardReleaser.shard = tShard;
+    return tShard;
+}
+
+void TransactionStats::setEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TransactionStats::isEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void TransactionStats::record(Direction direction, const char16_t* interface, size_t interfaceLen,
+                              uint32_t code, nsecs_t latency, size_t dataSize) {
+    if (!isEnabled()) return;
+
+    Shard* shard = currentShard();
+    if (shard == nullptr) return;
+
+    uint64_t key = makeKey(direction, interface, interfaceLen, code);
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < kMaxKeysPerThread; i++) {
+        Slot& candidate = shard->slots[(key + i) % kMaxKeysPerThread];
+        uint64_t candidateKey = candidate.key.load(std::memory_order_relaxed);
+        if (candidateKey == key) {
+            slot = &candidate;
+            break;
+        }
+        if (candidateKey == 0) {
+            candidate.interface =
+                    interface == nullptr ? "" : String8(interface, interfaceLen).c_str();
+            candidate.code = code;
+            candidate.direction = direction;
+            candidate.key.store(key, std::memory_order_release);
+            slot = &candidate;
+            break;
+        }
+    }
+    if (slot == nullptr) {
+        add<uint64_t>(shard->dropped, 1);
+        return;
+    }
+
+    add<uint64_t>(slot->count, 1);
+    add<int64_t>(slot->totalLatency, latency);
+    if (latency > slot->maxLatency.load(std::memory_order_relaxed)) {
+        slot->maxLatency.store(latency, std::memory_order_relaxed);
+    }
+    add<uint64_t>(slot->totalSize, dataSize);
+    add<uint64_t>(slot->latencyBuckets[bucketFor<kNumLatencyBuckets>(
+                          static_cast<uint64_t>(std::max<nsecs_t>(latency, 0)) / 1000)],
+                  1);
+    add<uint64_t>(slot->sizeBuckets[bucketFor<kNumSizeBuckets>(dataSize / 64)], 1);
+}
+
+std::vector<TransactionStats::Histogram> TransactionStats::collect() {
+    std::map<uint64_t, Histogram> merged;
+
+    std::lock_guard<std::mutex> _l(gShardsLock);
+    for (const auto& shard : gShards) {
+        for (const Slot& slot : shard->slots) {
+            uint64_t key = slot.key.load(std::memory_order_acquire);
+            if (key == 0) continue;
+
+            Histogram& histogram = merged[key];
+            histogram.interface = slot.interface;
+            histogram.code = slot.code;
+            histogram.direction = slot.direction;
+            histogram.count += slot.count.load(std::memory_order_relaxed);
+            histogram.totalLatency += slot.totalLatency.load(std::memory_order_relaxed);
+            histogram.maxLatency =
+                    std::max(histogram.maxLatency, slot.maxLatency.load(std::memory_order_relaxed));
+            histogram.totalSize += slot.totalSize.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < kNumLatencyBuckets; i++) {
+                histogram.latencyBuckets[i] +=
+                        slot.latencyBuckets[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < kNumSizeBuckets; i++) {
+                histogram.sizeBuckets[i] += slot.sizeBuckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::vector<Histogram> histograms;
+    histograms.reserve(merged.size());
+    for (auto& [key, histogram] : merged) histograms.push_back(std::move(histogram));
+    std::sort(histograms.begin(), histograms.end(), [](const Histogram& a, const Histogram& b) {
+        return std::tie(a.interface, a.code, a.direction) <
+                std::tie(b.interface, b.code, b.direction);
+    });
+    return histograms;
+}
+
+status_t TransactionStats::dump(binder::borrowed_fd fd) {
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> _l(gShardsLock);
+        for (const auto& shard : gShards) dropped += shard->dropped.load(std::memory_order_relaxed);
+    }
+
+    std::stringstream ss;
+    ss << "Binder transaction stats (" << (isEnabled() ? "enabled" : "disabled") << ", "
+       << dropped << " transactions not recorded):\n";
+    // Recorded whether or not stats are enabled, and cheap enough to always include.
+    ss << "  " << Parcel::getBufferPoolStats().toString() << "\n";
+    for (const Histogram& h : collect()) {
+        ss << (h.direction == Direction::OUTGOING ? "  outgoing " : "  incoming ")
+           << (h.interface.empty() ? "<no interface>" : h.interface) << " code " << h.code << ": "
+           << h.count << " calls, avg " << (h.count ? h.totalLatency / h.count / 1000 : 0)
+           << "us, max " << h.maxLatency / 1000 << "us, avg "
+           << (h.count ? h.totalSize / h.count : 0) << " bytes\n";
+        ss << "    latency (us):";
+        for (size_t i = 0; i < kNumLatencyBuckets; i++) {
+            if (h.latencyBuckets[i] == 0) continue;
+            if (i + 1 == kNumLatencyBuckets) {
+                ss << " >=" << (1ULL << (i - 1)) << ":" << h.latencyBuckets[i];
+            } else {
+                ss << " <" << (1ULL << i) << ":" << h.latencyBuckets[i];
+            }
+        }
+        ss << "\n    size (bytes):";
+        for (size_t i = 0; i < kNumSizeBuckets; i++) {
+            if (h.sizeBuckets[i] == 0) continue;
+            if (i + 1 == kNumSizeBuckets) {
+                ss << " >=" << (64ULL << (i - 1)) << ":" << h.sizeBuckets[i];
+            } else {
+                ss << " <" << (64ULL << i) << ":" << h.sizeBuckets[i];
+            }
+        }
+        ss << "\n";
+    }
+
+    std::string text = ss.str();
+    if (!WriteFully(fd, text.data(), text.size())) {
+        ALOGE("Failed to write transaction stats to fd %d", fd.get());
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
+
+} // namespace android::binder::debug
@@ -228,6 +228,9 @@ private:
     static void freeBuffer(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
                            size_t objectsSize);
     static  void                logExtendedError();
+    // For binder::debug::TransactionStats, with 'startTime' from SYSTEM_TIME_MONOTONIC.
+    static  void                recordTransactionStats(bool incoming, uint32_t code,
+                                                       const Parcel& data, int64_t startTime);
 
     const   sp<ProcessState>    mProcess;
             Vector<BBinder*>    mPendingStrongDerefs;
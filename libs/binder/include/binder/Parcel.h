@@ -83,6 +83,10 @@ public:
     // Writing over objects, such as file descriptors and binders, is not supported.
     void                setDataPosition(size_t pos) const;
     status_t            setDataCapacity(size_t size);
+    // Makes sure 'len' more bytes can be written at dataPosition() without
+    // growing the buffer again. For generated code, which knows the size of
+    // what it is about to write.
+    status_t            reserveForWrite(size_t len);
 
     status_t            setData(const uint8_t* buffer, size_t len);
 
@@ -603,6 +607,19 @@ public:
     static size_t       getGlobalAllocSize();
     static size_t       getGlobalAllocCount();
 
+    // Debugging: metrics on the per-thread caches that Parcel data buffers are
+    // drawn from and returned to, summed over all threads.
+    struct BufferPoolStats {
+        size_t hits = 0;        // buffers reused from a cache
+        size_t misses = 0;      // buffers allocated with malloc
+        size_t cachedCount = 0; // buffers currently cached
+        size_t cachedSize = 0;  // bytes currently cached
+
+        // for TransactionStats::dump()
+        std::string toString() const;
+    };
+    static BufferPoolStats getBufferPoolStats();
+
     bool                replaceCallingWorkSourceUid(uid_t uid);
     // Returns the work source provided by the caller. This can only be trusted for trusted calling
     // uid.
@@ -647,6 +664,9 @@ private:
     status_t            validateReadData(size_t len) const;
 
     void                updateWorkSourceRequestHeaderPosition() const;
+    // Reads the descriptor written by writeInterfaceToken, without moving
+    // the data position. Returns nullptr if the data doesn't start with one.
+    const char16_t*     peekInterfaceToken(size_t* outLen) const;
 
     status_t            finishFlattenBinder(const sp<IBinder>& binder);
     status_t            finishUnflattenBinder(const sp<IBinder>& binder, sp<IBinder>* out) const;
@@ -42,6 +42,11 @@ public:
 
     [[nodiscard]] status_t dumpToFile(const binder::unique_fd& fd) const;
 
+    // Sends the recorded data to 'binder' again, with the recorded code and
+    // flags. With TransactionStats enabled, this measures the latency of the
+    // recorded call against a live service.
+    status_t replay(const sp<IBinder>& binder, Parcel* reply = nullptr) const;
+
     const std::string& getInterfaceName() const;
     uint32_t getCode() const;
     uint32_t getFlags() const;
@@ -24,12 +24,14 @@
 #include <utils/RefBase.h>
 
 #include <bitset>
+#include <chrono>
 #include <mutex>
 #include <thread>
 
 namespace android {
 
 class FdTrigger;
+class RpcDispatcher;
 class RpcServerTrusty;
 class RpcSocketAddress;
 
@@ -149,6 +151,47 @@ public:
     void setSupportedFileDescriptorTransportModes(
             const std::vector<RpcSession::FileDescriptorTransportMode>& modes);
 
+    /**
+     * Allow clients to pass large transactions through shared memory, see
+     * RpcSession::setSharedMemoryTransactionThreshold. Only used for sessions
+     * with FileDescriptorTransportMode::UNIX where the client also enables
+     * it. 0 (the default) disables this.
+     *
+     * This applies to every client of this server. Transactions received
+     * through shared memory are not subject to the socket transaction size
+     * limit, so a client can make the server allocate up to the size of its
+     * region (at most 64MB) per transaction. Only enable this if all clients
+     * are trusted.
+     */
+    void setSharedMemoryTransactionThreshold(size_t bytes);
+
+    /**
+     * By default, each incoming connection is served by its own thread. If
+     * threads is non-zero, connections are instead watched with epoll and
+     * their commands are processed by a shared pool of this many threads
+     * (e.g. the number of cores), which steal work from each other when idle.
+     * This lets a server handle many mostly idle clients with few threads.
+     *
+     * Commands on each connection are still processed in order, and oneway
+     * transactions to each binder are still processed in the order they were
+     * sent. A transaction which blocks ties up a pool thread, though. A
+     * client which stops partway through a command has its session shut
+     * down after a while, see setDispatchCommandTimeout.
+     *
+     * Must be called before join(). Not supported on single-threaded
+     * libbinder.
+     */
+    void setDispatchThreads(size_t threads);
+
+    /**
+     * With dispatch threads, how long a client has to send the rest of a
+     * command once it has started sending it. Past this, its session is shut
+     * down, so that it can't tie up a pool thread for longer. Default is 10s.
+     *
+     * Must be called before join().
+     */
+    void setDispatchCommandTimeout(std::chrono::milliseconds timeout);
+
     /**
      * The root object can be retrieved by any client, without any
      * authentication. TODO(b/183988761)
@@ -268,6 +311,9 @@ private:
     // A mode is supported if the N'th bit is on, where N is the mode enum's value.
     std::bitset<8> mSupportedFileDescriptorTransportModes = std::bitset<8>().set(
             static_cast<size_t>(RpcSession::FileDescriptorTransportMode::NONE));
+    size_t mSharedMemoryTransactionThreshold = 0;
+    size_t mDispatchThreads = 0;
+    std::chrono::milliseconds mDispatchCommandTimeout = std::chrono::seconds(10);
     RpcTransportFd mServer; // socket we are accepting sessions on
 
     RpcMutex mLock; // for below
@@ -284,6 +330,8 @@ private:
     std::unique_ptr<FdTrigger> mShutdownTrigger;
     RpcConditionVariable mShutdownCv;
     std::function<status_t(const RpcServer& server, RpcTransportFd* out)> mAcceptFn;
+    // shared so that connection threads can finish handing off connections
+    std::shared_ptr<RpcDispatcher> mDispatcher;
 };
 
 } // namespace android
@@ -22,6 +22,7 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 
+#include <chrono>
 #include <map>
 #include <optional>
 #include <vector>
@@ -29,8 +30,11 @@
 namespace android {
 
 class Parcel;
+class RpcDispatcher;
 class RpcServer;
 class RpcServerTrusty;
+class RpcSharedMemoryRegion;
+struct RpcOnewayBatch;
 class RpcSocketAddress;
 class RpcState;
 class RpcTransport;
@@ -114,6 +118,41 @@ public:
     void setFileDescriptorTransportMode(FileDescriptorTransportMode mode);
     FileDescriptorTransportMode getFileDescriptorTransportMode();
 
+    /**
+     * Twoway transactions of at least this many bytes are passed through
+     * memory shared with the other process instead of being copied through
+     * the socket. This also allows transactions larger than the socket
+     * transaction size limit. 0 (the default) disables this.
+     *
+     * Requires FileDescriptorTransportMode::UNIX, and the server must also
+     * enable it (see RpcServer::setSharedMemoryTransactionThreshold), otherwise
+     * transactions are sent on the socket as usual. The receiver copies each
+     * transaction out of the shared memory before reading it, but it does so
+     * without the socket transaction size limit, so a peer can make it
+     * allocate up to the size of the region per transaction. This should only
+     * be used between processes which trust each other.
+     */
+    void setSharedMemoryTransactionThreshold(size_t bytes);
+    size_t getSharedMemoryTransactionThreshold();
+
+    /**
+     * Coalesce oneway transactions into batches of up to maxBatchBytes which
+     * are written to the connection together. A batch is sent when it is full,
+     * when a twoway transaction is made on this session, before a reference to
+     * a remote binder is released, or at most maxDelay after its first
+     * transaction was queued. Oneway transactions which carry
+     * file descriptors are never batched.
+     *
+     * Ordering of oneway transactions to each binder is preserved. Batched
+     * transactions which have not been sent when the session shuts down are
+     * dropped.
+     *
+     * If the server doesn't support batches, transactions are sent one at a
+     * time as usual. Not supported on single-threaded libbinder.
+     */
+    [[nodiscard]] status_t setOnewayBatching(size_t maxBatchBytes,
+                                             std::chrono::microseconds maxDelay);
+
     /**
      * This should be called once per thread, matching 'join' in the remote
      * process.
@@ -216,8 +255,14 @@ public:
     // internal only
     const std::unique_ptr<RpcState>& state() { return mRpcBinderState; }
 
+    // Sends queued oneway transactions once their latency budget runs out.
+    static void onewayBatchFlusherLoop(const wp<RpcSession>& weakSession,
+                                       const std::shared_ptr<RpcOnewayBatch>& batch);
+    void stopOnewayBatching();
+
 private:
     friend sp<RpcSession>;
+    friend RpcDispatcher;
     friend RpcServer;
     friend RpcServerTrusty;
     friend RpcState;
@@ -258,6 +303,15 @@ private:
         std::optional<uint64_t> exclusiveTid;
 
         bool allowNested = false;
+
+        // Used instead of polling the transport while reading an incoming
+        // command, until it starts executing, see RpcDispatcher.
+        std::optional<binder::impl::SmallFunction<status_t()>> incomingCommandPoll;
+
+        // Regions for transactions sent/received through shared memory, see
+        // setSharedMemoryTransactionThreshold.
+        std::shared_ptr<RpcSharedMemoryRegion> outgoingSharedMemory;
+        std::shared_ptr<RpcSharedMemoryRegion> incomingSharedMemory;
     };
 
     [[nodiscard]] status_t readId();
@@ -280,6 +334,12 @@ private:
     PreJoinSetupResult preJoinSetup(std::unique_ptr<RpcTransport> rpcTransport);
     // join on thread passed to preJoinThreadOwnership
     static void join(sp<RpcSession>&& session, PreJoinSetupResult&& result);
+    // Cleans up after serving an incoming connection ends. connection may be
+    // null if setup failed.
+    static void releaseIncomingConnection(sp<RpcSession>&& session,
+                                          const sp<RpcConnection>& connection);
+    // For threads which serve connections other than through join.
+    static void runAttachedToJavaVm(const std::function<void()>& fn);
 
     [[nodiscard]] status_t setupClient(
             const std::function<status_t(const std::vector<uint8_t>& sessionId, bool incoming)>&
@@ -377,6 +437,12 @@ private:
     size_t mMaxOutgoingConnections = kDefaultMaxOutgoingConnections;
     std::optional<uint32_t> mProtocolVersion;
     FileDescriptorTransportMode mFileDescriptorTransportMode = FileDescriptorTransportMode::NONE;
+    // after setup, only non-zero if the server agreed to use shared memory
+    size_t mSharedMemoryTransactionThreshold = 0;
+    size_t mOnewayBatchMaxBytes = 0;
+    std::chrono::microseconds mOnewayBatchMaxDelay{0};
+    // only set if the server agreed to receive batches, after setup
+    std::shared_ptr<RpcOnewayBatch> mOnewayBatch;
 
     RpcConditionVariable mAvailableConnectionCv; // for mWaitingThreads
 
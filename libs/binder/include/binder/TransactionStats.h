@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/unique_fd.h>
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace android {
+
+namespace binder::debug {
+
+/**
+ * Histograms of the latency and data size of the binder transactions a
+ * process makes and serves through IPCThreadState, by interface and
+ * transaction code. This is meant to find slow calls in production, without
+ * enabling tracing.
+ *
+ * Off by default. When enabled, each thread records into its own table
+ * without locks, and the tables of all threads are only merged when read.
+ * Tables are kept after their thread exits, and are reused by new threads.
+ */
+class TransactionStats {
+public:
+    enum class Direction : uint8_t {
+        // from IPCThreadState::transact, until the reply is received
+        OUTGOING,
+        // the time the target binder took to handle the transaction
+        INCOMING,
+    };
+
+    // Bucket 0 counts latencies below 1us, and bucket i > 0 latencies from
+    // 2^(i-1)us to below 2^i us. The last bucket counts everything above.
+    static constexpr size_t kNumLatencyBuckets = 20;
+    // Bucket 0 counts data below 64 bytes, and bucket i > 0 data from
+    // 64 * 2^(i-1) bytes to below 64 * 2^i bytes. The last bucket counts
+    // everything above.
+    static constexpr size_t kNumSizeBuckets = 12;
+
+    struct Histogram {
+        // from the interface token of the data, empty if it has none
+        std::string interface;
+        uint32_t code = 0;
+        Direction direction = Direction::OUTGOING;
+
+        uint64_t count = 0;
+        nsecs_t totalLatency = 0;
+        nsecs_t maxLatency = 0;
+        // of the data Parcel
+        uint64_t totalSize = 0;
+        std::array<uint64_t, kNumLatencyBuckets> latencyBuckets{};
+        std::array<uint64_t, kNumSizeBuckets> sizeBuckets{};
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // Merges the histograms of all threads, sorted by interface and code.
+    static std::vector<Histogram> collect();
+    // Writes collect() to 'fd' as text, e.g. from IBinder::dump, along with
+    // Parcel::getBufferPoolStats().
+    static status_t dump(binder::borrowed_fd fd);
+
+    // For libbinder. Does nothing unless enabled.
+    static void record(Direction direction, const char16_t* interface, size_t interfaceLen,
+                       uint32_t code, nsecs_t latency, size_t dataSize);
+
+private:
+    TransactionStats() = delete;
+};
+
+} // namespace binder::debug
+
+} // namespace android
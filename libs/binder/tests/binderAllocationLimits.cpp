@@ -221,6 +221,67 @@ TEST(BinderAllocation, SmallTransaction) {
     });
     manager->checkService(empty_descriptor);
 
+    // none if the Parcel buffer is still cached from an earlier transaction
+    EXPECT_LE(mallocs, 1);
+}
+
+TEST(BinderAllocation, SmallTransactionSteadyState) {
+    String16 empty_descriptor = String16("");
+    sp<IServiceManager> manager = defaultServiceManager();
+    manager->checkService(empty_descriptor); // caches a Parcel buffer on this thread
+
+    size_t hitsBefore = Parcel::getBufferPoolStats().hits;
+    {
+        const auto m = ScopeDisallowMalloc();
+        for (size_t i = 0; i < 10; i++) {
+            manager->checkService(empty_descriptor);
+        }
+    }
+    EXPECT_GE(Parcel::getBufferPoolStats().hits, hitsBefore + 10);
+}
+
+TEST(BinderAllocation, ParcelBufferReused) {
+    {
+        Parcel p;
+        p.writeInt32(0);
+    }
+
+    const auto m = ScopeDisallowMalloc();
+    for (size_t i = 0; i < 10; i++) {
+        Parcel p;
+        p.writeInt32(i);
+        imaginary_use = p.data();
+    }
+}
+
+TEST(BinderAllocation, ParcelGrowthSteadyState) {
+    auto writeInts = [](size_t count) {
+        Parcel p;
+        for (size_t i = 0; i < count; i++) p.writeInt32(i);
+        imaginary_use = p.data();
+    };
+    writeInts(1000); // grows through several sizes, caching each buffer
+
+    const auto m = ScopeDisallowMalloc();
+    for (size_t i = 0; i < 10; i++) {
+        writeInts(1000);
+    }
+}
+
+TEST(BinderAllocation, ParcelReserveForWrite) {
+    constexpr size_t kNumInts = 16 * 1024;
+
+    size_t mallocs = 0;
+    const auto on_malloc = OnMalloc([&](size_t) { mallocs++; });
+
+    // larger than any cached buffer, so this always allocates, but only once
+    Parcel p;
+    ASSERT_EQ(OK, p.reserveForWrite(kNumInts * sizeof(int32_t)));
+    for (size_t i = 0; i < kNumInts; i++) {
+        ASSERT_EQ(OK, p.writeInt32(i));
+    }
+    imaginary_use = p.data();
+
     EXPECT_EQ(mallocs, 1);
 }
 
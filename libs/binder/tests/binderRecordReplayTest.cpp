@@ -22,6 +22,7 @@
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
 #include <binder/RecordedTransaction.h>
+#include <binder/TransactionStats.h>
 #include <binder/unique_fd.h>
 
 #include <fuzzbinder/libbinder_driver.h>
@@ -41,6 +42,7 @@ using android::binder::borrowed_fd;
 using android::binder::Status;
 using android::binder::unique_fd;
 using android::binder::debug::RecordedTransaction;
+using android::binder::debug::TransactionStats;
 using parcelables::SingleDataParcelable;
 
 const String16 kServerName = String16("binderRecordReplay");
@@ -122,13 +124,8 @@ void replayFuzzService(const sp<BpBinder>& binder, const RecordedTransaction& tr
 }
 
 void replayBinder(const sp<BpBinder>& binder, const RecordedTransaction& transaction) {
-    // TODO: move logic to replay RecordedTransaction into RecordedTransaction
-    Parcel data;
-    data.setData(transaction.getDataParcel().data(), transaction.getDataParcel().dataSize());
-    auto result = binder->transact(transaction.getCode(), data, nullptr, transaction.getFlags());
-
     // make sure recording does the thing we expect it to do
-    EXPECT_EQ(OK, result);
+    EXPECT_EQ(OK, transaction.replay(binder));
 }
 
 class BinderRecordReplayTest : public ::testing::Test {
@@ -319,6 +316,58 @@ TEST_F(BinderRecordReplayTest, ReplaySingleDataParcelableArray) {
                  &IBinderRecordReplayTest::getSingleDataParcelableArray, changed);
 }
 
+TEST_F(BinderRecordReplayTest, ReplayRecordsTransactionStats) {
+    unique_fd fd(open("/data/local/tmp/binderRecordReplayTest.rec",
+                      O_RDWR | O_CREAT | O_CLOEXEC | O_TRUNC, 0666));
+    ASSERT_TRUE(fd.ok());
+
+    mBpBinder->startRecordingBinder(fd);
+    EXPECT_TRUE(mInterface->setInt(3).isOk());
+    mBpBinder->stopRecordingBinder();
+
+    ASSERT_EQ(0, lseek(fd.get(), 0, SEEK_SET));
+    std::optional<RecordedTransaction> transaction = RecordedTransaction::fromFile(fd);
+    ASSERT_NE(transaction, std::nullopt);
+
+    constexpr size_t kNumReplays = 10;
+    TransactionStats::setEnabled(true);
+    for (size_t i = 0; i < kNumReplays; i++) {
+        EXPECT_EQ(OK, transaction->replay(mBpBinder));
+    }
+    TransactionStats::setEnabled(false);
+
+    bool found = false;
+    for (const auto& histogram : TransactionStats::collect()) {
+        if (histogram.direction != TransactionStats::Direction::OUTGOING ||
+            histogram.interface != transaction->getInterfaceName() ||
+            histogram.code != transaction->getCode()) {
+            continue;
+        }
+        found = true;
+        EXPECT_EQ(kNumReplays, histogram.count);
+        EXPECT_GT(histogram.totalLatency, 0);
+        EXPECT_GE(histogram.totalSize, kNumReplays * transaction->getDataParcel().dataSize());
+
+        uint64_t bucketed = 0;
+        for (uint64_t bucket : histogram.latencyBuckets) bucketed += bucket;
+        EXPECT_EQ(kNumReplays, bucketed);
+    }
+    EXPECT_TRUE(found) << "no stats for " << transaction->getInterfaceName();
+
+    unique_fd dumpFd(open("/data/local/tmp/binderRecordReplayTest.dump",
+                          O_RDWR | O_CREAT | O_CLOEXEC | O_TRUNC, 0666));
+    ASSERT_TRUE(dumpFd.ok());
+    EXPECT_EQ(OK, TransactionStats::dump(dumpFd));
+
+    const off_t dumpSize = lseek(dumpFd.get(), 0, SEEK_CUR);
+    ASSERT_GT(dumpSize, 0);
+    std::string dump(static_cast<size_t>(dumpSize), '\0');
+    ASSERT_EQ(0, lseek(dumpFd.get(), 0, SEEK_SET));
+    ASSERT_TRUE(binder::ReadFully(dumpFd, dump.data(), dump.size()));
+    EXPECT_NE(std::string::npos, dump.find(transaction->getInterfaceName()));
+    EXPECT_NE(std::string::npos, dump.find("Parcel buffer pool: "));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
 
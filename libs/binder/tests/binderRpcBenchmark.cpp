@@ -31,6 +31,7 @@
 #include <binder/RpcTransportTls.h>
 #include <openssl/ssl.h>
 
+#include <chrono>
 #include <thread>
 
 #include <signal.h>
@@ -74,6 +75,14 @@ class MyBinderRpcBenchmark : public BnBinderRpcBenchmark {
         *out = bytes;
         return Status::ok();
     }
+    Status countBytes(const std::vector<uint8_t>& bytes, int64_t* out) override {
+        *out = bytes.size();
+        return Status::ok();
+    }
+    Status consumeBytes(const std::vector<uint8_t>& bytes) override {
+        (void)bytes;
+        return Status::ok();
+    }
 
     class CountedBinder : public BBinder {
     public:
@@ -118,6 +127,8 @@ enum Transport {
     KERNEL,
     RPC,
     RPC_TLS,
+    RPC_SHARED_MEMORY,
+    RPC_ONEWAY_BATCH,
 };
 
 static const std::initializer_list<int64_t> kTransportList = {
@@ -126,8 +137,13 @@ static const std::initializer_list<int64_t> kTransportList = {
 #endif
         Transport::RPC,
         Transport::RPC_TLS,
+        Transport::RPC_SHARED_MEMORY,
+        Transport::RPC_ONEWAY_BATCH,
 };
 
+// Transactions at least this large use shared memory with RPC_SHARED_MEMORY.
+static constexpr size_t kSharedMemoryTransactionThreshold = 64 * 1024;
+
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
     auto pkey = android::makeKeyPairForSelfSignedCert();
     CHECK_NE(pkey.get(), nullptr);
@@ -145,6 +161,10 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+static sp<RpcSession> gSessionSharedMemory = RpcSession::make();
+static sp<IBinder> gRpcSharedMemoryBinder;
+static sp<RpcSession> gSessionOnewayBatch = RpcSession::make();
+static sp<IBinder> gRpcOnewayBatchBinder;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
@@ -161,6 +181,10 @@ static sp<IBinder> getBinderForOptions(benchmark::State& state) {
             return gRpcBinder;
         case RPC_TLS:
             return gRpcTlsBinder;
+        case RPC_SHARED_MEMORY:
+            return gRpcSharedMemoryBinder;
+        case RPC_ONEWAY_BATCH:
+            return gRpcOnewayBatchBinder;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
             return nullptr;
@@ -181,6 +205,12 @@ static void SetLabel(benchmark::State& state) {
         case RPC_TLS:
             state.SetLabel("rpc_tls");
             break;
+        case RPC_SHARED_MEMORY:
+            state.SetLabel("rpc_shm");
+            break;
+        case RPC_ONEWAY_BATCH:
+            state.SetLabel("rpc_oneway_batch");
+            break;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
     }
@@ -250,6 +280,71 @@ BENCHMARK(BM_throughputForTransportAndBytes)
         ->ArgsProduct({kTransportList,
                        {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537}});
 
+// Only the request is large here, so this measures one direction of the
+// transfer, and works with payloads beyond what the socket transports allow.
+void BM_sendLargePayload(benchmark::State& state) {
+    Transport transport = static_cast<Transport>(state.range(0));
+    const size_t payloadBytes = state.range(1);
+
+    // RPC over sockets limits transactions to 100KB, and kernel binder shares
+    // a 1MB buffer between all transactions of the process.
+    size_t maxPayloadBytes = 96 * 1024;
+    if (transport == RPC_SHARED_MEMORY) maxPayloadBytes = 8 * 1024 * 1024;
+#ifdef __BIONIC__
+    if (transport == KERNEL) maxPayloadBytes = 512 * 1024;
+#endif
+    if (payloadBytes > maxPayloadBytes) {
+        state.SkipWithError("payload too large for transport");
+        return;
+    }
+
+    sp<IBinder> binder = getBinderForOptions(state);
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(payloadBytes);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = i % 256;
+    }
+
+    while (state.KeepRunning()) {
+        int64_t out;
+        Status ret = iface->countBytes(bytes, &out);
+        CHECK(ret.isOk()) << ret;
+        CHECK_EQ(out, static_cast<int64_t>(bytes.size()));
+    }
+
+    state.SetBytesProcessed(state.iterations() * payloadBytes);
+    SetLabel(state);
+}
+BENCHMARK(BM_sendLargePayload)
+        ->ArgsProduct({kTransportList,
+                       {4 * 1024, 16 * 1024, 64 * 1024, 96 * 1024, 256 * 1024, 1024 * 1024,
+                        4 * 1024 * 1024}});
+
+// Many small oneway calls followed by a twoway call, which can only complete
+// once the oneway calls before it have been processed.
+void BM_onewayThroughput(benchmark::State& state) {
+    sp<IBinder> binder = getBinderForOptions(state);
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+
+    constexpr size_t kCallsPerIteration = 100;
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(state.range(1));
+
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < kCallsPerIteration; i++) {
+            Status ret = iface->consumeBytes(bytes);
+            CHECK(ret.isOk()) << ret;
+        }
+        CHECK_EQ(OK, binder->pingBinder());
+    }
+
+    state.SetItemsProcessed(state.iterations() * kCallsPerIteration);
+    SetLabel(state);
+}
+BENCHMARK(BM_onewayThroughput)->ArgsProduct({kTransportList, {16, 256, 1024}});
+
 void BM_collectProxies(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
     sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
@@ -356,6 +451,25 @@ int main(int argc, char** argv) {
     setupClient(gSessionTls, tlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
 
+    std::string shmAddr = tmp + "/binderRpcSharedMemoryBenchmark";
+    (void)unlink(shmAddr.c_str());
+    auto shmServer = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+    shmServer->setSupportedFileDescriptorTransportModes(
+            {RpcSession::FileDescriptorTransportMode::NONE,
+             RpcSession::FileDescriptorTransportMode::UNIX});
+    shmServer->setSharedMemoryTransactionThreshold(kSharedMemoryTransactionThreshold);
+    forkRpcServer(shmAddr.c_str(), shmServer);
+    gSessionSharedMemory->setFileDescriptorTransportMode(
+            RpcSession::FileDescriptorTransportMode::UNIX);
+    gSessionSharedMemory->setSharedMemoryTransactionThreshold(kSharedMemoryTransactionThreshold);
+    setupClient(gSessionSharedMemory, shmAddr.c_str());
+    gRpcSharedMemoryBinder = gSessionSharedMemory->getRootObject();
+
+    // batching is up to the client, so this uses the plain RPC server
+    CHECK_EQ(OK, gSessionOnewayBatch->setOnewayBatching(16 * 1024, std::chrono::microseconds(500)));
+    setupClient(gSessionOnewayBatch, addr.c_str());
+    gRpcOnewayBatchBinder = gSessionOnewayBatch->getRootObject();
+
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
@@ -28,6 +28,7 @@
 #include <dirent.h>
 #include <dlfcn.h>
 #include <poll.h>
+#include <sys/mman.h>
 #include <sys/prctl.h>
 #include <sys/socket.h>
 
@@ -36,6 +37,7 @@
 #include <trusty/tipc.h>
 #endif // BINDER_RPC_TO_TRUSTY_TEST
 
+#include "../RpcWireFormat.h"
 #include "../Utils.h"
 #include "binderRpcTestCommon.h"
 #include "binderRpcTestFixture.h"
@@ -298,6 +300,9 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
 
     BinderRpcTestServerConfig serverConfig;
     serverConfig.numThreads = options.numThreads;
+    serverConfig.numDispatchThreads = options.numDispatchThreads;
+    serverConfig.sharedMemoryTransactionThreshold =
+            static_cast<int32_t>(options.sharedMemoryTransactionThreshold);
     serverConfig.socketType = static_cast<int32_t>(socketType);
     serverConfig.rpcSecurity = static_cast<int32_t>(rpcSecurity);
     serverConfig.serverVersion = serverVersion;
@@ -364,6 +369,12 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
         session->setMaxIncomingThreads(numIncoming);
         session->setMaxOutgoingConnections(options.numOutgoingConnections);
         session->setFileDescriptorTransportMode(options.clientFileDescriptorTransportMode);
+        session->setSharedMemoryTransactionThreshold(options.sharedMemoryTransactionThreshold);
+        if (options.onewayBatchMaxBytes != 0) {
+            LOG_ALWAYS_FATAL_IF(OK !=
+                                session->setOnewayBatching(options.onewayBatchMaxBytes,
+                                                           options.onewayBatchMaxDelay));
+        }
 
         switch (socketType) {
             case SocketType::PRECONNECTED:
@@ -629,6 +640,85 @@ TEST_P(BinderRpc, OnewayCallQueueing) {
     saturateThreadPool(1 + kNumExtraServerThreads, proc.rootIface);
 }
 
+TEST_P(BinderRpc, OnewayBatchKeepsOrderWithTwowayCalls) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumQueued = 10;
+    constexpr size_t kNumExtraServerThreads = 4;
+
+    // the delay is long enough that batches are only sent by twoway calls
+    auto proc = createRpcTestSocketServerProcess({
+            .numThreads = 1 + kNumExtraServerThreads,
+            .onewayBatchMaxBytes = 4096,
+            .onewayBatchMaxDelay = 10s,
+    });
+
+    for (size_t i = 0; i + 1 < kNumQueued; i++) {
+        proc.rootIface->blockingSendIntOneway(i);
+        if (i % 3 == 0) {
+            std::string out;
+            EXPECT_OK(proc.rootIface->doubleString("a", &out));
+        }
+    }
+    for (size_t i = 0; i + 1 < kNumQueued; i++) {
+        int n;
+        proc.rootIface->blockingRecvInt(&n);
+        EXPECT_EQ(n, i);
+    }
+
+    saturateThreadPool(1 + kNumExtraServerThreads, proc.rootIface);
+}
+
+TEST_P(BinderRpc, DispatchThreadsServeManySessions) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumSessions = 20;
+    constexpr size_t kNumCalls = 20;
+
+    // many more connections than threads serving them
+    auto proc = createRpcTestSocketServerProcess(
+            {.numThreads = 2, .numDispatchThreads = 2, .numSessions = kNumSessions});
+
+    std::vector<std::thread> threads;
+    for (const auto& session : proc.proc->sessions) {
+        threads.push_back(std::thread([&] {
+            for (size_t i = 0; i < kNumCalls; i++) {
+                EXPECT_EQ(OK, session.root->pingBinder());
+            }
+        }));
+    }
+    for (auto& t : threads) t.join();
+}
+
+TEST_P(BinderRpc, DispatchThreadsOnewayCallQueueing) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumQueued = 10;
+    constexpr size_t kNumDispatchThreads = 4;
+
+    auto proc = createRpcTestSocketServerProcess(
+            {.numThreads = kNumDispatchThreads, .numDispatchThreads = kNumDispatchThreads});
+
+    // oneway calls are still processed in order, even when the connection is
+    // picked up by different threads
+    for (size_t i = 0; i + 1 < kNumQueued; i++) {
+        proc.rootIface->blockingSendIntOneway(i);
+    }
+    for (size_t i = 0; i + 1 < kNumQueued; i++) {
+        int n;
+        proc.rootIface->blockingRecvInt(&n);
+        EXPECT_EQ(n, i);
+    }
+
+    saturateThreadPool(kNumDispatchThreads, proc.rootIface);
+}
+
 TEST_P(BinderRpc, OnewayCallExhaustion) {
     if (clientOrServerSingleThreaded()) {
         GTEST_SKIP() << "This test requires multiple threads";
@@ -1035,6 +1125,29 @@ TEST_P(BinderRpc, SendTooManyFiles) {
     EXPECT_EQ(status.transactionError(), BAD_VALUE) << status;
 }
 
+TEST_P(BinderRpc, SharedMemoryTransactions) {
+    if (!supportsFdTransport()) {
+        GTEST_SKIP() << "Shared memory is only used with FileDescriptorTransportMode::UNIX";
+    }
+
+    constexpr size_t kThreshold = 1024;
+    auto proc = createRpcTestSocketServerProcess({
+            .clientFileDescriptorTransportMode = RpcSession::FileDescriptorTransportMode::UNIX,
+            .serverSupportedFileDescriptorTransportModes =
+                    {RpcSession::FileDescriptorTransportMode::UNIX},
+            .sharedMemoryTransactionThreshold = kThreshold,
+    });
+
+    // Strings are sent as UTF-16, so these are below and above the threshold.
+    // Replies are always sent on the socket.
+    for (size_t length : {kThreshold / 4, kThreshold, size_t{16 * 1024}}) {
+        std::string in(length, 'a');
+        std::string out;
+        EXPECT_OK(proc.rootIface->doubleString(in, &out)) << length;
+        EXPECT_EQ(in + in, out) << length;
+    }
+}
+
 TEST_P(BinderRpc, AppendInvalidFd) {
     if (socketType() == SocketType::TIPC) {
         GTEST_SKIP() << "File descriptor tests not supported on Trusty (yet)";
@@ -1473,6 +1586,365 @@ INSTANTIATE_TEST_CASE_P(BinderRpc, BinderRpcServerOnly,
                                            ::testing::ValuesIn(testVersions())),
                         BinderRpcServerOnly::PrintTestParam);
 
+// Speaks the wire protocol directly to an in-process RpcServer, in order to send
+// it commands which RpcSession never would.
+class BinderRpcRawProtocol : public ::testing::Test {
+public:
+    void SetUp() override {
+        if constexpr (!kEnableRpcThreads) {
+            GTEST_SKIP() << "Test skipped because threads were disabled at build time";
+        }
+
+        mAddr = allocateSocketAddress();
+        mServer = RpcServer::make();
+        mServer->setSupportedFileDescriptorTransportModes(
+                {RpcSession::FileDescriptorTransportMode::UNIX});
+        mServer->setSharedMemoryTransactionThreshold(1);
+        if (mDispatchThreads > 0) mServer->setDispatchThreads(mDispatchThreads);
+        if (mDispatchCommandTimeout) mServer->setDispatchCommandTimeout(*mDispatchCommandTimeout);
+        mServer->setRootObject(sp<BBinder>::make());
+        ASSERT_EQ(OK, mServer->setupUnixDomainServer(mAddr.c_str()));
+        mJoinThread = std::thread([server = mServer] { server->join(); });
+    }
+
+    void TearDown() override {
+        if (!mJoinThread.joinable()) return;
+        while (!mServer->shutdown()) usleep(10 * 1000);
+        mJoinThread.join();
+    }
+
+    // Connects to the server as a new session, with RPC_CONNECTION_OPTION_*
+    // options.
+    RpcTransportFd connect(uint8_t options) {
+        RpcTransportFd fd(connectTo(UnixSocketAddress(mAddr.c_str())));
+        RpcConnectionHeader header{
+                .version = RPC_WIRE_PROTOCOL_VERSION,
+                .options = options,
+                .fileDescriptorTransportMode =
+                        static_cast<uint8_t>(RpcSession::FileDescriptorTransportMode::UNIX),
+        };
+        EXPECT_TRUE(binder::WriteFully(fd.fd, &header, sizeof(header)));
+        RpcNewSessionResponse response;
+        EXPECT_EQ(OK, readFully(fd, &response, sizeof(response)));
+        RpcOutgoingConnectionInit init{.msg = RPC_CONNECTION_INIT_OKAY};
+        EXPECT_TRUE(binder::WriteFully(fd.fd, &init, sizeof(init)));
+        return fd;
+    }
+
+    static void send(const RpcTransportFd& fd, uint32_t command, const void* body,
+                     size_t bodySize, std::vector<std::variant<unique_fd, borrowed_fd>> fds = {}) {
+        RpcWireHeader header{.command = command, .bodySize = static_cast<uint32_t>(bodySize)};
+        iovec iovs[]{{&header, sizeof(header)}, {const_cast<void*>(body), bodySize}};
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(header) + bodySize),
+                  binder::os::sendMessageOnSocket(fd, iovs, countof(iovs), &fds));
+    }
+
+    // Returns DEAD_OBJECT if the server closed the connection.
+    static status_t readFully(const RpcTransportFd& fd, void* data, size_t size) {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            pollfd pfd{.fd = fd.fd.get(), .events = POLLIN};
+            int ret = TEMP_FAILURE_RETRY(poll(&pfd, 1, 30'000));
+            if (ret == 0) return TIMED_OUT;
+            if (ret < 0) return -errno;
+            ssize_t n = TEMP_FAILURE_RETRY(read(fd.fd.get(), bytes, size));
+            if (n == 0 || (n < 0 && errno == ECONNRESET)) return DEAD_OBJECT;
+            if (n < 0) return -errno;
+            bytes += n;
+            size -= static_cast<size_t>(n);
+        }
+        return OK;
+    }
+
+    // Reads the reply to a twoway transaction and returns its status.
+    static status_t readReply(const RpcTransportFd& fd) {
+        RpcWireHeader header;
+        if (status_t status = readFully(fd, &header, sizeof(header)); status != OK) return status;
+        std::vector<uint8_t> body(header.bodySize);
+        if (status_t status = readFully(fd, body.data(), body.size()); status != OK) {
+            return status;
+        }
+        if (header.command != RPC_COMMAND_REPLY || body.size() < sizeof(RpcWireReply::status)) {
+            return BAD_VALUE;
+        }
+        int32_t replyStatus;
+        memcpy(&replyStatus, body.data(), sizeof(replyStatus));
+        return replyStatus;
+    }
+
+    // The server closes the connection when it terminates a session.
+    static bool closedByServer(const RpcTransportFd& fd) {
+        uint8_t byte;
+        return readFully(fd, &byte, sizeof(byte)) == DEAD_OBJECT;
+    }
+
+    // A transaction which the server always replies to, without a binder.
+    static RpcWireTransaction getMaxThreadsTransaction(uint32_t flags = 0) {
+        return RpcWireTransaction{
+                .address = RpcWireAddress::fromRaw(0),
+                .code = RPC_SPECIAL_TRANSACT_GET_MAX_THREADS,
+                .flags = flags,
+        };
+    }
+
+    // Appends a command to an RPC_COMMAND_TRANSACT_BATCH body.
+    static void appendToBatch(std::vector<uint8_t>* batch, uint32_t command,
+                              const RpcWireTransaction& transaction) {
+        RpcWireHeader header{.command = command, .bodySize = sizeof(transaction)};
+        size_t offset = batch->size();
+        batch->resize(offset + sizeof(header) + sizeof(transaction));
+        memcpy(batch->data() + offset, &header, sizeof(header));
+        memcpy(batch->data() + offset + sizeof(header), &transaction, sizeof(transaction));
+        batch->resize((batch->size() + RPC_WIRE_BATCH_ALIGNMENT - 1) &
+                      ~(RPC_WIRE_BATCH_ALIGNMENT - 1));
+    }
+
+    static constexpr size_t kRegionSize = 4096;
+
+    // Sends getMaxThreadsTransaction() through a shared memory region, as the
+    // sender's first use of the region.
+    static void sendInRegion(const RpcTransportFd& fd, borrowed_fd region, uint64_t regionSize,
+                             uint64_t offset = 0) {
+        RpcWireSharedMemory body{
+                .offset = offset,
+                .size = sizeof(RpcWireTransaction),
+                .options = RPC_WIRE_SHARED_MEMORY_OPTION_NEW_REGION,
+                .regionSize = regionSize,
+        };
+        std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+        fds.emplace_back(region);
+        send(fd, RPC_COMMAND_TRANSACT_SHARED_MEMORY, &body, sizeof(body), std::move(fds));
+    }
+
+    // Creates a region like RpcSession does, with getMaxThreadsTransaction() at
+    // its start.
+    static unique_fd createRegion() {
+        unique_fd region;
+        void* data;
+        EXPECT_EQ(OK, binder::os::createSharedMemory("test", kRegionSize, &region, &data));
+        if (!region.ok()) return region;
+        RpcWireTransaction transaction = getMaxThreadsTransaction();
+        memcpy(data, &transaction, sizeof(transaction));
+        binder::os::unmapSharedMemory(data, kRegionSize);
+        return region;
+    }
+
+protected:
+    // see RpcServer::setDispatchThreads
+    size_t mDispatchThreads = 0;
+    // see RpcServer::setDispatchCommandTimeout
+    std::optional<std::chrono::milliseconds> mDispatchCommandTimeout;
+
+private:
+    std::string mAddr;
+    sp<RpcServer> mServer;
+    std::thread mJoinThread;
+};
+
+class BinderRpcRawProtocolDispatch : public BinderRpcRawProtocol {
+public:
+    BinderRpcRawProtocolDispatch() {
+        mDispatchThreads = 1;
+        mDispatchCommandTimeout = 100ms;
+    }
+};
+
+TEST_F(BinderRpcRawProtocolDispatch, StalledCommandTimesOut) {
+    RpcTransportFd stalled = connect(0);
+    RpcWireHeader header{.command = RPC_COMMAND_TRANSACT, .bodySize = sizeof(RpcWireTransaction)};
+    ASSERT_TRUE(binder::WriteFully(stalled.fd, &header, sizeof(header) / 2));
+
+    // the only dispatch thread is freed once the stalled command times out
+    RpcTransportFd fd = connect(0);
+    RpcWireTransaction transaction = getMaxThreadsTransaction();
+    send(fd, RPC_COMMAND_TRANSACT, &transaction, sizeof(transaction));
+    EXPECT_EQ(OK, readReply(fd));
+    EXPECT_TRUE(closedByServer(stalled));
+}
+
+TEST_F(BinderRpcRawProtocol, OnewayBatch) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_ONEWAY_BATCH);
+
+    std::vector<uint8_t> batch;
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    send(fd, RPC_COMMAND_TRANSACT_BATCH, batch.data(), batch.size());
+
+    // oneway transactions aren't replied to, so this is the only reply
+    RpcWireTransaction transaction = getMaxThreadsTransaction();
+    send(fd, RPC_COMMAND_TRANSACT, &transaction, sizeof(transaction));
+    EXPECT_EQ(OK, readReply(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, OnewayBatchRejectsOtherCommands) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_ONEWAY_BATCH);
+
+    std::vector<uint8_t> batch;
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    appendToBatch(&batch, RPC_COMMAND_REPLY, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    send(fd, RPC_COMMAND_TRANSACT_BATCH, batch.data(), batch.size());
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, OnewayBatchRejectsTwowayTransactions) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_ONEWAY_BATCH);
+
+    std::vector<uint8_t> batch;
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction());
+    send(fd, RPC_COMMAND_TRANSACT_BATCH, batch.data(), batch.size());
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, OnewayBatchRejectsTruncatedTransaction) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_ONEWAY_BATCH);
+
+    std::vector<uint8_t> batch;
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    batch.resize(sizeof(RpcWireHeader) + sizeof(RpcWireTransaction) / 2);
+    send(fd, RPC_COMMAND_TRANSACT_BATCH, batch.data(), batch.size());
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, OnewayBatchRejectsTruncatedHeader) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_ONEWAY_BATCH);
+
+    std::vector<uint8_t> batch;
+    appendToBatch(&batch, RPC_COMMAND_TRANSACT, getMaxThreadsTransaction(IBinder::FLAG_ONEWAY));
+    batch.resize(batch.size() + sizeof(RpcWireHeader) / 2);
+    send(fd, RPC_COMMAND_TRANSACT_BATCH, batch.data(), batch.size());
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, SharedMemoryTransaction) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_SHARED_MEMORY);
+    unique_fd region = createRegion();
+    ASSERT_TRUE(region.ok());
+
+    sendInRegion(fd, region, kRegionSize);
+    EXPECT_EQ(OK, readReply(fd));
+
+    // later transactions use the region which was already sent
+    RpcWireSharedMemory body{.offset = 0, .size = sizeof(RpcWireTransaction)};
+    send(fd, RPC_COMMAND_TRANSACT_SHARED_MEMORY, &body, sizeof(body));
+    EXPECT_EQ(OK, readReply(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, SharedMemoryRegionCannotBeResized) {
+    unique_fd region = createRegion();
+    ASSERT_TRUE(region.ok());
+    EXPECT_EQ(-1, ftruncate(region.get(), 0));
+    EXPECT_EQ(EPERM, errno);
+    EXPECT_EQ(-1, ftruncate(region.get(), kRegionSize * 2));
+    EXPECT_EQ(EPERM, errno);
+}
+
+TEST_F(BinderRpcRawProtocol, SharedMemoryRejectsUnsealedRegion) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_SHARED_MEMORY);
+
+    // this could be truncated while the server reads it
+    unique_fd region(memfd_create("test", MFD_CLOEXEC));
+    ASSERT_TRUE(region.ok());
+    ASSERT_EQ(0, ftruncate(region.get(), kRegionSize));
+    RpcWireTransaction transaction = getMaxThreadsTransaction();
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(transaction)),
+              pwrite(region.get(), &transaction, sizeof(transaction), 0));
+
+    sendInRegion(fd, region, kRegionSize);
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, SharedMemoryRejectsRegionSizeMismatch) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_SHARED_MEMORY);
+    unique_fd region = createRegion();
+    ASSERT_TRUE(region.ok());
+
+    sendInRegion(fd, region, kRegionSize * 2);
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+TEST_F(BinderRpcRawProtocol, SharedMemoryRejectsTransactionPastRegion) {
+    RpcTransportFd fd = connect(RPC_CONNECTION_OPTION_SHARED_MEMORY);
+    unique_fd region = createRegion();
+    ASSERT_TRUE(region.ok());
+
+    sendInRegion(fd, region, kRegionSize, kRegionSize - alignof(RpcWireTransaction));
+    EXPECT_TRUE(closedByServer(fd));
+}
+
+// Counts the transactions it receives. The count outlives the binder, which
+// the server may drop as soon as the client releases it.
+class CountingBinder : public BBinder {
+public:
+    explicit CountingBinder(std::shared_ptr<std::atomic<size_t>> count)
+          : mCount(std::move(count)) {}
+    status_t onTransact(uint32_t, const Parcel&, Parcel*, uint32_t) override {
+        (*mCount)++;
+        return OK;
+    }
+
+private:
+    std::shared_ptr<std::atomic<size_t>> mCount;
+};
+
+// Replies to every transaction with a new CountingBinder.
+class CountingBinderFactory : public BBinder {
+public:
+    std::shared_ptr<std::atomic<size_t>> count = std::make_shared<std::atomic<size_t>>(0);
+    status_t onTransact(uint32_t, const Parcel&, Parcel* reply, uint32_t) override {
+        return reply->writeStrongBinder(sp<CountingBinder>::make(count));
+    }
+};
+
+TEST(BinderRpc, OnewayBatchIsSentBeforeBinderIsReleased) {
+    if constexpr (!kEnableRpcThreads) {
+        GTEST_SKIP() << "Test skipped because threads were disabled at build time";
+    }
+
+    std::string addr = allocateSocketAddress();
+    auto server = RpcServer::make(newTlsFactory(RpcSecurity::RAW));
+    server->setMaxThreads(1);
+    auto factory = sp<CountingBinderFactory>::make();
+    server->setRootObject(factory);
+    ASSERT_EQ(OK, server->setupUnixDomainServer(addr.c_str()));
+    std::thread joinThread([&] { server->join(); });
+
+    auto session = RpcSession::make();
+    ASSERT_EQ(OK, session->setOnewayBatching(4096, 10s));
+    ASSERT_EQ(OK, session->setupUnixDomainClient(addr.c_str()));
+
+    sp<IBinder> binder;
+    {
+        sp<IBinder> root = session->getRootObject();
+        ASSERT_NE(nullptr, root);
+        Parcel data, reply;
+        data.markForBinder(root);
+        ASSERT_EQ(OK, root->transact(IBinder::FIRST_CALL_TRANSACTION, data, &reply));
+        ASSERT_EQ(OK, reply.readStrongBinder(&binder));
+        ASSERT_NE(nullptr, binder);
+    }
+
+    // None of these are sent until the batch is flushed, so if releasing the
+    // binder came first, the server wouldn't know where to deliver them.
+    constexpr size_t kNumCalls = 10;
+    for (size_t i = 0; i < kNumCalls; i++) {
+        Parcel data, reply;
+        data.markForBinder(binder);
+        EXPECT_EQ(OK,
+                  binder->transact(IBinder::FIRST_CALL_TRANSACTION, data, &reply,
+                                   IBinder::FLAG_ONEWAY));
+    }
+    binder = nullptr;
+
+    for (size_t tries = 0; *factory->count < kNumCalls && tries < 1000; tries++) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(kNumCalls, factory->count->load());
+
+    EXPECT_TRUE(session->shutdownAndWait(true));
+    while (!server->shutdown()) usleep(10 * 1000);
+    joinThread.join();
+}
+
 class RpcTransportTestUtils {
 public:
     // Only parameterized only server version because `RpcSession` is bypassed
@@ -138,6 +138,8 @@ static inline size_t epochMillis() {
 
 struct BinderRpcOptions {
     size_t numThreads = 1;
+    // if nonzero, see RpcServer::setDispatchThreads
+    size_t numDispatchThreads = 0;
     size_t numSessions = 1;
     // right now, this can be empty, or length numSessions, where each value
     // represents the info for the corresponding session, but we should
@@ -150,6 +152,12 @@ struct BinderRpcOptions {
     std::vector<RpcSession::FileDescriptorTransportMode>
             serverSupportedFileDescriptorTransportModes = {
                     RpcSession::FileDescriptorTransportMode::NONE};
+    // if nonzero, see RpcSession::setSharedMemoryTransactionThreshold, set on
+    // both the server and the client
+    size_t sharedMemoryTransactionThreshold = 0;
+    // if nonzero, see RpcSession::setOnewayBatching
+    size_t onewayBatchMaxBytes = 0;
+    std::chrono::microseconds onewayBatchMaxDelay{0};
 
     // If true, connection failures will result in `ProcessSession::sessions` being empty
     // instead of a fatal error.
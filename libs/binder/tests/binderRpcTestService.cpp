@@ -122,7 +122,11 @@ int main(int argc, char* argv[]) {
 
     LOG_ALWAYS_FATAL_IF(!server->setProtocolVersion(serverConfig.serverVersion));
     server->setMaxThreads(serverConfig.numThreads);
+    if (serverConfig.numDispatchThreads > 0) {
+        server->setDispatchThreads(serverConfig.numDispatchThreads);
+    }
     server->setSupportedFileDescriptorTransportModes(serverSupportedFileDescriptorTransportModes);
+    server->setSharedMemoryTransactionThreshold(serverConfig.sharedMemoryTransactionThreshold);
 
     unsigned int outPort = 0;
     unique_fd socketFd(serverConfig.socketFd);
@@ -72,6 +72,17 @@ status_t dupFileDescriptor(int oldFd, int* newFd) {
     return OK;
 }
 
+status_t createSharedMemory(const char* /*name*/, size_t /*size*/, unique_fd* /*outFd*/,
+                            void** /*outData*/) {
+    return INVALID_OPERATION;
+}
+
+status_t mapSharedMemory(borrowed_fd /*fd*/, size_t /*size*/, void** /*outData*/) {
+    return INVALID_OPERATION;
+}
+
+void unmapSharedMemory(void* /*data*/, size_t /*size*/) {}
+
 std::unique_ptr<RpcTransportCtxFactory> makeDefaultRpcTransportCtxFactory() {
     return RpcTransportCtxFactoryTipcTrusty::make();
 }
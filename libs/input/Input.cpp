@@ -594,6 +594,11 @@ void MotionEvent::addSample(
                                 &pointerCoords[getPointerCount()]);
 }
 
+void MotionEvent::reserveSamples(size_t sampleCount) {
+    mSampleEventTimes.reserve(mSampleEventTimes.size() + sampleCount);
+    mSamplePointerCoords.reserve(mSamplePointerCoords.size() + sampleCount * getPointerCount());
+}
+
 std::optional<ui::Rotation> MotionEvent::getSurfaceRotation() const {
     // The surface rotation is the rotation from the window's coordinate space to that of the
     // display. Since the event's transform takes display space coordinates to window space, the
@@ -676,6 +681,18 @@ float MotionEvent::getHistoricalAxisValue(int32_t axis, size_t pointerIndex,
     return calculateTransformedAxisValue(axis, mSource, mTransform, coords);
 }
 
+void MotionEvent::getAxisValueHistory(int32_t axis, size_t pointerIndex, float* outValues) const {
+    const size_t pointerCount = getPointerCount();
+    if (CC_UNLIKELY(pointerIndex >= pointerCount)) {
+        LOG(FATAL) << __func__ << ": Invalid pointer index " << pointerIndex << " for " << *this;
+    }
+    const size_t sampleCount = mSampleEventTimes.size();
+    for (size_t i = 0; i < sampleCount; i++) {
+        const PointerCoords& coords = mSamplePointerCoords[i * pointerCount + pointerIndex];
+        outValues[i] = calculateTransformedAxisValue(axis, mSource, mTransform, coords);
+    }
+}
+
 ssize_t MotionEvent::findPointerIndex(int32_t pointerId) const {
     size_t pointerCount = mPointerProperties.size();
     for (size_t i = 0; i < pointerCount; i++) {
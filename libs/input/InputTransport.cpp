@@ -10,6 +10,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -18,6 +19,7 @@
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <binder/Parcel.h>
+#include <cutils/ashmem.h>
 #include <cutils/properties.h>
 #include <ftl/enum.h>
 #include <log/log.h>
@@ -151,8 +153,15 @@ inline static T min(const T& a, const T& b) {
     return a < b ? a : b;
 }
 
-inline static float lerp(float a, float b, float alpha) {
-    return a + alpha * (b - a);
+/**
+ * Interpolates, or extrapolates for alpha outside of [0, 1], count values at once. The values are
+ * in separate arrays rather than in PointerCoords, so that the loop can be vectorized.
+ */
+static void lerp(size_t count, const float* __restrict a, const float* __restrict b, float alpha,
+                 float* __restrict out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = a[i] + alpha * (b[i] - a[i]);
+    }
 }
 
 inline static bool isPointerEvent(int32_t source) {
@@ -380,6 +389,208 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
     }
 }
 
+// --- InputChannelRing ---
+
+// A single producer, single consumer ring of InputMessages in shared memory. The server end of an
+// InputChannel writes to it, and the client end reads from it.
+//
+// The client may be untrusted, so the writer only relies on its own copy of the write position,
+// and treats a read position that doesn't make sense as a broken channel.
+class InputChannelRing {
+public:
+    enum class Role : int32_t { WRITER = 0, READER = 1 };
+
+    // Creates a new ring, to be written to from the returned object.
+    static std::shared_ptr<InputChannelRing> create(const std::string& name);
+    // Maps an existing ring from its fd.
+    static std::shared_ptr<InputChannelRing> map(android::base::unique_fd fd, Role role);
+
+    ~InputChannelRing();
+
+    Role getRole() const { return mRole; }
+    const android::base::unique_fd& getFd() const { return mFd; }
+
+    // Returns WOULD_BLOCK if the ring is too full for the message.
+    status_t write(const InputMessage& msg, size_t msgLength);
+    // Returns true if the reader has asked to be woken up since the last call.
+    bool takeReaderWaiting();
+
+    // Returns WOULD_BLOCK if the ring is empty.
+    status_t read(InputMessage* msg);
+    // Asks the writer to wake up the reader on its next write.
+    void setReaderWaiting();
+
+private:
+    struct Header {
+        // Byte positions, which only ever increase and wrap around. The reader owns head, and
+        // the writer owns tail.
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+        std::atomic<uint32_t> readerWaiting;
+        uint32_t empty;
+    };
+
+    // Each message is preceded by a RecordHeader, and padded to keep the next one aligned.
+    struct RecordHeader {
+        uint32_t size;
+        uint32_t empty;
+    };
+
+    // Same as the socket buffer, so that the ring can hold as many messages. Must be a power of
+    // two, so that the positions stay consistent when they wrap around.
+    static constexpr uint32_t CAPACITY = SOCKET_BUFFER_SIZE;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+    static constexpr size_t MAPPING_SIZE = sizeof(Header) + CAPACITY;
+    // Size of a RecordHeader that skips to the start of the ring.
+    static constexpr uint32_t WRAP_AROUND = UINT32_MAX;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+    static_assert(alignof(InputMessage) <= sizeof(RecordHeader));
+
+    InputChannelRing(android::base::unique_fd fd, Role role, void* mapping);
+
+    static uint32_t recordSize(size_t msgLength) {
+        return static_cast<uint32_t>((sizeof(RecordHeader) + msgLength + sizeof(RecordHeader) - 1) &
+                                     ~(sizeof(RecordHeader) - 1));
+    }
+    uint8_t* at(uint32_t position) const { return mData + (position & (CAPACITY - 1)); }
+
+    const android::base::unique_fd mFd;
+    const Role mRole;
+    Header* const mHeader;
+    uint8_t* const mData;
+    // This end's copy of its position: the tail for the writer, the head for the reader.
+    uint32_t mPosition;
+};
+
+std::shared_ptr<InputChannelRing> InputChannelRing::create(const std::string& name) {
+    android::base::unique_fd fd(
+            ashmem_create_region(("InputChannel " + name).c_str(), MAPPING_SIZE));
+    if (!fd.ok()) {
+        ALOGE("channel '%s' ~ Could not create shared memory ring: %s", name.c_str(),
+              strerror(errno));
+        return nullptr;
+    }
+    std::shared_ptr<InputChannelRing> ring = map(std::move(fd), Role::WRITER);
+    if (ring != nullptr) {
+        // Nothing has been read yet, so the first message wakes up the reader.
+        ring->mHeader->readerWaiting.store(1, std::memory_order_relaxed);
+    }
+    return ring;
+}
+
+std::shared_ptr<InputChannelRing> InputChannelRing::map(android::base::unique_fd fd, Role role) {
+    const int size = ashmem_get_size_region(fd.get());
+    if (size < 0 || static_cast<size_t>(size) != MAPPING_SIZE) {
+        ALOGE("Shared memory ring has size %d instead of %zu", size, MAPPING_SIZE);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (mapping == MAP_FAILED) {
+        ALOGE("Could not map shared memory ring: %s", strerror(errno));
+        return nullptr;
+    }
+    // using 'new' to access a non-public constructor
+    return std::shared_ptr<InputChannelRing>(new InputChannelRing(std::move(fd), role, mapping));
+}
+
+InputChannelRing::InputChannelRing(android::base::unique_fd fd, Role role, void* mapping)
+      : mFd(std::move(fd)),
+        mRole(role),
+        mHeader(static_cast<Header*>(mapping)),
+        mData(static_cast<uint8_t*>(mapping) + sizeof(Header)),
+        mPosition(role == Role::WRITER ? mHeader->tail.load(std::memory_order_relaxed)
+                                       : mHeader->head.load(std::memory_order_relaxed)) {}
+
+InputChannelRing::~InputChannelRing() {
+    munmap(mHeader, MAPPING_SIZE);
+}
+
+status_t InputChannelRing::write(const InputMessage& msg, size_t msgLength) {
+    const uint32_t size = recordSize(msgLength);
+    const uint32_t head = mHeader->head.load(std::memory_order_acquire);
+    const uint32_t used = mPosition - head;
+    if (used > CAPACITY) {
+        ALOGE("Shared memory ring is corrupted: head %" PRIu32 ", tail %" PRIu32, head, mPosition);
+        return DEAD_OBJECT;
+    }
+
+    // Messages are contiguous, so skip the end of the ring if the message doesn't fit there.
+    const uint32_t untilEnd = CAPACITY - (mPosition & (CAPACITY - 1));
+    const uint32_t skipped = untilEnd < size ? untilEnd : 0;
+    if (CAPACITY - used < skipped + size) {
+        return WOULD_BLOCK;
+    }
+
+    uint32_t tail = mPosition;
+    if (skipped != 0) {
+        const RecordHeader wrapAround{.size = WRAP_AROUND};
+        memcpy(at(tail), &wrapAround, sizeof(wrapAround));
+        tail += skipped;
+    }
+    const RecordHeader record{.size = static_cast<uint32_t>(msgLength)};
+    memcpy(at(tail), &record, sizeof(record));
+    memcpy(at(tail) + sizeof(record), &msg, msgLength);
+    tail += size;
+
+    mPosition = tail;
+    mHeader->tail.store(tail, std::memory_order_release);
+    return OK;
+}
+
+bool InputChannelRing::takeReaderWaiting() {
+    // Pairs with the fence in setReaderWaiting: either the reader sees the new tail, or this sees
+    // that it is waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return mHeader->readerWaiting.load(std::memory_order_relaxed) != 0 &&
+            mHeader->readerWaiting.exchange(0, std::memory_order_relaxed) != 0;
+}
+
+status_t InputChannelRing::read(InputMessage* msg) {
+    const uint32_t tail = mHeader->tail.load(std::memory_order_acquire);
+    uint32_t head = mPosition;
+    while (head != tail) {
+        RecordHeader record;
+        memcpy(&record, at(head), sizeof(record));
+        if (record.size == WRAP_AROUND) {
+            const uint32_t untilEnd = CAPACITY - (head & (CAPACITY - 1));
+            if (tail - head < untilEnd) {
+                ALOGE("Shared memory ring skips past its last message");
+                return BAD_VALUE;
+            }
+            head += untilEnd;
+            continue;
+        }
+
+        if (record.size > sizeof(InputMessage) || tail - head < recordSize(record.size)) {
+            ALOGE("Shared memory ring has an invalid message of size %" PRIu32, record.size);
+            return BAD_VALUE;
+        }
+        memcpy(msg, at(head) + sizeof(record), record.size);
+        if (!msg->isValid(record.size)) {
+            ALOGE("Shared memory ring has an invalid message of size %" PRIu32, record.size);
+            return BAD_VALUE;
+        }
+        head += recordSize(record.size);
+
+        mPosition = head;
+        mHeader->head.store(head, std::memory_order_release);
+        return OK;
+    }
+
+    if (head != mPosition) {
+        // Only skipped the end of the ring
+        mPosition = head;
+        mHeader->head.store(head, std::memory_order_release);
+    }
+    return WOULD_BLOCK;
+}
+
+void InputChannelRing::setReaderWaiting() {
+    mHeader->readerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
 // --- InputChannel ---
 
 std::unique_ptr<InputChannel> InputChannel::create(const std::string& name,
@@ -408,6 +619,15 @@ InputChannel::~InputChannel() {
 status_t InputChannel::openInputChannelPair(const std::string& name,
                                             std::unique_ptr<InputChannel>& outServerChannel,
                                             std::unique_ptr<InputChannel>& outClientChannel) {
+    const Transport transport = input_flags::input_channel_shared_memory_ring()
+            ? Transport::SHARED_MEMORY_RING
+            : Transport::SOCKET;
+    return openInputChannelPair(name, transport, outServerChannel, outClientChannel);
+}
+
+status_t InputChannel::openInputChannelPair(const std::string& name, Transport transport,
+                                            std::unique_ptr<InputChannel>& outServerChannel,
+                                            std::unique_ptr<InputChannel>& outClientChannel) {
     int sockets[2];
     if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets)) {
         status_t result = -errno;
@@ -433,9 +653,28 @@ status_t InputChannel::openInputChannelPair(const std::string& name,
     std::string clientChannelName = name + " (client)";
     android::base::unique_fd clientFd(sockets[1]);
     outClientChannel = InputChannel::create(clientChannelName, std::move(clientFd), token);
+
+    if (transport == Transport::SHARED_MEMORY_RING) {
+        std::shared_ptr<InputChannelRing> writer = InputChannelRing::create(name);
+        std::shared_ptr<InputChannelRing> reader = writer == nullptr
+                ? nullptr
+                : InputChannelRing::map(base::unique_fd(::dup(writer->getFd().get())),
+                                        InputChannelRing::Role::READER);
+        if (reader == nullptr) {
+            outServerChannel.reset();
+            outClientChannel.reset();
+            return NO_MEMORY;
+        }
+        outServerChannel->mRing = std::move(writer);
+        outClientChannel->mRing = std::move(reader);
+    }
     return OK;
 }
 
+InputChannel::Transport InputChannel::getTransport() const {
+    return mRing != nullptr ? Transport::SHARED_MEMORY_RING : Transport::SOCKET;
+}
+
 status_t InputChannel::sendMessage(const InputMessage* msg) {
     ATRACE_NAME_IF(ATRACE_ENABLED(),
                    StringPrintf("sendMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=0x%" PRIx32
@@ -444,9 +683,23 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
     const size_t msgLength = msg->size();
     InputMessage cleanMsg;
     msg->getSanitizedCopy(&cleanMsg);
+    const status_t status = mRing != nullptr && mRing->getRole() == InputChannelRing::Role::WRITER
+            ? sendRingMessage(&cleanMsg, msgLength)
+            : sendSocketMessage(&cleanMsg, msgLength);
+    if (status != OK) {
+        return status;
+    }
+
+    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ sent message of type %s", mName.c_str(),
+             ftl::enum_string(msg->header.type).c_str());
+
+    return OK;
+}
+
+status_t InputChannel::sendSocketMessage(const InputMessage* msg, size_t msgLength) {
     ssize_t nWrite;
     do {
-        nWrite = ::send(getFd().get(), &cleanMsg, msgLength, MSG_DONTWAIT | MSG_NOSIGNAL);
+        nWrite = ::send(getFd().get(), msg, msgLength, MSG_DONTWAIT | MSG_NOSIGNAL);
     } while (nWrite == -1 && errno == EINTR);
 
     if (nWrite < 0) {
@@ -469,13 +722,66 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
         return DEAD_OBJECT;
     }
 
-    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ sent message of type %s", mName.c_str(),
-             ftl::enum_string(msg->header.type).c_str());
+    return OK;
+}
 
+status_t InputChannel::sendRingMessage(const InputMessage* msg, size_t msgLength) {
+    if (const status_t status = mRing->write(*msg, msgLength); status != OK) {
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error writing message of type %s, %s",
+                 mName.c_str(), ftl::enum_string(msg->header.type).c_str(),
+                 statusToString(status).c_str());
+        return status;
+    }
+
+    // Only ring the doorbell when the client has drained the ring and gone to sleep. Until then,
+    // it will find this message without a syscall on either side.
+    if (!mRing->takeReaderWaiting()) {
+        return OK;
+    }
+
+    const uint8_t doorbell = 0;
+    ssize_t nWrite;
+    do {
+        nWrite = ::send(getFd().get(), &doorbell, sizeof(doorbell), MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (nWrite == -1 && errno == EINTR);
+
+    if (nWrite < 0) {
+        int error = errno;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            // The socket is full of doorbells that the client has yet to read.
+            return OK;
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error ringing doorbell, %s",
+                 mName.c_str(), strerror(error));
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+            return DEAD_OBJECT;
+        }
+        return -error;
+    }
     return OK;
 }
 
 status_t InputChannel::receiveMessage(InputMessage* msg) {
+    const status_t status = mRing != nullptr && mRing->getRole() == InputChannelRing::Role::READER
+            ? receiveRingMessage(msg)
+            : receiveSocketMessage(msg);
+    if (status != OK) {
+        return status;
+    }
+
+    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s", mName.c_str(),
+             ftl::enum_string(msg->header.type).c_str());
+    if (ATRACE_ENABLED()) {
+        // Add an additional trace point to include data about the received message.
+        std::string message = StringPrintf("receiveMessage(inputChannel=%s, seq=0x%" PRIx32
+                                           ", type=0x%" PRIx32 ")",
+                                           mName.c_str(), msg->header.seq, msg->header.type);
+        ATRACE_NAME(message.c_str());
+    }
+    return OK;
+}
+
+status_t InputChannel::receiveSocketMessage(InputMessage* msg) {
     ssize_t nRead;
     do {
         nRead = ::recv(getFd().get(), msg, sizeof(InputMessage), MSG_DONTWAIT);
@@ -505,27 +811,66 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
         return BAD_VALUE;
     }
 
-    ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s", mName.c_str(),
-             ftl::enum_string(msg->header.type).c_str());
-    if (ATRACE_ENABLED()) {
-        // Add an additional trace point to include data about the received message.
-        std::string message = StringPrintf("receiveMessage(inputChannel=%s, seq=0x%" PRIx32
-                                           ", type=0x%" PRIx32 ")",
-                                           mName.c_str(), msg->header.seq, msg->header.type);
-        ATRACE_NAME(message.c_str());
-    }
     return OK;
 }
 
+status_t InputChannel::receiveRingMessage(InputMessage* msg) {
+    if (const status_t status = mRing->read(msg); status != WOULD_BLOCK) {
+        return status;
+    }
+
+    // The ring is empty. Only now clear the doorbells, so that the fd stays readable for as long
+    // as the messages that rang it are in the ring, and becomes readable again once the server has
+    // written more messages.
+    for (;;) {
+        uint8_t doorbell;
+        ssize_t nRead;
+        do {
+            nRead = ::recv(getFd().get(), &doorbell, sizeof(doorbell), MSG_DONTWAIT);
+        } while (nRead == -1 && errno == EINTR);
+
+        if (nRead < 0) {
+            int error = errno;
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                break;
+            }
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive doorbell failed, errno=%d",
+                     mName.c_str(), error);
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+
+        if (nRead == 0) { // check for EOF
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ receive message failed because peer was closed",
+                     mName.c_str());
+            return DEAD_OBJECT;
+        }
+    }
+
+    // A message may have been written before the server could see that this end is waiting. The
+    // messages written in that window did not ring the doorbell, and the client end can't ring
+    // its own, so the ones left behind this one are only found because the consumer keeps
+    // receiving until WOULD_BLOCK. Later messages ring the doorbell again.
+    mRing->setReaderWaiting();
+    return mRing->read(msg);
+}
+
 std::unique_ptr<InputChannel> InputChannel::dup() const {
     base::unique_fd newFd(dupFd());
-    return InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    std::unique_ptr<InputChannel> channel =
+            InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    channel->mRing = mRing;
+    return channel;
 }
 
 void InputChannel::copyTo(InputChannel& outChannel) const {
     outChannel.mName = getName();
     outChannel.mFd = dupFd();
     outChannel.mToken = getConnectionToken();
+    outChannel.mRing = mRing;
 }
 
 status_t InputChannel::writeToParcel(android::Parcel* parcel) const {
@@ -533,8 +878,14 @@ status_t InputChannel::writeToParcel(android::Parcel* parcel) const {
         ALOGE("%s: Null parcel", __func__);
         return BAD_VALUE;
     }
-    return parcel->writeStrongBinder(mToken)
-            ?: parcel->writeUtf8AsUtf16(mName) ?: parcel->writeUniqueFileDescriptor(mFd);
+    status_t status = parcel->writeStrongBinder(mToken)
+            ?: parcel->writeUtf8AsUtf16(mName) ?: parcel->writeUniqueFileDescriptor(mFd)
+            ?: parcel->writeBool(mRing != nullptr);
+    if (status != OK || mRing == nullptr) {
+        return status;
+    }
+    return parcel->writeInt32(static_cast<int32_t>(mRing->getRole()))
+            ?: parcel->writeUniqueFileDescriptor(mRing->getFd());
 }
 
 status_t InputChannel::readFromParcel(const android::Parcel* parcel) {
@@ -543,7 +894,27 @@ status_t InputChannel::readFromParcel(const android::Parcel* parcel) {
         return BAD_VALUE;
     }
     mToken = parcel->readStrongBinder();
-    return parcel->readUtf8FromUtf16(&mName) ?: parcel->readUniqueFileDescriptor(&mFd);
+    mRing.reset();
+    bool hasRing = false;
+    status_t status = parcel->readUtf8FromUtf16(&mName)
+            ?: parcel->readUniqueFileDescriptor(&mFd) ?: parcel->readBool(&hasRing);
+    if (status != OK || !hasRing) {
+        return status;
+    }
+
+    int32_t role;
+    base::unique_fd ringFd;
+    status = parcel->readInt32(&role) ?: parcel->readUniqueFileDescriptor(&ringFd);
+    if (status != OK) {
+        return status;
+    }
+    if (role != static_cast<int32_t>(InputChannelRing::Role::WRITER) &&
+        role != static_cast<int32_t>(InputChannelRing::Role::READER)) {
+        ALOGE("%s: Invalid shared memory ring role %" PRId32, __func__, role);
+        return BAD_VALUE;
+    }
+    mRing = InputChannelRing::map(std::move(ringFd), static_cast<InputChannelRing::Role>(role));
+    return mRing != nullptr ? OK : BAD_VALUE;
 }
 
 sp<IBinder> InputChannel::getConnectionToken() const {
@@ -1051,6 +1422,9 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
             addSample(motionEvent, &msg);
         } else {
             initializeMotionEvent(motionEvent, &msg);
+            // Make room for the rest of the batch and for a resampled sample, count + 1 samples
+            // in all, even when the batch has a single sample.
+            motionEvent->reserveSamples(count);
         }
         chain = msg.header.seq;
     }
@@ -1250,7 +1624,15 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         return;
     }
 
-    // Resample touch coordinates.
+    // Resample touch coordinates. The coordinates of the pointers that get resampled are gathered
+    // into arrays, with all of the x coordinates followed by all of the y coordinates, so that they
+    // can be resampled together.
+    size_t resampledCount = 0;
+    std::array<size_t, MAX_POINTERS> resampledIndices;
+    std::array<float, 2 * MAX_POINTERS> currentValues;
+    std::array<float, 2 * MAX_POINTERS> otherValues;
+    std::array<float, 2 * MAX_POINTERS> resampledValues;
+
     History oldLastResample;
     oldLastResample.initializeFrom(touchState.lastResample);
     touchState.lastResample.eventTime = sampleTime;
@@ -1279,15 +1661,12 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         resampledCoords.isResampled = true;
         if (other->idBits.hasBit(id) && shouldResampleTool(event->getToolType(i))) {
             const PointerCoords& otherCoords = other->getPointerById(id);
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X,
-                                         lerp(currentCoords.getX(), otherCoords.getX(), alpha));
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y,
-                                         lerp(currentCoords.getY(), otherCoords.getY(), alpha));
-            ALOGD_IF(debugResampling(),
-                     "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
-                     "other (%0.3f, %0.3f), alpha %0.3f",
-                     id, resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
-                     currentCoords.getY(), otherCoords.getX(), otherCoords.getY(), alpha);
+            resampledIndices[resampledCount] = i;
+            currentValues[resampledCount] = currentCoords.getX();
+            currentValues[MAX_POINTERS + resampledCount] = currentCoords.getY();
+            otherValues[resampledCount] = otherCoords.getX();
+            otherValues[MAX_POINTERS + resampledCount] = otherCoords.getY();
+            resampledCount++;
         } else {
             ALOGD_IF(debugResampling(), "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f)", id,
                      resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
@@ -1295,6 +1674,22 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         }
     }
 
+    lerp(resampledCount, currentValues.data(), otherValues.data(), alpha, resampledValues.data());
+    lerp(resampledCount, currentValues.data() + MAX_POINTERS, otherValues.data() + MAX_POINTERS,
+         alpha, resampledValues.data() + MAX_POINTERS);
+    for (size_t j = 0; j < resampledCount; j++) {
+        PointerCoords& resampledCoords = touchState.lastResample.pointers[resampledIndices[j]];
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X, resampledValues[j]);
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, resampledValues[MAX_POINTERS + j]);
+        ALOGD_IF(debugResampling(),
+                 "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
+                 "other (%0.3f, %0.3f), alpha %0.3f",
+                 event->getPointerId(resampledIndices[j]), resampledValues[j],
+                 resampledValues[MAX_POINTERS + j], currentValues[j],
+                 currentValues[MAX_POINTERS + j], otherValues[j], otherValues[MAX_POINTERS + j],
+                 alpha);
+    }
+
     event->addSample(sampleTime, touchState.lastResample.pointers);
 }
 
@@ -404,17 +404,21 @@ void AccumulatingVelocityTrackerStrategy::addMovement(nsecs_t eventTime, int32_t
         // for this time (i.e. pop out the last element, and insert the updated movement).
         // We only compare against the last value, as it is likely that addMovement is called
         // in chronological order as events occur.
-        movements.popBack();
+        onMovementRemoved(pointerId, movements.popBack());
+    } else if (size == HISTORY_SIZE) {
+        // The oldest movement gets overwritten.
+        onMovementRemoved(pointerId, movements[0]);
     }
 
     movements.pushBack({eventTime, position});
+    onMovementAdded(pointerId, movements[movements.size() - 1]);
 
     // Clear movements that do not fall within `mHorizonNanos` of the latest movement.
     // Note that, if in the future we decide to use more movements (i.e. increase HISTORY_SIZE),
     // we can consider making this step binary-search based, which will give us some improvement.
     if (mMaintainHorizonDuringAdd) {
         while (eventTime - movements[0].eventTime > mHorizonNanos) {
-            movements.popFront();
+            onMovementRemoved(pointerId, movements.popFront());
         }
     }
 }
@@ -430,6 +434,78 @@ LeastSquaresVelocityTrackerStrategy::LeastSquaresVelocityTrackerStrategy(uint32_
 
 LeastSquaresVelocityTrackerStrategy::~LeastSquaresVelocityTrackerStrategy() {}
 
+void LeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime, int32_t pointerId,
+                                                      float position) {
+    AccumulatingVelocityTrackerStrategy::addMovement(eventTime, pointerId, position);
+
+    if (usesRunningSums() && eventTime - mRunningSums[pointerId].origin > REBASE_INTERVAL) {
+        rebuildRunningSums(pointerId);
+    }
+}
+
+void LeastSquaresVelocityTrackerStrategy::clearPointer(int32_t pointerId) {
+    AccumulatingVelocityTrackerStrategy::clearPointer(pointerId);
+    mRunningSums.erase(pointerId);
+}
+
+void LeastSquaresVelocityTrackerStrategy::onMovementAdded(int32_t pointerId,
+                                                          const Movement& movement) {
+    if (!usesRunningSums()) {
+        return;
+    }
+    RunningSums& sums = mRunningSums[pointerId];
+    if (sums.count == 0) {
+        sums = {.origin = movement.eventTime};
+    }
+    sums.add(movement, 1);
+}
+
+void LeastSquaresVelocityTrackerStrategy::onMovementRemoved(int32_t pointerId,
+                                                            const Movement& movement) {
+    if (!usesRunningSums()) {
+        return;
+    }
+    RunningSums& sums = mRunningSums[pointerId];
+    if (sums.count <= 1) {
+        // Start over from exact zeroes rather than from the rounding errors of the subtractions.
+        sums = {};
+        return;
+    }
+    sums.add(movement, -1);
+}
+
+bool LeastSquaresVelocityTrackerStrategy::usesRunningSums() const {
+    return mDegree >= 2 && mWeighting == Weighting::NONE;
+}
+
+void LeastSquaresVelocityTrackerStrategy::rebuildRunningSums(int32_t pointerId) {
+    const RingBuffer<Movement>& movements = mMovements.at(pointerId);
+    RunningSums& sums = mRunningSums[pointerId];
+    sums = {.origin = movements[0].eventTime};
+    for (const Movement& movement : movements) {
+        sums.add(movement, 1);
+    }
+}
+
+void LeastSquaresVelocityTrackerStrategy::RunningSums::add(const Movement& movement,
+                                                           double sign) {
+    const double x = (movement.eventTime - origin) * 0.000000001;
+    const double y = movement.position;
+    const double x2 = x * x;
+    sx += sign * x;
+    sx2 += sign * x2;
+    sx3 += sign * x2 * x;
+    sx4 += sign * x2 * x2;
+    sy += sign * y;
+    sxy += sign * x * y;
+    sx2y += sign * x2 * y;
+    if (sign > 0) {
+        count++;
+    } else {
+        count--;
+    }
+}
+
 /**
  * Solves a linear least squares problem to obtain a N degree polynomial that fits
  * the specified input data as nearly as possible.
@@ -597,52 +673,33 @@ static std::optional<float> solveLeastSquares(const std::vector<float>& x,
 }
 
 /*
- * Optimized unweighted second-order least squares fit. About 2x speed improvement compared to
- * the default implementation
+ * Optimized unweighted second-order least squares fit, from the running sums of the history. About
+ * 2x speed improvement compared to the default implementation even without the running sums, which
+ * make it independent of the size of the history.
  */
 std::optional<float> LeastSquaresVelocityTrackerStrategy::solveUnweightedLeastSquaresDeg2(
-        const RingBuffer<Movement>& movements) const {
+        const RunningSums& sums, nsecs_t latestEventTime) const {
     // Solving y = a*x^2 + b*x + c, where
-    //      - "x" is age (i.e. duration since latest movement) of the movemnets
+    //      - "x" is the time of the movements since the origin of the sums
     //      - "y" is positions of the movements.
-    float sxi = 0, sxiyi = 0, syi = 0, sxi2 = 0, sxi3 = 0, sxi2yi = 0, sxi4 = 0;
-
-    const size_t count = movements.size();
-    const Movement& newestMovement = movements[count - 1];
-    for (size_t i = 0; i < count; i++) {
-        const Movement& movement = movements[i];
-        nsecs_t age = newestMovement.eventTime - movement.eventTime;
-        float xi = -age * SECONDS_PER_NANO;
-        float yi = movement.position;
-
-        float xi2 = xi*xi;
-        float xi3 = xi2*xi;
-        float xi4 = xi3*xi;
-        float xiyi = xi*yi;
-        float xi2yi = xi2*yi;
-
-        sxi += xi;
-        sxi2 += xi2;
-        sxiyi += xiyi;
-        sxi2yi += xi2yi;
-        syi += yi;
-        sxi3 += xi3;
-        sxi4 += xi4;
-    }
-
-    float Sxx = sxi2 - sxi*sxi / count;
-    float Sxy = sxiyi - sxi*syi / count;
-    float Sxx2 = sxi3 - sxi*sxi2 / count;
-    float Sx2y = sxi2yi - sxi2*syi / count;
-    float Sx2x2 = sxi4 - sxi2*sxi2 / count;
-
-    float denominator = Sxx*Sx2x2 - Sxx2*Sxx2;
+    // The velocity is the derivative at the latest movement, 2*a*x + b.
+    const double count = sums.count;
+    const double Sxx = sums.sx2 - sums.sx * sums.sx / count;
+    const double Sxy = sums.sxy - sums.sx * sums.sy / count;
+    const double Sxx2 = sums.sx3 - sums.sx * sums.sx2 / count;
+    const double Sx2y = sums.sx2y - sums.sx2 * sums.sy / count;
+    const double Sx2x2 = sums.sx4 - sums.sx2 * sums.sx2 / count;
+
+    const double denominator = Sxx * Sx2x2 - Sxx2 * Sxx2;
     if (denominator == 0) {
         ALOGW("division by 0 when computing velocity, Sxx=%f, Sx2x2=%f, Sxx2=%f", Sxx, Sx2x2, Sxx2);
         return std::nullopt;
     }
 
-    return (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
+    const double a = (Sx2y * Sxx - Sxy * Sxx2) / denominator;
+    const double b = (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
+    const double x = (latestEventTime - sums.origin) * 0.000000001;
+    return static_cast<float>(2 * a * x + b);
 }
 
 std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t pointerId) const {
@@ -668,7 +725,8 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t po
 
     if (degree == 2 && mWeighting == Weighting::NONE) {
         // Optimize unweighted, quadratic polynomial fit
-        return solveUnweightedLeastSquaresDeg2(movements);
+        return solveUnweightedLeastSquaresDeg2(mRunningSums.at(pointerId),
+                                               movements[size - 1].eventTime);
     }
 
     // Iterate over movement samples in reverse time order and collect samples.
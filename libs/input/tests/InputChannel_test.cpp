@@ -18,6 +18,8 @@
 
 #include "TestHelpers.h"
 
+#include <poll.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <time.h>
 #include <errno.h>
@@ -32,6 +34,15 @@
 
 namespace android {
 
+namespace {
+
+bool isReadable(const InputChannel& channel) {
+    struct pollfd pfd = {.fd = channel.getFd().get(), .events = POLLIN};
+    return poll(&pfd, 1, /*timeout=*/0) == 1 && (pfd.revents & POLLIN) != 0;
+}
+
+} // namespace
+
 class InputChannelTest : public testing::Test {
 };
 
@@ -227,4 +238,159 @@ TEST_F(InputChannelTest, DuplicateChannelAndAssertEqual) {
     EXPECT_EQ(*serverChannel == *dupChan, true) << "inputchannel should be equal after duplication";
 }
 
+TEST_F(InputChannelTest, SharedMemoryRing_SendsServerMessagesThroughRing) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name",
+                                               InputChannel::Transport::SHARED_MEMORY_RING,
+                                               serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+    EXPECT_EQ(InputChannel::Transport::SHARED_MEMORY_RING, serverChannel->getTransport());
+    EXPECT_EQ(InputChannel::Transport::SHARED_MEMORY_RING, clientChannel->getTransport());
+
+    // Server->Client communication
+    InputMessage serverMsg = {}, clientMsg;
+    serverMsg.header.type = InputMessage::Type::KEY;
+    serverMsg.header.seq = 1;
+    serverMsg.body.key.action = AKEY_EVENT_ACTION_DOWN;
+    EXPECT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    EXPECT_TRUE(isReadable(*clientChannel)) << "server should have woken up the client";
+
+    EXPECT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_EQ(serverMsg.header.type, clientMsg.header.type);
+    EXPECT_EQ(serverMsg.header.seq, clientMsg.header.seq);
+    EXPECT_EQ(serverMsg.body.key.action, clientMsg.body.key.action);
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_FALSE(isReadable(*clientChannel)) << "client should have cleared the doorbell";
+
+    // Client->Server communication still goes through the socket
+    InputMessage clientReply = {}, serverReply;
+    clientReply.header.type = InputMessage::Type::FINISHED;
+    clientReply.header.seq = 1;
+    clientReply.body.finished.handled = true;
+    EXPECT_EQ(OK, clientChannel->sendMessage(&clientReply));
+    EXPECT_EQ(OK, serverChannel->receiveMessage(&serverReply));
+    EXPECT_EQ(clientReply.header.type, serverReply.header.type);
+    EXPECT_EQ(clientReply.header.seq, serverReply.header.seq);
+    EXPECT_EQ(clientReply.body.finished.handled, serverReply.body.finished.handled);
+}
+
+TEST_F(InputChannelTest, SharedMemoryRing_OnlyRingsDoorbellWhenClientIsWaiting) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name",
+                                               InputChannel::Transport::SHARED_MEMORY_RING,
+                                               serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    InputMessage serverMsg = {}, clientMsg;
+    serverMsg.header.type = InputMessage::Type::FOCUS;
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        serverMsg.header.seq = seq;
+        ASSERT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    }
+
+    // Only the first message rings the doorbell. Count the doorbells by reading them directly; the
+    // client finds the messages in the ring regardless.
+    size_t doorbells = 0;
+    uint8_t doorbell;
+    while (::recv(clientChannel->getFd().get(), &doorbell, sizeof(doorbell), MSG_DONTWAIT) == 1) {
+        doorbells++;
+    }
+    EXPECT_EQ(1u, doorbells) << "only the first message should ring the doorbell";
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+        EXPECT_EQ(seq, clientMsg.header.seq);
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_FALSE(isReadable(*clientChannel));
+
+    // Once the client has drained the ring, the next message wakes it up again, and the doorbell
+    // stays set until the client has drained the ring once more.
+    for (uint32_t seq = 4; seq <= 5; seq++) {
+        serverMsg.header.seq = seq;
+        ASSERT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    }
+    EXPECT_TRUE(isReadable(*clientChannel));
+    ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_EQ(4u, clientMsg.header.seq);
+    EXPECT_TRUE(isReadable(*clientChannel)) << "the doorbell should stay set while messages remain";
+    ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_EQ(5u, clientMsg.header.seq);
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+    EXPECT_FALSE(isReadable(*clientChannel));
+}
+
+TEST_F(InputChannelTest, SharedMemoryRing_WhenFull_ReturnsWouldBlock) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name",
+                                               InputChannel::Transport::SHARED_MEMORY_RING,
+                                               serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    InputMessage serverMsg = {}, clientMsg;
+    serverMsg.header.type = InputMessage::Type::MOTION;
+    serverMsg.body.motion.pointerCount = 1;
+    uint32_t sentCount = 0;
+    while (serverChannel->sendMessage(&serverMsg) == OK) {
+        serverMsg.header.seq = ++sentCount;
+        ASSERT_LT(sentCount, 1000u) << "ring should have filled up";
+    }
+    EXPECT_EQ(WOULD_BLOCK, serverChannel->sendMessage(&serverMsg));
+
+    // Draining the ring makes room again, including across the end of the ring.
+    for (uint32_t seq = 0; seq < sentCount; seq++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+        EXPECT_EQ(seq, clientMsg.header.seq);
+        serverMsg.header.seq = sentCount + seq;
+        ASSERT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    }
+    for (uint32_t seq = sentCount; seq < 2 * sentCount; seq++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+        EXPECT_EQ(seq, clientMsg.header.seq);
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg));
+}
+
+TEST_F(InputChannelTest, SharedMemoryRing_ReceiveWhenPeerClosed_ReturnsAnError) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name",
+                                               InputChannel::Transport::SHARED_MEMORY_RING,
+                                               serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    serverChannel.reset(); // close server channel
+
+    InputMessage msg;
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->receiveMessage(&msg))
+            << "receiveMessage should have returned DEAD_OBJECT";
+}
+
+TEST_F(InputChannelTest, SharedMemoryRing_ParcelAndUnparcel) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel parceling",
+                                               InputChannel::Transport::SHARED_MEMORY_RING,
+                                               serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    InputChannel chan;
+    Parcel parcel;
+    ASSERT_EQ(OK, clientChannel->writeToParcel(&parcel));
+    parcel.setDataPosition(0);
+    ASSERT_EQ(OK, chan.readFromParcel(&parcel));
+    EXPECT_EQ(chan == *clientChannel, true);
+    EXPECT_EQ(InputChannel::Transport::SHARED_MEMORY_RING, chan.getTransport());
+
+    // The unparceled channel reads from the same ring
+    InputMessage serverMsg = {}, clientMsg;
+    serverMsg.header.type = InputMessage::Type::FOCUS;
+    serverMsg.header.seq = 1;
+    ASSERT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    ASSERT_EQ(OK, chan.receiveMessage(&clientMsg));
+    EXPECT_EQ(serverMsg.header.seq, clientMsg.header.seq);
+}
+
 } // namespace android
@@ -554,6 +554,34 @@ TEST_F(MotionEventTest, CopyFrom_DoNotKeepHistory) {
     ASSERT_EQ(event.getX(0), copy.getX(0));
 }
 
+TEST_F(MotionEventTest, GetAxisValueHistory_MatchesHistoricalAxisValues) {
+    MotionEvent event;
+    initializeEventWithHistory(&event);
+
+    const size_t sampleCount = event.getHistorySize() + 1;
+    for (int32_t axis : {AMOTION_EVENT_AXIS_X, AMOTION_EVENT_AXIS_Y, AMOTION_EVENT_AXIS_PRESSURE,
+                         AMOTION_EVENT_AXIS_ORIENTATION}) {
+        for (size_t pointerIndex = 0; pointerIndex < event.getPointerCount(); pointerIndex++) {
+            std::vector<float> values(sampleCount);
+            event.getAxisValueHistory(axis, pointerIndex, values.data());
+            for (size_t i = 0; i < sampleCount; i++) {
+                EXPECT_EQ(event.getHistoricalAxisValue(axis, pointerIndex, i), values[i])
+                        << "axis=" << MotionEvent::getLabel(axis) << " pointer=" << pointerIndex
+                        << " sample=" << i;
+            }
+        }
+    }
+}
+
+TEST_F(MotionEventTest, ReserveSamples_KeepsExistingSamples) {
+    MotionEvent event;
+    initializeEventWithHistory(&event);
+
+    event.reserveSamples(10);
+
+    ASSERT_NO_FATAL_FAILURE(assertEqualsEventWithHistory(&event));
+}
+
 TEST_F(MotionEventTest, OffsetLocation) {
     MotionEvent event;
     initializeEventWithHistory(&event);
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <attestation/HmacKeyManager.h>
+#include <input/InputTransport.h>
+#include <poll.h>
+#include <utils/Timers.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+using Transport = InputChannel::Transport;
+
+// Publishes the events of a single touch gesture, the way InputDispatcher does.
+class Gesture {
+public:
+    Gesture(InputPublisher& publisher, size_t pointerCount)
+          : mPublisher(publisher), mProperties(pointerCount), mCoords(pointerCount) {
+        for (size_t i = 0; i < pointerCount; i++) {
+            mProperties[i].id = static_cast<int32_t>(i);
+            mProperties[i].toolType = ToolType::FINGER;
+        }
+        publish(AMOTION_EVENT_ACTION_DOWN);
+    }
+
+    ~Gesture() { publish(AMOTION_EVENT_ACTION_CANCEL); }
+
+    void move() { publish(AMOTION_EVENT_ACTION_MOVE); }
+
+private:
+    void publish(int32_t action) {
+        for (size_t i = 0; i < mCoords.size(); i++) {
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, static_cast<float>(mSeq + 100 * i));
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, static_cast<float>(mSeq + 100 * i));
+        }
+        ui::Transform identity;
+        const nsecs_t eventTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (action == AMOTION_EVENT_ACTION_DOWN) {
+            mDownTime = eventTime;
+        }
+        const int32_t flags =
+                action == AMOTION_EVENT_ACTION_CANCEL ? AMOTION_EVENT_FLAG_CANCELED : 0;
+        mPublisher.publishMotionEvent(mSeq++, InputEvent::nextId(), /*deviceId=*/1,
+                                      AINPUT_SOURCE_TOUCHSCREEN, ADISPLAY_ID_DEFAULT, INVALID_HMAC,
+                                      action, /*actionButton=*/0, flags, /*edgeFlags=*/0,
+                                      /*metaState=*/0, /*buttonState=*/0,
+                                      MotionClassification::NONE, identity, /*xPrecision=*/0,
+                                      /*yPrecision=*/0, AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                      AMOTION_EVENT_INVALID_CURSOR_POSITION, identity, mDownTime,
+                                      eventTime, mProperties.size(), mProperties.data(),
+                                      mCoords.data());
+    }
+
+    InputPublisher& mPublisher;
+    std::vector<PointerProperties> mProperties;
+    std::vector<PointerCoords> mCoords;
+    uint32_t mSeq = 1;
+    nsecs_t mDownTime = 0;
+};
+
+// Consumes everything that has been published, and returns how many events there were.
+size_t consumeAll(InputConsumer& consumer, PreallocatedInputEventFactory& factory) {
+    size_t count = 0;
+    uint32_t seq;
+    InputEvent* event;
+    while (consumer.consume(&factory, /*consumeBatches=*/true, /*frameTime=*/-1, &seq, &event) ==
+           OK) {
+        consumer.sendFinishedSignal(seq, /*handled=*/true);
+        count++;
+    }
+    return count;
+}
+
+void receiveAllResponses(InputPublisher& publisher) {
+    while (publisher.receiveConsumerResponse().ok()) {
+    }
+}
+
+// CPU cost of delivering the events of a frame on one thread: the dispatcher publishes the
+// samples of range(1) pointers range(2) times, then the app consumes them and finishes them.
+void BM_publishAndConsume(benchmark::State& state) {
+    const Transport transport = static_cast<Transport>(state.range(0));
+    const size_t pointerCount = static_cast<size_t>(state.range(1));
+    const size_t eventsPerFrame = static_cast<size_t>(state.range(2));
+
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    if (InputChannel::openInputChannelPair("benchmark", transport, serverChannel, clientChannel) !=
+        OK) {
+        state.SkipWithError("Could not open channel pair");
+        return;
+    }
+    InputPublisher publisher(std::move(serverChannel));
+    InputConsumer consumer(std::move(clientChannel));
+    PreallocatedInputEventFactory factory;
+
+    {
+        Gesture gesture(publisher, pointerCount);
+        for (auto _ : state) {
+            for (size_t i = 0; i < eventsPerFrame; i++) {
+                gesture.move();
+            }
+            benchmark::DoNotOptimize(consumeAll(consumer, factory));
+            receiveAllResponses(publisher);
+        }
+    }
+    consumeAll(consumer, factory);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * eventsPerFrame));
+}
+
+// Time from publishing an event to the app having consumed it, with the app waiting in poll()
+// on another thread like it does in its Looper.
+void BM_publishToConsumeLatency(benchmark::State& state) {
+    const Transport transport = static_cast<Transport>(state.range(0));
+    const size_t pointerCount = static_cast<size_t>(state.range(1));
+
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    if (InputChannel::openInputChannelPair("benchmark", transport, serverChannel, clientChannel) !=
+        OK) {
+        state.SkipWithError("Could not open channel pair");
+        return;
+    }
+    InputPublisher publisher(std::move(serverChannel));
+    InputConsumer consumer(std::move(clientChannel));
+
+    std::atomic<size_t> consumedCount = 0;
+    std::atomic<bool> stop = false;
+    std::thread app([&]() {
+        PreallocatedInputEventFactory factory;
+        struct pollfd pfd = {.fd = consumer.getChannel()->getFd().get(), .events = POLLIN};
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (poll(&pfd, 1, /*timeout=*/100) <= 0) {
+                continue;
+            }
+            consumedCount.fetch_add(consumeAll(consumer, factory), std::memory_order_release);
+        }
+    });
+
+    {
+        Gesture gesture(publisher, pointerCount);
+        size_t published = 1;
+        while (consumedCount.load(std::memory_order_acquire) < published) {
+        }
+
+        for (auto _ : state) {
+            const auto start = std::chrono::steady_clock::now();
+            gesture.move();
+            published++;
+            while (consumedCount.load(std::memory_order_acquire) < published) {
+            }
+            const auto end = std::chrono::steady_clock::now();
+            state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+            receiveAllResponses(publisher);
+        }
+    }
+
+    stop = true;
+    app.join();
+}
+
+// Publishes range(1) samples of a range(0) pointer gesture per frame, like a high refresh rate
+// touchscreen does, and consumes them as a single resampled batch, like the app's Choreographer
+// does. Same flow as in TouchResampling_test.
+void BM_consumeResampledBatch(benchmark::State& state) {
+    const size_t pointerCount = static_cast<size_t>(state.range(0));
+    const size_t samplesPerFrame = static_cast<size_t>(state.range(1));
+
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    if (InputChannel::openInputChannelPair("benchmark", serverChannel, clientChannel) != OK) {
+        state.SkipWithError("Could not open channel pair");
+        return;
+    }
+    InputPublisher publisher(std::move(serverChannel));
+    InputConsumer consumer(std::move(clientChannel), /*enableTouchResampling=*/true);
+    PreallocatedInputEventFactory factory;
+
+    std::vector<PointerProperties> properties(pointerCount);
+    std::vector<PointerCoords> coords(pointerCount);
+    for (size_t i = 0; i < pointerCount; i++) {
+        properties[i].id = static_cast<int32_t>(i);
+        properties[i].toolType = ToolType::FINGER;
+    }
+    uint32_t seq = 1;
+    nsecs_t eventTime = 0;
+    auto publish = [&](int32_t action) {
+        for (size_t i = 0; i < pointerCount; i++) {
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_X, static_cast<float>(eventTime / 100000));
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, static_cast<float>(100 * i));
+        }
+        ui::Transform identity;
+        publisher.publishMotionEvent(seq++, InputEvent::nextId(), /*deviceId=*/1,
+                                     AINPUT_SOURCE_TOUCHSCREEN, ADISPLAY_ID_DEFAULT, INVALID_HMAC,
+                                     action, /*actionButton=*/0, /*flags=*/0, /*edgeFlags=*/0,
+                                     /*metaState=*/0, /*buttonState=*/0, MotionClassification::NONE,
+                                     identity, /*xPrecision=*/0, /*yPrecision=*/0,
+                                     AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                     AMOTION_EVENT_INVALID_CURSOR_POSITION, identity,
+                                     /*downTime=*/0, eventTime, pointerCount, properties.data(),
+                                     coords.data());
+    };
+    // The frame comes 8ms after the last sample. Since the consumer resamples 5ms before the
+    // frame time, it extrapolates from the last two samples.
+    auto consumeFrame = [&]() {
+        const nsecs_t frameTime = eventTime + std::chrono::nanoseconds(8ms).count();
+        size_t consumed = 0;
+        uint32_t consumedSeq;
+        InputEvent* event;
+        while (consumer.consume(&factory, /*consumeBatches=*/true, frameTime, &consumedSeq,
+                                &event) == OK) {
+            consumer.sendFinishedSignal(consumedSeq, /*handled=*/true);
+            consumed++;
+        }
+        receiveAllResponses(publisher);
+        return consumed;
+    };
+
+    publish(AMOTION_EVENT_ACTION_DOWN);
+    consumeFrame();
+    for (auto _ : state) {
+        for (size_t i = 0; i < samplesPerFrame; i++) {
+            eventTime += std::chrono::nanoseconds(4ms).count();
+            publish(AMOTION_EVENT_ACTION_MOVE);
+        }
+        benchmark::DoNotOptimize(consumeFrame());
+    }
+    publish(AMOTION_EVENT_ACTION_CANCEL);
+    consumeFrame();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * samplesPerFrame));
+}
+
+// Reading every sample of an axis, one at a time with getHistoricalX when range(1) is 0, or all
+// at once with getAxisValueHistory when range(1) is 1.
+void BM_readAxisHistory(benchmark::State& state) {
+    const size_t sampleCount = static_cast<size_t>(state.range(0));
+    const bool readAll = state.range(1) != 0;
+
+    PointerProperties properties;
+    properties.clear();
+    properties.toolType = ToolType::FINGER;
+    PointerCoords coords;
+    coords.clear();
+    MotionEvent event;
+    ui::Transform transform;
+    transform.set(2.f, 0.f, 0.f, 2.f);
+    event.initialize(InputEvent::nextId(), /*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN,
+                     ADISPLAY_ID_DEFAULT, INVALID_HMAC, AMOTION_EVENT_ACTION_MOVE,
+                     /*actionButton=*/0, /*flags=*/0, /*edgeFlags=*/0, /*metaState=*/0,
+                     /*buttonState=*/0, MotionClassification::NONE, transform, /*xPrecision=*/0,
+                     /*yPrecision=*/0, AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                     AMOTION_EVENT_INVALID_CURSOR_POSITION, transform, /*downTime=*/0,
+                     /*eventTime=*/0, /*pointerCount=*/1, &properties, &coords);
+    event.reserveSamples(sampleCount - 1);
+    for (size_t i = 1; i < sampleCount; i++) {
+        coords.setAxisValue(AMOTION_EVENT_AXIS_X, static_cast<float>(i));
+        event.addSample(static_cast<nsecs_t>(i), &coords);
+    }
+
+    std::vector<float> values(sampleCount);
+    for (auto _ : state) {
+        if (readAll) {
+            event.getAxisValueHistory(AMOTION_EVENT_AXIS_X, /*pointerIndex=*/0, values.data());
+        } else {
+            for (size_t i = 0; i < sampleCount; i++) {
+                values[i] = event.getHistoricalX(/*pointerIndex=*/0, i);
+            }
+        }
+        benchmark::DoNotOptimize(values.data());
+    }
+}
+
+void transportArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"transport", "pointers", "events"});
+    for (Transport transport : {Transport::SOCKET, Transport::SHARED_MEMORY_RING}) {
+        for (int64_t pointers : {1, 5}) {
+            for (int64_t events : {1, 8, 32}) {
+                b->Args({static_cast<int64_t>(transport), pointers, events});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_publishAndConsume)->Apply(transportArgs);
+BENCHMARK(BM_publishToConsumeLatency)
+        ->ArgNames({"transport", "pointers"})
+        ->ArgsProduct({{static_cast<int64_t>(Transport::SOCKET),
+                        static_cast<int64_t>(Transport::SHARED_MEMORY_RING)},
+                       {1, 5}})
+        ->UseManualTime();
+BENCHMARK(BM_consumeResampledBatch)
+        ->ArgNames({"pointers", "samples"})
+        ->ArgsProduct({{1, 2, 5, 10}, {1, 2, 4}});
+BENCHMARK(BM_readAxisHistory)->ArgNames({"samples", "readAll"})->ArgsProduct({{4, 16}, {0, 1}});
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ftl/enum.h>
+#include <input/VelocityTracker.h>
+#include <utils/Timers.h>
+
+#include <chrono>
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr nsecs_t FRAME_INTERVAL = std::chrono::nanoseconds(8ms).count();
+
+// Feeds a fling to a VelocityTracker and computes the velocities after every frame, the way a
+// scrolling view does.
+void BM_addMovementAndGetVelocity(benchmark::State& state) {
+    const auto strategy = static_cast<VelocityTracker::Strategy>(state.range(0));
+    const int32_t pointerCount = state.range(1);
+    state.SetLabel(ftl::enum_string(strategy));
+
+    VelocityTracker tracker(strategy);
+    nsecs_t eventTime = 0;
+    float position = 0;
+    for (auto _ : state) {
+        eventTime += FRAME_INTERVAL;
+        // Accelerate, so that the strategies don't all see the same movement every time.
+        position += 8 + (eventTime / FRAME_INTERVAL) % 16;
+        for (int32_t pointerId = 0; pointerId < pointerCount; pointerId++) {
+            tracker.addMovement(eventTime, pointerId, AMOTION_EVENT_AXIS_X, position);
+            tracker.addMovement(eventTime, pointerId, AMOTION_EVENT_AXIS_Y, position / 2);
+        }
+        for (int32_t pointerId = 0; pointerId < pointerCount; pointerId++) {
+            benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_X, pointerId));
+            benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_Y, pointerId));
+        }
+    }
+}
+
+BENCHMARK(BM_addMovementAndGetVelocity)
+        ->ArgNames({"strategy", "pointers"})
+        ->ArgsProduct({benchmark::CreateDenseRange(ftl::to_underlying(
+                                                           VelocityTracker::Strategy::MIN),
+                                                   ftl::to_underlying(
+                                                           VelocityTracker::Strategy::MAX),
+                                                   /*step=*/1),
+                       {1, 5}});
+
+} // namespace
+} // namespace android
@@ -1335,6 +1335,21 @@ TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategy_Parabolic3) {
     computeAndCheckQuadraticVelocity(motions, 0E3);
 }
 
+/*
+ * A long straight line :: most of the movements have to leave the history again, so the result
+ * depends on the sums of the movements in the history staying accurate while the gesture goes on.
+ */
+TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategy_LongGesture) {
+    std::vector<PlanarMotionEventEntry> motions;
+    for (int i = 0; i <= 1000; i++) {
+        // 8 px every 8 ms, so 1000 px per second.
+        const float position = 8 * i;
+        motions.push_back({i * 8ms, {{position, position}}});
+    }
+    motions.push_back({motions.back().eventTime, motions.back().positions}); // ACTION_UP
+    computeAndCheckQuadraticVelocity(motions, 1E3);
+}
+
 // Recorded by hand on sailfish, but only the diffs are taken to test cumulative axis velocity.
 TEST_F(VelocityTrackerTest, AxisScrollVelocity) {
     std::vector<std::pair<std::chrono::nanoseconds, float>> motions = {
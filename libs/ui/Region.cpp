@@ -19,6 +19,8 @@
 #include <inttypes.h>
 #include <limits.h>
 
+#include <algorithm>
+
 #include <android-base/stringprintf.h>
 
 #include <utils/Log.h>
@@ -312,6 +314,91 @@ void Region::addRectUnchecked(int l, int t, int r, int b)
 
 // ----------------------------------------------------------------------------
 
+static inline bool containsRect(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right &&
+            outer.bottom >= inner.bottom;
+}
+
+// Computes the operations whose result is known without running
+// region_operator: empty operands, operands which don't overlap, and most
+// operations between two rects. Returns false if the general algorithm is
+// needed. 'dst' may be the same Region as 'lhs'.
+static bool trivial_boolean_operation(uint32_t op, Region& dst, const Region& lhs, Rect rhs) {
+    const Rect bounds = lhs.getBounds();
+
+    if (bounds.isEmpty()) {
+        if ((op == op_or || op == op_xor) && !rhs.isEmpty()) {
+            dst.set(rhs);
+        } else {
+            dst.clear();
+        }
+        return true;
+    }
+
+    if (rhs.isEmpty()) {
+        if (op == op_and) {
+            dst.clear();
+        } else {
+            dst = lhs;
+        }
+        return true;
+    }
+
+    // rects which line up and overlap or touch form a single rect
+    if (op == op_or && lhs.isRect() &&
+        ((bounds.left == rhs.left && bounds.right == rhs.right && bounds.top <= rhs.bottom &&
+          rhs.top <= bounds.bottom) ||
+         (bounds.top == rhs.top && bounds.bottom == rhs.bottom && bounds.left <= rhs.right &&
+          rhs.left <= bounds.right))) {
+        dst.set(Rect(std::min(bounds.left, rhs.left), std::min(bounds.top, rhs.top),
+                     std::max(bounds.right, rhs.right), std::max(bounds.bottom, rhs.bottom)));
+        return true;
+    }
+
+    Rect overlap;
+    if (!bounds.intersect(rhs, &overlap)) {
+        if (op == op_and) {
+            dst.clear();
+            return true;
+        }
+        if (op == op_nand) {
+            dst = lhs;
+            return true;
+        }
+        return false;
+    }
+
+    if (containsRect(rhs, bounds)) {
+        switch (op) {
+            case op_and:
+                dst = lhs;
+                return true;
+            case op_nand:
+                dst.clear();
+                return true;
+            case op_or:
+                dst.set(rhs);
+                return true;
+        }
+        return false;
+    }
+
+    if (!lhs.isRect()) return false;
+
+    switch (op) {
+        case op_and:
+            dst.set(overlap);
+            return true;
+        case op_or:
+            if (containsRect(bounds, rhs)) {
+                dst = lhs;
+                return true;
+            }
+            return false;
+    }
+    return false;
+}
+
 Region& Region::orSelf(const Rect& r) {
     if (isEmpty()) {
         set(r);
@@ -329,6 +416,7 @@ Region& Region::subtractSelf(const Rect& r) {
     return operationSelf(r, op_nand);
 }
 Region& Region::operationSelf(const Rect& r, uint32_t op) {
+    if (r.isValid() && trivial_boolean_operation(op, *this, *this, r)) return *this;
     Region lhs(*this);
     boolean_operation(op, *this, lhs, r);
     return *this;
@@ -353,6 +441,9 @@ Region& Region::subtractSelf(const Region& rhs) {
     return operationSelf(rhs, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, uint32_t op) {
+    if (rhs.isRect() && trivial_boolean_operation(op, *this, *this, rhs.getBounds())) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, rhs);
     return *this;
@@ -393,6 +484,7 @@ const Region Region::subtract(const Rect& rhs) const {
 }
 const Region Region::operation(const Rect& rhs, uint32_t op) const {
     Region result;
+    if (rhs.isValid() && trivial_boolean_operation(op, result, *this, rhs)) return result;
     boolean_operation(op, result, *this, rhs);
     return result;
 }
@@ -413,6 +505,9 @@ const Region Region::subtract(const Region& rhs) const {
 }
 const Region Region::operation(const Region& rhs, uint32_t op) const {
     Region result;
+    if (rhs.isRect() && trivial_boolean_operation(op, result, *this, rhs.getBounds())) {
+        return result;
+    }
     boolean_operation(op, result, *this, rhs);
     return result;
 }
@@ -438,6 +533,10 @@ Region& Region::subtractSelf(const Region& rhs, int dx, int dy) {
     return operationSelf(rhs, dx, dy, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, int dx, int dy, uint32_t op) {
+    if (rhs.isRect()) {
+        Rect rect = rhs.getBounds();
+        if (trivial_boolean_operation(op, *this, *this, rect.offsetBy(dx, dy))) return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, rhs, dx, dy);
     return *this;
@@ -459,6 +558,10 @@ const Region Region::subtract(const Region& rhs, int dx, int dy) const {
 }
 const Region Region::operation(const Region& rhs, int dx, int dy, uint32_t op) const {
     Region result;
+    if (rhs.isRect()) {
+        Rect rect = rhs.getBounds();
+        if (trivial_boolean_operation(op, result, *this, rect.offsetBy(dx, dy))) return result;
+    }
     boolean_operation(op, result, *this, rhs, dx, dy);
     return result;
 }
@@ -534,16 +637,16 @@ void Region::rasterizer::flushSpan()
     if (tail-head == ssize_t(span.size())) {
         Rect const* p = span.data();
         Rect const* q = head;
-        if (p->top == q->bottom) {
-            merge = true;
-            while (q != tail) {
-                if ((p->left != q->left) || (p->right != q->right)) {
-                    merge = false;
-                    break;
-                }
-                p++;
-                q++;
+        if (p->top == q->bottom && p->left == q->left && p->right == q->right) {
+            // Past the first rect, spans which differ are rare, so compare
+            // every rect rather than stopping at the first difference. This
+            // lets the loop be vectorized.
+            int32_t diff = 0;
+            const size_t count = span.size();
+            for (size_t i = 1; i < count; i++) {
+                diff |= (p[i].left ^ q[i].left) | (p[i].right ^ q[i].right);
             }
+            merge = diff == 0;
         }
     }
     if (merge) {
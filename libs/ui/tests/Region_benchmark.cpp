@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace android {
+namespace {
+
+constexpr int32_t kWidth = 1080;
+constexpr int32_t kHeight = 2400;
+
+struct Layer {
+    Rect bounds;
+    bool opaque;
+};
+
+// Front to back, like the layers of a phone showing an app with a dialog, a toast and a
+// picture-in-picture window.
+const std::vector<Layer> kLayers = {
+        {{0, 0, kWidth, 120}, false},                               // status bar
+        {{0, kHeight - 160, kWidth, kHeight}, false},               // navigation bar
+        {{120, kHeight - 400, kWidth - 120, kHeight - 300}, false}, // toast
+        {{kWidth - 480, 1600, kWidth - 40, 1870}, true},            // picture-in-picture
+        {{90, 900, kWidth - 90, 1500}, true},                       // dialog
+        {{0, 0, kWidth, kHeight}, false},                           // dim layer
+        {{0, 0, kWidth, kHeight}, true},                            // app
+        {{0, 0, kWidth, kHeight}, true},                            // wallpaper
+};
+
+// The region operations Output::ensureOutputLayerIfVisible does for each layer, walking from
+// front to back.
+void BM_computeVisibleRegions(benchmark::State& state) {
+    const Rect display(0, 0, kWidth, kHeight);
+    for (auto _ : state) {
+        Region aboveOpaqueLayers;
+        Region aboveCoveredLayers;
+        Region dirtyRegion;
+        for (const auto& layer : kLayers) {
+            Region visibleRegion(layer.bounds);
+            visibleRegion.andSelf(display);
+            Region coveredRegion = aboveCoveredLayers.intersect(visibleRegion);
+            aboveCoveredLayers.orSelf(visibleRegion);
+            visibleRegion.subtractSelf(aboveOpaqueLayers);
+            dirtyRegion.orSelf(visibleRegion.subtract(coveredRegion));
+            if (layer.opaque) {
+                aboveOpaqueLayers.orSelf(layer.bounds);
+            }
+            benchmark::DoNotOptimize(visibleRegion);
+        }
+        benchmark::DoNotOptimize(dirtyRegion);
+    }
+}
+BENCHMARK(BM_computeVisibleRegions);
+
+void BM_rectOrRect(benchmark::State& state) {
+    const Rect top(0, 0, kWidth, 1200);
+    const Rect bottom(0, 1200, kWidth, kHeight);
+    for (auto _ : state) {
+        Region region(top);
+        region.orSelf(bottom);
+        benchmark::DoNotOptimize(region);
+    }
+}
+BENCHMARK(BM_rectOrRect);
+
+void BM_rectAndRect(benchmark::State& state) {
+    const Region window(Rect(90, 900, kWidth - 90, 1500));
+    const Rect display(0, 0, kWidth, kHeight);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(window.intersect(display));
+    }
+}
+BENCHMARK(BM_rectAndRect);
+
+void BM_subtractDisjointRect(benchmark::State& state) {
+    const Region statusBar(Rect(0, 0, kWidth, 120));
+    const Rect navigationBar(0, kHeight - 160, kWidth, kHeight);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(statusBar.subtract(navigationBar));
+    }
+}
+BENCHMARK(BM_subtractDisjointRect);
+
+void BM_subtractCoveringRect(benchmark::State& state) {
+    const Region dialog(Rect(90, 900, kWidth - 90, 1500));
+    const Rect app(0, 0, kWidth, kHeight);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dialog.subtract(app));
+    }
+}
+BENCHMARK(BM_subtractCoveringRect);
+
+// A grid of range(0) x range(0) cells with every other cell set, so that no rects merge.
+Region makeCheckerboard(int32_t cells) {
+    const int32_t cellWidth = kWidth / cells;
+    const int32_t cellHeight = kHeight / cells;
+    Region region;
+    for (int32_t row = 0; row < cells; row++) {
+        for (int32_t column = row % 2; column < cells; column += 2) {
+            region.orSelf(Rect(column * cellWidth, row * cellHeight, (column + 1) * cellWidth,
+                               (row + 1) * cellHeight));
+        }
+    }
+    return region;
+}
+
+void BM_complexRegionSubtract(benchmark::State& state) {
+    const Region region = makeCheckerboard(static_cast<int32_t>(state.range(0)));
+    const Rect dialog(90, 900, kWidth - 90, 1500);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(dialog));
+    }
+}
+BENCHMARK(BM_complexRegionSubtract)->Arg(4)->Arg(16)->Arg(64);
+
+void BM_complexRegionOrComplexRegion(benchmark::State& state) {
+    const int32_t cells = static_cast<int32_t>(state.range(0));
+    const Region region = makeCheckerboard(cells);
+    const Region shifted = region.translate(kWidth / cells, 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.merge(shifted));
+    }
+}
+BENCHMARK(BM_complexRegionOrComplexRegion)->Arg(4)->Arg(16)->Arg(64);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -53,6 +53,8 @@ protected:
         }
         EXPECT_TRUE((original ^ modified).isEmpty());
     }
+
+    size_t rectCount(const Region& r) { return r.end() - r.begin(); }
 };
 
 TEST_F(RegionTest, MinimalDivision_TJunction) {
@@ -167,6 +169,69 @@ TEST_F(RegionTest, EqualsToSelf) {
     ASSERT_TRUE(touchableRegion.contains(50, 50));
 }
 
+TEST_F(RegionTest, RectOperations) {
+    const Rect a(0, 0, 100, 100);
+
+    // overlapping
+    const Rect b(50, 50, 150, 150);
+    EXPECT_TRUE(Region(a).intersect(b).isRect());
+    EXPECT_EQ(Rect(50, 50, 100, 100), Region(a).intersect(b).getBounds());
+    EXPECT_EQ(3, rectCount(Region(a).merge(b)));
+    EXPECT_EQ(2, rectCount(Region(a).subtract(b)));
+    EXPECT_TRUE((Region(a).merge(b) ^ (Region(a).subtract(b) | Region(b))).isEmpty());
+
+    // lined up and touching
+    const Region merged = Region(a).merge(Rect(0, 100, 100, 200));
+    EXPECT_TRUE(merged.isRect());
+    EXPECT_EQ(Rect(0, 0, 100, 200), merged.getBounds());
+    Region self(a);
+    self.orSelf(Rect(100, 0, 150, 100));
+    EXPECT_TRUE(self.isRect());
+    EXPECT_EQ(Rect(0, 0, 150, 100), self.getBounds());
+
+    // disjoint
+    const Rect c(200, 200, 300, 300);
+    EXPECT_TRUE(Region(a).intersect(c).isEmpty());
+    EXPECT_TRUE(Region(a).hasSameRects(Region(a).subtract(c)));
+    EXPECT_EQ(2, rectCount(Region(a).merge(c)));
+
+    // contained
+    const Rect d(25, 25, 75, 75);
+    EXPECT_TRUE(Region(d).hasSameRects(Region(d).intersect(a)));
+    EXPECT_TRUE(Region(d).subtract(a).isEmpty());
+    EXPECT_TRUE(Region(a).hasSameRects(Region(d).merge(a)));
+    EXPECT_TRUE(Region(a).hasSameRects(Region(a).merge(d)));
+    EXPECT_EQ(4, rectCount(Region(a).subtract(d)));
+
+    // empty
+    EXPECT_TRUE(Region(a).hasSameRects(Region().merge(a)));
+    EXPECT_TRUE(Region(a).hasSameRects(Region(a).subtract(Rect(0, 0, 0, 0))));
+    EXPECT_TRUE(Region(a).intersect(Rect(0, 0, 0, 0)).isEmpty());
+    EXPECT_TRUE(Region().subtract(a).isEmpty());
+}
+
+TEST_F(RegionTest, ComplexRegionRectOperations) {
+    Region r;
+    r.orSelf(Rect(0, 0, 100, 100));
+    r.orSelf(Rect(200, 0, 300, 100));
+
+    Region covered(r);
+    covered.subtractSelf(Rect(0, 0, 300, 100));
+    EXPECT_TRUE(covered.isEmpty());
+
+    Region disjoint(r);
+    disjoint.subtractSelf(Rect(0, 200, 300, 300));
+    EXPECT_TRUE(r.hasSameRects(disjoint));
+
+    Region merged(r);
+    merged.orSelf(Rect(0, 0, 300, 100));
+    EXPECT_TRUE(merged.isRect());
+    EXPECT_EQ(Rect(0, 0, 300, 100), merged.getBounds());
+
+    EXPECT_TRUE(r.hasSameRects(r.intersect(Rect(0, 0, 300, 100))));
+    EXPECT_TRUE(Region(Rect(50, 0, 100, 100)).hasSameRects(r.intersect(Rect(50, 0, 150, 100))));
+}
+
 TEST_F(RegionTest, RegionHash) {
     Region region1;
     region1.addRectUnchecked(10, 20, 30, 40);
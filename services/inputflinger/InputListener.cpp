@@ -64,6 +64,10 @@ void InputListenerInterface::notify(const NotifyArgs& generalArgs) {
 QueuedInputListener::QueuedInputListener(InputListenerInterface& innerListener)
       : mInnerListener(innerListener) {}
 
+QueuedInputListener::QueuedInputListener(InputListenerInterface& innerListener,
+                                         size_t motionStage)
+      : mInnerListener(innerListener), mMotionStage(motionStage) {}
+
 void QueuedInputListener::notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) {
     mArgsQueue.emplace_back(args);
 }
@@ -77,7 +81,11 @@ void QueuedInputListener::notifyKey(const NotifyKeyArgs& args) {
 }
 
 void QueuedInputListener::notifyMotion(const NotifyMotionArgs& args) {
-    mArgsQueue.emplace_back(args);
+    NotifyArgs& queuedArgs = mArgsQueue.emplace_back(args);
+    if (mMotionStage) {
+        std::get<NotifyMotionArgs>(queuedArgs).stageTimes[*mMotionStage] =
+                systemTime(SYSTEM_TIME_MONOTONIC);
+    }
 }
 
 void QueuedInputListener::notifySwitch(const NotifySwitchArgs& args) {
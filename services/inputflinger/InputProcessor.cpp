@@ -365,7 +365,8 @@ void MotionClassifier::monitor() {
 
 // --- InputProcessor ---
 
-InputProcessor::InputProcessor(InputListenerInterface& listener) : mQueuedListener(listener) {}
+InputProcessor::InputProcessor(InputListenerInterface& listener)
+      : mQueuedListener(listener, InputStageTimeline::PROCESSOR_TIME) {}
 
 void InputProcessor::onBinderDied(void* cookie) {
     InputProcessor* processor = static_cast<InputProcessor*>(cookie);
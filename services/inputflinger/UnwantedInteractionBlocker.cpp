@@ -340,7 +340,8 @@ UnwantedInteractionBlocker::UnwantedInteractionBlocker(InputListenerInterface& l
 
 UnwantedInteractionBlocker::UnwantedInteractionBlocker(InputListenerInterface& listener,
                                                        bool enablePalmRejection)
-      : mQueuedListener(listener), mEnablePalmRejection(enablePalmRejection) {}
+      : mQueuedListener(listener, InputStageTimeline::BLOCKER_TIME),
+        mEnablePalmRejection(enablePalmRejection) {}
 
 void UnwantedInteractionBlocker::notifyConfigurationChanged(
         const NotifyConfigurationChangedArgs& args) {
@@ -19,17 +19,59 @@
 #include <android/os/IInputConstants.h>
 #include <binder/Binder.h>
 #include <gui/constants.h>
+#include "../dispatcher/Entry.h"
+#include "../dispatcher/EntryPool.h"
 #include "../dispatcher/InputDispatcher.h"
 #include "../tests/FakeApplicationHandle.h"
 #include "../tests/FakeInputDispatcherPolicy.h"
 #include "../tests/FakeWindowHandle.h"
 
+#include <atomic>
+#include <cstdlib>
+
 using android::base::Result;
 using android::gui::WindowInfo;
 using android::os::IInputConstants;
 using android::os::InputEventInjectionResult;
 using android::os::InputEventInjectionSync;
 
+// Every heap allocation goes through the operator new below, so that the benchmarks can count them
+// and check that events are dispatched without allocating. A thread can stop counting while it
+// does work that is not part of the dispatch, such as consuming the events.
+static std::atomic<size_t> gHeapAllocations = 0;
+static thread_local bool gCountHeapAllocations = true;
+
+void* operator new(size_t size) {
+    if (gCountHeapAllocations) {
+        gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
 namespace android::inputdispatcher {
 
 namespace {
@@ -196,11 +238,174 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
     dispatcher.stop();
 }
 
+static void benchmarkNotifyMotionWithManyWindows(benchmark::State& state) {
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    InputDispatcher dispatcher(fakePolicy);
+    dispatcher.setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher.start();
+
+    // Create small windows tiled across the display, like in desktop mode, on top of a full
+    // screen window that receives the motion events. None of the small windows contain the
+    // touched point, but each of them has to be ruled out for the hit test and the occlusion
+    // checks.
+    constexpr int32_t TILE_SIZE = 50;
+    constexpr int32_t TILES_PER_ROW = 20;
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> windows;
+    std::vector<gui::WindowInfo> windowInfos;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        sp<FakeWindowHandle> tile =
+                sp<FakeWindowHandle>::make(application, dispatcher,
+                                           "Tile " + std::to_string(i), DISPLAY_ID);
+        const int32_t left = static_cast<int32_t>(i % TILES_PER_ROW) * TILE_SIZE;
+        const int32_t top = 200 + static_cast<int32_t>(i / TILES_PER_ROW) * TILE_SIZE;
+        tile->setFrame(Rect(left, top, left + TILE_SIZE, top + TILE_SIZE));
+        tile->setOwnerInfo(gui::Pid{static_cast<pid_t>(1000 + i)},
+                           gui::Uid{static_cast<uid_t>(10000 + i)});
+        windowInfos.push_back(*tile->getInfo());
+        windows.push_back(std::move(tile));
+    }
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window", DISPLAY_ID);
+    windowInfos.push_back(*window->getInfo());
+
+    dispatcher.onWindowInfosChanged({windowInfos, {}, 0, 0});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    for (auto _ : state) {
+        // Send ACTION_DOWN
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher.notifyMotion(motionArgs);
+
+        // Send ACTION_UP
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher.notifyMotion(motionArgs);
+
+        window->consumeMotion();
+        window->consumeMotion();
+    }
+
+    dispatcher.stop();
+}
+
+static void benchmarkEntryAllocationsForMotion(benchmark::State& state) {
+    const NotifyMotionArgs args = generateMotionArgs();
+    const ui::Transform identityTransform;
+    // The entries that notifyMotion and createDispatchEntry create for every motion event.
+    auto createEntries = [&]() {
+        std::shared_ptr<MotionEntry> entry =
+                makeSharedEntry<MotionEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
+                                             args.deviceId, args.source, args.displayId,
+                                             args.policyFlags, args.action, args.actionButton,
+                                             args.flags, args.metaState, args.buttonState,
+                                             args.classification, args.edgeFlags, args.xPrecision,
+                                             args.yPrecision, args.xCursorPosition,
+                                             args.yCursorPosition, args.downTime,
+                                             args.pointerProperties, args.pointerCoords);
+        auto dispatchEntry =
+                std::make_unique<DispatchEntry>(std::move(entry), InputTarget::Flags::FOREGROUND,
+                                                identityTransform, identityTransform,
+                                                /*globalScaleFactor=*/1.0f);
+        benchmark::DoNotOptimize(dispatchEntry.get());
+    };
+
+    // Warm up the pool, so that only the steady state is measured.
+    createEntries();
+
+    const size_t start = gHeapAllocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        createEntries();
+    }
+    const size_t heapAllocations = gHeapAllocations.load(std::memory_order_relaxed) - start;
+
+    state.counters["heapAllocationsPerEvent"] =
+            static_cast<double>(heapAllocations) / static_cast<double>(state.iterations());
+    if (heapAllocations != 0) {
+        state.SkipWithError("Creating the entries for a motion event allocated from the heap");
+    }
+}
+
+static void benchmarkEntryAllocationsForTouchStream(benchmark::State& state) {
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    InputDispatcher dispatcher(fakePolicy);
+    dispatcher.setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher.start();
+
+    // Create a window that will receive motion events
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window", DISPLAY_ID);
+
+    dispatcher.onWindowInfosChanged({{*window->getInfo()}, {}, 0, 0});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+    constexpr int MOVES_PER_GESTURE = 10;
+    // Consuming is the app's side of the channel, so its allocations are not counted.
+    auto consumeMotion = [&]() {
+        gCountHeapAllocations = false;
+        window->consumeMotion();
+        gCountHeapAllocations = true;
+    };
+    auto sendGesture = [&]() {
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher.notifyMotion(motionArgs);
+        consumeMotion();
+
+        motionArgs.action = AMOTION_EVENT_ACTION_MOVE;
+        for (int i = 0; i < MOVES_PER_GESTURE; i++) {
+            motionArgs.eventTime = now();
+            dispatcher.notifyMotion(motionArgs);
+            consumeMotion();
+        }
+
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher.notifyMotion(motionArgs);
+        consumeMotion();
+    };
+
+    // Warm up the pool, so that only the steady state is measured.
+    sendGesture();
+
+    const EntryPool::Stats start = EntryPool::getStats();
+    const size_t startHeapAllocations = gHeapAllocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        sendGesture();
+    }
+    const size_t heapAllocations =
+            gHeapAllocations.load(std::memory_order_relaxed) - startHeapAllocations;
+    const EntryPool::Stats end = EntryPool::getStats();
+
+    const double events = static_cast<double>(state.iterations() * (MOVES_PER_GESTURE + 2));
+    state.counters["entryAllocationsPerEvent"] = (end.allocations - start.allocations) / events;
+    // Every allocation on the way from notifyMotion to the channel, on any thread. The entries
+    // don't contribute to this, as benchmarkEntryAllocationsForMotion checks, but the rest of the
+    // dispatch still does, for example for the list of targets of each event.
+    state.counters["heapAllocationsPerEvent"] = heapAllocations / events;
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+    if (end.heapAllocations != start.heapAllocations) {
+        state.SkipWithError("Entries did not reuse pooled blocks");
+    }
+
+    dispatcher.stop();
+}
+
 } // namespace
 
 BENCHMARK(benchmarkNotifyMotion);
 BENCHMARK(benchmarkInjectMotion);
 BENCHMARK(benchmarkOnWindowInfosChanged);
+BENCHMARK(benchmarkNotifyMotionWithManyWindows)->Arg(100)->Arg(500);
+BENCHMARK(benchmarkEntryAllocationsForMotion);
+BENCHMARK(benchmarkEntryAllocationsForTouchStream);
 
 } // namespace android::inputdispatcher
 
@@ -177,14 +177,17 @@ std::string TouchModeEntry::getDescription() const {
 
 // --- MotionEntry ---
 
+static_assert(MAX_POINTERS * sizeof(PointerCoords) <= EntryPool::MAX_POOLED_SIZE,
+              "The pointers of a MotionEntry should fit in a pooled block");
+
 MotionEntry::MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionState,
                          nsecs_t eventTime, int32_t deviceId, uint32_t source, int32_t displayId,
                          uint32_t policyFlags, int32_t action, int32_t actionButton, int32_t flags,
                          int32_t metaState, int32_t buttonState,
                          MotionClassification classification, int32_t edgeFlags, float xPrecision,
                          float yPrecision, float xCursorPosition, float yCursorPosition,
-                         nsecs_t downTime, const std::vector<PointerProperties>& pointerProperties,
-                         const std::vector<PointerCoords>& pointerCoords)
+                         nsecs_t downTime, std::span<const PointerProperties> pointerProperties,
+                         std::span<const PointerCoords> pointerCoords)
       : EventEntry(id, Type::MOTION, eventTime, policyFlags),
         deviceId(deviceId),
         source(source),
@@ -201,8 +204,8 @@ MotionEntry::MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionSt
         xCursorPosition(xCursorPosition),
         yCursorPosition(yCursorPosition),
         downTime(downTime),
-        pointerProperties(pointerProperties),
-        pointerCoords(pointerCoords) {
+        pointerProperties(pointerProperties.begin(), pointerProperties.end()),
+        pointerCoords(pointerCoords.begin(), pointerCoords.end()) {
     EventEntry::injectionState = std::move(injectionState);
 }
 
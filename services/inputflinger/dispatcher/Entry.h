@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "EntryPool.h"
 #include "InjectionState.h"
 #include "InputTarget.h"
 
@@ -25,6 +26,7 @@
 #include <utils/Timers.h>
 #include <functional>
 #include <ostream>
+#include <span>
 #include <string>
 
 namespace android::inputdispatcher {
@@ -75,6 +77,11 @@ struct EventEntry {
     EventEntry(const EventEntry&) = delete;
     EventEntry& operator=(const EventEntry&) = delete;
     virtual ~EventEntry() = default;
+
+    // Entries are created for every event, so they come from the EntryPool. Use
+    // makeSharedEntry() rather than std::make_shared() to also pool the control block.
+    static void* operator new(size_t size) { return EntryPool::allocate(size); }
+    static void operator delete(void* ptr, size_t size) { EntryPool::deallocate(ptr, size); }
 };
 
 struct ConfigurationChangedEntry : EventEntry {
@@ -163,8 +170,9 @@ struct MotionEntry : EventEntry {
     float xCursorPosition;
     float yCursorPosition;
     nsecs_t downTime;
-    std::vector<PointerProperties> pointerProperties;
-    std::vector<PointerCoords> pointerCoords;
+    // Pooled like the entry itself, so that a motion event doesn't go to the heap for its pointers.
+    PooledVector<PointerProperties> pointerProperties;
+    PooledVector<PointerCoords> pointerCoords;
 
     size_t getPointerCount() const { return pointerProperties.size(); }
 
@@ -173,8 +181,8 @@ struct MotionEntry : EventEntry {
                 int32_t action, int32_t actionButton, int32_t flags, int32_t metaState,
                 int32_t buttonState, MotionClassification classification, int32_t edgeFlags,
                 float xPrecision, float yPrecision, float xCursorPosition, float yCursorPosition,
-                nsecs_t downTime, const std::vector<PointerProperties>& pointerProperties,
-                const std::vector<PointerCoords>& pointerCoords);
+                nsecs_t downTime, std::span<const PointerProperties> pointerProperties,
+                std::span<const PointerCoords> pointerCoords);
     std::string getDescription() const override;
 };
 
@@ -228,6 +236,9 @@ struct DispatchEntry {
     DispatchEntry(const DispatchEntry&) = delete;
     DispatchEntry& operator=(const DispatchEntry&) = delete;
 
+    static void* operator new(size_t size) { return EntryPool::allocate(size); }
+    static void operator delete(void* ptr, size_t size) { EntryPool::deallocate(ptr, size); }
+
     inline bool hasForegroundTarget() const {
         return targetFlags.test(InputTarget::Flags::FOREGROUND);
     }
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EntryPool.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+constexpr size_t NUM_SIZE_CLASSES =
+        EntryPool::MAX_POOLED_SIZE / EntryPool::SIZE_CLASS_GRANULARITY;
+constexpr uint32_t NUM_BLOCKS = EntryPool::MAX_POOLED_BLOCKS_PER_SIZE_CLASS;
+constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+// The free list head is a block index in the low bits and a tag in the high bits. The tag changes
+// on every update, so that a thread that read a block which was taken and put back in the meantime
+// fails its compare_exchange rather than corrupting the list.
+uint64_t pack(uint32_t tag, uint32_t index) {
+    return (static_cast<uint64_t>(tag) << 32) | index;
+}
+uint32_t tagOf(uint64_t head) {
+    return static_cast<uint32_t>(head >> 32);
+}
+uint32_t indexOf(uint64_t head) {
+    return static_cast<uint32_t>(head);
+}
+
+struct SizeClass {
+    // Room for NUM_BLOCKS blocks, reserved when the size class is first used. Blocks are
+    // identified by their index in it.
+    std::atomic<std::byte*> blocks = nullptr;
+    // How many blocks have been handed out at least once.
+    std::atomic<uint32_t> usedBlocks = 0;
+    std::atomic<uint64_t> freeHead = pack(0, NO_BLOCK);
+    // The block after each free block in the free list. Kept out of the blocks, since another
+    // thread may still read the link of a block that was just taken.
+    std::array<std::atomic<uint32_t>, NUM_BLOCKS> nextFree;
+};
+
+struct Pool {
+    std::array<SizeClass, NUM_SIZE_CLASSES> sizeClasses;
+    // Only for the stats, so they don't order anything. Every allocation and release updates one
+    // counter; the others only change on the slow paths.
+    std::atomic<size_t> allocations = 0;
+    std::atomic<size_t> releases = 0;
+    std::atomic<size_t> heapAllocations = 0;
+    // Blocks that are not in any size class, because they are too large or their size class was
+    // full.
+    std::atomic<size_t> unpooledAllocations = 0;
+    std::atomic<size_t> unpooledReleases = 0;
+};
+
+Pool& getPool() {
+    // Never destroyed, since entries may outlive the static destructors.
+    static Pool* pool = new Pool();
+    return *pool;
+}
+
+size_t sizeClassIndex(size_t size) {
+    return (std::max<size_t>(size, 1) - 1) / EntryPool::SIZE_CLASS_GRANULARITY;
+}
+
+size_t blockSize(size_t sizeClassIndex) {
+    return (sizeClassIndex + 1) * EntryPool::SIZE_CLASS_GRANULARITY;
+}
+
+std::byte* getOrReserveBlocks(SizeClass& sizeClass, size_t blockSize) {
+    std::byte* blocks = sizeClass.blocks.load(std::memory_order_acquire);
+    if (blocks != nullptr) {
+        return blocks;
+    }
+    // Only the blocks that get used are ever touched, so this mostly reserves address space.
+    auto* reserved = static_cast<std::byte*>(::operator new(NUM_BLOCKS * blockSize));
+    if (sizeClass.blocks.compare_exchange_strong(blocks, reserved, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+        return reserved;
+    }
+    // Another thread reserved them first.
+    ::operator delete(reserved);
+    return blocks;
+}
+
+uint32_t blockIndex(const SizeClass& sizeClass, const void* ptr, size_t blockSize) {
+    const std::byte* blocks = sizeClass.blocks.load(std::memory_order_relaxed);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t first = reinterpret_cast<uintptr_t>(blocks);
+    if (blocks == nullptr || address < first || address >= first + NUM_BLOCKS * blockSize) {
+        return NO_BLOCK;
+    }
+    // The offset fits in 32 bits, which makes the division a lot cheaper.
+    return static_cast<uint32_t>(address - first) / static_cast<uint32_t>(blockSize);
+}
+
+} // namespace
+
+void* EntryPool::allocate(size_t size) {
+    Pool& pool = getPool();
+    pool.allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size > MAX_POOLED_SIZE) {
+        pool.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        pool.unpooledAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    const size_t index = sizeClassIndex(size);
+    SizeClass& sizeClass = pool.sizeClasses[index];
+    uint64_t head = sizeClass.freeHead.load(std::memory_order_acquire);
+    while (indexOf(head) != NO_BLOCK) {
+        const uint64_t next =
+                pack(tagOf(head) + 1,
+                     sizeClass.nextFree[indexOf(head)].load(std::memory_order_relaxed));
+        if (sizeClass.freeHead.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                                     std::memory_order_acquire)) {
+            return sizeClass.blocks.load(std::memory_order_relaxed) +
+                    indexOf(head) * blockSize(index);
+        }
+    }
+
+    pool.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    uint32_t used = sizeClass.usedBlocks.load(std::memory_order_relaxed);
+    while (used < NUM_BLOCKS) {
+        if (sizeClass.usedBlocks.compare_exchange_weak(used, used + 1,
+                                                       std::memory_order_relaxed)) {
+            return getOrReserveBlocks(sizeClass, blockSize(index)) + used * blockSize(index);
+        }
+    }
+    pool.unpooledAllocations.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void EntryPool::deallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    Pool& pool = getPool();
+    pool.releases.fetch_add(1, std::memory_order_relaxed);
+    if (size > MAX_POOLED_SIZE) {
+        pool.unpooledReleases.fetch_add(1, std::memory_order_relaxed);
+        ::operator delete(ptr);
+        return;
+    }
+    const size_t index = sizeClassIndex(size);
+    SizeClass& sizeClass = pool.sizeClasses[index];
+    const uint32_t block = blockIndex(sizeClass, ptr, blockSize(index));
+    if (block == NO_BLOCK) {
+        // The size class was full when this block was allocated.
+        pool.unpooledReleases.fetch_add(1, std::memory_order_relaxed);
+        ::operator delete(ptr);
+        return;
+    }
+
+    uint64_t head = sizeClass.freeHead.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        sizeClass.nextFree[block].store(indexOf(head), std::memory_order_relaxed);
+        next = pack(tagOf(head) + 1, block);
+    } while (!sizeClass.freeHead.compare_exchange_weak(head, next, std::memory_order_release,
+                                                       std::memory_order_relaxed));
+}
+
+EntryPool::Stats EntryPool::getStats() {
+    // The counters are read one at a time, so they may be off by the blocks being allocated or
+    // released meanwhile.
+    const Pool& pool = getPool();
+    const size_t releases = pool.releases.load(std::memory_order_relaxed);
+    const size_t unpooledReleases = pool.unpooledReleases.load(std::memory_order_relaxed);
+    const size_t allocations = std::max(pool.allocations.load(std::memory_order_relaxed), releases);
+    const size_t unpooledAllocations =
+            std::max(pool.unpooledAllocations.load(std::memory_order_relaxed), unpooledReleases);
+    size_t usedBlocks = 0;
+    for (const SizeClass& sizeClass : pool.sizeClasses) {
+        usedBlocks += sizeClass.usedBlocks.load(std::memory_order_relaxed);
+    }
+    const size_t liveBlocks = allocations - releases;
+    const size_t livePooledBlocks =
+            liveBlocks - std::min(liveBlocks, unpooledAllocations - unpooledReleases);
+    return {.allocations = allocations,
+            .heapAllocations = pool.heapAllocations.load(std::memory_order_relaxed),
+            .liveBlocks = liveBlocks,
+            .freeBlocks = usedBlocks - std::min(usedBlocks, livePooledBlocks)};
+}
+
+std::string EntryPool::dump(const char* prefix) {
+    const Stats stats = getStats();
+    return base::StringPrintf("%sEntryPool: allocations=%zu, heapAllocations=%zu, liveBlocks=%zu, "
+                              "freeBlocks=%zu\n",
+                              prefix, stats.allocations, stats.heapAllocations, stats.liveBlocks,
+                              stats.freeBlocks);
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * Memory for the EventEntry and DispatchEntry objects, which get created and destroyed for every
+ * event that goes through the dispatcher.
+ *
+ * Released blocks are kept in free lists by size class, so that a steady stream of events keeps
+ * reusing the same blocks rather than going through the allocator. Entries are created by the
+ * threads that notify the dispatcher and released by the dispatcher thread, so the pool is
+ * shared by all threads. The free lists are lock-free, so that the two threads don't contend for
+ * a lock on every event.
+ */
+class EntryPool {
+public:
+    struct Stats {
+        // Blocks handed out since the start of the process.
+        size_t allocations;
+        // How many of those were new blocks, because no released block of the right size was
+        // free.
+        size_t heapAllocations;
+        // Blocks currently handed out.
+        size_t liveBlocks;
+        // Blocks kept in the free lists.
+        size_t freeBlocks;
+    };
+
+    // Blocks larger than this always come from the heap. Large enough for the pointer coords of
+    // a MotionEntry with MAX_POINTERS pointers.
+    static constexpr size_t MAX_POOLED_SIZE = 4096;
+    // Blocks are rounded up to a multiple of this.
+    static constexpr size_t SIZE_CLASS_GRANULARITY = 64;
+    // The pool doesn't keep more than this many blocks per size class, so that a burst of events
+    // doesn't keep its memory around forever. Blocks beyond that come from the heap, and go back
+    // to it when released.
+    static constexpr size_t MAX_POOLED_BLOCKS_PER_SIZE_CLASS = 256;
+
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr, size_t size);
+
+    static Stats getStats();
+    static std::string dump(const char* prefix);
+};
+
+/**
+ * Allocator drawing from the EntryPool, for std::allocate_shared to put a shared entry and its
+ * control block in a single pooled block.
+ */
+template <typename T>
+struct EntryAllocator {
+    using value_type = T;
+
+    EntryAllocator() = default;
+    template <typename U>
+    EntryAllocator(const EntryAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(EntryPool::allocate(n * sizeof(T))); }
+    void deallocate(T* ptr, size_t n) { EntryPool::deallocate(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const EntryAllocator<U>&) const {
+        return true;
+    }
+};
+
+/**
+ * Vector drawing from the EntryPool, for the arrays that an entry owns, such as the pointers of a
+ * MotionEntry.
+ */
+template <typename T>
+using PooledVector = std::vector<T, EntryAllocator<T>>;
+
+template <typename T, typename... Args>
+std::shared_ptr<T> makeSharedEntry(Args&&... args) {
+    return std::allocate_shared<T>(EntryAllocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace android::inputdispatcher
@@ -45,6 +45,7 @@
 #include <cstddef>
 #include <ctime>
 #include <queue>
+#include <span>
 #include <sstream>
 
 #include "../InputDeviceMetricsSource.h"
@@ -362,8 +363,19 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(
     ALOG_ASSERT(eventEntry->type == EventEntry::Type::MOTION);
     const MotionEntry& motionEntry = static_cast<const MotionEntry&>(*eventEntry);
 
-    std::vector<PointerCoords> pointerCoords;
-    pointerCoords.resize(motionEntry.getPointerCount());
+    std::shared_ptr<MotionEntry> combinedMotionEntry =
+            makeSharedEntry<MotionEntry>(motionEntry.id, motionEntry.injectionState,
+                                         motionEntry.eventTime, motionEntry.deviceId,
+                                         motionEntry.source, motionEntry.displayId,
+                                         motionEntry.policyFlags, motionEntry.action,
+                                         motionEntry.actionButton, motionEntry.flags,
+                                         motionEntry.metaState, motionEntry.buttonState,
+                                         motionEntry.classification, motionEntry.edgeFlags,
+                                         motionEntry.xPrecision, motionEntry.yPrecision,
+                                         motionEntry.xCursorPosition, motionEntry.yCursorPosition,
+                                         motionEntry.downTime, motionEntry.pointerProperties,
+                                         motionEntry.pointerCoords);
+    PooledVector<PointerCoords>& pointerCoords = combinedMotionEntry->pointerCoords;
 
     // Use the first pointer information to normalize all other pointers. This could be any pointer
     // as long as all other pointers are normalized to the same value and the final DispatchEntry
@@ -378,7 +390,6 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(
         uint32_t pointerId = uint32_t(pointerProperties.id);
         const ui::Transform& currTransform = inputTarget.pointerTransforms[pointerId];
 
-        pointerCoords[pointerIndex].copyFrom(motionEntry.pointerCoords[pointerIndex]);
         // First, apply the current pointer's transform to update the coordinates into
         // window space.
         pointerCoords[pointerIndex].transform(currTransform);
@@ -387,19 +398,6 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(
         pointerCoords[pointerIndex].transform(inverseFirstTransform);
     }
 
-    std::unique_ptr<MotionEntry> combinedMotionEntry =
-            std::make_unique<MotionEntry>(motionEntry.id, motionEntry.injectionState,
-                                          motionEntry.eventTime, motionEntry.deviceId,
-                                          motionEntry.source, motionEntry.displayId,
-                                          motionEntry.policyFlags, motionEntry.action,
-                                          motionEntry.actionButton, motionEntry.flags,
-                                          motionEntry.metaState, motionEntry.buttonState,
-                                          motionEntry.classification, motionEntry.edgeFlags,
-                                          motionEntry.xPrecision, motionEntry.yPrecision,
-                                          motionEntry.xCursorPosition, motionEntry.yCursorPosition,
-                                          motionEntry.downTime, motionEntry.pointerProperties,
-                                          pointerCoords);
-
     std::unique_ptr<DispatchEntry> dispatchEntry =
             std::make_unique<DispatchEntry>(std::move(combinedMotionEntry), inputTargetFlags,
                                             firstPointerTransform, inputTarget.displayTransform,
@@ -982,6 +980,10 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
             mPendingEvent = mInboundQueue.front();
             mInboundQueue.pop_front();
             traceInboundQueueLengthLocked();
+            if (mPendingEvent->type == EventEntry::Type::MOTION &&
+                IdGenerator::getSource(mPendingEvent->id) == IdGenerator::Source::INPUT_READER) {
+                mLatencyTracker.trackDequeuedEvent(mPendingEvent->id, currentTime);
+            }
         }
 
         // Poke user activity for this event.
@@ -1202,7 +1204,7 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
     return false;
 }
 
-bool InputDispatcher::enqueueInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
+bool InputDispatcher::enqueueInboundEventLocked(std::shared_ptr<EventEntry> newEntry) {
     bool needWake = mInboundQueue.empty();
     mInboundQueue.push_back(std::move(newEntry));
     const EventEntry& entry = *(mInboundQueue.back());
@@ -1292,14 +1294,16 @@ sp<WindowInfoHandle> InputDispatcher::findTouchedWindowAtLocked(int32_t displayI
                                                                 bool ignoreDragWindow) const {
     // Traverse windows from front to back to find touched window.
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    const ui::Transform displayTransform = getTransformLocked(displayId);
+    for (size_t position : findTouchableWindowCandidatesLocked(displayId, x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[position];
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
         }
 
         const WindowInfo& info = *windowHandle->getInfo();
         if (!info.isSpy() &&
-            windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+            windowAcceptsTouchAt(info, displayId, x, y, isStylus, displayTransform)) {
             return windowHandle;
         }
     }
@@ -1338,10 +1342,12 @@ std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked
     // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    const ui::Transform displayTransform = getTransformLocked(displayId);
+    for (size_t position : findTouchableWindowCandidatesLocked(displayId, x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[position];
         const WindowInfo& info = *windowHandle->getInfo();
 
-        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, displayTransform)) {
             continue;
         }
         if (!info.isSpy()) {
@@ -3026,10 +3032,8 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
     info.obscuringOpacity = 0;
     info.obscuringUid = gui::Uid::INVALID;
     std::map<gui::Uid, float> opacityByUid;
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
+    for (size_t position : findWindowsAboveAtLocked(windowHandle, x, y)) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[position];
         const WindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) && otherInfo->frameContainsPoint(x, y) &&
             !haveSameApplicationToken(windowInfo, otherInfo)) {
@@ -3104,10 +3108,8 @@ bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<WindowInfoHandle>&
                                                     int32_t x, int32_t y) const {
     int32_t displayId = windowHandle->getInfo()->displayId;
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
+    for (size_t position : findWindowsAboveAtLocked(windowHandle, x, y)) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[position];
         const WindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) &&
             otherInfo->frameContainsPoint(x, y)) {
@@ -3121,10 +3123,8 @@ bool InputDispatcher::isWindowObscuredLocked(const sp<WindowInfoHandle>& windowH
     int32_t displayId = windowHandle->getInfo()->displayId;
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
     const WindowInfo* windowInfo = windowHandle->getInfo();
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
+    for (size_t position : findWindowsAboveOverlappingLocked(windowHandle)) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[position];
         const WindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) &&
             otherInfo->overlaps(windowInfo)) {
@@ -3381,7 +3381,7 @@ void InputDispatcher::enqueueDispatchEntryLocked(const std::shared_ptr<Connectio
                     // Generate a new MotionEntry with a new eventId using the resolved action and
                     // flags.
                     resolvedMotion =
-                            std::make_shared<MotionEntry>(mIdGenerator.nextId(),
+                            makeSharedEntry<MotionEntry>(mIdGenerator.nextId(),
                                                           motionEntry.injectionState,
                                                           motionEntry.eventTime,
                                                           motionEntry.deviceId, motionEntry.source,
@@ -4352,11 +4352,11 @@ void InputDispatcher::notifyKey(const NotifyKeyArgs& args) {
             mLock.lock();
         }
 
-        std::unique_ptr<KeyEntry> newEntry =
-                std::make_unique<KeyEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
-                                           args.deviceId, args.source, args.displayId, policyFlags,
-                                           args.action, flags, keyCode, args.scanCode, metaState,
-                                           repeatCount, args.downTime);
+        std::shared_ptr<KeyEntry> newEntry =
+                makeSharedEntry<KeyEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
+                                          args.deviceId, args.source, args.displayId, policyFlags,
+                                          args.action, flags, keyCode, args.scanCode, metaState,
+                                          repeatCount, args.downTime);
 
         needWake = enqueueInboundEventLocked(std::move(newEntry));
         mLock.unlock();
@@ -4473,15 +4473,15 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
         }
 
         // Just enqueue a new motion event.
-        std::unique_ptr<MotionEntry> newEntry =
-                std::make_unique<MotionEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
-                                              args.deviceId, args.source, args.displayId,
-                                              policyFlags, args.action, args.actionButton,
-                                              args.flags, args.metaState, args.buttonState,
-                                              args.classification, args.edgeFlags, args.xPrecision,
-                                              args.yPrecision, args.xCursorPosition,
-                                              args.yCursorPosition, args.downTime,
-                                              args.pointerProperties, args.pointerCoords);
+        std::shared_ptr<MotionEntry> newEntry =
+                makeSharedEntry<MotionEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
+                                             args.deviceId, args.source, args.displayId,
+                                             policyFlags, args.action, args.actionButton,
+                                             args.flags, args.metaState, args.buttonState,
+                                             args.classification, args.edgeFlags, args.xPrecision,
+                                             args.yPrecision, args.xCursorPosition,
+                                             args.yCursorPosition, args.downTime,
+                                             args.pointerProperties, args.pointerCoords);
 
         if (args.id != android::os::IInputConstants::INVALID_INPUT_EVENT_ID &&
             IdGenerator::getSource(args.id) == IdGenerator::Source::INPUT_READER &&
@@ -4490,6 +4490,7 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
             std::set<InputDeviceUsageSource> sources = getUsageSourcesForMotionArgs(args);
             mLatencyTracker.trackListener(args.id, isDown, args.eventTime, args.readTime,
                                           args.deviceId, sources);
+            mLatencyTracker.trackInputStages(args.id, args.stageTimes, now());
         }
 
         needWake = enqueueInboundEventLocked(std::move(newEntry));
@@ -4700,9 +4701,8 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
             mLock.lock();
             const nsecs_t* sampleEventTimes = motionEvent.getSampleEventTimes();
             const size_t pointerCount = motionEvent.getPointerCount();
-            const std::vector<PointerProperties>
-                    pointerProperties(motionEvent.getPointerProperties(),
-                                      motionEvent.getPointerProperties() + pointerCount);
+            const std::span<const PointerProperties>
+                    pointerProperties(motionEvent.getPointerProperties(), pointerCount);
 
             const PointerCoords* samplePointerCoords = motionEvent.getSamplePointerCoords();
             std::unique_ptr<MotionEntry> injectedEntry =
@@ -4720,9 +4720,7 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                                                   motionEvent.getRawXCursorPosition(),
                                                   motionEvent.getRawYCursorPosition(),
                                                   motionEvent.getDownTime(), pointerProperties,
-                                                  std::vector<PointerCoords>(samplePointerCoords,
-                                                                             samplePointerCoords +
-                                                                                     pointerCount));
+                                                  std::span(samplePointerCoords, pointerCount));
             transformMotionEntryForInjectionLocked(*injectedEntry, motionEvent.getTransform());
             injectedEntries.push(std::move(injectedEntry));
             for (size_t i = motionEvent.getHistorySize(); i > 0; i--) {
@@ -4739,9 +4737,7 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                                      motionEvent.getRawXCursorPosition(),
                                      motionEvent.getRawYCursorPosition(), motionEvent.getDownTime(),
                                      pointerProperties,
-                                     std::vector<PointerCoords>(samplePointerCoords,
-                                                                samplePointerCoords +
-                                                                        pointerCount));
+                                     std::span(samplePointerCoords, pointerCount));
                 transformMotionEntryForInjectionLocked(*nextInjectedEntry,
                                                        motionEvent.getTransform());
                 injectedEntries.push(std::move(nextInjectedEntry));
@@ -5071,6 +5067,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (windowInfoHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mWindowIndexByDisplay.erase(displayId);
         return;
     }
 
@@ -5116,6 +5113,73 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
 
     // Insert or replace
     mWindowHandlesByDisplay[displayId] = newHandles;
+    updateWindowIndexLocked(displayId);
+}
+
+void InputDispatcher::updateWindowIndexLocked(int32_t displayId) {
+    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    const ui::Transform displayTransform = getTransformLocked(displayId);
+    WindowIndex index;
+    std::vector<Rect> touchableBounds;
+    std::vector<Rect> frames;
+    touchableBounds.reserve(windowHandles.size());
+    frames.reserve(windowHandles.size());
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const WindowInfo& info = *windowHandles[i]->getInfo();
+        // Same transform as windowAcceptsTouchAt, so that the bounds contain every point that it
+        // considers to be inside the touchable region.
+        touchableBounds.push_back(displayTransform.transform(info.touchableRegion).getBounds());
+        frames.push_back(info.frame);
+        index.positions.emplace(windowHandles[i].get(), i);
+    }
+    index.touchableBounds = WindowSpatialIndex(std::move(touchableBounds));
+    index.frames = WindowSpatialIndex(std::move(frames));
+    mWindowIndexByDisplay[displayId] = std::move(index);
+}
+
+std::vector<size_t> InputDispatcher::findTouchableWindowCandidatesLocked(int32_t displayId,
+                                                                         float x, float y) const {
+    const auto it = mWindowIndexByDisplay.find(displayId);
+    if (it == mWindowIndexByDisplay.end()) {
+        return {};
+    }
+    const auto p = getTransformLocked(displayId).transform(x, y);
+    return it->second.touchableBounds.findAt(static_cast<int32_t>(std::floor(p.x)),
+                                             static_cast<int32_t>(std::floor(p.y)));
+}
+
+std::vector<size_t> InputDispatcher::findWindowsAboveAtLocked(
+        const sp<WindowInfoHandle>& windowHandle, int32_t x, int32_t y) const {
+    const auto it = mWindowIndexByDisplay.find(windowHandle->getInfo()->displayId);
+    if (it == mWindowIndexByDisplay.end()) {
+        return {};
+    }
+    const WindowIndex& index = it->second;
+    std::vector<size_t> positions = index.frames.findAt(x, y);
+    if (const auto positionIt = index.positions.find(windowHandle.get());
+        positionIt != index.positions.end()) {
+        // All windows from this one onwards are below it.
+        positions.erase(std::lower_bound(positions.begin(), positions.end(), positionIt->second),
+                        positions.end());
+    }
+    return positions;
+}
+
+std::vector<size_t> InputDispatcher::findWindowsAboveOverlappingLocked(
+        const sp<WindowInfoHandle>& windowHandle) const {
+    const auto it = mWindowIndexByDisplay.find(windowHandle->getInfo()->displayId);
+    if (it == mWindowIndexByDisplay.end()) {
+        return {};
+    }
+    const WindowIndex& index = it->second;
+    std::vector<size_t> positions = index.frames.findIntersecting(windowHandle->getInfo()->frame);
+    if (const auto positionIt = index.positions.find(windowHandle.get());
+        positionIt != index.positions.end()) {
+        // All windows from this one onwards are below it.
+        positions.erase(std::lower_bound(positions.begin(), positions.end(), positionIt->second),
+                        positions.end());
+    }
+    return positions;
 }
 
 /**
@@ -5816,6 +5880,7 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
+    dump += EntryPool::dump(INDENT2);
 }
 
 void InputDispatcher::dumpMonitors(std::string& dump, const std::vector<Monitor>& monitors) const {
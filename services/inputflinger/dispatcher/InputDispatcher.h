@@ -32,6 +32,7 @@
 #include "Monitor.h"
 #include "TouchState.h"
 #include "TouchedWindow.h"
+#include "WindowSpatialIndex.h"
 
 #include <attestation/HmacKeyManager.h>
 #include <gui/InputApplication.h>
@@ -212,7 +213,7 @@ private:
     void dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) REQUIRES(mLock);
 
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
-    bool enqueueInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
+    bool enqueueInboundEventLocked(std::shared_ptr<EventEntry> entry) REQUIRES(mLock);
 
     // Cleans up input state when dropping an inbound event.
     void dropInboundEventLocked(const EventEntry& entry, DropReason dropReason) REQUIRES(mLock);
@@ -350,6 +351,30 @@ private:
             mWindowHandlesByDisplay GUARDED_BY(mLock);
     std::unordered_map<int32_t /*displayId*/, android::gui::DisplayInfo> mDisplayInfos
             GUARDED_BY(mLock);
+
+    // Spatial indices over the windows of a display, so that hit tests don't have to go through
+    // all of them. The indices refer to the windows in mWindowHandlesByDisplay, which are ordered
+    // from front to back.
+    struct WindowIndex {
+        // Bounds of the touchable regions, in the logical display space used for hit tests.
+        WindowSpatialIndex touchableBounds;
+        // Window frames, in display space.
+        WindowSpatialIndex frames;
+        std::unordered_map<const android::gui::WindowInfoHandle*, size_t> positions;
+    };
+    std::unordered_map<int32_t /*displayId*/, WindowIndex> mWindowIndexByDisplay GUARDED_BY(mLock);
+    void updateWindowIndexLocked(int32_t displayId) REQUIRES(mLock);
+    // Returns the positions of the windows whose touchable region may contain the given display
+    // location, from front to back.
+    std::vector<size_t> findTouchableWindowCandidatesLocked(int32_t displayId, float x,
+                                                            float y) const REQUIRES(mLock);
+    // Return the positions of the windows above the given one whose frame contains the given
+    // point, or overlaps the frame of the given window, from front to back.
+    std::vector<size_t> findWindowsAboveAtLocked(
+            const sp<android::gui::WindowInfoHandle>& windowHandle, int32_t x, int32_t y) const
+            REQUIRES(mLock);
+    std::vector<size_t> findWindowsAboveOverlappingLocked(
+            const sp<android::gui::WindowInfoHandle>& windowHandle) const REQUIRES(mLock);
     void setInputWindowsLocked(
             const std::vector<sp<android::gui::WindowInfoHandle>>& inputWindowHandles,
             int32_t displayId) REQUIRES(mLock);
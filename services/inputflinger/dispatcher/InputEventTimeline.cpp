@@ -90,7 +90,9 @@ bool InputEventTimeline::operator==(const InputEventTimeline& rhs) const {
         }
     }
     return isDown == rhs.isDown && eventTime == rhs.eventTime && readTime == rhs.readTime &&
-            vendorId == rhs.vendorId && productId == rhs.productId && sources == rhs.sources;
+            vendorId == rhs.vendorId && productId == rhs.productId && sources == rhs.sources &&
+            stageTimes == rhs.stageTimes && enqueueTime == rhs.enqueueTime &&
+            dequeueTime == rhs.dequeueTime;
 }
 
 } // namespace android::inputdispatcher
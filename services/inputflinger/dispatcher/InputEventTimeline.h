@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../InputDeviceMetricsSource.h"
+#include "NotifyArgs.h"
 
 #include <binder/IBinder.h>
 #include <input/Input.h>
@@ -83,6 +84,11 @@ struct InputEventTimeline {
     const uint16_t vendorId;
     const uint16_t productId;
     const std::set<InputDeviceUsageSource> sources;
+    // Times at which the event left each stage before the dispatcher, indexed by
+    // InputStageTimeline. 0 if unknown.
+    std::array<nsecs_t, InputStageTimeline::SIZE> stageTimes{};
+    nsecs_t enqueueTime = 0; // time at which the dispatcher queued the event
+    nsecs_t dequeueTime = 0; // time at which the dispatcher started dispatching the event
 
     struct IBinderHash {
         std::size_t operator()(const sp<IBinder>& b) const {
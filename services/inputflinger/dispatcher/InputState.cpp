@@ -19,11 +19,28 @@
 
 #include "InputState.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <span>
 #include "InputDispatcher.h"
 
 namespace android::inputdispatcher {
 
+namespace {
+
+// Same as isStylusEvent, for the pooled pointers of a MotionEntry as well as those of a memento.
+bool isStylusMotion(uint32_t source, std::span<const PointerProperties> properties) {
+    if (!isFromSource(source, AINPUT_SOURCE_STYLUS)) {
+        return false;
+    }
+    return std::any_of(properties.begin(), properties.end(),
+                       [](const PointerProperties& pointerProperties) {
+                           return isStylusToolType(pointerProperties.toolType);
+                       });
+}
+
+} // namespace
+
 InputState::InputState(const IdGenerator& idGenerator) : mIdGenerator(idGenerator) {}
 
 InputState::~InputState() {}
@@ -97,8 +114,8 @@ bool InputState::trackMotion(const MotionEntry& entry, int32_t flags) {
 
     if (!mMotionMementos.empty()) {
         const MotionMemento& lastMemento = mMotionMementos.back();
-        if (isStylusEvent(lastMemento.source, lastMemento.pointerProperties) &&
-            !isStylusEvent(entry.source, entry.pointerProperties)) {
+        if (isStylusMotion(lastMemento.source, lastMemento.pointerProperties) &&
+            !isStylusMotion(entry.source, entry.pointerProperties)) {
             // We already have a stylus stream, and the new event is not from stylus.
             return false;
         }
@@ -345,9 +362,9 @@ bool InputState::shouldCancelPreviousStream(const MotionEntry& motionEntry) cons
         return false;
     }
 
-    if (isStylusEvent(lastMemento.source, lastMemento.pointerProperties)) {
+    if (isStylusMotion(lastMemento.source, lastMemento.pointerProperties)) {
         // A stylus is already active.
-        if (isStylusEvent(motionEntry.source, motionEntry.pointerProperties) &&
+        if (isStylusMotion(motionEntry.source, motionEntry.pointerProperties) &&
             actionMasked == AMOTION_EVENT_ACTION_DOWN) {
             // If this new event is from a different device, then cancel the old
             // stylus and allow the new stylus to take over, but only if it's going down.
@@ -42,6 +42,9 @@ static inline int64_t ns2hus(nsecs_t nanos) {
 // The value here has been determined empirically.
 static constexpr size_t MAX_EVENTS_FOR_STATISTICS = 20000;
 
+// The maximum number of devices to keep the per-stage latency for. Any other devices are ignored.
+static constexpr size_t MAX_DEVICES_FOR_STAGE_STATISTICS = 16;
+
 // Category (=namespace) name for the input settings that are applied at boot time
 static const char* INPUT_NATIVE_BOOT = "input_native_boot";
 // Feature flag name for the threshold of end-to-end touch latency that would trigger
@@ -122,9 +125,58 @@ AStatsManager_PullAtomCallbackReturn LatencyAggregator::pullAtomCallback(int32_t
 
 void LatencyAggregator::processTimeline(const InputEventTimeline& timeline) {
     processStatistics(timeline);
+    processStageStatistics(timeline);
     processSlowEvent(timeline);
 }
 
+void LatencyAggregator::processStageStatistics(const InputEventTimeline& timeline) {
+    std::scoped_lock lock(mLock);
+    const std::pair<uint16_t, uint16_t> device{timeline.vendorId, timeline.productId};
+    auto it = mStageHistograms.find(device);
+    if (it == mStageHistograms.end()) {
+        if (mStageHistograms.size() >= MAX_DEVICES_FOR_STAGE_STATISTICS) {
+            return;
+        }
+        it = mStageHistograms.emplace(device, StageHistograms{}).first;
+    }
+    StageHistograms& histograms = it->second;
+
+    // A stage is only counted if the times at both of its ends are known.
+    auto addStage = [&histograms](LatencyStage stage, nsecs_t start, nsecs_t end) {
+        if (start != 0 && end != 0) {
+            histograms[ftl::to_underlying(stage)].add(end - start);
+        }
+    };
+    const auto& stageTimes = timeline.stageTimes;
+    addStage(LatencyStage::READ_TO_MAPPED, timeline.readTime,
+             stageTimes[InputStageTimeline::MAPPER_TIME]);
+    addStage(LatencyStage::MAPPED_TO_BLOCKED, stageTimes[InputStageTimeline::MAPPER_TIME],
+             stageTimes[InputStageTimeline::BLOCKER_TIME]);
+    addStage(LatencyStage::BLOCKED_TO_PROCESSED, stageTimes[InputStageTimeline::BLOCKER_TIME],
+             stageTimes[InputStageTimeline::PROCESSOR_TIME]);
+    addStage(LatencyStage::PROCESSED_TO_QUEUED, stageTimes[InputStageTimeline::PROCESSOR_TIME],
+             timeline.enqueueTime);
+    addStage(LatencyStage::QUEUED_TO_DEQUEUED, timeline.enqueueTime, timeline.dequeueTime);
+    for (const auto& [connectionToken, connectionTimeline] : timeline.connectionTimelines) {
+        if (!connectionTimeline.isComplete()) {
+            continue;
+        }
+        addStage(LatencyStage::DEQUEUED_TO_DELIVER, timeline.dequeueTime,
+                 connectionTimeline.deliveryTime);
+    }
+}
+
+std::optional<LatencyHistogram> LatencyAggregator::getStageHistogram(uint16_t vendorId,
+                                                                     uint16_t productId,
+                                                                     LatencyStage stage) const {
+    std::scoped_lock lock(mLock);
+    const auto it = mStageHistograms.find({vendorId, productId});
+    if (it == mStageHistograms.end()) {
+        return std::nullopt;
+    }
+    return it->second[ftl::to_underlying(stage)];
+}
+
 void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
     std::scoped_lock lock(mLock);
     // Before we do any processing, check that we have not yet exceeded MAX_SIZE
@@ -274,7 +326,17 @@ std::string LatencyAggregator::dump(const char* prefix) const {
                              prefix, i, numDown, downBytesKb, i, numMove, moveBytesKb);
     }
 
-    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump +
+    std::string stageDump = StringPrintf("%s  Stage latencies:\n", prefix);
+    for (const auto& [device, histograms] : mStageHistograms) {
+        stageDump += StringPrintf("%s    vendorId=0x%04x productId=0x%04x:\n", prefix,
+                                  device.first, device.second);
+        for (LatencyStage stage : ftl::enum_range<LatencyStage>()) {
+            stageDump += StringPrintf("%s      %s: %s\n", prefix, ftl::enum_string(stage).c_str(),
+                                      histograms[ftl::to_underlying(stage)].dump().c_str());
+        }
+    }
+
+    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump + stageDump +
             StringPrintf("%s  mNumSketchEventsProcessed=%zu\n", prefix, mNumSketchEventsProcessed) +
             StringPrintf("%s  mLastSlowEventTime=%" PRId64 "\n", prefix, mLastSlowEventTime) +
             StringPrintf("%s  mNumEventsSinceLastSlowEventReport = %zu\n", prefix,
@@ -17,11 +17,16 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <ftl/enum.h>
 #include <kll.h>
 #include <statslog.h>
 #include <utils/Timers.h>
 
+#include <map>
+#include <optional>
+
 #include "InputEventTimeline.h"
+#include "LatencyHistogram.h"
 
 namespace android::inputdispatcher {
 
@@ -36,6 +41,19 @@ enum SketchIndex : size_t {
     SIZE = 7,       // Must be last
 };
 
+// The stages between reading an event and delivering it to the apps, which are each kept in a
+// histogram per device.
+enum class LatencyStage : size_t {
+    READ_TO_MAPPED = 0,       // InputReader mappers
+    MAPPED_TO_BLOCKED = 1,    // UnwantedInteractionBlocker
+    BLOCKED_TO_PROCESSED = 2, // PointerChoreographer and InputProcessor
+    PROCESSED_TO_QUEUED = 3,  // InputDeviceMetricsCollector, InputFilter and InputDispatcher
+    QUEUED_TO_DEQUEUED = 4,   // Waiting in the InputDispatcher inbound queue
+    DEQUEUED_TO_DELIVER = 5,  // InputDispatcher finding the targets and publishing the event
+
+    ftl_last = DEQUEUED_TO_DELIVER
+};
+
 // Let's create a full timeline here:
 // eventTime
 // readTime
@@ -59,6 +77,13 @@ public:
 
     std::string dump(const char* prefix) const;
 
+    /**
+     * Returns the histogram of the given stage for the device with the given vendor and product
+     * ids, or nothing if no events have been seen from that device.
+     */
+    std::optional<LatencyHistogram> getStageHistogram(uint16_t vendorId, uint16_t productId,
+                                                      LatencyStage stage) const;
+
     ~LatencyAggregator();
 
 private:
@@ -89,6 +114,12 @@ private:
             mMoveSketches GUARDED_BY(mLock);
     // How many events have been processed so far
     size_t mNumSketchEventsProcessed GUARDED_BY(mLock) = 0;
+
+    // ---------- Per-stage latency ----------
+    void processStageStatistics(const InputEventTimeline& timeline);
+    using StageHistograms = std::array<LatencyHistogram, ftl::enum_size_v<LatencyStage>>;
+    // Keyed by vendor and product id
+    std::map<std::pair<uint16_t, uint16_t>, StageHistograms> mStageHistograms GUARDED_BY(mLock);
 };
 
 } // namespace android::inputdispatcher
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+size_t bucketIndex(nsecs_t latency) {
+    const uint64_t micros = static_cast<uint64_t>(std::max<nsecs_t>(ns2us(latency), 1));
+    return std::min<size_t>(std::bit_width(micros) - 1, LatencyHistogram::NUM_BUCKETS - 1);
+}
+
+} // namespace
+
+void LatencyHistogram::add(nsecs_t latency) {
+    mBuckets[bucketIndex(latency)]++;
+    mCount++;
+}
+
+void LatencyHistogram::reset() {
+    mBuckets.fill(0);
+    mCount = 0;
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    const size_t rank = std::max<size_t>(static_cast<size_t>(std::ceil(percentile / 100 * mCount)),
+                                         1);
+    size_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += mBuckets[i];
+        if (seen >= rank) {
+            return us2ns(nsecs_t{1} << (i + 1));
+        }
+    }
+    return us2ns(nsecs_t{1} << NUM_BUCKETS);
+}
+
+std::string LatencyHistogram::dump() const {
+    return StringPrintf("count=%zu p50<=%.3fms p90<=%.3fms p99<=%.3fms", mCount,
+                        ns2us(getPercentile(50)) / 1000.f, ns2us(getPercentile(90)) / 1000.f,
+                        ns2us(getPercentile(99)) / 1000.f);
+}
+
+} // namespace android::inputdispatcher
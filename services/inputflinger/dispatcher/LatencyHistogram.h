@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utils/Timers.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android::inputdispatcher {
+
+/**
+ * Distribution of latencies, with a bucket per power of two microseconds.
+ *
+ * Adding a value is constant time and the memory use is fixed, so a histogram can be kept for
+ * every stage of every device. The percentiles are only known to within a factor of two.
+ */
+class LatencyHistogram {
+public:
+    // Bucket i counts the latencies in [2^i, 2^(i+1)) microseconds. The first bucket also counts
+    // anything shorter, and the last one anything longer.
+    static constexpr size_t NUM_BUCKETS = 21;
+
+    void add(nsecs_t latency);
+    void reset();
+
+    size_t count() const { return mCount; }
+    const std::array<uint32_t, NUM_BUCKETS>& getBuckets() const { return mBuckets; }
+
+    // Returns the upper bound of the bucket containing the given percentile, in [0, 100], or 0 if
+    // the histogram is empty.
+    nsecs_t getPercentile(float percentile) const;
+
+    // A single line with the number of values and the 50th, 90th and 99th percentiles.
+    std::string dump() const;
+
+private:
+    std::array<uint32_t, NUM_BUCKETS> mBuckets{};
+    size_t mCount = 0;
+};
+
+} // namespace android::inputdispatcher
@@ -107,6 +107,26 @@ void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t ev
     mEventTimes.emplace(eventTime, inputEventId);
 }
 
+void LatencyTracker::trackInputStages(
+        int32_t inputEventId, const std::array<nsecs_t, InputStageTimeline::SIZE>& stageTimes,
+        nsecs_t enqueueTime) {
+    const auto it = mTimelines.find(inputEventId);
+    if (it == mTimelines.end()) {
+        // The event was dropped by 'trackListener'.
+        return;
+    }
+    it->second.stageTimes = stageTimes;
+    it->second.enqueueTime = enqueueTime;
+}
+
+void LatencyTracker::trackDequeuedEvent(int32_t inputEventId, nsecs_t dequeueTime) {
+    const auto it = mTimelines.find(inputEventId);
+    if (it == mTimelines.end()) {
+        return;
+    }
+    it->second.dequeueTime = dequeueTime;
+}
+
 void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
                                         nsecs_t deliveryTime, nsecs_t consumeTime,
                                         nsecs_t finishTime) {
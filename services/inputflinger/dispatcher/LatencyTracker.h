@@ -54,6 +54,17 @@ public:
      */
     void trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime, nsecs_t readTime,
                        DeviceId deviceId, const std::set<InputDeviceUsageSource>& sources);
+    /**
+     * Record how the event went through the stages before the dispatcher, and when the dispatcher
+     * queued it. Should be called right after 'trackListener'.
+     */
+    void trackInputStages(int32_t inputEventId,
+                          const std::array<nsecs_t, InputStageTimeline::SIZE>& stageTimes,
+                          nsecs_t enqueueTime);
+    /**
+     * Record when the dispatcher took the event out of its queue to dispatch it.
+     */
+    void trackDequeuedEvent(int32_t inputEventId, nsecs_t dequeueTime);
     void trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
                             nsecs_t deliveryTime, nsecs_t consumeTime, nsecs_t finishTime);
     void trackGraphicsLatency(int32_t inputEventId, const sp<IBinder>& connectionToken,
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowSpatialIndex.h"
+
+#include <algorithm>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+bool isEmpty(const Rect& rect) {
+    // Compare the edges rather than the size, which can overflow for very large rects.
+    return rect.left >= rect.right || rect.top >= rect.bottom;
+}
+
+bool contains(const Rect& rect, int32_t x, int32_t y) {
+    return x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+}
+
+bool intersects(const Rect& a, const Rect& b) {
+    return a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top;
+}
+
+int32_t cellSizeFor(int32_t begin, int32_t end) {
+    const int64_t length = static_cast<int64_t>(end) - begin;
+    const int64_t size = (length + WindowSpatialIndex::GRID_SIZE - 1) /
+            WindowSpatialIndex::GRID_SIZE;
+    return static_cast<int32_t>(std::max<int64_t>(size, 1));
+}
+
+} // namespace
+
+WindowSpatialIndex::WindowSpatialIndex(std::vector<Rect> rects) : mRects(std::move(rects)) {
+    bool hasBounds = false;
+    for (const Rect& rect : mRects) {
+        if (isEmpty(rect)) {
+            continue;
+        }
+        if (!hasBounds) {
+            mBounds = rect;
+            hasBounds = true;
+            continue;
+        }
+        mBounds.left = std::min(mBounds.left, rect.left);
+        mBounds.top = std::min(mBounds.top, rect.top);
+        mBounds.right = std::max(mBounds.right, rect.right);
+        mBounds.bottom = std::max(mBounds.bottom, rect.bottom);
+    }
+    if (!hasBounds) {
+        mBounds = Rect::EMPTY_RECT;
+        return;
+    }
+
+    mCellWidth = cellSizeFor(mBounds.left, mBounds.right);
+    mCellHeight = cellSizeFor(mBounds.top, mBounds.bottom);
+    mCells.resize(GRID_SIZE * GRID_SIZE);
+    for (size_t i = 0; i < mRects.size(); i++) {
+        const Rect& rect = mRects[i];
+        if (isEmpty(rect)) {
+            continue;
+        }
+        const auto [firstColumn, lastColumn] =
+                cellRange(rect.left, rect.right, mBounds.left, mCellWidth);
+        const auto [firstRow, lastRow] = cellRange(rect.top, rect.bottom, mBounds.top, mCellHeight);
+        for (int32_t row = firstRow; row <= lastRow; row++) {
+            for (int32_t column = firstColumn; column <= lastColumn; column++) {
+                mCells[row * GRID_SIZE + column].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+std::pair<int32_t, int32_t> WindowSpatialIndex::cellRange(int32_t begin, int32_t end,
+                                                          int32_t origin, int32_t cellSize) const {
+    const int64_t first = (static_cast<int64_t>(begin) - origin) / cellSize;
+    const int64_t last = (static_cast<int64_t>(end) - 1 - origin) / cellSize;
+    return {static_cast<int32_t>(std::clamp<int64_t>(first, 0, GRID_SIZE - 1)),
+            static_cast<int32_t>(std::clamp<int64_t>(last, 0, GRID_SIZE - 1))};
+}
+
+std::vector<size_t> WindowSpatialIndex::findAt(int32_t x, int32_t y) const {
+    std::vector<size_t> indices;
+    if (!contains(mBounds, x, y)) {
+        return indices;
+    }
+    const int32_t column = cellRange(x, x + 1, mBounds.left, mCellWidth).first;
+    const int32_t row = cellRange(y, y + 1, mBounds.top, mCellHeight).first;
+    for (uint32_t i : mCells[row * GRID_SIZE + column]) {
+        if (contains(mRects[i], x, y)) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+std::vector<size_t> WindowSpatialIndex::findIntersecting(const Rect& rect) const {
+    std::vector<size_t> indices;
+    if (isEmpty(rect)) {
+        // An empty rect can still be between the edges of other rects, but doesn't have cells.
+        for (size_t i = 0; i < mRects.size(); i++) {
+            if (!isEmpty(mRects[i]) && intersects(mRects[i], rect)) {
+                indices.push_back(i);
+            }
+        }
+        return indices;
+    }
+    if (mCells.empty() || !intersects(mBounds, rect)) {
+        return indices;
+    }
+    const auto [firstColumn, lastColumn] =
+            cellRange(std::max(rect.left, mBounds.left), std::min(rect.right, mBounds.right),
+                      mBounds.left, mCellWidth);
+    const auto [firstRow, lastRow] =
+            cellRange(std::max(rect.top, mBounds.top), std::min(rect.bottom, mBounds.bottom),
+                      mBounds.top, mCellHeight);
+    for (int32_t row = firstRow; row <= lastRow; row++) {
+        for (int32_t column = firstColumn; column <= lastColumn; column++) {
+            for (uint32_t i : mCells[row * GRID_SIZE + column]) {
+                if (intersects(mRects[i], rect)) {
+                    indices.push_back(i);
+                }
+            }
+        }
+    }
+    // A rect spanning several cells is found in each of them.
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+} // namespace android::inputdispatcher
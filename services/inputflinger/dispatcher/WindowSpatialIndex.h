@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ui/Rect.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * Finds which of a list of rects contain a point, or intersect another rect, without going
+ * through all of them.
+ *
+ * The rects are bucketed into a uniform grid over their combined bounds. A query only looks at
+ * the rects in the cells it touches. The rects keep the order in which they were given, which
+ * for windows is their z-order from front to back.
+ */
+class WindowSpatialIndex {
+public:
+    // Number of cells along each side of the grid.
+    static constexpr int32_t GRID_SIZE = 16;
+
+    WindowSpatialIndex() = default;
+    // Empty rects are never found.
+    explicit WindowSpatialIndex(std::vector<Rect> rects);
+
+    size_t size() const { return mRects.size(); }
+
+    // Returns the indices of the rects that contain the given point, in ascending order. As with
+    // WindowInfo::frameContainsPoint, the right and bottom edges are outside of a rect.
+    std::vector<size_t> findAt(int32_t x, int32_t y) const;
+
+    // Returns the indices of the rects that intersect the given rect, in ascending order. Like
+    // WindowInfo::overlaps, an empty rect intersects the rects that it is between the edges of.
+    std::vector<size_t> findIntersecting(const Rect& rect) const;
+
+private:
+    // Returns the range of cells, as [first, last], covering the given range of coordinates.
+    std::pair<int32_t, int32_t> cellRange(int32_t begin, int32_t end, int32_t origin,
+                                          int32_t cellSize) const;
+
+    std::vector<Rect> mRects;
+    Rect mBounds;
+    int32_t mCellWidth = 1;
+    int32_t mCellHeight = 1;
+    // Indices of the rects that intersect each cell, in ascending order. Row major.
+    std::vector<std::vector<uint32_t>> mCells;
+};
+
+} // namespace android::inputdispatcher
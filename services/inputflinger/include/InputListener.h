@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include <input/Input.h>
@@ -58,6 +59,11 @@ class QueuedInputListener : public InputListenerInterface {
 
 public:
     explicit QueuedInputListener(InputListenerInterface& innerListener);
+    /*
+     * Motion events are stamped with the time at which they are queued, as the given
+     * InputStageTimeline stage.
+     */
+    QueuedInputListener(InputListenerInterface& innerListener, size_t motionStage);
 
     virtual void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override;
     virtual void notifyConfigurationChanged(const NotifyConfigurationChangedArgs& args) override;
@@ -73,6 +79,7 @@ public:
 
 private:
     InputListenerInterface& mInnerListener;
+    const std::optional<size_t> mMotionStage;
     std::vector<NotifyArgs> mArgsQueue;
 };
 
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include <input/Input.h>
@@ -84,6 +85,20 @@ struct NotifyKeyArgs {
     NotifyKeyArgs& operator=(const NotifyKeyArgs&) = default;
 };
 
+/*
+ * Indices of the times at which a motion event left each stage of the input pipeline, before it
+ * reached the dispatcher. Used to break the input latency down by stage.
+ */
+struct InputStageTimeline {
+    // The InputReader mappers turned the raw events into a motion event.
+    static constexpr size_t MAPPER_TIME = 0;
+    // The UnwantedInteractionBlocker let the event through.
+    static constexpr size_t BLOCKER_TIME = 1;
+    // The InputProcessor classified the event.
+    static constexpr size_t PROCESSOR_TIME = 2;
+    static constexpr size_t SIZE = 3;
+};
+
 /* Describes a motion event. */
 struct NotifyMotionArgs {
     int32_t id;
@@ -119,6 +134,11 @@ struct NotifyMotionArgs {
     nsecs_t downTime;
     nsecs_t readTime;
     std::vector<TouchVideoFrame> videoFrames;
+    /**
+     * Indexed by InputStageTimeline. A stage that the event didn't go through has a time of 0.
+     * Only used for latency metrics, so it's not part of the comparison of two events.
+     */
+    std::array<nsecs_t, InputStageTimeline::SIZE> stageTimes{};
 
     inline NotifyMotionArgs() {}
 
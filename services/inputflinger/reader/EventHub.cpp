@@ -27,6 +27,7 @@
 #include <string.h>
 #include <sys/capability.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
@@ -51,6 +52,7 @@
 #include <utils/Log.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <optional>
 #include <regex>
@@ -79,8 +81,13 @@ static constexpr size_t OBFUSCATED_LENGTH = 8;
 static constexpr int32_t FF_STRONG_MAGNITUDE_CHANNEL_IDX = 0;
 static constexpr int32_t FF_WEAK_MAGNITUDE_CHANNEL_IDX = 1;
 
+// Number of raw events read from a device fd at a time.
 static constexpr size_t EVENT_BUFFER_SIZE = 256;
 
+// Number of raw events after which getEvents returns, even if there are more ready devices. This
+// lets a single call drain several devices that each had a full buffer of events pending.
+static constexpr size_t MAX_EVENTS_PER_CALL = 4 * EVENT_BUFFER_SIZE;
+
 // Mapping for input battery class node IDs lookup.
 // https://www.kernel.org/doc/Documentation/power/power_supply_class.txt
 static const std::unordered_map<std::string, InputBatteryClass> BATTERY_CLASSES =
@@ -917,24 +924,13 @@ EventHub::EventHub(void)
     int result = epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mINotifyFd, &eventItem);
     LOG_ALWAYS_FATAL_IF(result != 0, "Could not add INotify to epoll instance.  errno=%d", errno);
 
-    int wakeFds[2];
-    result = pipe2(wakeFds, O_CLOEXEC);
-    LOG_ALWAYS_FATAL_IF(result != 0, "Could not create wake pipe.  errno=%d", errno);
-
-    mWakeReadPipeFd = wakeFds[0];
-    mWakeWritePipeFd = wakeFds[1];
-
-    result = fcntl(mWakeReadPipeFd, F_SETFL, O_NONBLOCK);
-    LOG_ALWAYS_FATAL_IF(result != 0, "Could not make wake read pipe non-blocking.  errno=%d",
-                        errno);
-
-    result = fcntl(mWakeWritePipeFd, F_SETFL, O_NONBLOCK);
-    LOG_ALWAYS_FATAL_IF(result != 0, "Could not make wake write pipe non-blocking.  errno=%d",
-                        errno);
+    // Any number of wakes are folded into the eventfd counter, which a single read resets.
+    mWakeEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    LOG_ALWAYS_FATAL_IF(mWakeEventFd < 0, "Could not create wake eventfd.  errno=%d", errno);
 
-    eventItem.data.fd = mWakeReadPipeFd;
-    result = epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeReadPipeFd, &eventItem);
-    LOG_ALWAYS_FATAL_IF(result != 0, "Could not add wake read pipe to epoll instance.  errno=%d",
+    eventItem.data.fd = mWakeEventFd;
+    result = epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeEventFd, &eventItem);
+    LOG_ALWAYS_FATAL_IF(result != 0, "Could not add wake eventfd to epoll instance.  errno=%d",
                         errno);
 }
 
@@ -943,8 +939,7 @@ EventHub::~EventHub(void) {
 
     ::close(mEpollFd);
     ::close(mINotifyFd);
-    ::close(mWakeReadPipeFd);
-    ::close(mWakeWritePipeFd);
+    ::close(mWakeEventFd);
 }
 
 /**
@@ -1827,6 +1822,10 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
 
     std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
 
+    mReadStats.calls++;
+    nsecs_t processingStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    nsecs_t processingTime = 0;
+
     std::vector<RawEvent> events;
     bool awoken = false;
     for (;;) {
@@ -1924,17 +1923,18 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                 continue;
             }
 
-            if (eventItem.data.fd == mWakeReadPipeFd) {
+            if (eventItem.data.fd == mWakeEventFd) {
                 if (eventItem.events & EPOLLIN) {
                     ALOGV("awoken after wake()");
                     awoken = true;
-                    char wakeReadBuffer[16];
+                    uint64_t wakeCount;
                     ssize_t nRead;
                     do {
-                        nRead = read(mWakeReadPipeFd, wakeReadBuffer, sizeof(wakeReadBuffer));
-                    } while ((nRead == -1 && errno == EINTR) || nRead == sizeof(wakeReadBuffer));
+                        nRead = read(mWakeEventFd, &wakeCount, sizeof(wakeCount));
+                    } while (nRead == -1 && errno == EINTR);
+                    mReadStats.wakeReads++;
                 } else {
-                    ALOGW("Received unexpected epoll event 0x%08x for wake read pipe.",
+                    ALOGW("Received unexpected epoll event 0x%08x for wake eventfd.",
                           eventItem.events);
                 }
                 continue;
@@ -1972,6 +1972,7 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                 int32_t readSize =
                         read(device->fd, readBuffer.data(),
                              sizeof(decltype(readBuffer)::value_type) * readBuffer.size());
+                mReadStats.reads++;
                 if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
                     // Device was removed before INotify noticed.
                     ALOGW("could not get event, removed? (fd: %d size: %" PRId32
@@ -1989,22 +1990,31 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                     const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
 
                     const size_t count = size_t(readSize) / sizeof(struct input_event);
+                    // All of the events were read by the same syscall.
+                    const nsecs_t readTime = systemTime(SYSTEM_TIME_MONOTONIC);
+                    events.reserve(events.size() + count);
                     for (size_t i = 0; i < count; i++) {
                         struct input_event& iev = readBuffer[i];
                         device->trackInputEvent(iev);
                         events.push_back({
                                 .when = processEventTimestamp(iev),
-                                .readTime = systemTime(SYSTEM_TIME_MONOTONIC),
+                                .readTime = readTime,
                                 .deviceId = deviceId,
                                 .type = iev.type,
                                 .code = iev.code,
                                 .value = iev.value,
                         });
                     }
-                    if (events.size() >= EVENT_BUFFER_SIZE) {
-                        // The result buffer is full.  Reset the pending event index
-                        // so we will try to read the device again on the next iteration.
+                    mReadStats.eventsRead += count;
+                    if (count == readBuffer.size()) {
+                        // The buffer was filled, so the device likely has more events pending.
+                        // Read it again right away rather than waiting for the next epoll_wait.
+                        mReadStats.fullReads++;
                         mPendingEventIndex -= 1;
+                    }
+                    if (events.size() >= MAX_EVENTS_PER_CALL) {
+                        // The result is full. If the device wasn't drained, its epoll event is
+                        // still pending, and it will be read again on the next call.
                         break;
                     }
                 }
@@ -2054,12 +2064,17 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         // service the timeout.
         mPendingEventIndex = 0;
 
+        processingTime += systemTime(SYSTEM_TIME_MONOTONIC) - processingStartTime;
+        mReadStats.polls++;
+
         mLock.unlock(); // release lock before poll
 
         int pollResult = epoll_wait(mEpollFd, mPendingEventItems, EPOLL_MAX_EVENTS, timeoutMillis);
 
         mLock.lock(); // reacquire lock after poll
 
+        processingStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
         if (pollResult == 0) {
             // Timed out.
             mPendingEventCount = 0;
@@ -2082,6 +2097,10 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         }
     }
 
+    processingTime += systemTime(SYSTEM_TIME_MONOTONIC) - processingStartTime;
+    mReadStats.totalProcessingTime += processingTime;
+    mReadStats.maxProcessingTime = std::max(mReadStats.maxProcessingTime, processingTime);
+
     // All done, return the number of events we read.
     return events;
 }
@@ -2099,12 +2118,13 @@ std::vector<TouchVideoFrame> EventHub::getVideoFrames(int32_t deviceId) {
 void EventHub::wake() {
     ALOGV("wake() called");
 
+    const uint64_t increment = 1;
     ssize_t nWrite;
     do {
-        nWrite = write(mWakeWritePipeFd, "W", 1);
+        nWrite = write(mWakeEventFd, &increment, sizeof(increment));
     } while (nWrite == -1 && errno == EINTR);
 
-    if (nWrite != 1 && errno != EAGAIN) {
+    if (nWrite != sizeof(increment) && errno != EAGAIN) {
         ALOGW("Could not write wake signal: %s", strerror(errno));
     }
 }
@@ -2904,6 +2924,25 @@ void EventHub::dump(std::string& dump) const {
         if (mUnattachedVideoDevices.empty()) {
             dump += INDENT2 "<none>\n";
         }
+
+        const ReadStats& stats = mReadStats;
+        const auto perCall = [&stats](size_t value) {
+            return stats.calls == 0 ? 0.f : static_cast<float>(value) / stats.calls;
+        };
+        dump += INDENT "Read stats:\n";
+        dump += StringPrintf(INDENT2 "Calls: %zu\n", stats.calls);
+        dump += StringPrintf(INDENT2 "Syscalls per call: epoll_wait=%.2f, read=%.2f (full=%.2f), "
+                                     "wake=%.2f\n",
+                             perCall(stats.polls), perCall(stats.reads), perCall(stats.fullReads),
+                             perCall(stats.wakeReads));
+        dump += StringPrintf(INDENT2 "Events per read: %.2f\n",
+                             stats.reads == 0 ? 0.f
+                                              : static_cast<float>(stats.eventsRead) / stats.reads);
+        dump += StringPrintf(INDENT2 "Processing time: average=%.3fms, max=%.3fms\n",
+                             stats.calls == 0 ? 0.f
+                                              : ns2us(stats.totalProcessingTime / stats.calls) /
+                                                     1000.f,
+                             ns2us(stats.maxProcessingTime) / 1000.f);
     } // release lock
 }
 
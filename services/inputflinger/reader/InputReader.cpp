@@ -206,7 +206,16 @@ std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents
             if (debugRawEvents()) {
                 ALOGD("BatchSize: %zu Count: %zu", batchSize, count);
             }
-            out += processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            std::list<NotifyArgs> deviceArgs =
+                    processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            // The mappers are done with these events, so they can move on to the next stage.
+            const nsecs_t mappedTime = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (NotifyArgs& args : deviceArgs) {
+                if (auto* motionArgs = std::get_if<NotifyMotionArgs>(&args); motionArgs) {
+                    motionArgs->stageTimes[InputStageTimeline::MAPPER_TIME] = mappedTime;
+                }
+            }
+            out += std::move(deviceArgs);
         } else {
             switch (rawEvent->type) {
                 case EventHubInterface::DEVICE_ADDED:
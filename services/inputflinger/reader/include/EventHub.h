@@ -789,20 +789,34 @@ private:
 
     int mEpollFd;
     int mINotifyFd;
-    int mWakeReadPipeFd;
-    int mWakeWritePipeFd;
+    int mWakeEventFd;
 
     int mDeviceInputWd;
     int mDeviceWd = -1;
 
-    // Maximum number of signalled FDs to handle at a time.
-    static const int EPOLL_MAX_EVENTS = 16;
+    // Maximum number of signalled FDs to handle at a time. Large enough for all of the devices
+    // to be drained after a single epoll_wait.
+    static const int EPOLL_MAX_EVENTS = 64;
 
     // The array of pending epoll events and the index of the next event to be handled.
     struct epoll_event mPendingEventItems[EPOLL_MAX_EVENTS];
     size_t mPendingEventCount;
     size_t mPendingEventIndex;
     bool mPendingINotify;
+
+    // How many syscalls getEvents makes, and how long it takes, for dumpsys.
+    struct ReadStats {
+        size_t calls = 0;      // calls to getEvents
+        size_t polls = 0;      // calls to epoll_wait
+        size_t reads = 0;      // reads from device fds
+        size_t fullReads = 0;  // reads that filled the whole buffer, so that more may be pending
+        size_t wakeReads = 0;  // wakeups read from the wake eventfd, not counting EINTR retries
+        size_t eventsRead = 0; // raw events read from the devices
+        // Time spent in getEvents, not counting the time waiting in epoll_wait
+        nsecs_t totalProcessingTime = 0;
+        nsecs_t maxProcessingTime = 0;
+    };
+    ReadStats mReadStats;
 };
 
 } // namespace android
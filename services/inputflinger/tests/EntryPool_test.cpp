@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/EntryPool.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "../dispatcher/Entry.h"
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// The pool is shared by the whole process, so the tests only look at how the stats change.
+struct StatsDelta {
+    StatsDelta() : mStart(EntryPool::getStats()) {}
+
+    size_t allocations() const { return EntryPool::getStats().allocations - mStart.allocations; }
+    size_t heapAllocations() const {
+        return EntryPool::getStats().heapAllocations - mStart.heapAllocations;
+    }
+    ssize_t liveBlocks() const {
+        return static_cast<ssize_t>(EntryPool::getStats().liveBlocks) -
+                static_cast<ssize_t>(mStart.liveBlocks);
+    }
+
+private:
+    const EntryPool::Stats mStart;
+};
+
+std::shared_ptr<KeyEntry> makeKeyEntry() {
+    return makeSharedEntry<KeyEntry>(/*id=*/1, /*injectionState=*/nullptr, /*eventTime=*/0,
+                                     /*deviceId=*/1, AINPUT_SOURCE_KEYBOARD, ADISPLAY_ID_DEFAULT,
+                                     /*policyFlags=*/0, AKEY_EVENT_ACTION_DOWN, /*flags=*/0,
+                                     AKEYCODE_A, /*scanCode=*/0, AMETA_NONE, /*repeatCount=*/0,
+                                     /*downTime=*/0);
+}
+
+std::shared_ptr<MotionEntry> makeMotionEntry() {
+    PointerProperties properties;
+    properties.clear();
+    properties.id = 0;
+    properties.toolType = ToolType::FINGER;
+    PointerCoords coords;
+    coords.clear();
+    coords.setAxisValue(AMOTION_EVENT_AXIS_X, 100);
+    coords.setAxisValue(AMOTION_EVENT_AXIS_Y, 200);
+    return makeSharedEntry<MotionEntry>(/*id=*/1, /*injectionState=*/nullptr, /*eventTime=*/0,
+                                        /*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN,
+                                        ADISPLAY_ID_DEFAULT, /*policyFlags=*/0,
+                                        AMOTION_EVENT_ACTION_MOVE, /*actionButton=*/0,
+                                        /*flags=*/0, AMETA_NONE, /*buttonState=*/0,
+                                        MotionClassification::NONE, AMOTION_EVENT_EDGE_FLAG_NONE,
+                                        /*xPrecision=*/0, /*yPrecision=*/0,
+                                        AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                        AMOTION_EVENT_INVALID_CURSOR_POSITION, /*downTime=*/0,
+                                        std::span(&properties, 1), std::span(&coords, 1));
+}
+
+} // namespace
+
+// --- EntryPoolTest ---
+
+TEST(EntryPoolTest, ReleasedBlock_IsReused) {
+    void* first = EntryPool::allocate(100);
+    EntryPool::deallocate(first, 100);
+
+    StatsDelta delta;
+    // Any size in the same size class can use the released block.
+    void* second = EntryPool::allocate(120);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(1u, delta.allocations());
+    EXPECT_EQ(0u, delta.heapAllocations());
+    EXPECT_EQ(1, delta.liveBlocks());
+
+    EntryPool::deallocate(second, 120);
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+TEST(EntryPoolTest, OversizedBlock_AlwaysComesFromTheHeap) {
+    constexpr size_t size = EntryPool::MAX_POOLED_SIZE + 1;
+    EntryPool::deallocate(EntryPool::allocate(size), size);
+
+    StatsDelta delta;
+    void* block = EntryPool::allocate(size);
+    EXPECT_EQ(1u, delta.heapAllocations());
+    EntryPool::deallocate(block, size);
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+TEST(EntryPoolTest, FullSizeClass_FallsBackToTheHeap) {
+    constexpr size_t size = EntryPool::MAX_POOLED_SIZE;
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < EntryPool::MAX_POOLED_BLOCKS_PER_SIZE_CLASS + 1; i++) {
+        blocks.push_back(EntryPool::allocate(size));
+    }
+    for (void* block : blocks) {
+        EntryPool::deallocate(block, size);
+    }
+
+    // The pool kept as many blocks as it could, and they are all free now.
+    StatsDelta delta;
+    for (void*& block : blocks) {
+        block = EntryPool::allocate(size);
+    }
+    EXPECT_EQ(1u, delta.heapAllocations());
+    for (void* block : blocks) {
+        EntryPool::deallocate(block, size);
+    }
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+TEST(EntryPoolTest, BlockReleasedOnAnotherThread_IsReused) {
+    void* first = EntryPool::allocate(100);
+    std::thread([first] { EntryPool::deallocate(first, 100); }).join();
+
+    StatsDelta delta;
+    void* second = EntryPool::allocate(100);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(0u, delta.heapAllocations());
+    EntryPool::deallocate(second, 100);
+}
+
+TEST(EntryPoolTest, SharedEntries_AreAllocatedOnceInSteadyState) {
+    makeKeyEntry();
+
+    StatsDelta delta;
+    for (int i = 0; i < 100; i++) {
+        std::shared_ptr<KeyEntry> entry = makeKeyEntry();
+        ASSERT_EQ(AKEYCODE_A, entry->keyCode);
+    }
+    // The entry and its control block share one block.
+    EXPECT_EQ(100u, delta.allocations());
+    EXPECT_EQ(0u, delta.heapAllocations());
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+TEST(EntryPoolTest, MotionEntryPointers_ComeFromThePool) {
+    makeMotionEntry();
+
+    StatsDelta delta;
+    std::shared_ptr<MotionEntry> entry = makeMotionEntry();
+    ASSERT_EQ(1u, entry->getPointerCount());
+    EXPECT_EQ(200, entry->pointerCoords[0].getY());
+    // The entry, its pointer properties and its pointer coords.
+    EXPECT_EQ(3u, delta.allocations());
+    EXPECT_EQ(0u, delta.heapAllocations());
+
+    entry.reset();
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+TEST(EntryPoolTest, UniqueEntries_ComeFromThePool) {
+    std::make_unique<DeviceResetEntry>(/*id=*/1, /*eventTime=*/0, /*deviceId=*/1);
+
+    StatsDelta delta;
+    std::unique_ptr<EventEntry> entry =
+            std::make_unique<DeviceResetEntry>(/*id=*/2, /*eventTime=*/0, /*deviceId=*/1);
+    EXPECT_EQ(1u, delta.allocations());
+    EXPECT_EQ(0u, delta.heapAllocations());
+
+    // Deleted through the base class, with the size of the derived class.
+    entry.reset();
+    EXPECT_EQ(0, delta.liveBlocks());
+}
+
+} // namespace android::inputdispatcher
@@ -218,6 +218,43 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+/**
+ * Ensure that each event is read after it occurred, and that events are returned in the order
+ * they were read. The events may arrive over several reads, so their read times may differ.
+ */
+TEST_F(EventHubTest, InputEvent_ReadTimeIsAfterEventTime) {
+    ASSERT_NO_FATAL_FAILURE(mKeyboard->pressAndReleaseHomeKey());
+
+    std::vector<RawEvent> events = getEvents(4);
+    ASSERT_EQ(4U, events.size()) << "Expected to receive 2 keys and 2 syncs, total of 4 events";
+    nsecs_t lastReadTime = 0;
+    for (const RawEvent& event : events) {
+        ASSERT_LE(event.when, event.readTime) << "Event must have been read after it occurred";
+        ASSERT_LE(lastReadTime, event.readTime) << "Events must be returned in the order read";
+        lastReadTime = event.readTime;
+    }
+}
+
+/**
+ * Several calls to wake() before getEvents should only interrupt a single call.
+ */
+TEST_F(EventHubTest, Wake_InterruptsGetEventsOnce) {
+    mEventHub->wake();
+    mEventHub->wake();
+    mEventHub->wake();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RawEvent> events = mEventHub->getEvents(std::chrono::milliseconds(5s).count());
+    ASSERT_TRUE(events.empty());
+    ASSERT_LT(std::chrono::steady_clock::now() - start, 1s) << "getEvents was not woken";
+
+    // All of the wakes have been consumed, so this call waits for its whole timeout.
+    start = std::chrono::steady_clock::now();
+    events = mEventHub->getEvents(std::chrono::milliseconds(100ms).count());
+    ASSERT_TRUE(events.empty());
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 90ms);
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+namespace android::inputdispatcher {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr nsecs_t toNs(std::chrono::nanoseconds duration) {
+    return duration.count();
+}
+
+} // namespace
+
+// --- LatencyHistogramTest ---
+
+TEST(LatencyHistogramTest, EmptyHistogram_HasNoPercentiles) {
+    LatencyHistogram histogram;
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0, histogram.getPercentile(50));
+}
+
+TEST(LatencyHistogramTest, Add_CountsIntoPowerOfTwoBuckets) {
+    LatencyHistogram histogram;
+    histogram.add(toNs(500ns)); // shorter than the first bucket
+    histogram.add(toNs(1us));
+    histogram.add(toNs(3us));
+    histogram.add(toNs(4us));
+
+    EXPECT_EQ(4u, histogram.count());
+    EXPECT_EQ(2u, histogram.getBuckets()[0]);
+    EXPECT_EQ(1u, histogram.getBuckets()[1]);
+    EXPECT_EQ(1u, histogram.getBuckets()[2]);
+}
+
+TEST(LatencyHistogramTest, Add_VeryLongLatency_GoesIntoTheLastBucket) {
+    LatencyHistogram histogram;
+    histogram.add(toNs(1h));
+
+    EXPECT_EQ(1u, histogram.getBuckets()[LatencyHistogram::NUM_BUCKETS - 1]);
+}
+
+TEST(LatencyHistogramTest, GetPercentile_ReturnsUpperBoundOfBucket) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 98; i++) {
+        histogram.add(toNs(100us));
+    }
+    histogram.add(toNs(5ms));
+    histogram.add(toNs(5ms));
+
+    // 100us is in [64us, 128us), and 5ms in [4096us, 8192us).
+    EXPECT_EQ(toNs(128us), histogram.getPercentile(50));
+    EXPECT_EQ(toNs(128us), histogram.getPercentile(98));
+    EXPECT_EQ(toNs(8192us), histogram.getPercentile(99));
+    EXPECT_EQ(toNs(8192us), histogram.getPercentile(100));
+}
+
+TEST(LatencyHistogramTest, Reset_ClearsAllBuckets) {
+    LatencyHistogram histogram;
+    histogram.add(toNs(1ms));
+    histogram.reset();
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.getBuckets()[10]);
+}
+
+} // namespace android::inputdispatcher
@@ -214,6 +214,37 @@ TEST_F(LatencyTrackerTest, TrackAllParameters_ReportsFullTimeline) {
     assertReceivedTimeline(expected);
 }
 
+TEST_F(LatencyTrackerTest, TrackInputStages_ReportsStageTimes) {
+    constexpr int32_t inputEventId = 1;
+    InputEventTimeline expected = getTestTimeline();
+    expected.stageTimes[InputStageTimeline::MAPPER_TIME] = 4;
+    expected.stageTimes[InputStageTimeline::BLOCKER_TIME] = 5;
+    expected.stageTimes[InputStageTimeline::PROCESSOR_TIME] = 5;
+    expected.enqueueTime = 5;
+    expected.dequeueTime = 6;
+
+    const auto& [connectionToken, expectedCT] = *expected.connectionTimelines.begin();
+
+    mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime,
+                            DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+    mTracker->trackInputStages(inputEventId, expected.stageTimes, expected.enqueueTime);
+    mTracker->trackDequeuedEvent(inputEventId, expected.dequeueTime);
+    mTracker->trackFinishedEvent(inputEventId, connectionToken, expectedCT.deliveryTime,
+                                 expectedCT.consumeTime, expectedCT.finishTime);
+    mTracker->trackGraphicsLatency(inputEventId, connectionToken, expectedCT.graphicsTimeline);
+
+    triggerEventReporting(expected.eventTime);
+    assertReceivedTimeline(expected);
+}
+
+TEST_F(LatencyTrackerTest, TrackInputStages_WithoutTrackListener_IsIgnored) {
+    mTracker->trackInputStages(/*inputEventId=*/1, {4, 5, 5}, /*enqueueTime=*/5);
+    mTracker->trackDequeuedEvent(/*inputEventId=*/1, /*dequeueTime=*/6);
+
+    triggerEventReporting(/*eventTime=*/2);
+    assertReceivedTimelines({});
+}
+
 /**
  * Send 2 events with the same inputEventId, but different eventTime's. Ensure that no crash occurs,
  * and that the tracker drops such events completely.
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/WindowSpatialIndex.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace android::inputdispatcher {
+
+// --- WindowSpatialIndexTest ---
+
+TEST(WindowSpatialIndexTest, EmptyIndex_FindsNothing) {
+    WindowSpatialIndex index;
+
+    EXPECT_THAT(index.findAt(0, 0), IsEmpty());
+    EXPECT_THAT(index.findIntersecting(Rect(0, 0, 100, 100)), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, FindAt_ReturnsContainingRectsInOrder) {
+    WindowSpatialIndex index({Rect(50, 50, 150, 150), Rect(500, 500, 600, 600),
+                              Rect(0, 0, 1000, 1000)});
+
+    EXPECT_THAT(index.findAt(100, 100), ElementsAre(0, 2));
+    EXPECT_THAT(index.findAt(550, 550), ElementsAre(1, 2));
+    EXPECT_THAT(index.findAt(300, 300), ElementsAre(2));
+    EXPECT_THAT(index.findAt(-1, 300), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, FindAt_ExcludesRightAndBottomEdges) {
+    WindowSpatialIndex index({Rect(0, 0, 100, 100), Rect(100, 100, 200, 200)});
+
+    EXPECT_THAT(index.findAt(0, 0), ElementsAre(0));
+    EXPECT_THAT(index.findAt(99, 99), ElementsAre(0));
+    EXPECT_THAT(index.findAt(100, 100), ElementsAre(1));
+    EXPECT_THAT(index.findAt(200, 150), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, EmptyRects_AreNeverFound) {
+    WindowSpatialIndex index({Rect(10, 10, 10, 20), Rect(0, 0, 100, 100), Rect(50, 50, 40, 40)});
+
+    EXPECT_THAT(index.findAt(10, 15), ElementsAre(1));
+    EXPECT_THAT(index.findAt(45, 45), ElementsAre(1));
+    EXPECT_THAT(index.findIntersecting(Rect(0, 0, 100, 100)), ElementsAre(1));
+}
+
+TEST(WindowSpatialIndexTest, FindIntersecting_ReturnsEachRectOnce) {
+    // Spans every cell of the grid
+    WindowSpatialIndex index({Rect(0, 0, 1600, 1600), Rect(1500, 1500, 1600, 1600),
+                              Rect(200, 200, 300, 300)});
+
+    EXPECT_THAT(index.findIntersecting(Rect(0, 0, 1600, 1600)), ElementsAre(0, 1, 2));
+    EXPECT_THAT(index.findIntersecting(Rect(250, 250, 1550, 1550)), ElementsAre(0, 1, 2));
+    EXPECT_THAT(index.findIntersecting(Rect(300, 300, 1500, 1500)), ElementsAre(0));
+}
+
+TEST(WindowSpatialIndexTest, FindIntersecting_EmptyRectBetweenEdges) {
+    WindowSpatialIndex index({Rect(0, 0, 100, 100), Rect(200, 200, 300, 300)});
+
+    // Same as WindowInfo::overlaps, which only compares the edges.
+    EXPECT_THAT(index.findIntersecting(Rect(50, 50, 50, 50)), ElementsAre(0));
+    EXPECT_THAT(index.findIntersecting(Rect(150, 150, 150, 150)), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, VeryLargeRects) {
+    WindowSpatialIndex index({Rect(0, 0, 100, 100),
+                              Rect(INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX)});
+
+    EXPECT_THAT(index.findAt(50, 50), ElementsAre(0, 1));
+    EXPECT_THAT(index.findAt(INT32_MIN, INT32_MAX - 1), ElementsAre(1));
+    EXPECT_THAT(index.findIntersecting(Rect(-100, -100, 0, 0)), ElementsAre(1));
+}
+
+} // namespace android::inputdispatcher
@@ -311,10 +311,14 @@ bool Fusion::checkInitComplete(int what, const vec3_t& d, float dT) {
 }
 
 void Fusion::handleGyro(const vec3_t& w, float dT) {
-    if (!checkInitComplete(GYRO, w, dT))
-        return;
+    handleGyro(&w, &dT, 1);
+}
 
-    predict(w, dT);
+void Fusion::handleGyro(const vec3_t* w, const float* dT, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (checkInitComplete(GYRO, w[i], dT[i]))
+            predict(w[i], dT[i]);
+    }
 }
 
 status_t Fusion::handleAcc(const vec3_t& a, float dT) {
@@ -487,7 +491,28 @@ void Fusion::predict(const vec3_t& w, float dT) {
     if (x0.w < 0)
         x0 = -x0;
 
-    P = Phi*P*transpose(Phi) + GQGt;
+    // Phi and GQGt are mostly zeros and identities, so rather than
+    // multiplying the full 6x6 matrices, expand the product by blocks:
+    //
+    //  T = Phi00*P00 + Phi10*P01
+    //  U = Phi00*P10 + Phi10*P11
+    //
+    //  P00 = T*Phi00' + U*Phi10' + q00
+    //  P10 = U - q10
+    //  P11 = P11 + q11
+    //
+    // this takes 6 3x3 products instead of 16.
+    const mat33_t& A(Phi[0][0]);
+    const mat33_t& B(Phi[1][0]);
+    const mat33_t T(A*P[0][0] + B*P[0][1]);
+    const mat33_t U(A*P[1][0] + B*P[1][1]);
+    P[0][0] = T*transpose(A) + U*transpose(B) + GQGt[0][0];
+    P[1][0] = U + GQGt[1][0];
+    // P01 is not computed, which is only valid while P is symmetric. This
+    // step keeps it so, since GQGt is symmetric (see initFusion). update()
+    // also stores P01 as the transpose of P10.
+    P[0][1] = transpose(P[1][0]);
+    P[1][1] += GQGt[1][1];
 
     checkState();
 }
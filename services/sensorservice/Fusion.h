@@ -64,6 +64,9 @@ public:
     Fusion();
     void init(int mode = FUSION_9AXIS);
     void handleGyro(const vec3_t& w, float dT);
+    // Integrates count gyro samples in a row, as if handleGyro() had been
+    // called for each of them.
+    void handleGyro(const vec3_t* w, const float* dT, size_t count);
     status_t handleAcc(const vec3_t& a, float dT);
     status_t handleMag(const vec3_t& m);
     vec4_t getAttitude() const;
@@ -95,6 +98,8 @@ private:
     void update(const vec3_t& z, const vec3_t& Bi, float sigma);
     static mat34_t getF(const vec4_t& p);
     static vec3_t getOrthogonal(const vec3_t &v);
+
+    friend class FusionTest;
 };
 
 }; // namespace android
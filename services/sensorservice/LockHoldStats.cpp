@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LockHoldStats.h"
+
+#include <utils/String8.h>
+
+#include <algorithm>
+#include <inttypes.h>
+
+namespace android {
+namespace SensorServiceUtil {
+
+namespace {
+
+const char* operationName(LockHoldStats::Operation operation) {
+    switch (operation) {
+        case LockHoldStats::Operation::THREAD_LOOP:
+            return "threadLoop";
+        case LockHoldStats::Operation::THREAD_LOOP_AFTER_SEND:
+            return "threadLoopAfterSend";
+        case LockHoldStats::Operation::RUNTIME_SENSOR_EVENTS:
+            return "runtimeSensorEvents";
+        case LockHoldStats::Operation::CREATE_CONNECTION:
+            return "createConnection";
+        case LockHoldStats::Operation::ENABLE:
+            return "enable";
+        case LockHoldStats::Operation::DISABLE:
+            return "disable";
+        case LockHoldStats::Operation::FLUSH:
+            return "flush";
+        case LockHoldStats::Operation::CLEANUP_CONNECTION:
+            return "cleanupConnection";
+        case LockHoldStats::Operation::COUNT:
+            break;
+    }
+    return "unknown";
+}
+
+} // namespace
+
+void LockHoldStats::record(Operation operation, nsecs_t holdTime) {
+    Stats& stats = mStats[static_cast<size_t>(operation)];
+    stats.count++;
+    stats.totalTime += holdTime;
+    stats.maxTime = std::max(stats.maxTime, holdTime);
+    const size_t bucket = std::upper_bound(BUCKET_LIMITS.begin(), BUCKET_LIMITS.end(), holdTime) -
+            BUCKET_LIMITS.begin();
+    stats.buckets[bucket]++;
+}
+
+std::string LockHoldStats::dump() const {
+    String8 buffer;
+    for (size_t i = 0; i < mStats.size(); i++) {
+        const Stats& stats = mStats[i];
+        if (stats.count == 0) {
+            continue;
+        }
+        buffer.appendFormat("\t%s: count=%" PRIu64 ", avg=%" PRId64 "us, max=%" PRId64
+                            "us, <100us=%" PRIu64 ", <1ms=%" PRIu64 ", <10ms=%" PRIu64
+                            ", >=10ms=%" PRIu64 "\n",
+                            operationName(static_cast<Operation>(i)), stats.count,
+                            ns2us(stats.totalTime / static_cast<nsecs_t>(stats.count)),
+                            ns2us(stats.maxTime), stats.buckets[0], stats.buckets[1],
+                            stats.buckets[2], stats.buckets[3]);
+    }
+    return std::string(buffer.c_str());
+}
+
+} // namespace SensorServiceUtil
+} // namespace android
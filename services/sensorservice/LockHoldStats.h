@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_SERVICE_UTIL_LOCK_HOLD_STATS_H
+#define ANDROID_SENSOR_SERVICE_UTIL_LOCK_HOLD_STATS_H
+
+#include "SensorServiceUtils.h"
+
+#include <utils/Timers.h>
+
+#include <array>
+#include <stdint.h>
+
+namespace android {
+namespace SensorServiceUtil {
+
+// Records how long a lock is held for by each kind of operation, to see what delays the sensor
+// thread, or what the sensor thread delays. Not thread safe: the durations are recorded while the
+// lock is still held, and the lock has to be held to dump them too.
+class LockHoldStats : public Dumpable {
+public:
+    enum class Operation {
+        THREAD_LOOP,
+        THREAD_LOOP_AFTER_SEND,
+        RUNTIME_SENSOR_EVENTS,
+        CREATE_CONNECTION,
+        ENABLE,
+        DISABLE,
+        FLUSH,
+        CLEANUP_CONNECTION,
+        COUNT,
+    };
+
+    // Records the time from its construction to its destruction. To be constructed just after
+    // the lock is acquired, so that it is destroyed just before the lock is released.
+    class Timer {
+    public:
+        Timer(LockHoldStats& stats, Operation operation)
+              : mStats(stats), mOperation(operation), mStartTime(systemTime()) {}
+        ~Timer() { mStats.record(mOperation, systemTime() - mStartTime); }
+
+    private:
+        LockHoldStats& mStats;
+        const Operation mOperation;
+        const nsecs_t mStartTime;
+    };
+
+    void record(Operation operation, nsecs_t holdTime);
+
+    std::string dump() const override;
+
+private:
+    // Upper bounds of the buckets of hold times, the last bucket has the longer ones.
+    static constexpr std::array<nsecs_t, 3> BUCKET_LIMITS = {100000 /*100us*/, 1000000 /*1ms*/,
+                                                             10000000 /*10ms*/};
+
+    struct Stats {
+        uint64_t count = 0;
+        nsecs_t totalTime = 0;
+        nsecs_t maxTime = 0;
+        std::array<uint64_t, BUCKET_LIMITS.size() + 1> buckets{};
+    };
+
+    std::array<Stats, static_cast<size_t>(Operation::COUNT)> mStats;
+};
+
+} // namespace SensorServiceUtil
+} // namespace android
+
+#endif // ANDROID_SENSOR_SERVICE_UTIL_LOCK_HOLD_STATS_H
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorEventBatch.h"
+
+#include <algorithm>
+
+namespace android {
+
+void SensorEventBatch::reset(sensors_event_t const* events, size_t count) {
+    mEvents = events;
+    mCount = count;
+    mHandles.clear();
+    mSensorIndices.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        // The sensor of a flush complete event is zero, the flushed sensor is in its meta data.
+        const int32_t handle = events[i].type == SENSOR_TYPE_META_DATA
+                ? events[i].meta_data.sensor
+                : events[i].sensor;
+        // A batch has events from a handful of sensors, so a linear search is enough.
+        const size_t sensorIndex =
+                std::find(mHandles.begin(), mHandles.end(), handle) - mHandles.begin();
+        if (sensorIndex == mHandles.size()) {
+            mHandles.push_back(handle);
+        }
+        mSensorIndices[i] = static_cast<uint16_t>(sensorIndex);
+    }
+}
+
+} // namespace android
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_EVENT_BATCH_H
+#define ANDROID_SENSOR_EVENT_BATCH_H
+
+#include <hardware/sensors.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace android {
+
+// A batch of sensor events, along with the sensor each event is for. The sensors are worked out
+// once by the sensor thread and shared by all the connections the batch is sent to, so that a
+// connection only has to look up the few sensors of the batch rather than the sensor of every
+// event. Flush complete events count as events of the sensor that was flushed.
+class SensorEventBatch {
+public:
+    // Indexes the given events, which have to outlive the use of the batch.
+    void reset(sensors_event_t const* events, size_t count);
+
+    sensors_event_t const* getEvents() const { return mEvents; }
+    size_t size() const { return mCount; }
+
+    // The distinct sensors of the batch, in the order of their first event.
+    const std::vector<int32_t>& getSensorHandles() const { return mHandles; }
+    // Index in getSensorHandles() of the sensor of the event at the given index.
+    size_t getSensorIndex(size_t eventIndex) const { return mSensorIndices[eventIndex]; }
+
+private:
+    sensors_event_t const* mEvents = nullptr;
+    size_t mCount = 0;
+    std::vector<int32_t> mHandles;
+    std::vector<uint16_t> mSensorIndices;
+};
+
+} // namespace android
+
+#endif // ANDROID_SENSOR_EVENT_BATCH_H
@@ -288,90 +288,100 @@ bool SensorService::SensorEventConnection::incrementPendingFlushCountIfHasAccess
 }
 
 status_t SensorService::SensorEventConnection::sendEvents(
-        sensors_event_t const* buffer, size_t numEvents,
-        sensors_event_t* scratch,
+        const SensorEventBatch& batch, sensors_event_t* scratch,
         wp<const SensorEventConnection> const * mapFlushEventsToConnections) {
-    // filter out events not for this connection
+    sensors_event_t const* buffer = batch.getEvents();
 
-    std::unique_ptr<sensors_event_t[]> sanitizedBuffer;
-
-    int count = 0;
     Mutex::Autolock _l(mConnectionLock);
-    if (scratch) {
-        size_t i=0;
-        while (i<numEvents) {
-            int32_t sensor_handle = buffer[i].sensor;
-            if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ",
-                        buffer[i].meta_data.sensor);
-                // Setting sensor_handle to the correct sensor to ensure the sensor events per
-                // connection are filtered correctly.  buffer[i].sensor is zero for meta_data
-                // events.
-                sensor_handle = buffer[i].meta_data.sensor;
-            }
-
-            // Check if this connection has registered for this sensor. If not continue to the
-            // next sensor_event.
-            if (mSensorInfo.count(sensor_handle) == 0) {
-                ++i;
-                continue;
-            }
+    // Look up the sensors of the batch once, rather than the sensor of each event. Null for the
+    // sensors this connection isn't registered for.
+    const std::vector<int32_t>& sensorHandles = batch.getSensorHandles();
+    mBatchFlushInfos.assign(sensorHandles.size(), nullptr);
+    bool hasWakeUpSensors = false;
+    for (size_t i = 0; i < sensorHandles.size(); i++) {
+        const auto it = mSensorInfo.find(sensorHandles[i]);
+        if (it != mSensorInfo.end()) {
+            mBatchFlushInfos[i] = &it->second;
+            hasWakeUpSensors |= mService->isWakeUpSensor(sensorHandles[i]);
+        }
+    }
+
+    const bool sensorAccess = hasSensorAccess();
+    mBatchEventIndices.clear();
+    for (size_t i = 0; i < batch.size(); i++) {
+        // Check if this connection has registered for this sensor. If not continue to the
+        // next sensor_event.
+        FlushInfo* flushInfo = mBatchFlushInfos[batch.getSensorIndex(i)];
+        if (flushInfo == nullptr) {
+            continue;
+        }
 
-            FlushInfo& flushInfo = mSensorInfo[sensor_handle];
-            // Check if there is a pending flush_complete event for this sensor on this connection.
-            if (buffer[i].type == SENSOR_TYPE_META_DATA && flushInfo.mFirstFlushPending == true &&
-                    mapFlushEventsToConnections[i] == this) {
-                flushInfo.mFirstFlushPending = false;
+        const bool isFlushForThisConnection = buffer[i].type == SENSOR_TYPE_META_DATA &&
+                mapFlushEventsToConnections[i] == this;
+        // If there is a pending flush complete event for this sensor on this connection, ignore
+        // the events until it arrives, and the event itself.
+        if (flushInfo->mFirstFlushPending) {
+            if (isFlushForThisConnection) {
+                flushInfo->mFirstFlushPending = false;
                 ALOGD_IF(DEBUG_CONNECTIONS, "First flush event for sensor==%d ",
                         buffer[i].meta_data.sensor);
-                ++i;
-                continue;
             }
+            continue;
+        }
 
-            // If there is a pending flush complete event for this sensor on this connection,
-            // ignore the event and proceed to the next.
-            if (flushInfo.mFirstFlushPending) {
-                ++i;
-                continue;
+        if (buffer[i].type == SENSOR_TYPE_META_DATA) {
+            ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ",
+                    buffer[i].meta_data.sensor);
+            if (isFlushForThisConnection) {
+                mBatchEventIndices.push_back(i);
             }
-
-            do {
-                // Keep copying events into the scratch buffer as long as they are regular
-                // sensor_events are from the same sensor_handle OR they are flush_complete_events
-                // from the same sensor_handle AND the current connection is mapped to the
-                // corresponding flush_complete_event.
-                if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                    if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
-                    }
-                } else {
-                    // Regular sensor event, just copy it to the scratch buffer after checking
-                    // the AppOp.
-                    if (hasSensorAccess() && noteOpIfRequired(buffer[i])) {
-                        scratch[count++] = buffer[i];
-                    }
-                }
-                i++;
-            } while ((i<numEvents) && ((buffer[i].sensor == sensor_handle &&
-                                        buffer[i].type != SENSOR_TYPE_META_DATA) ||
-                                       (buffer[i].type == SENSOR_TYPE_META_DATA  &&
-                                        buffer[i].meta_data.sensor == sensor_handle)));
+        } else if (sensorAccess && noteOpIfRequired(buffer[i])) {
+            // Regular sensor event, send it after checking the AppOp.
+            mBatchEventIndices.push_back(i);
         }
+    }
+
+    const int count = mBatchEventIndices.size();
+    if (count > 0 && !hasWakeUpSensors &&
+        mBatchEventIndices.back() - mBatchEventIndices.front() + 1 == uint32_t(count)) {
+        // The events are a contiguous range of the batch, and none of them need to be flagged as
+        // a wake up event, so write them straight from the batch instead of copying them. This is
+        // the usual case of connections listening to all the sensors of the batch.
+        return sendFilteredEventsLocked(
+                const_cast<sensors_event_t*>(buffer + mBatchEventIndices.front()), count,
+                /*mayHaveWakeUpEvents=*/false);
+    }
+    for (int i = 0; i < count; i++) {
+        scratch[i] = buffer[mBatchEventIndices[i]];
+    }
+    return sendFilteredEventsLocked(scratch, count, hasWakeUpSensors);
+}
+
+status_t SensorService::SensorEventConnection::sendEvents(sensors_event_t const* buffer,
+                                                          size_t numEvents) {
+    std::unique_ptr<sensors_event_t[]> sanitizedBuffer;
+
+    int count = 0;
+    sensors_event_t* scratch;
+    Mutex::Autolock _l(mConnectionLock);
+    if (hasSensorAccess()) {
+        scratch = const_cast<sensors_event_t *>(buffer);
+        count = numEvents;
     } else {
-        if (hasSensorAccess()) {
-            scratch = const_cast<sensors_event_t *>(buffer);
-            count = numEvents;
-        } else {
-            sanitizedBuffer.reset(new sensors_event_t[numEvents]);
-            scratch = sanitizedBuffer.get();
-            for (size_t i = 0; i < numEvents; i++) {
-                if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                    scratch[count++] = buffer[i++];
-                }
+        sanitizedBuffer.reset(new sensors_event_t[numEvents]);
+        scratch = sanitizedBuffer.get();
+        for (size_t i = 0; i < numEvents; i++) {
+            if (buffer[i].type == SENSOR_TYPE_META_DATA) {
+                scratch[count++] = buffer[i++];
             }
         }
     }
+    return sendFilteredEventsLocked(scratch, count, /*mayHaveWakeUpEvents=*/true);
+}
 
+status_t SensorService::SensorEventConnection::sendFilteredEventsLocked(sensors_event_t* scratch,
+                                                                        int count,
+                                                                        bool mayHaveWakeUpEvents) {
     sendPendingFlushEventsLocked();
     // Early return if there are no events for this connection.
     if (count == 0) {
@@ -389,7 +399,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
     }
 
     int index_wake_up_event = -1;
-    if (hasSensorAccess()) {
+    if (mayHaveWakeUpEvents && hasSensorAccess()) {
         index_wake_up_event = findWakeUpSensorEventLocked(scratch, count);
         if (index_wake_up_event >= 0) {
             BatteryService::noteWakeupSensorEvent(scratch[index_wake_up_event].timestamp,
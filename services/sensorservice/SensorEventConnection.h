@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <unordered_map>
+#include <vector>
 
 #include <utils/Vector.h>
 #include <utils/SortedVector.h>
@@ -38,6 +39,7 @@
 #include <sensor/ISensorServer.h>
 #include <sensor/ISensorEventConnection.h>
 
+#include "SensorEventBatch.h"
 #include "SensorService.h"
 
 namespace android {
@@ -54,8 +56,12 @@ public:
                           bool isDataInjectionMode, const String16& opPackageName,
                           const String16& attributionTag);
 
-    status_t sendEvents(sensors_event_t const* buffer, size_t count, sensors_event_t* scratch,
-                        wp<const SensorEventConnection> const * mapFlushEventsToConnections = nullptr);
+    // Sends the events of the batch that are for this connection. They are copied to the scratch
+    // buffer, unless they can be written straight from the batch.
+    status_t sendEvents(const SensorEventBatch& batch, sensors_event_t* scratch,
+                        wp<const SensorEventConnection> const * mapFlushEventsToConnections);
+    // Sends all the given events, without filtering them by sensor.
+    status_t sendEvents(sensors_event_t const* buffer, size_t count);
     bool hasSensor(int32_t handle) const;
     bool hasAnySensor() const;
     bool hasOneShotSensors() const;
@@ -96,6 +102,12 @@ private:
     // flag set. SOCK_SEQPACKET ensures that either the entire packet is read or dropped.
     int findWakeUpSensorEventLocked(sensors_event_t const* scratch, int count);
 
+    // Sends events which have been filtered for this connection, flagging the first wake up event
+    // among them, or caches them if the socket is full. Looking for the wake up event is skipped
+    // if the caller knows that there isn't any.
+    status_t sendFilteredEventsLocked(sensors_event_t* scratch, int count,
+                                      bool mayHaveWakeUpEvents);
+
     // Send pending flush_complete events. There may have been flush_complete_events that are
     // dropped which need to be sent separately before other events. On older HALs (1_0) this method
     // emulates the behavior of flush().
@@ -179,6 +191,11 @@ private:
     // protected by SensorService::mLock. Key for this map is the sensor handle.
     std::unordered_map<int32_t, FlushInfo> mSensorInfo;
 
+    // The FlushInfo of each sensor of the batch being sent, and the indices of its events which
+    // are for this connection. Kept around so that sending a batch doesn't allocate.
+    std::vector<FlushInfo*> mBatchFlushInfos;
+    std::vector<uint32_t> mBatchEventIndices;
+
     sensors_event_t *mEventCache;
     int mCacheSize, mMaxCacheSize;
     int64_t mTimeOfLastEventDrop;
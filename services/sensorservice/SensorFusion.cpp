@@ -80,27 +80,8 @@ SensorFusion::SensorFusion()
 void SensorFusion::process(const sensors_event_t& event) {
 
     if (event.type == mGyro.getType()) {
-        float dT;
-        if ( event.timestamp - mGyroTime> 0 &&
-             event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
-
-            dT = (event.timestamp - mGyroTime) / 1000000000.0f;
-            // here we estimate the gyro rate (useful for debugging)
-            const float freq = 1 / dT;
-            if (freq >= 100 && freq<1000) { // filter values obviously wrong
-                const float alpha = 1 / (1 + dT); // 1s time-constant
-                mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
-            }
-
-            const vec3_t gyro(event.data);
-            for (int i = 0; i<NUM_FUSION_MODE; ++i) {
-                if (mEnabled[i]) {
-                    // fusion in no gyro mode will ignore
-                    mFusions[i].handleGyro(gyro, dT);
-                }
-            }
-        }
-        mGyroTime = event.timestamp;
+        queueGyro(event);
+        flushGyro();
     } else if (event.type == SENSOR_TYPE_MAGNETIC_FIELD) {
         const vec3_t mag(event.data);
         for (int i = 0; i<NUM_FUSION_MODE; ++i) {
@@ -126,6 +107,53 @@ void SensorFusion::process(const sensors_event_t& event) {
     }
 }
 
+void SensorFusion::process(const sensors_event_t* events, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        if (events[n].type == mGyro.getType()) {
+            queueGyro(events[n]);
+        } else {
+            // accelerometer and magnetometer updates must see every gyro
+            // sample that came before them
+            flushGyro();
+            process(events[n]);
+        }
+    }
+    flushGyro();
+}
+
+void SensorFusion::queueGyro(const sensors_event_t& event) {
+    if ( event.timestamp - mGyroTime> 0 &&
+         event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
+
+        const float dT = (event.timestamp - mGyroTime) / 1000000000.0f;
+        // here we estimate the gyro rate (useful for debugging)
+        const float freq = 1 / dT;
+        if (freq >= 100 && freq<1000) { // filter values obviously wrong
+            const float alpha = 1 / (1 + dT); // 1s time-constant
+            mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
+        }
+
+        mGyroSamples.push_back(vec3_t(event.data));
+        mGyroDeltas.push_back(dT);
+    }
+    mGyroTime = event.timestamp;
+}
+
+void SensorFusion::flushGyro() {
+    if (mGyroSamples.empty()) {
+        return;
+    }
+    for (int i = 0; i<NUM_FUSION_MODE; ++i) {
+        if (mEnabled[i]) {
+            // fusion in no gyro mode will ignore
+            mFusions[i].handleGyro(mGyroSamples.data(), mGyroDeltas.data(),
+                    mGyroSamples.size());
+        }
+    }
+    mGyroSamples.clear();
+    mGyroDeltas.clear();
+}
+
 template <typename T> inline T min(T a, T b) { return a<b ? a : b; }
 template <typename T> inline T max(T a, T b) { return a>b ? a : b; }
 
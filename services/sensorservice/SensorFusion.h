@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <vector>
+
 #include <utils/SortedVector.h>
 #include <utils/Singleton.h>
 #include <utils/String8.h>
@@ -58,10 +60,20 @@ class SensorFusion : public Singleton<SensorFusion> {
     nsecs_t mGyroTime;
     nsecs_t mAccTime;
 
+    // gyro samples waiting to be integrated, see flushGyro()
+    std::vector<vec3_t> mGyroSamples;
+    std::vector<float> mGyroDeltas;
+
     SensorFusion();
 
+    void queueGyro(const sensors_event_t& event);
+    void flushGyro();
+
 public:
     void process(const sensors_event_t& event);
+    // Same as calling process() for each event, but runs of gyro samples are
+    // integrated together.
+    void process(const sensors_event_t* events, size_t count);
 
     bool isEnabled() const {
         return mEnabled[FUSION_9AXIS] ||
@@ -63,9 +63,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <ctime>
 #include <future>
+#include <iterator>
 #include <mutex>
 #include <string>
 
@@ -76,6 +78,8 @@ using namespace std::chrono_literals;
 namespace android {
 // ---------------------------------------------------------------------------
 
+using SensorServiceUtil::LockHoldStats;
+
 /*
  * Notes:
  *
@@ -226,6 +230,7 @@ status_t SensorService::unregisterRuntimeSensor(int handle) {
     for (const sp<SensorEventConnection>& connection : connLock.getActiveConnections()) {
         connection->removeSensor(handle);
     }
+    mConnectionHolder.removeSensor(handle);
 
     // If this was the last sensor for this device, remove its callback.
     bool deviceHasSensors = false;
@@ -675,6 +680,7 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
             }
             result.appendFormat("Sensor Privacy: %s\n",
                     mSensorPrivacyPolicy->isSensorPrivacyEnabled() ? "enabled" : "disabled");
+            result.appendFormat("mLock hold times:\n%s", mLockHoldStats.dump().c_str());
 
             const auto& activeConnections = connLock.getActiveConnections();
             result.appendFormat("%zd active connections\n", activeConnections.size());
@@ -1089,13 +1095,8 @@ bool SensorService::threadLoop() {
         for (int i = 0; i < count; i++) {
              mSensorEventBuffer[i].flags = 0;
         }
-        ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
-
-        // Poll has returned. Hold a wakelock if one of the events is from a wake up sensor. The
-        // rest of this loop is under a critical section protected by mLock. Acquiring a wakeLock,
-        // sending events to clients (incrementing SensorEventConnection::mWakeLockRefCount) should
-        // not be interleaved with decrementing SensorEventConnection::mWakeLockRefCount and
-        // releasing the wakelock.
+        // Looking up the sensors of the events doesn't need mLock, so count the wake up events
+        // before taking it.
         uint32_t wakeEvents = 0;
         for (int i = 0; i < count; i++) {
             if (isWakeUpSensorEvent(mSensorEventBuffer[i])) {
@@ -1103,145 +1104,206 @@ bool SensorService::threadLoop() {
             }
         }
 
-        if (wakeEvents > 0) {
-            if (!mWakeLockAcquired) {
-                setWakeLockAcquiredLocked(true);
+        // Everything but sending the events to clients is done under mLock: the fusion of virtual
+        // sensors, and the mapping of flush complete events, go through state that
+        // enable/disable/flush also change.
+        bool wakeLockAcquired;
+        {
+            ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+            LockHoldStats::Timer lockHoldTimer(mLockHoldStats,
+                                               LockHoldStats::Operation::THREAD_LOOP);
+
+            // Poll has returned. Hold a wakelock if one of the events is from a wake up sensor.
+            // The events are sent to clients without mLock held, which increments
+            // SensorEventConnection::mWakeLockRefCount. Until then, checkWakeLockStateLocked must
+            // not release the wakelock because a client acknowledged its previous events.
+            if (wakeEvents > 0) {
+                if (!mWakeLockAcquired) {
+                    setWakeLockAcquiredLocked(true);
+                }
+                device.writeWakeLockHandled(wakeEvents);
+                mDispatchingWakeUpEvents = true;
             }
-            device.writeWakeLockHandled(wakeEvents);
-        }
-        recordLastValueLocked(mSensorEventBuffer, count);
-
-        // handle virtual sensors
-        if (count && vcount) {
-            sensors_event_t const * const event = mSensorEventBuffer;
-            if (!mActiveVirtualSensors.empty()) {
-                size_t k = 0;
-                SensorFusion& fusion(SensorFusion::getInstance());
-                if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
+            recordLastValueLocked(mSensorEventBuffer, count);
+
+            // handle virtual sensors
+            if (count && vcount) {
+                sensors_event_t const * const event = mSensorEventBuffer;
+                if (!mActiveVirtualSensors.empty()) {
+                    size_t k = 0;
+                    SensorFusion& fusion(SensorFusion::getInstance());
+                    if (fusion.isEnabled()) {
+                        fusion.process(event, count);
                     }
-                }
-                for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
+                    // Look the virtual sensors up once for the whole batch, rather than for each
+                    // event.
+                    mActiveVirtualSensorInterfaces.clear();
                     for (int handle : mActiveVirtualSensors) {
-                        if (count + k >= minBufferSize) {
-                            ALOGE("buffer too small to hold all events: "
-                                    "count=%zd, k=%zu, size=%zu",
-                                    count, k, minBufferSize);
-                            break;
-                        }
-                        sensors_event_t out;
                         std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
                         if (si == nullptr) {
                             ALOGE("handle %d is not an valid virtual sensor", handle);
                             continue;
                         }
-
-                        if (si->process(&out, event[i])) {
-                            mSensorEventBuffer[count + k] = out;
-                            k++;
+                        mActiveVirtualSensorInterfaces.push_back(std::move(si));
+                    }
+                    for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
+                        for (const std::shared_ptr<SensorInterface>& si :
+                                     mActiveVirtualSensorInterfaces) {
+                            if (count + k >= minBufferSize) {
+                                ALOGE("buffer too small to hold all events: "
+                                        "count=%zd, k=%zu, size=%zu",
+                                        count, k, minBufferSize);
+                                break;
+                            }
+                            sensors_event_t out;
+                            if (si->process(&out, event[i])) {
+                                mSensorEventBuffer[count + k] = out;
+                                k++;
+                            }
                         }
                     }
-                }
-                if (k) {
-                    // record the last synthesized values
-                    recordLastValueLocked(&mSensorEventBuffer[count], k);
-                    count += k;
-                    sortEventBuffer(mSensorEventBuffer, count);
+                    mActiveVirtualSensorInterfaces.clear();
+                    if (k) {
+                        // record the last synthesized values
+                        recordLastValueLocked(&mSensorEventBuffer[count], k);
+                        count += k;
+                        sortEventBuffer(mSensorEventBuffer, count);
+                    }
                 }
             }
-        }
 
-        // handle backward compatibility for RotationVector sensor
-        if (halVersion < SENSORS_DEVICE_API_VERSION_1_0) {
-            for (int i = 0; i < count; i++) {
-                if (mSensorEventBuffer[i].type == SENSOR_TYPE_ROTATION_VECTOR) {
-                    // All the 4 components of the quaternion should be available
-                    // No heading accuracy. Set it to -1
-                    mSensorEventBuffer[i].data[4] = -1;
+            // handle backward compatibility for RotationVector sensor
+            if (halVersion < SENSORS_DEVICE_API_VERSION_1_0) {
+                for (int i = 0; i < count; i++) {
+                    if (mSensorEventBuffer[i].type == SENSOR_TYPE_ROTATION_VECTOR) {
+                        // All the 4 components of the quaternion should be available
+                        // No heading accuracy. Set it to -1
+                        mSensorEventBuffer[i].data[4] = -1;
+                    }
                 }
             }
-        }
 
-        // Cache the list of active connections, since we use it in multiple places below but won't
-        // modify it here
-        const std::vector<sp<SensorEventConnection>> activeConnections = connLock.getActiveConnections();
-
-        for (int i = 0; i < count; ++i) {
-            // Map flush_complete_events in the buffer to SensorEventConnections which called flush
-            // on the hardware sensor. mapFlushEventsToConnections[i] will be the
-            // SensorEventConnection mapped to the corresponding flush_complete_event in
-            // mSensorEventBuffer[i] if such a mapping exists (NULL otherwise).
-            mMapFlushEventsToConnections[i] = nullptr;
-            if (mSensorEventBuffer[i].type == SENSOR_TYPE_META_DATA) {
-                const int sensor_handle = mSensorEventBuffer[i].meta_data.sensor;
-                SensorRecord* rec = mActiveSensors.valueFor(sensor_handle);
-                if (rec != nullptr) {
-                    mMapFlushEventsToConnections[i] = rec->getFirstPendingFlushConnection();
-                    rec->removeFirstPendingFlushConnection();
+            for (int i = 0; i < count; ++i) {
+                // Map flush_complete_events in the buffer to SensorEventConnections which called
+                // flush on the hardware sensor. mapFlushEventsToConnections[i] will be the
+                // SensorEventConnection mapped to the corresponding flush_complete_event in
+                // mSensorEventBuffer[i] if such a mapping exists (NULL otherwise).
+                mMapFlushEventsToConnections[i] = nullptr;
+                if (mSensorEventBuffer[i].type == SENSOR_TYPE_META_DATA) {
+                    const int sensor_handle = mSensorEventBuffer[i].meta_data.sensor;
+                    SensorRecord* rec = mActiveSensors.valueFor(sensor_handle);
+                    if (rec != nullptr) {
+                        mMapFlushEventsToConnections[i] = rec->getFirstPendingFlushConnection();
+                        rec->removeFirstPendingFlushConnection();
+                    }
                 }
-            }
 
-            // handle dynamic sensor meta events, process registration and unregistration of dynamic
-            // sensor based on content of event.
-            if (mSensorEventBuffer[i].type == SENSOR_TYPE_DYNAMIC_SENSOR_META) {
-                if (mSensorEventBuffer[i].dynamic_sensor_meta.connected) {
-                    int handle = mSensorEventBuffer[i].dynamic_sensor_meta.handle;
-                    const sensor_t& dynamicSensor =
-                            *(mSensorEventBuffer[i].dynamic_sensor_meta.sensor);
-                    ALOGI("Dynamic sensor handle 0x%x connected, type %d, name %s",
-                          handle, dynamicSensor.type, dynamicSensor.name);
-
-                    if (mSensors.isNewHandle(handle)) {
-                        const auto& uuid = mSensorEventBuffer[i].dynamic_sensor_meta.uuid;
-                        sensor_t s = dynamicSensor;
-                        // make sure the dynamic sensor flag is set
-                        s.flags |= DYNAMIC_SENSOR_MASK;
-                        // force the handle to be consistent
-                        s.handle = handle;
-
-                        auto si = std::make_shared<HardwareSensor>(s, uuid);
-
-                        // This will release hold on dynamic sensor meta, so it should be called
-                        // after Sensor object is created.
-                        device.handleDynamicSensorConnection(handle, true /*connected*/);
-                        registerDynamicSensorLocked(std::move(si));
+                // handle dynamic sensor meta events, process registration and unregistration of
+                // dynamic sensor based on content of event.
+                if (mSensorEventBuffer[i].type == SENSOR_TYPE_DYNAMIC_SENSOR_META) {
+                    if (mSensorEventBuffer[i].dynamic_sensor_meta.connected) {
+                        int handle = mSensorEventBuffer[i].dynamic_sensor_meta.handle;
+                        const sensor_t& dynamicSensor =
+                                *(mSensorEventBuffer[i].dynamic_sensor_meta.sensor);
+                        ALOGI("Dynamic sensor handle 0x%x connected, type %d, name %s",
+                              handle, dynamicSensor.type, dynamicSensor.name);
+
+                        if (mSensors.isNewHandle(handle)) {
+                            const auto& uuid = mSensorEventBuffer[i].dynamic_sensor_meta.uuid;
+                            sensor_t s = dynamicSensor;
+                            // make sure the dynamic sensor flag is set
+                            s.flags |= DYNAMIC_SENSOR_MASK;
+                            // force the handle to be consistent
+                            s.handle = handle;
+
+                            auto si = std::make_shared<HardwareSensor>(s, uuid);
+
+                            // This will release hold on dynamic sensor meta, so it should be called
+                            // after Sensor object is created.
+                            device.handleDynamicSensorConnection(handle, true /*connected*/);
+                            registerDynamicSensorLocked(std::move(si));
+                        } else {
+                            ALOGE("Handle %d has been used, cannot use again before reboot.",
+                                  handle);
+                        }
                     } else {
-                        ALOGE("Handle %d has been used, cannot use again before reboot.", handle);
-                    }
-                } else {
-                    int handle = mSensorEventBuffer[i].dynamic_sensor_meta.handle;
-                    ALOGI("Dynamic sensor handle 0x%x disconnected", handle);
+                        int handle = mSensorEventBuffer[i].dynamic_sensor_meta.handle;
+                        ALOGI("Dynamic sensor handle 0x%x disconnected", handle);
 
-                    device.handleDynamicSensorConnection(handle, false /*connected*/);
-                    if (!unregisterDynamicSensorLocked(handle)) {
-                        ALOGE("Dynamic sensor release error.");
-                    }
+                        device.handleDynamicSensorConnection(handle, false /*connected*/);
+                        if (!unregisterDynamicSensorLocked(handle)) {
+                            ALOGE("Dynamic sensor release error.");
+                        }
 
-                    for (const sp<SensorEventConnection>& connection : activeConnections) {
-                        connection->removeSensor(handle);
+                        for (const sp<SensorEventConnection>& connection :
+                                     connLock.getActiveConnections()) {
+                            connection->removeSensor(handle);
+                        }
+                        mConnectionHolder.removeSensor(handle);
                     }
                 }
             }
+            wakeLockAcquired = mWakeLockAcquired;
         }
 
-        // Send our events to clients. Check the state of wake lock for each client and release the
-        // lock if none of the clients need it.
+        // Send our events to clients without mLock held, so that clients enabling, disabling or
+        // flushing sensors don't wait for every socket to be written to, nor the other way around.
+        // The connections are those of the last snapshot published by these calls.
+        const std::shared_ptr<const SensorConnectionHolder::Snapshot> snapshot =
+                mConnectionHolder.getSnapshot();
+        mDispatchConnections.clear();
+        for (const wp<SensorEventConnection>& weakConnection : snapshot->connections) {
+            mDispatchConnections.push_back(weakConnection.promote());
+        }
         bool needsWakeLock = false;
-        for (const sp<SensorEventConnection>& connection : activeConnections) {
-            connection->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
+        // count is still negative if the poll failed while the HAL was reconnecting.
+        mSensorEventBatch.reset(mSensorEventBuffer, count > 0 ? count : 0);
+        for (const sp<SensorEventConnection>& connection : mDispatchConnections) {
+            if (connection == nullptr) {
+                continue;
+            }
+            connection->sendEvents(mSensorEventBatch, mSensorEventScratch,
                                    mMapFlushEventsToConnections);
             needsWakeLock |= connection->needsWakeLock();
-            // If the connection has one-shot sensors, it may be cleaned up after first trigger.
-            // Early check for one-shot sensors.
-            if (connection->hasOneShotSensors()) {
-                cleanupAutoDisabledSensorLocked(connection, mSensorEventBuffer, count);
+        }
+
+        // A connection may be cleaned up after the first trigger of its one-shot sensors. Only
+        // the connections registered for the one-shot sensors of the batch need to be checked.
+        std::vector<size_t> oneShotConnections;
+        for (int32_t handle : mSensorEventBatch.getSensorHandles()) {
+            const auto it = snapshot->connectionsByHandle.find(handle);
+            if (it == snapshot->connectionsByHandle.end()) {
+                continue;
+            }
+            std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
+            if (si != nullptr && si->getSensor().getReportingMode() == AREPORTING_MODE_ONE_SHOT) {
+                oneShotConnections.insert(oneShotConnections.end(), it->second.begin(),
+                                          it->second.end());
             }
         }
 
-        if (mWakeLockAcquired && !needsWakeLock) {
-            setWakeLockAcquiredLocked(false);
+        // Check the state of wake lock for each client and release the lock if none of the clients
+        // need it.
+        if (wakeEvents > 0 || (wakeLockAcquired && !needsWakeLock) ||
+            !oneShotConnections.empty()) {
+            ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+            LockHoldStats::Timer lockHoldTimer(mLockHoldStats,
+                                               LockHoldStats::Operation::THREAD_LOOP_AFTER_SEND);
+            std::sort(oneShotConnections.begin(), oneShotConnections.end());
+            oneShotConnections.erase(std::unique(oneShotConnections.begin(),
+                                                 oneShotConnections.end()),
+                                     oneShotConnections.end());
+            for (size_t index : oneShotConnections) {
+                if (mDispatchConnections[index] != nullptr) {
+                    cleanupAutoDisabledSensorLocked(mDispatchConnections[index],
+                                                    mSensorEventBuffer, count);
+                }
+            }
+            mDispatchingWakeUpEvents = false;
+            checkWakeLockStateLocked(&connLock);
         }
+        // Outside of mLock, since this may release the last reference to a connection.
+        mDispatchConnections.clear();
     } while (!Thread::exitPending());
 
     ALOGW("Exiting SensorService::threadLoop => aborting...");
@@ -1275,13 +1337,14 @@ void SensorService::processRuntimeSensorEvents() {
 
     if (count) {
         ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+        LockHoldStats::Timer lockHoldTimer(mLockHoldStats,
+                                           LockHoldStats::Operation::RUNTIME_SENSOR_EVENTS);
 
         recordLastValueLocked(mRuntimeSensorEventBuffer, count);
         sortEventBuffer(mRuntimeSensorEventBuffer, count);
 
         for (const sp<SensorEventConnection>& connection : connLock.getActiveConnections()) {
-            connection->sendEvents(mRuntimeSensorEventBuffer, count, /* scratch= */ nullptr,
-                                   /* mapFlushEventsToConnections= */ nullptr);
+            connection->sendEvents(mRuntimeSensorEventBuffer, count);
             if (connection->hasOneShotSensors()) {
                 cleanupAutoDisabledSensorLocked(connection, mRuntimeSensorEventBuffer, count);
             }
@@ -1389,6 +1452,10 @@ bool SensorService::isWakeUpSensorEvent(const sensors_event_t& event) const {
     if (event.type == SENSOR_TYPE_META_DATA) {
         handle = event.meta_data.sensor;
     }
+    return isWakeUpSensor(handle);
+}
+
+bool SensorService::isWakeUpSensor(int handle) const {
     std::shared_ptr<SensorInterface> sensor = getSensorInterfaceFromHandle(handle);
     return sensor != nullptr && sensor->getSensor().isWakeUpSensor();
 }
@@ -1546,6 +1613,8 @@ sp<ISensorEventConnection> SensorService::createSensorEventConnection(const Stri
     resetTargetSdkVersionCache(opPackageName);
 
     Mutex::Autolock _l(mLock);
+    LockHoldStats::Timer lockHoldTimer(mLockHoldStats,
+                                       LockHoldStats::Operation::CREATE_CONNECTION);
     // To create a client in DATA_INJECTION mode to inject data, SensorService should already be
     // operating in DI mode.
     if (requestedMode == DATA_INJECTION) {
@@ -1828,6 +1897,8 @@ status_t SensorService::resetToNormalModeLocked() {
 
 void SensorService::cleanupConnection(SensorEventConnection* c) {
     ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+    LockHoldStats::Timer lockHoldTimer(mLockHoldStats,
+                                       LockHoldStats::Operation::CLEANUP_CONNECTION);
     const wp<SensorEventConnection> connection(c);
     size_t size = mActiveSensors.size();
     ALOGD_IF(DEBUG_CONNECTIONS, "%zu active sensors", size);
@@ -1989,6 +2060,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
     }
 
     ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+    LockHoldStats::Timer lockHoldTimer(mLockHoldStats, LockHoldStats::Operation::ENABLE);
     if (mCurrentOperatingMode != NORMAL && mCurrentOperatingMode != REPLAY_DATA_INJECTION &&
            !isAllowListedPackage(connection->getPackageName())) {
         return INVALID_OPERATION;
@@ -2037,7 +2109,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
                             if (isWakeUpSensorEvent(event) && !mWakeLockAcquired) {
                                 setWakeLockAcquiredLocked(true);
                             }
-                            connection->sendEvents(&event, 1, nullptr);
+                            connection->sendEvents(&event, 1);
                             if (!connection->needsWakeLock() && mWakeLockAcquired) {
                                 checkWakeLockStateLocked(&connLock);
                             }
@@ -2052,7 +2124,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
         BatteryService::enableSensor(connection->getUid(), handle);
         // the sensor was added (which means it wasn't already there)
         // so, see if this connection becomes active
-        mConnectionHolder.addEventConnectionIfNotPresent(connection);
+        mConnectionHolder.addSensor(connection, handle);
     } else {
         ALOGW("sensor %08x already enabled in connection %p (ignoring)",
             handle, connection.get());
@@ -2126,6 +2198,7 @@ status_t SensorService::disable(const sp<SensorEventConnection>& connection, int
         return mInitCheck;
 
     Mutex::Autolock _l(mLock);
+    LockHoldStats::Timer lockHoldTimer(mLockHoldStats, LockHoldStats::Operation::DISABLE);
     status_t err = cleanupWithoutDisableLocked(connection, handle);
     if (err == NO_ERROR) {
         std::shared_ptr<SensorInterface> sensor = getSensorInterfaceFromHandle(handle);
@@ -2153,6 +2226,7 @@ status_t SensorService::cleanupWithoutDisableLocked(
         // see if this connection becomes inactive
         if (connection->removeSensor(handle)) {
             BatteryService::disableSensor(connection->getUid(), handle);
+            mConnectionHolder.removeSensor(connection, handle);
         }
         if (connection->hasAnySensor() == false) {
             connection->updateLooperRegistration(mLooper);
@@ -2198,6 +2272,7 @@ status_t SensorService::flushSensor(const sp<SensorEventConnection>& connection,
     const int halVersion = dev.getHalDeviceVersion();
     status_t err(NO_ERROR);
     Mutex::Autolock _l(mLock);
+    LockHoldStats::Timer lockHoldTimer(mLockHoldStats, LockHoldStats::Operation::FLUSH);
     // Loop through all sensors for this connection and call flush on each of them.
     for (int handle : connection->getActiveSensorHandles()) {
         std::shared_ptr<SensorInterface> sensor = getSensorInterfaceFromHandle(handle);
@@ -2449,7 +2524,7 @@ void SensorService::checkWakeLockState() {
 }
 
 void SensorService::checkWakeLockStateLocked(ConnectionSafeAutolock* connLock) {
-    if (!mWakeLockAcquired) {
+    if (!mWakeLockAcquired || mDispatchingWakeUpEvents) {
         return;
     }
     bool releaseLock = true;
@@ -2755,12 +2830,69 @@ void SensorService::SensorConnectionHolder::addEventConnectionIfNotPresent(
         const sp<SensorService::SensorEventConnection>& connection) {
     if (mActiveConnections.indexOf(connection) < 0) {
         mActiveConnections.add(connection);
+        publishSnapshot();
     }
 }
 
 void SensorService::SensorConnectionHolder::removeEventConnection(
         const wp<SensorService::SensorEventConnection>& connection) {
     mActiveConnections.remove(connection);
+    for (auto it = mConnectionsByHandle.begin(); it != mConnectionsByHandle.end();) {
+        it->second.remove(connection);
+        it = it->second.isEmpty() ? mConnectionsByHandle.erase(it) : std::next(it);
+    }
+    publishSnapshot();
+}
+
+void SensorService::SensorConnectionHolder::addSensor(
+        const sp<SensorService::SensorEventConnection>& connection, int32_t handle) {
+    if (mActiveConnections.indexOf(connection) < 0) {
+        mActiveConnections.add(connection);
+    }
+    mConnectionsByHandle[handle].add(connection);
+    publishSnapshot();
+}
+
+void SensorService::SensorConnectionHolder::removeSensor(
+        const wp<SensorService::SensorEventConnection>& connection, int32_t handle) {
+    auto it = mConnectionsByHandle.find(handle);
+    if (it == mConnectionsByHandle.end() || it->second.remove(connection) < 0) {
+        return;
+    }
+    if (it->second.isEmpty()) {
+        mConnectionsByHandle.erase(it);
+    }
+    publishSnapshot();
+}
+
+void SensorService::SensorConnectionHolder::removeSensor(int32_t handle) {
+    if (mConnectionsByHandle.erase(handle) > 0) {
+        publishSnapshot();
+    }
+}
+
+std::shared_ptr<const SensorService::SensorConnectionHolder::Snapshot>
+        SensorService::SensorConnectionHolder::getSnapshot() const {
+    std::lock_guard<std::mutex> _l(mSnapshotLock);
+    return mSnapshot;
+}
+
+void SensorService::SensorConnectionHolder::publishSnapshot() {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->connections.assign(mActiveConnections.begin(), mActiveConnections.end());
+    for (const auto& [handle, connections] : mConnectionsByHandle) {
+        std::vector<size_t>& indices = snapshot->connectionsByHandle[handle];
+        indices.reserve(connections.size());
+        for (const wp<SensorEventConnection>& connection : connections) {
+            const ssize_t index = mActiveConnections.indexOf(connection);
+            if (index >= 0) {
+                indices.push_back(static_cast<size_t>(index));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> _l(mSnapshotLock);
+    mSnapshot = std::move(snapshot);
 }
 
 void SensorService::SensorConnectionHolder::addDirectConnection(
@@ -17,6 +17,8 @@
 #ifndef ANDROID_SENSOR_SERVICE_H
 #define ANDROID_SENSOR_SERVICE_H
 
+#include "LockHoldStats.h"
+#include "SensorEventBatch.h"
 #include "SensorList.h"
 #include "RecentEventLogger.h"
 
@@ -43,6 +45,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
@@ -253,12 +256,29 @@ private:
 
     // Encapsulates the collection of active SensorEventConection and SensorDirectConnection
     // references. Write access is done through this class with mLock held, but all read access
-    // must be routed through ConnectionSafeAutolock.
+    // must be routed through ConnectionSafeAutolock, or through a Snapshot.
     class SensorConnectionHolder {
     public:
+        // The active event connections and the sensors they are registered for, as of a write
+        // access. Snapshots are never modified: each write access publishes a new one, so that
+        // the sensor thread can send events to the connections without holding mLock while
+        // clients enable, disable and flush sensors.
+        struct Snapshot {
+            std::vector<wp<SensorEventConnection>> connections;
+            // Indices in connections of the connections registered for each sensor handle.
+            std::unordered_map<int32_t, std::vector<size_t>> connectionsByHandle;
+        };
+
         void addEventConnectionIfNotPresent(const sp<SensorEventConnection>& connection);
+        // Also removes the connection from all of its sensors.
         void removeEventConnection(const wp<SensorEventConnection>& connection);
 
+        // Records that the connection is registered for the sensor, and adds it if needed.
+        void addSensor(const sp<SensorEventConnection>& connection, int32_t handle);
+        void removeSensor(const wp<SensorEventConnection>& connection, int32_t handle);
+        // Removes the sensor from all of the connections, e.g. when it is disconnected.
+        void removeSensor(int32_t handle);
+
         void addDirectConnection(const sp<SensorDirectConnection>& connection);
         void removeDirectConnection(const wp<SensorDirectConnection>& connection);
 
@@ -266,10 +286,22 @@ private:
         // object that can be used to safely read the lists of connections
         ConnectionSafeAutolock lock(Mutex& mutex);
 
+        // Can be called without mLock. The weak references have to be promoted without mLock
+        // held, since the last strong reference to a connection may be released with them.
+        std::shared_ptr<const Snapshot> getSnapshot() const;
+
     private:
         friend class ConnectionSafeAutolock;
+
+        void publishSnapshot();
+
         SortedVector< wp<SensorEventConnection> > mActiveConnections;
         SortedVector< wp<SensorDirectConnection> > mDirectConnections;
+        std::unordered_map<int32_t, SortedVector<wp<SensorEventConnection>>> mConnectionsByHandle;
+
+        // Only guards the pointer, so that publishing never waits for the sensor thread.
+        mutable std::mutex mSnapshotLock;
+        std::shared_ptr<const Snapshot> mSnapshot = std::make_shared<const Snapshot>();
     };
 
     class RuntimeSensorHandler : public Thread {
@@ -438,6 +470,7 @@ private:
     void checkWakeLockStateLocked(ConnectionSafeAutolock* connLock);
     bool isWakeLockAcquired();
     bool isWakeUpSensorEvent(const sensors_event_t& event) const;
+    bool isWakeUpSensor(int handle) const;
 
     sp<Looper> getLooper() const;
 
@@ -543,12 +576,24 @@ private:
     mutable Mutex mLock;
     DefaultKeyedVector<int, SensorRecord*> mActiveSensors;
     std::unordered_set<int> mActiveVirtualSensors;
+    // scratch for threadLoop(), the interfaces of mActiveVirtualSensors
+    std::vector<std::shared_ptr<SensorInterface>> mActiveVirtualSensorInterfaces;
     SensorConnectionHolder mConnectionHolder;
     bool mWakeLockAcquired;
     sensors_event_t *mSensorEventBuffer, *mSensorEventScratch, *mRuntimeSensorEventBuffer;
     // WARNING: these SensorEventConnection instances must not be promoted to sp, except via
     // modification to add support for them in ConnectionSafeAutolock
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
+    // Index of mSensorEventBuffer by sensor, shared by all the connections it is sent to.
+    SensorEventBatch mSensorEventBatch;
+    // scratch for threadLoop(), the connections of the snapshot that events are sent to. Only
+    // cleared without mLock held, see SensorConnectionHolder::getSnapshot.
+    std::vector<sp<SensorEventConnection>> mDispatchConnections;
+    // Set while threadLoop() sends wake up events without mLock held, so that the wake lock is
+    // not released before the connections have counted the events they need to acknowledge.
+    bool mDispatchingWakeUpEvents = false;
+    // How long mLock is held for by the sensor threads and by the calls from clients.
+    SensorServiceUtil::LockHoldStats mLockHoldStats;
     std::unordered_map<int, SensorServiceUtil::RecentEventLogger*> mRecentEvent;
     Mode mCurrentOperatingMode;
     std::queue<sensors_event_t> mRuntimeSensorEventQueue;
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "Fusion.h"
+
+#include <math.h>
+#include <vector>
+
+namespace android {
+namespace {
+
+constexpr float GYRO_PERIOD = 0.001f;   // 1kHz
+constexpr size_t ACC_DECIMATION = 10;   // 100Hz
+constexpr size_t MAG_DECIMATION = 20;   // 50Hz
+constexpr size_t DURATION = 10000;      // 10s of gyro samples
+
+struct ImuSample {
+    vec3_t w;
+    vec3_t a;
+    vec3_t m;
+};
+
+// A device being turned around in the hand, sampled like a phone IMU would report it.
+std::vector<ImuSample> createRecording() {
+    std::vector<ImuSample> samples(DURATION);
+    for (size_t i = 0; i < samples.size(); i++) {
+        const float t = i * GYRO_PERIOD;
+        ImuSample& s = samples[i];
+        s.w.x = 0.8f * sinf(1.3f * t);
+        s.w.y = 0.5f * cosf(0.7f * t);
+        s.w.z = 0.2f + 0.05f * sinf(3.1f * t);
+        s.a.x = 0.6f * sinf(0.9f * t);
+        s.a.y = 0.4f * cosf(1.1f * t);
+        s.a.z = 9.7f;
+        s.m.x = 5;
+        s.m.y = 30 * cosf(0.2f * t);
+        s.m.z = -20;
+    }
+    return samples;
+}
+
+// Feeds the fusion one gyro sample at a time, the way SensorFusion used to.
+void BM_replayPerSample(benchmark::State& state) {
+    const std::vector<ImuSample> recording = createRecording();
+    for (auto _ : state) {
+        Fusion fusion;
+        fusion.init(state.range(0));
+        for (size_t i = 0; i < recording.size(); i++) {
+            fusion.handleGyro(recording[i].w, GYRO_PERIOD);
+            if (i % MAG_DECIMATION == 0) {
+                fusion.handleMag(recording[i].m);
+            }
+            if (i % ACC_DECIMATION == 0) {
+                fusion.handleAcc(recording[i].a, GYRO_PERIOD * ACC_DECIMATION);
+            }
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * recording.size());
+}
+BENCHMARK(BM_replayPerSample)->Arg(FUSION_9AXIS)->Arg(FUSION_NOMAG);
+
+// Feeds the fusion the gyro samples between two accelerometer samples at once.
+void BM_replayBatched(benchmark::State& state) {
+    const std::vector<ImuSample> recording = createRecording();
+    std::vector<vec3_t> gyro;
+    const std::vector<float> dT(ACC_DECIMATION, GYRO_PERIOD);
+    for (auto _ : state) {
+        Fusion fusion;
+        fusion.init(state.range(0));
+        for (size_t i = 0; i < recording.size(); i++) {
+            gyro.push_back(recording[i].w);
+            if (i % ACC_DECIMATION == 0) {
+                fusion.handleGyro(gyro.data(), dT.data(), gyro.size());
+                gyro.clear();
+                if (i % MAG_DECIMATION == 0) {
+                    fusion.handleMag(recording[i].m);
+                }
+                fusion.handleAcc(recording[i].a, GYRO_PERIOD * ACC_DECIMATION);
+            }
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * recording.size());
+}
+BENCHMARK(BM_replayBatched)->Arg(FUSION_9AXIS)->Arg(FUSION_NOMAG);
+
+mat<mat33_t, 2, 2> createCovariance() {
+    mat<mat33_t, 2, 2> P;
+    for (size_t c = 0; c < 6; c++) {
+        for (size_t r = 0; r < 6; r++) {
+            P[c / 3][r / 3][c % 3][r % 3] = (c == r ? 1e-3f : 1e-5f) / (1 + c + r);
+        }
+    }
+    return P;
+}
+
+mat<mat33_t, 2, 2> createTransition() {
+    mat<mat33_t, 2, 2> Phi;
+    Phi[0][0] = 1;
+    Phi[0][0][1][0] = 1e-3f;
+    Phi[0][0][0][1] = -1e-3f;
+    Phi[1][0] = -GYRO_PERIOD;
+    Phi[0][1] = 0;
+    Phi[1][1] = 1;
+    return Phi;
+}
+
+// The covariance prediction as a product of the full 6x6 matrices.
+void BM_predictCovarianceFull(benchmark::State& state) {
+    mat<mat33_t, 2, 2> P = createCovariance();
+    const mat<mat33_t, 2, 2> Phi = createTransition();
+    mat<mat33_t, 2, 2> GQGt;
+    GQGt[0][0] = 1e-10f;
+    GQGt[1][0] = -1e-18f;
+    GQGt[0][1] = -1e-18f;
+    GQGt[1][1] = 1e-15f;
+    for (auto _ : state) {
+        P = Phi * P * transpose(Phi) + GQGt;
+        benchmark::DoNotOptimize(P);
+    }
+}
+BENCHMARK(BM_predictCovarianceFull);
+
+// The same prediction expanded by blocks, as Fusion::predict() does it.
+void BM_predictCovarianceByBlocks(benchmark::State& state) {
+    mat<mat33_t, 2, 2> P = createCovariance();
+    const mat<mat33_t, 2, 2> Phi = createTransition();
+    const mat33_t& A(Phi[0][0]);
+    const mat33_t& B(Phi[1][0]);
+    const mat33_t q00(1e-10f);
+    const mat33_t q10(-1e-18f);
+    const mat33_t q11(1e-15f);
+    for (auto _ : state) {
+        const mat33_t T(A * P[0][0] + B * P[0][1]);
+        const mat33_t U(A * P[1][0] + B * P[1][1]);
+        P[0][0] = T * transpose(A) + U * transpose(B) + q00;
+        P[1][0] = U + q10;
+        P[0][1] = transpose(P[1][0]);
+        P[1][1] += q11;
+        benchmark::DoNotOptimize(P);
+    }
+}
+BENCHMARK(BM_predictCovarianceByBlocks);
+
+} // namespace
+} // namespace android
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Fusion.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace android {
+
+using Covariance = mat<mat33_t, 2, 2>;
+
+class FusionTest : public testing::Test {
+protected:
+    static constexpr float GYRO_PERIOD = 0.001f; // 1kHz
+
+    void SetUp() override {
+        vec4_t q;
+        q.x = 0;
+        q.y = 0;
+        q.z = 0;
+        q.w = 1;
+        mFusion.initFusion(q, GYRO_PERIOD);
+    }
+
+    void predict(const vec3_t& w, float dT) { mFusion.predict(w, dT); }
+
+    const Covariance& covariance() const { return mFusion.P; }
+    void setCovariance(const Covariance& P) { mFusion.P = P; }
+    // The transition matrix of the last predict().
+    const Covariance& transition() const { return mFusion.Phi; }
+    const Covariance& processNoise() const { return mFusion.GQGt; }
+    void setProcessNoise(const Covariance& GQGt) { mFusion.GQGt = GQGt; }
+
+    Fusion mFusion;
+};
+
+namespace {
+
+// A symmetric positive definite covariance, with every block non-zero. Keep
+// it about as small as the fusion's own, since checkState() resets P once
+// rounding has made it asymmetric by more than an absolute tolerance.
+Covariance createCovariance(float scale) {
+    Covariance L;
+    for (size_t i = 0; i < 2; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    L[i][j][c][r] = scale * sinf(1.f + i * 7 + j * 5 + c * 3 + r);
+                }
+            }
+        }
+    }
+    Covariance P(L * transpose(L));
+    P[0][0] += mat33_t(scale * scale);
+    P[1][1] += mat33_t(scale * scale);
+    return P;
+}
+
+float maxAbs(const Covariance& P) {
+    float result = 0;
+    for (size_t i = 0; i < 2; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    result = std::max(result, fabsf(P[i][j][c][r]));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void expectNear(const Covariance& expected, const Covariance& actual, float tolerance) {
+    for (size_t i = 0; i < 2; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    EXPECT_NEAR(expected[i][j][c][r], actual[i][j][c][r], tolerance)
+                            << "block " << i << "," << j << " element " << c << "," << r;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST_F(FusionTest, predictMatchesFullCovarianceProduct) {
+    constexpr size_t kNumSteps = 1000;
+
+    setCovariance(createCovariance(1e-3f));
+    // The default process noise is too small to tell a wrong expansion of
+    // its blocks apart from rounding.
+    setProcessNoise(createCovariance(3e-5f));
+    Covariance expected(covariance());
+    for (size_t i = 0; i < kNumSteps; i++) {
+        const float t = i * GYRO_PERIOD;
+        vec3_t w;
+        w.x = 0.8f * sinf(1.3f * t);
+        w.y = 0.5f * cosf(0.7f * t);
+        w.z = 0.2f + 0.05f * sinf(3.1f * t);
+        predict(w, GYRO_PERIOD);
+        expected = transition() * expected * transpose(transition()) + processNoise();
+    }
+
+    expectNear(expected, covariance(), 1e-4f * maxAbs(expected));
+}
+
+TEST_F(FusionTest, predictKeepsCovarianceSymmetric) {
+    setCovariance(createCovariance(1e-3f));
+    setProcessNoise(createCovariance(3e-5f));
+    vec3_t w;
+    w.x = 0.3f;
+    w.y = -1.2f;
+    w.z = 0.7f;
+    for (size_t i = 0; i < 100; i++) {
+        predict(w, GYRO_PERIOD);
+    }
+
+    const Covariance& P = covariance();
+    expectNear(P, transpose(P), 1e-5f * maxAbs(P));
+}
+
+} // namespace android
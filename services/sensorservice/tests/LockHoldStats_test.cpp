@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "LockHoldStats.h"
+
+namespace android {
+namespace SensorServiceUtil {
+namespace {
+
+using Operation = LockHoldStats::Operation;
+
+TEST(LockHoldStatsTest, dumpsNothingWithoutSamples) {
+    LockHoldStats stats;
+    EXPECT_EQ("", stats.dump());
+}
+
+TEST(LockHoldStatsTest, bucketsAreExclusiveOfTheirLimit) {
+    LockHoldStats stats;
+    stats.record(Operation::THREAD_LOOP, us2ns(100) - 1);
+    stats.record(Operation::THREAD_LOOP, us2ns(100));
+    stats.record(Operation::THREAD_LOOP, ms2ns(1) - 1);
+    stats.record(Operation::THREAD_LOOP, ms2ns(1));
+    stats.record(Operation::THREAD_LOOP, ms2ns(10) - 1);
+    stats.record(Operation::THREAD_LOOP, ms2ns(10));
+
+    // (99999 + 100000 + 999999 + 1000000 + 9999999 + 10000000) / 6 = 3699999ns
+    EXPECT_EQ("\tthreadLoop: count=6, avg=3699us, max=10000us, <100us=1, <1ms=2, <10ms=2, "
+              ">=10ms=1\n",
+              stats.dump());
+}
+
+TEST(LockHoldStatsTest, dumpsEachOperationWithSamplesInOrder) {
+    LockHoldStats stats;
+    stats.record(Operation::FLUSH, us2ns(50));
+    stats.record(Operation::ENABLE, ms2ns(20));
+    stats.record(Operation::ENABLE, ms2ns(40));
+
+    EXPECT_EQ("\tenable: count=2, avg=30000us, max=40000us, <100us=0, <1ms=0, <10ms=0, "
+              ">=10ms=2\n"
+              "\tflush: count=1, avg=50us, max=50us, <100us=1, <1ms=0, <10ms=0, >=10ms=0\n",
+              stats.dump());
+}
+
+} // namespace
+} // namespace SensorServiceUtil
+} // namespace android
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "SensorEventBatch.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace android {
+namespace {
+
+constexpr int32_t ACCELEROMETER_HANDLE = 1;
+constexpr int32_t GYROSCOPE_HANDLE = 2;
+constexpr int32_t MAGNETOMETER_HANDLE = 3;
+constexpr size_t BATCH_SIZE = 64;
+
+// A batch from a 400Hz IMU, with the occasional magnetometer event.
+std::vector<sensors_event_t> createBatch() {
+    std::vector<sensors_event_t> events(BATCH_SIZE);
+    for (size_t i = 0; i < events.size(); i++) {
+        events[i].version = sizeof(sensors_event_t);
+        events[i].type = SENSOR_TYPE_ACCELEROMETER;
+        events[i].sensor = i % 2 == 0 ? ACCELEROMETER_HANDLE : GYROSCOPE_HANDLE;
+        events[i].timestamp = i * 1250000;
+    }
+    events[BATCH_SIZE / 2].sensor = MAGNETOMETER_HANDLE;
+    return events;
+}
+
+// Most clients listen to the whole IMU, some to the accelerometer only.
+std::vector<std::unordered_set<int32_t>> createClients(size_t count) {
+    std::vector<std::unordered_set<int32_t>> clients;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 4 == 3) {
+            clients.push_back({ACCELEROMETER_HANDLE});
+        } else {
+            clients.push_back({ACCELEROMETER_HANDLE, GYROSCOPE_HANDLE, MAGNETOMETER_HANDLE});
+        }
+    }
+    return clients;
+}
+
+// Each client goes through the whole batch and copies its events to the scratch buffer, which is
+// how batches were sent before they were indexed.
+void BM_fanOutByScanning(benchmark::State& state) {
+    const std::vector<sensors_event_t> events = createBatch();
+    const std::vector<std::unordered_set<int32_t>> clients = createClients(state.range(0));
+    std::vector<sensors_event_t> scratch(events.size());
+    size_t copied = 0;
+    for (auto _ : state) {
+        for (const std::unordered_set<int32_t>& handles : clients) {
+            size_t count = 0;
+            for (const sensors_event_t& event : events) {
+                if (handles.count(event.sensor) != 0) {
+                    scratch[count++] = event;
+                }
+            }
+            copied += count;
+            benchmark::DoNotOptimize(scratch.data());
+        }
+    }
+    state.counters["copiedEventsPerBatch"] =
+            benchmark::Counter(copied, benchmark::Counter::kAvgIterations);
+}
+
+// The sensors of the batch are worked out once, and each client only looks up those. Clients whose
+// events are a contiguous range of the batch are sent the batch itself.
+void BM_fanOutByIndex(benchmark::State& state) {
+    const std::vector<sensors_event_t> events = createBatch();
+    const std::vector<std::unordered_set<int32_t>> clients = createClients(state.range(0));
+    std::vector<sensors_event_t> scratch(events.size());
+    std::vector<bool> registered;
+    std::vector<uint32_t> indices;
+    SensorEventBatch batch;
+    size_t copied = 0;
+    for (auto _ : state) {
+        batch.reset(events.data(), events.size());
+        for (const std::unordered_set<int32_t>& handles : clients) {
+            const std::vector<int32_t>& sensorHandles = batch.getSensorHandles();
+            registered.assign(sensorHandles.size(), false);
+            for (size_t i = 0; i < sensorHandles.size(); i++) {
+                registered[i] = handles.count(sensorHandles[i]) != 0;
+            }
+            indices.clear();
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (registered[batch.getSensorIndex(i)]) {
+                    indices.push_back(i);
+                }
+            }
+            const sensors_event_t* sent = scratch.data();
+            if (!indices.empty() && indices.back() - indices.front() + 1 == indices.size()) {
+                sent = batch.getEvents() + indices.front();
+            } else {
+                for (size_t i = 0; i < indices.size(); i++) {
+                    scratch[i] = batch.getEvents()[indices[i]];
+                }
+                copied += indices.size();
+            }
+            benchmark::DoNotOptimize(sent);
+        }
+    }
+    state.counters["copiedEventsPerBatch"] =
+            benchmark::Counter(copied, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_fanOutByScanning)->ArgName("clients")->Arg(1)->Arg(8)->Arg(32)->Arg(64);
+BENCHMARK(BM_fanOutByIndex)->ArgName("clients")->Arg(1)->Arg(8)->Arg(32)->Arg(64);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -268,6 +268,12 @@ public:
     // asynchronously, in which case the returned future must be waited upon.
     virtual ftl::Future<std::monostate> present(const CompositionRefreshArgs&) = 0;
 
+    // Runs the steps of `present` up to presenting the frame: updating the
+    // composition state, choosing the composition strategy and client
+    // composition. The next call to `present` then only presents the frame.
+    // This may be called from another thread, concurrently with other outputs.
+    virtual void composeFrame(const CompositionRefreshArgs&) = 0;
+
     // Whether this output can be presented from another thread.
     virtual bool supportsOffloadPresent() const = 0;
 
@@ -18,8 +18,13 @@
 
 #include <compositionengine/CompositionEngine.h>
 
+#include <memory>
+#include <vector>
+
 namespace android::compositionengine::impl {
 
+class HwcAsyncWorker;
+
 class CompositionEngine : public compositionengine::CompositionEngine {
 public:
     CompositionEngine();
@@ -57,11 +62,16 @@ public:
     void setNeedsAnotherUpdateForTest(bool);
 
 private:
+    // Composes the outputs which support it in parallel, ahead of presenting.
+    void composeOutputs(CompositionRefreshArgs&);
+
     std::unique_ptr<HWComposer> mHwComposer;
-    renderengine::RenderEngine* mRenderEngine;
+    renderengine::RenderEngine* mRenderEngine = nullptr;
     std::shared_ptr<TimeStats> mTimeStats;
     bool mNeedsAnotherUpdate = false;
     nsecs_t mRefreshStartTime = 0;
+    // Used by composeOutputs, one fewer than the outputs composed at once.
+    std::vector<std::unique_ptr<HwcAsyncWorker>> mCompositionWorkers;
 };
 
 std::unique_ptr<compositionengine::CompositionEngine> createCompositionEngine();
@@ -81,6 +81,7 @@ public:
 
     void prepare(const CompositionRefreshArgs&, LayerFESet&) override;
     ftl::Future<std::monostate> present(const CompositionRefreshArgs&) override;
+    void composeFrame(const CompositionRefreshArgs&) override;
     bool supportsOffloadPresent() const override { return false; }
     void offloadPresentNextFrame() override;
 
@@ -185,6 +186,8 @@ private:
 
     bool mPredictCompositionStrategy = false;
     bool mOffloadPresent = false;
+    // Whether composeFrame has run ahead of the next present.
+    bool mFrameComposed = false;
 
     // Whether the content must be recomposed this frame.
     bool mMustRecompose = false;
@@ -74,6 +74,10 @@ public:
         return mTexture ? mTexture->get() : nullptr;
     }
     const sp<Fence>& getDrawFence() const { return mDrawFence; }
+    // End-to-end latency of drawing this set, from the request to RenderEngine until the draw
+    // fence signaled. This includes any time the draw spent queued before the GPU ran it, so it
+    // is not the GPU time alone. Not known until the fence has signaled.
+    std::optional<std::chrono::nanoseconds> getRenderLatency() const;
     const ProjectionSpace& getOutputSpace() const { return mOutputSpace; }
     ui::Dataspace getOutputDataspace() const { return mOutputDataspace; }
     const std::vector<Layer>& getConstituentLayers() const { return mLayers; }
@@ -98,6 +102,7 @@ public:
         mTexture.reset();
         mOutputDataspace = ui::Dataspace::UNKNOWN;
         mDrawFence = nullptr;
+        mRenderRequestTime = 0;
         mBlurLayer = nullptr;
         mHolePunchLayer = nullptr;
         mSkipCount = 0;
@@ -169,6 +174,7 @@ private:
     // containers in the Flattener. Logically this should have unique ownership otherwise.
     std::shared_ptr<TexturePool::AutoTexture> mTexture;
     sp<Fence> mDrawFence;
+    nsecs_t mRenderRequestTime = 0;
     ProjectionSpace mOutputSpace;
     ui::Dataspace mOutputDataspace;
     ui::Transform::RotationFlags mOrientation = ui::Transform::ROT_0;
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <compositionengine/impl/planner/CachedSet.h>
+#include <ftl/flags.h>
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <string>
+
+namespace android::compositionengine::impl::planner {
+
+// Predicts how long it takes for a CachedSet to be drawn, and how much the display saves by
+// reading it instead of its layers.
+//
+// The draw cost of a layer is its area times a cost per pixel, which depends on the properties of
+// the layer that make it more or less expensive to draw. Each combination of properties starts
+// from a default cost per pixel, which is then learned from the CachedSets that get rendered.
+//
+// What is learned is the end-to-end latency of a draw: from the request to RenderEngine until its
+// draw fence signals. Besides the GPU work itself, this includes the time spent queued in
+// RenderEngine and behind other GPU work, since RenderEngine doesn't report the GPU time alone.
+class CostModel {
+public:
+    // Properties of a layer which affect how expensive it is to draw.
+    enum class Property : uint32_t {
+        Buffer = 1u << 0,
+        Blending = 1u << 1,
+        RoundedCorners = 1u << 2,
+        BlurBehind = 1u << 3,
+    };
+    using Properties = ftl::Flags<Property>;
+
+    // Costs are fractional nanoseconds, since a pixel costs much less than one.
+    using Duration = std::chrono::duration<double, std::nano>;
+
+    static constexpr size_t kNumPropertyCombinations = 1u << 4;
+
+    // The cost of a combination is the average of its samples, up to this many. After that, it is a
+    // moving average in which each new sample has 1/kMaxAveragedSamples of the weight, so that it
+    // keeps adapting to e.g. GPU frequency changes.
+    static constexpr size_t kMaxAveragedSamples = 10;
+
+    // Cost of the display reading a pixel of a layer, in the same units as the draw costs. Scanning
+    // out is cheaper than drawing, but it is paid on every frame.
+    static constexpr double kDisplayCostPerPixel = 0.05;
+
+    // Default cost per frame of HWC composing one more layer, e.g. setting up and validating one
+    // more plane, or falling back to the GPU when it runs out of planes. Flattening a run of layers
+    // saves this for all but one of them, even when they don't overlap.
+    //
+    // Unlike the draw costs, this is not learned: HWC reports no per-layer timing, and the time
+    // spent in validate and present varies with whatever else changed in the frame far more than
+    // with one layer. The default is a rough estimate rather than a measurement, so devices whose
+    // HWC is much cheaper or more expensive per layer should set
+    // debug.sf.flattener_hwc_cost_per_layer_ns.
+    static constexpr Duration kDefaultHwcCostPerLayer = std::chrono::microseconds(10);
+
+    explicit CostModel(Duration hwcCostPerLayer = kDefaultHwcCostPerLayer);
+
+    static Properties getProperties(const CachedSet::Layer&);
+
+    Duration getHwcCostPerLayer() const { return mHwcCostPerLayer; }
+
+    // Predicted latency of drawing the layers of the given CachedSets into a single buffer.
+    Duration predictRenderLatency(std::span<const CachedSet>) const;
+    Duration predictRenderLatency(const CachedSet& cachedSet) const {
+        return predictRenderLatency(std::span(&cachedSet, 1));
+    }
+
+    // Predicted cost per frame of HWC composing and the display reading the layers of the given
+    // CachedSets, rather than a single buffer spanning their bounds. Negative if the layers cover
+    // much less than the bounds.
+    Duration predictDisplaySavings(std::span<const CachedSet>) const;
+    Duration predictDisplaySavings(const CachedSet& cachedSet) const {
+        return predictDisplaySavings(std::span(&cachedSet, 1));
+    }
+
+    // Learns from the latency of drawing the given CachedSet, see CachedSet::getRenderLatency.
+    void recordRenderLatency(const CachedSet&, std::chrono::nanoseconds latency);
+
+    void dump(std::string& result) const;
+
+private:
+    struct Entry {
+        // Nanoseconds of draw latency per pixel.
+        double costPerPixel;
+        size_t sampleCount = 0;
+    };
+
+    static size_t getArea(const CachedSet::Layer&);
+
+    const Duration mHwcCostPerLayer;
+    std::array<Entry, kNumPropertyCombinations> mEntries;
+};
+
+} // namespace android::compositionengine::impl::planner
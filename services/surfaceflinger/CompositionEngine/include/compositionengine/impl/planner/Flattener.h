@@ -18,10 +18,12 @@
 
 #include <compositionengine/Output.h>
 #include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/CostModel.h>
 #include <compositionengine/impl/planner/LayerState.h>
 
 #include <chrono>
 #include <numeric>
+#include <span>
 #include <vector>
 
 namespace android {
@@ -85,6 +87,12 @@ public:
 
         // True if the hole punching feature should be enabled.
         const bool mEnableHolePunch;
+
+        // Cost per frame of HWC composing one more layer, which flattening saves.
+        // See: CostModel::kDefaultHwcCostPerLayer
+        const std::chrono::nanoseconds mHwcCostPerLayer =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        CostModel::kDefaultHwcCostPerLayer);
     };
 
     // Constants not yet backed by a sysprop
@@ -93,6 +101,9 @@ public:
     static constexpr int kNumLayersFpsConsideration = 1;
     // Frames/Second threshold below which these CachedSets may be considered inactive.
     static constexpr float kFpsActiveThreshold = 1.f;
+    // Number of frames a CachedSet is expected to be used for, until enough have been invalidated
+    // to know how long they actually last.
+    static constexpr double kDefaultCachedSetLifetime = 60.0;
 
     Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables);
 
@@ -188,7 +199,7 @@ private:
                     }
                 }
 
-                return Run(mStart,
+                return Run(mStart, static_cast<size_t>(mNumSets),
                            std::reduce(mStart, mStart + mNumSets, 0u,
                                        [](size_t length, const CachedSet& set) {
                                            return length + set.getLayerCount();
@@ -202,20 +213,35 @@ private:
         // Gets the starting CachedSet of this run.
         // This is an iterator into mLayers
         const std::vector<CachedSet>::const_iterator& getStart() const { return mStart; }
+        // Gets the CachedSets of this Run.
+        std::span<const CachedSet> getSets() const { return std::span(mStart, mNumSets); }
         // Gets the total number of layers encompassing this Run.
         size_t getLayerLength() const { return mLength; }
         // Gets the hole punch candidate for this Run.
         const CachedSet* getHolePunchCandidate() const { return mHolePunchCandidate; }
         const CachedSet* getBlurringLayer() const { return mBlurringLayer; }
 
+        // Merges the CachedSets of this run into a single CachedSet, yet to be rendered.
+        CachedSet merge() const {
+            CachedSet merged(*mStart);
+            auto currentSet = mStart;
+            while (merged.getLayerCount() < mLength) {
+                ++currentSet;
+                merged.append(*currentSet);
+            }
+            return merged;
+        }
+
     private:
-        Run(std::vector<CachedSet>::const_iterator start, size_t length,
+        Run(std::vector<CachedSet>::const_iterator start, size_t numSets, size_t length,
             const CachedSet* holePunchCandidate, const CachedSet* blurringLayer)
               : mStart(start),
+                mNumSets(numSets),
                 mLength(length),
                 mHolePunchCandidate(holePunchCandidate),
                 mBlurringLayer(blurringLayer) {}
         const std::vector<CachedSet>::const_iterator mStart;
+        const size_t mNumSets;
         const size_t mLength;
         const CachedSet* const mHolePunchCandidate;
         const CachedSet* const mBlurringLayer;
@@ -227,6 +253,9 @@ private:
 
     std::optional<Run> findBestRun(std::vector<Run>& runs) const;
 
+    // Average number of frames that CachedSets were used for before being invalidated.
+    double getAverageCachedSetLifetime() const;
+
     void buildCachedSets(std::chrono::steady_clock::time_point now);
 
     renderengine::RenderEngine& mRenderEngine;
@@ -234,6 +263,8 @@ private:
 
     TexturePool mTexturePool;
 
+    CostModel mCostModel;
+
 protected:
     // mNewCachedSet must be destroyed before mTexturePool is.
     std::optional<CachedSet> mNewCachedSet;
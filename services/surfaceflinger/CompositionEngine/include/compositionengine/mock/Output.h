@@ -82,6 +82,7 @@ public:
     MOCK_METHOD2(prepare, void(const compositionengine::CompositionRefreshArgs&, LayerFESet&));
     MOCK_METHOD1(present,
                  ftl::Future<std::monostate>(const compositionengine::CompositionRefreshArgs&));
+    MOCK_METHOD(void, composeFrame, (const compositionengine::CompositionRefreshArgs&));
     MOCK_CONST_METHOD0(supportsOffloadPresent, bool());
     MOCK_METHOD(void, offloadPresentNextFrame, ());
 
@@ -20,11 +20,14 @@
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/impl/CompositionEngine.h>
 #include <compositionengine/impl/Display.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
 #include <ui/DisplayMap.h>
 
 #include <renderengine/RenderEngine.h>
 #include <utils/Trace.h>
 
+#include <unordered_set>
+
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -90,12 +93,11 @@ nsecs_t CompositionEngine::getLastFrameRefreshTimestamp() const {
 }
 
 namespace {
-void offloadOutputs(Outputs& outputs) {
-    if (!FlagManager::getInstance().multithreaded_present() || outputs.size() < 2) {
-        return;
-    }
-
-    ui::PhysicalDisplayVector<compositionengine::Output*> outputsToOffload;
+// Returns the enabled HWC-enabled outputs, in order, if all of them can be
+// presented from another thread. Otherwise returns none.
+ui::PhysicalDisplayVector<compositionengine::Output*> getMultithreadedOutputs(
+        const Outputs& outputs) {
+    ui::PhysicalDisplayVector<compositionengine::Output*> multithreadedOutputs;
     for (const auto& output : outputs) {
         if (!ftl::Optional(output->getDisplayId()).and_then(HalDisplayId::tryCast)) {
             // Not HWC-enabled, so it is always client-composited. No need to offload.
@@ -108,11 +110,19 @@ void offloadOutputs(Outputs& outputs) {
         // Only run present in multiple threads if all HWC-enabled displays
         // being refreshed support it.
         if (!output->supportsOffloadPresent()) {
-            return;
+            return {};
         }
-        outputsToOffload.push_back(output.get());
+        multithreadedOutputs.push_back(output.get());
+    }
+    return multithreadedOutputs;
+}
+
+void offloadOutputs(Outputs& outputs) {
+    if (!FlagManager::getInstance().multithreaded_present() || outputs.size() < 2) {
+        return;
     }
 
+    auto outputsToOffload = getMultithreadedOutputs(outputs);
     if (outputsToOffload.size() < 2) {
         return;
     }
@@ -125,8 +135,60 @@ void offloadOutputs(Outputs& outputs) {
         output->offloadPresentNextFrame();
     }
 }
+
+// Outputs may only be composed concurrently if none of their layers are shared,
+// since composition records its results in the LayerFE.
+bool haveDisjointLayers(const ui::PhysicalDisplayVector<compositionengine::Output*>& outputs) {
+    std::unordered_set<const compositionengine::LayerFE*> layers;
+    for (const compositionengine::Output* output : outputs) {
+        for (const auto* outputLayer : output->getOutputLayersOrderedByZ()) {
+            if (!layers.insert(&outputLayer->getLayerFE()).second) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 } // namespace
 
+void CompositionEngine::composeOutputs(CompositionRefreshArgs& args) {
+    if (!FlagManager::getInstance().multithreaded_composition() || args.outputs.size() < 2) {
+        return;
+    }
+
+    // Client composition for several outputs at once relies on RenderEngine
+    // serializing the draws on its own thread.
+    if (!mRenderEngine || !mRenderEngine->getRenderEngineTid()) {
+        return;
+    }
+
+    const auto outputsToCompose = getMultithreadedOutputs(args.outputs);
+    if (outputsToCompose.size() < 2 || !haveDisjointLayers(outputsToCompose)) {
+        return;
+    }
+
+    while (mCompositionWorkers.size() < outputsToCompose.size() - 1) {
+        mCompositionWorkers.push_back(std::make_unique<HwcAsyncWorker>());
+    }
+
+    ui::PhysicalDisplayVector<std::future<bool>> composeFutures;
+    for (size_t i = 0; i < outputsToCompose.size() - 1; i++) {
+        composeFutures.push_back(
+                mCompositionWorkers[i]->send([&args, output = outputsToCompose[i]]() {
+                    output->composeFrame(args);
+                    return true;
+                }));
+    }
+
+    // As with offloading, the last output stays on the main thread.
+    outputsToCompose.back()->composeFrame(args);
+
+    ATRACE_NAME("Waiting on composition");
+    for (auto& future : composeFutures) {
+        future.get();
+    }
+}
+
 void CompositionEngine::present(CompositionRefreshArgs& args) {
     ATRACE_CALL();
     ALOGV(__FUNCTION__);
@@ -149,6 +211,10 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
     // be slow.
     offloadOutputs(args.outputs);
 
+    // Composing the HWC displays in parallel leaves only presenting them to
+    // the loop below, which keeps the order in which displays are presented.
+    composeOutputs(args);
+
     ui::DisplayVector<ftl::Future<std::monostate>> presentFutures;
     for (const auto& output : args.outputs) {
         presentFutures.push_back(output->present(args));
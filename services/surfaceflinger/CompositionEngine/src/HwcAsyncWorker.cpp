@@ -60,7 +60,8 @@ void HwcAsyncWorker::run() {
     std::unique_lock<std::mutex> lock(mMutex);
     android::base::ScopedLockAssertion assumeLock(mMutex);
     while (!mDone) {
-        mCv.wait(lock);
+        // A task may have been sent before this thread first waits.
+        mCv.wait(lock, [this]() REQUIRES(mMutex) { return mDone || mTaskRequested; });
         if (mTaskRequested && mTask.valid()) {
             mTask();
             mTaskRequested = false;
@@ -433,23 +433,11 @@ ftl::Future<std::monostate> Output::present(
     ATRACE_FORMAT("%s for %s", __func__, mNamePlusId.c_str());
     ALOGV(__FUNCTION__);
 
-    updateColorProfile(refreshArgs);
-    updateCompositionState(refreshArgs);
-    planComposition();
-    writeCompositionState(refreshArgs);
-    setColorTransform(refreshArgs);
-    beginFrame();
-
-    GpuCompositionResult result;
-    const bool predictCompositionStrategy = canPredictCompositionStrategy(refreshArgs);
-    if (predictCompositionStrategy) {
-        result = prepareFrameAsync();
-    } else {
-        prepareFrame();
+    if (!mFrameComposed) {
+        composeFrame(refreshArgs);
     }
+    mFrameComposed = false;
 
-    devOptRepaintFlash(refreshArgs);
-    finishFrame(std::move(result));
     ftl::Future<std::monostate> future;
     if (mOffloadPresent) {
         future = presentFrameAndReleaseLayersAsync();
@@ -467,6 +455,30 @@ ftl::Future<std::monostate> Output::present(
     return future;
 }
 
+void Output::composeFrame(const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    ATRACE_FORMAT("%s for %s", __func__, mNamePlusId.c_str());
+    ALOGV(__FUNCTION__);
+
+    updateColorProfile(refreshArgs);
+    updateCompositionState(refreshArgs);
+    planComposition();
+    writeCompositionState(refreshArgs);
+    setColorTransform(refreshArgs);
+    beginFrame();
+
+    GpuCompositionResult result;
+    const bool predictCompositionStrategy = canPredictCompositionStrategy(refreshArgs);
+    if (predictCompositionStrategy) {
+        result = prepareFrameAsync();
+    } else {
+        prepareFrame();
+    }
+
+    devOptRepaintFlash(refreshArgs);
+    finishFrame(std::move(result));
+    mFrameComposed = true;
+}
+
 void Output::offloadPresentNextFrame() {
     mOffloadPresent = true;
     updateHwcAsyncWorker();
@@ -139,6 +139,19 @@ bool CachedSet::hasReadyBuffer() const {
     return mTexture && mDrawFence->getStatus() == Fence::Status::Signaled;
 }
 
+std::optional<std::chrono::nanoseconds> CachedSet::getRenderLatency() const {
+    if (!mDrawFence || mRenderRequestTime == 0) {
+        return std::nullopt;
+    }
+
+    const nsecs_t signalTime = mDrawFence->getSignalTime();
+    if (signalTime == Fence::SIGNAL_TIME_INVALID || signalTime == Fence::SIGNAL_TIME_PENDING ||
+        signalTime < mRenderRequestTime) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(signalTime - mRenderRequestTime);
+}
+
 std::vector<CachedSet> CachedSet::decompose() const {
     std::vector<CachedSet> layers;
 
@@ -275,6 +288,7 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         bufferFence.reset(texture->getReadyFence()->dup());
     }
 
+    const nsecs_t renderRequestTime = systemTime();
     auto fenceResult = renderEngine
                                .drawLayers(displaySettings, layerSettings, texture->get(),
                                            std::move(bufferFence))
@@ -282,6 +296,7 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
 
     if (fenceStatus(fenceResult) == NO_ERROR) {
         mDrawFence = std::move(fenceResult).value_or(Fence::NO_FENCE);
+        mRenderRequestTime = renderRequestTime;
         mOutputSpace = outputState.framebufferSpace;
         mTexture = texture;
         mTexture->setReadyFence(mDrawFence);
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "Planner"
+// #define LOG_NDEBUG 0
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/LayerFECompositionState.h>
+#include <compositionengine/impl/planner/CostModel.h>
+
+#include <algorithm>
+
+namespace android::compositionengine::impl::planner {
+
+namespace {
+
+// Default costs, in nanoseconds per pixel, for a GPU which draws an opaque full-screen 1080p
+// buffer in about 1ms. They are only used until a combination of properties has been measured.
+constexpr double kDefaultSolidColorCostPerPixel = 0.2;
+constexpr double kDefaultBufferCostPerPixel = 0.4;
+constexpr double kDefaultBlendingCostFactor = 1.5;
+constexpr double kDefaultRoundedCornersCostFactor = 1.25;
+constexpr double kDefaultBlurBehindCostFactor = 4.0;
+
+} // namespace
+
+CostModel::CostModel(Duration hwcCostPerLayer) : mHwcCostPerLayer(hwcCostPerLayer) {
+    for (size_t i = 0; i < mEntries.size(); i++) {
+        const Properties properties(static_cast<uint32_t>(i));
+        double costPerPixel = properties.test(Property::Buffer) ? kDefaultBufferCostPerPixel
+                                                                : kDefaultSolidColorCostPerPixel;
+        if (properties.test(Property::Blending)) {
+            costPerPixel *= kDefaultBlendingCostFactor;
+        }
+        if (properties.test(Property::RoundedCorners)) {
+            costPerPixel *= kDefaultRoundedCornersCostFactor;
+        }
+        if (properties.test(Property::BlurBehind)) {
+            costPerPixel *= kDefaultBlurBehindCostFactor;
+        }
+        mEntries[i] = {.costPerPixel = costPerPixel};
+    }
+}
+
+CostModel::Properties CostModel::getProperties(const CachedSet::Layer& layer) {
+    Properties properties;
+    if (layer.getBuffer()) {
+        properties |= Property::Buffer;
+    }
+
+    const auto& layerFE = layer.getState()->getOutputLayer()->getLayerFE();
+    if (layerFE.getCompositionState()->blendMode != hal::BlendMode::NONE) {
+        properties |= Property::Blending;
+    }
+    if (layerFE.hasRoundedCorners()) {
+        properties |= Property::RoundedCorners;
+    }
+    if (layer.getState()->hasBlurBehind()) {
+        properties |= Property::BlurBehind;
+    }
+    return properties;
+}
+
+size_t CostModel::getArea(const CachedSet::Layer& layer) {
+    const Rect displayFrame = layer.getDisplayFrame();
+    if (displayFrame.isEmpty()) {
+        return 0;
+    }
+    return static_cast<size_t>(displayFrame.width()) * static_cast<size_t>(displayFrame.height());
+}
+
+CostModel::Duration CostModel::predictRenderLatency(std::span<const CachedSet> cachedSets) const {
+    Duration duration{0};
+    for (const CachedSet& cachedSet : cachedSets) {
+        for (const CachedSet::Layer& layer : cachedSet.getConstituentLayers()) {
+            duration += Duration(mEntries[getProperties(layer).get()].costPerPixel *
+                                 static_cast<double>(getArea(layer)));
+        }
+    }
+    return duration;
+}
+
+CostModel::Duration CostModel::predictDisplaySavings(std::span<const CachedSet> cachedSets) const {
+    // The same as merging the CachedSets and asking the result, without copying their layers.
+    size_t layersArea = 0;
+    size_t layerCount = 0;
+    Rect bounds = Rect::EMPTY_RECT;
+    for (const CachedSet& cachedSet : cachedSets) {
+        layersArea += cachedSet.getComponentDisplayCost();
+        layerCount += cachedSet.getLayerCount();
+
+        const Rect& setBounds = cachedSet.getBounds();
+        if (setBounds.isEmpty()) {
+            continue;
+        }
+        if (bounds.isEmpty()) {
+            bounds = setBounds;
+        } else {
+            bounds.left = std::min(bounds.left, setBounds.left);
+            bounds.top = std::min(bounds.top, setBounds.top);
+            bounds.right = std::max(bounds.right, setBounds.right);
+            bounds.bottom = std::max(bounds.bottom, setBounds.bottom);
+        }
+    }
+
+    const double bufferArea = bounds.isEmpty()
+            ? 0.0
+            : static_cast<double>(bounds.width()) * static_cast<double>(bounds.height());
+    const double mergedLayers = static_cast<double>(layerCount) - 1;
+    return Duration(kDisplayCostPerPixel * (static_cast<double>(layersArea) - bufferArea)) +
+            mHwcCostPerLayer * std::max(mergedLayers, 0.0);
+}
+
+void CostModel::recordRenderLatency(const CachedSet& cachedSet,
+                                    std::chrono::nanoseconds latency) {
+    // A single draw covers all of the layers, so split its latency between them in proportion
+    // to what each was predicted to cost.
+    std::array<double, kNumPropertyCombinations> areas{};
+    std::array<double, kNumPropertyCombinations> predicted{};
+    double totalPredicted = 0;
+    for (const CachedSet::Layer& layer : cachedSet.getConstituentLayers()) {
+        const uint32_t index = getProperties(layer).get();
+        const double area = static_cast<double>(getArea(layer));
+        areas[index] += area;
+        predicted[index] += mEntries[index].costPerPixel * area;
+        totalPredicted += mEntries[index].costPerPixel * area;
+    }
+
+    if (totalPredicted <= 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < mEntries.size(); i++) {
+        if (areas[i] <= 0) {
+            continue;
+        }
+
+        Entry& entry = mEntries[i];
+        const double measured =
+                static_cast<double>(latency.count()) * predicted[i] / totalPredicted / areas[i];
+        entry.sampleCount++;
+        const double weight = 1.0 / static_cast<double>(std::min(entry.sampleCount,
+                                                                 kMaxAveragedSamples));
+        entry.costPerPixel += weight * (measured - entry.costPerPixel);
+    }
+}
+
+void CostModel::dump(std::string& result) const {
+    base::StringAppendF(&result, "CostModel, HWC cost per layer: %.0f ns\n",
+                        mHwcCostPerLayer.count());
+    result.append("CostModel, in ns of draw latency per megapixel:\n");
+    for (size_t i = 0; i < mEntries.size(); i++) {
+        const Properties properties(static_cast<uint32_t>(i));
+        base::StringAppendF(&result, "  %-45s %8.0f (%zu samples)\n",
+                            i == 0 ? "None" : properties.string().c_str(),
+                            mEntries[i].costPerPixel * 1e6, mEntries[i].sampleCount);
+    }
+}
+
+} // namespace android::compositionengine::impl::planner
@@ -73,7 +73,10 @@ bool isSameStack(const std::vector<const LayerState*>& incomingLayers,
 } // namespace
 
 Flattener::Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables)
-      : mRenderEngine(renderEngine), mTunables(tunables), mTexturePool(mRenderEngine) {}
+      : mRenderEngine(renderEngine),
+        mTunables(tunables),
+        mTexturePool(mRenderEngine),
+        mCostModel(tunables.mHwcCostPerLayer) {}
 
 NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& layers,
                                        NonBufferHash hash, time_point now) {
@@ -210,6 +213,12 @@ void Flattener::dump(std::string& result) const {
 
     base::StringAppendF(&result, "\n");
     mTexturePool.dump(result);
+
+    base::StringAppendF(&result, "\n");
+    mCostModel.dump(result);
+    base::StringAppendF(&result, "  Average cached set lifetime: %.1f frames (%s)\n",
+                        getAverageCachedSetLifetime(),
+                        FlagManager::getInstance().flattener_cost_model() ? "used" : "not used");
 }
 
 size_t Flattener::calculateDisplayCost(const std::vector<const LayerState*>& layers) const {
@@ -347,6 +356,9 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
 
                     skipCount -= layerCount;
                 }
+                if (const auto renderLatency = mNewCachedSet->getRenderLatency()) {
+                    mCostModel.recordRenderLatency(*mNewCachedSet, *renderLatency);
+                }
                 priorBlurLayer = mNewCachedSet->getBlurLayer();
                 merged.emplace_back(std::move(*mNewCachedSet));
                 mNewCachedSet = std::nullopt;
@@ -489,8 +501,57 @@ std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>
         return std::nullopt;
     }
 
-    // TODO (b/181192467): Choose the best run, instead of just the first.
-    return runs[0];
+    if (!FlagManager::getInstance().flattener_cost_model()) {
+        // TODO (b/181192467): Choose the best run, instead of just the first.
+        return runs[0];
+    }
+
+    // Flattening a run costs one GPU draw, and then saves HWC from composing all but one of its
+    // layers, and the display from reading the layers which overlap, on each frame the new
+    // CachedSet is used.
+    const double lifetime = getAverageCachedSetLifetime();
+    std::optional<Run> bestRun;
+    CostModel::Duration bestBenefit{0};
+    for (const Run& run : runs) {
+        // Predict from the run's CachedSets directly, since merging copies all of their layers, and
+        // only the best run is merged.
+        const CostModel::Duration benefit =
+                mCostModel.predictDisplaySavings(run.getSets()) * lifetime -
+                mCostModel.predictRenderLatency(run.getSets());
+
+        // A hole punch lets the display compose the layer in front of the run, which the model
+        // doesn't account for, so it is worth the draw.
+        const bool requiresHolePunch =
+                run.getHolePunchCandidate() && run.getHolePunchCandidate()->requiresHolePunch();
+        if (benefit <= CostModel::Duration::zero() && !requiresHolePunch) {
+            continue;
+        }
+
+        if (!bestRun || benefit > bestBenefit) {
+            bestRun.emplace(run);
+            bestBenefit = benefit;
+        }
+    }
+
+    if (bestRun) {
+        ATRACE_FORMAT("Best run: %zu layers, predicted benefit %.0f ns",
+                      bestRun->getLayerLength(), bestBenefit.count());
+    }
+    return bestRun;
+}
+
+double Flattener::getAverageCachedSetLifetime() const {
+    size_t totalAge = 0;
+    size_t count = 0;
+    for (const auto& [age, ageCount] : mInvalidatedCachedSetAges) {
+        totalAge += age * ageCount;
+        count += ageCount;
+    }
+
+    if (count == 0) {
+        return kDefaultCachedSetLifetime;
+    }
+    return static_cast<double>(totalAge) / static_cast<double>(count);
 }
 
 void Flattener::buildCachedSets(time_point now) {
@@ -528,13 +589,8 @@ void Flattener::buildCachedSets(time_point now) {
         return;
     }
 
-    mNewCachedSet.emplace(*bestRun->getStart());
+    mNewCachedSet.emplace(bestRun->merge());
     mNewCachedSet->setLastUpdate(now);
-    auto currentSet = bestRun->getStart();
-    while (mNewCachedSet->getLayerCount() < bestRun->getLayerLength()) {
-        ++currentSet;
-        mNewCachedSet->append(*currentSet);
-    }
 
     if (bestRun->getBlurringLayer()) {
         mNewCachedSet->addBackgroundBlurLayer(*bestRun->getBlurringLayer());
@@ -61,10 +61,16 @@ Flattener::Tunables buildFlattenerTuneables() {
     const auto enableHolePunch =
             base::GetBoolProperty(std::string("debug.sf.enable_hole_punch_pip"),
                                   Flattener::Tunables::kDefaultEnableHolePunch);
+    const auto hwcCostPerLayer = std::chrono::nanoseconds(
+            base::GetUintProperty<uint64_t>(std::string("debug.sf.flattener_hwc_cost_per_layer_ns"),
+                                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    CostModel::kDefaultHwcCostPerLayer)
+                                                    .count()));
     return Flattener::Tunables{
             .mActiveLayerTimeout = activeLayerTimeout,
             .mRenderScheduling = buildRenderSchedulingTunables(),
             .mEnableHolePunch = enableHolePunch,
+            .mHwcCostPerLayer = hwcCostPerLayer,
     };
 }
 
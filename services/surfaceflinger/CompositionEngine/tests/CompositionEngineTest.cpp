@@ -29,6 +29,7 @@
 #include "MockHWComposer.h"
 #include "TimeStats/TimeStats.h"
 
+#include <thread>
 #include <variant>
 
 using namespace com::android::graphics::surfaceflinger;
@@ -483,5 +484,128 @@ TEST_F(CompositionEngineOffloadTest, disabledDisplaysDoNotPreventOthersFromOfflo
     mEngine.present(mRefreshArgs);
 }
 
+struct CompositionEngineComposeTest : public CompositionEngineOffloadTest {
+    StrictMock<renderengine::mock::RenderEngine> mRenderEngine;
+    StrictMock<mock::OutputLayer> mOutputLayer1;
+    StrictMock<mock::OutputLayer> mOutputLayer2;
+    sp<StrictMock<mock::LayerFE>> mLayerFE1 = sp<StrictMock<mock::LayerFE>>::make();
+    sp<StrictMock<mock::LayerFE>> mLayerFE2 = sp<StrictMock<mock::LayerFE>>::make();
+
+    void SetUp() override {
+        CompositionEngineOffloadTest::SetUp();
+
+        mEngine.setRenderEngine(&mRenderEngine);
+        EXPECT_CALL(mRenderEngine, getRenderEngineTid)
+                .WillRepeatedly(Return(std::make_optional<pid_t>(123)));
+
+        EXPECT_CALL(*mDisplay1, getOutputLayerCount).WillRepeatedly(Return(1u));
+        EXPECT_CALL(*mDisplay1, getOutputLayerOrderedByZByIndex(0))
+                .WillRepeatedly(Return(&mOutputLayer1));
+        EXPECT_CALL(*mDisplay2, getOutputLayerCount).WillRepeatedly(Return(1u));
+        EXPECT_CALL(*mDisplay2, getOutputLayerOrderedByZByIndex(0))
+                .WillRepeatedly(Return(&mOutputLayer2));
+        EXPECT_CALL(mOutputLayer1, getLayerFE).WillRepeatedly(ReturnRef(*mLayerFE1));
+        EXPECT_CALL(mOutputLayer2, getLayerFE).WillRepeatedly(ReturnRef(*mLayerFE2));
+    }
+};
+
+TEST_F(CompositionEngineComposeTest, basic) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+
+    // The last display is composed on the main thread, and the others on workers.
+    std::thread::id display1Thread;
+    std::thread::id display2Thread;
+    EXPECT_CALL(*mDisplay1, composeFrame(Ref(mRefreshArgs)))
+            .WillOnce([&](const CompositionRefreshArgs&) {
+                display1Thread = std::this_thread::get_id();
+            });
+    EXPECT_CALL(*mDisplay2, composeFrame(Ref(mRefreshArgs)))
+            .WillOnce([&](const CompositionRefreshArgs&) {
+                display2Thread = std::this_thread::get_id();
+            });
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, true);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+
+    EXPECT_NE(std::this_thread::get_id(), display1Thread);
+    EXPECT_EQ(std::this_thread::get_id(), display2Thread);
+}
+
+TEST_F(CompositionEngineComposeTest, dependsOnFlag) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).Times(0);
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).Times(0);
+
+    EXPECT_CALL(*mDisplay1, composeFrame).Times(0);
+    EXPECT_CALL(*mDisplay2, composeFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, false);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineComposeTest, dependsOnSupport) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(false));
+
+    EXPECT_CALL(*mDisplay1, composeFrame).Times(0);
+    EXPECT_CALL(*mDisplay2, composeFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, true);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineComposeTest, dependsOnThreadedRenderEngine) {
+    EXPECT_CALL(mRenderEngine, getRenderEngineTid).WillRepeatedly(Return(std::nullopt));
+
+    EXPECT_CALL(*mDisplay1, composeFrame).Times(0);
+    EXPECT_CALL(*mDisplay2, composeFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, true);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineComposeTest, dependsOnDisjointLayers) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(mOutputLayer2, getLayerFE).WillRepeatedly(ReturnRef(*mLayerFE1));
+
+    EXPECT_CALL(*mDisplay1, composeFrame).Times(0);
+    EXPECT_CALL(*mDisplay2, composeFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, true);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineComposeTest, virtualDisplay) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mVirtualDisplay, supportsOffloadPresent).Times(0);
+
+    EXPECT_CALL(*mDisplay1, composeFrame(Ref(mRefreshArgs))).Times(1);
+    EXPECT_CALL(*mDisplay2, composeFrame(Ref(mRefreshArgs))).Times(1);
+    EXPECT_CALL(*mVirtualDisplay, composeFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    SET_FLAG_FOR_TEST(flags::multithreaded_composition, true);
+    setOutputs({mVirtualDisplay, mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
 } // namespace
 } // namespace android::compositionengine
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/OutputCompositionState.h>
+#include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/CostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+#include <compositionengine/mock/LayerFE.h>
+#include <compositionengine/mock/OutputLayer.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+using namespace std::chrono_literals;
+
+using testing::Return;
+using testing::ReturnRef;
+
+using impl::planner::CachedSet;
+using impl::planner::CostModel;
+using impl::planner::LayerState;
+
+namespace {
+
+constexpr double kToleranceNs = 1.0;
+
+class CostModelTest : public testing::Test {
+public:
+    CostModelTest() = default;
+
+protected:
+    const std::chrono::steady_clock::time_point kStartTime = std::chrono::steady_clock::now();
+
+    struct TestLayer {
+        mock::OutputLayer outputLayer;
+        impl::OutputLayerCompositionState outputLayerCompositionState;
+        // LayerFE inherits from RefBase and must be held by an sp<>
+        sp<mock::LayerFE> layerFE;
+        LayerFECompositionState layerFECompositionState;
+
+        std::unique_ptr<LayerState> layerState;
+    };
+
+    // Adds an opaque layer drawing a buffer into the given frame.
+    TestLayer& addLayer(const Rect& displayFrame);
+
+    CachedSet makeCachedSet(std::initializer_list<const TestLayer*> layers) const;
+
+    std::vector<std::unique_ptr<TestLayer>> mTestLayers;
+    CostModel mCostModel;
+};
+
+CostModelTest::TestLayer& CostModelTest::addLayer(const Rect& displayFrame) {
+    auto testLayer = std::make_unique<TestLayer>();
+    testLayer->outputLayerCompositionState.displayFrame = displayFrame;
+    testLayer->outputLayerCompositionState.visibleRegion = Region(displayFrame);
+    testLayer->layerFECompositionState.blendMode = hal::BlendMode::NONE;
+    testLayer->layerFECompositionState.buffer =
+            sp<GraphicBuffer>::make(100u, 100u, HAL_PIXEL_FORMAT_RGBA_8888, 1u,
+                                    static_cast<uint64_t>(GRALLOC_USAGE_HW_TEXTURE), "layer");
+
+    testLayer->layerFE = sp<mock::LayerFE>::make();
+    EXPECT_CALL(*testLayer->layerFE, getSequence)
+            .WillRepeatedly(Return(static_cast<int32_t>(mTestLayers.size())));
+    EXPECT_CALL(*testLayer->layerFE, getDebugName).WillRepeatedly(Return("testLayer"));
+    EXPECT_CALL(*testLayer->layerFE, getCompositionState)
+            .WillRepeatedly(Return(&testLayer->layerFECompositionState));
+    EXPECT_CALL(*testLayer->layerFE, hasRoundedCorners).WillRepeatedly(Return(false));
+    EXPECT_CALL(testLayer->outputLayer, getLayerFE)
+            .WillRepeatedly(ReturnRef(*testLayer->layerFE));
+    EXPECT_CALL(testLayer->outputLayer, getState)
+            .WillRepeatedly(ReturnRef(testLayer->outputLayerCompositionState));
+
+    testLayer->layerState = std::make_unique<LayerState>(&testLayer->outputLayer);
+
+    mTestLayers.emplace_back(std::move(testLayer));
+    return *mTestLayers.back();
+}
+
+CachedSet CostModelTest::makeCachedSet(std::initializer_list<const TestLayer*> layers) const {
+    auto layer = layers.begin();
+    CachedSet cachedSet((*layer)->layerState.get(), kStartTime);
+    while (++layer != layers.end()) {
+        cachedSet.addLayer((*layer)->layerState.get(), kStartTime);
+    }
+    return cachedSet;
+}
+
+TEST_F(CostModelTest, getProperties) {
+    using Property = CostModel::Property;
+    using namespace ftl::flag_operators;
+
+    TestLayer& layer = addLayer(Rect(0, 0, 100, 100));
+    EXPECT_EQ(CostModel::Properties(Property::Buffer),
+              CostModel::getProperties(CachedSet::Layer(layer.layerState.get(), kStartTime)));
+
+    layer.layerFECompositionState.buffer = nullptr;
+    layer.layerFECompositionState.blendMode = hal::BlendMode::PREMULTIPLIED;
+    EXPECT_CALL(*layer.layerFE, hasRoundedCorners).WillRepeatedly(Return(true));
+    EXPECT_EQ(Property::Blending | Property::RoundedCorners,
+              CostModel::getProperties(CachedSet::Layer(layer.layerState.get(), kStartTime)));
+
+    layer.layerFECompositionState.backgroundBlurRadius = 10;
+    layer.layerState->update(&layer.outputLayer);
+    EXPECT_EQ(Property::Blending | Property::RoundedCorners | Property::BlurBehind,
+              CostModel::getProperties(CachedSet::Layer(layer.layerState.get(), kStartTime)));
+}
+
+TEST_F(CostModelTest, predictRenderLatencyScalesWithArea) {
+    const CachedSet small = makeCachedSet({&addLayer(Rect(0, 0, 100, 100))});
+    const CachedSet large = makeCachedSet({&addLayer(Rect(0, 0, 200, 200))});
+
+    EXPECT_GT(mCostModel.predictRenderLatency(small).count(), 0);
+    EXPECT_DOUBLE_EQ(4 * mCostModel.predictRenderLatency(small).count(),
+                     mCostModel.predictRenderLatency(large).count());
+}
+
+TEST_F(CostModelTest, predictRenderLatencyDependsOnProperties) {
+    TestLayer& opaqueLayer = addLayer(Rect(0, 0, 100, 100));
+    TestLayer& blurringLayer = addLayer(Rect(0, 0, 100, 100));
+    blurringLayer.layerFECompositionState.backgroundBlurRadius = 10;
+    blurringLayer.layerState->update(&blurringLayer.outputLayer);
+
+    EXPECT_LT(mCostModel.predictRenderLatency(makeCachedSet({&opaqueLayer})),
+              mCostModel.predictRenderLatency(makeCachedSet({&blurringLayer})));
+}
+
+TEST_F(CostModelTest, learnsFromMeasuredLatency) {
+    const CachedSet cachedSet = makeCachedSet({&addLayer(Rect(0, 0, 100, 100))});
+    const CachedSet largerSet = makeCachedSet({&addLayer(Rect(0, 0, 200, 200))});
+
+    mCostModel.recordRenderLatency(cachedSet, 1ms);
+    EXPECT_NEAR(CostModel::Duration(1ms).count(),
+                mCostModel.predictRenderLatency(cachedSet).count(), kToleranceNs);
+    // The same properties cost the same per pixel
+    EXPECT_NEAR(CostModel::Duration(4ms).count(),
+                mCostModel.predictRenderLatency(largerSet).count(), kToleranceNs);
+
+    // Once past the averaged samples, the model keeps adapting to new measurements
+    for (size_t i = 0; i < 10 * CostModel::kMaxAveragedSamples; i++) {
+        mCostModel.recordRenderLatency(cachedSet, 2ms);
+    }
+    EXPECT_NEAR(CostModel::Duration(2ms).count(),
+                mCostModel.predictRenderLatency(cachedSet).count(),
+                CostModel::Duration(10us).count());
+}
+
+TEST_F(CostModelTest, splitsMeasuredLatencyBetweenLayers) {
+    TestLayer& opaqueLayer = addLayer(Rect(0, 0, 100, 100));
+    TestLayer& solidColorLayer = addLayer(Rect(0, 0, 100, 100));
+    solidColorLayer.layerFECompositionState.buffer = nullptr;
+    const CachedSet cachedSet = makeCachedSet({&opaqueLayer, &solidColorLayer});
+
+    const double opaqueShare = mCostModel.predictRenderLatency(makeCachedSet({&opaqueLayer})) /
+            mCostModel.predictRenderLatency(cachedSet);
+
+    mCostModel.recordRenderLatency(cachedSet, 3ms);
+    EXPECT_NEAR(CostModel::Duration(3ms).count(),
+                mCostModel.predictRenderLatency(cachedSet).count(), kToleranceNs);
+    EXPECT_NEAR(CostModel::Duration(3ms).count() * opaqueShare,
+                mCostModel.predictRenderLatency(makeCachedSet({&opaqueLayer})).count(),
+                kToleranceNs);
+}
+
+TEST_F(CostModelTest, predictDisplaySavings) {
+    TestLayer& background = addLayer(Rect(0, 0, 100, 100));
+    TestLayer& foreground = addLayer(Rect(0, 0, 100, 100));
+    TestLayer& neighbor = addLayer(Rect(100, 0, 200, 100));
+    TestLayer& corner = addLayer(Rect(100, 100, 200, 200));
+    const double hwcCostPerLayer = mCostModel.getHwcCostPerLayer().count();
+
+    EXPECT_DOUBLE_EQ(0, mCostModel.predictDisplaySavings(makeCachedSet({&background})).count());
+
+    // HWC composes one layer instead of two, even though they don't overlap
+    EXPECT_DOUBLE_EQ(hwcCostPerLayer,
+                     mCostModel.predictDisplaySavings(makeCachedSet({&background, &neighbor}))
+                             .count());
+
+    // The display also reads the overlapping pixels once instead of twice
+    EXPECT_DOUBLE_EQ(hwcCostPerLayer + CostModel::kDisplayCostPerPixel * 100 * 100,
+                     mCostModel.predictDisplaySavings(makeCachedSet({&background, &foreground}))
+                             .count());
+
+    // The display reads the pixels between the layers, which neither covers
+    EXPECT_DOUBLE_EQ(hwcCostPerLayer - CostModel::kDisplayCostPerPixel * 2 * 100 * 100,
+                     mCostModel.predictDisplaySavings(makeCachedSet({&background, &corner}))
+                             .count());
+}
+
+TEST_F(CostModelTest, predictDisplaySavingsUsesHwcCostPerLayer) {
+    const CostModel costModel(20us);
+    const CachedSet cachedSet = makeCachedSet(
+            {&addLayer(Rect(0, 0, 100, 100)), &addLayer(Rect(100, 0, 200, 100))});
+
+    EXPECT_DOUBLE_EQ(CostModel::Duration(20us).count(),
+                     costModel.predictDisplaySavings(cachedSet).count());
+}
+
+TEST_F(CostModelTest, predictsSetsAsIfMerged) {
+    TestLayer& background = addLayer(Rect(0, 0, 100, 100));
+    TestLayer& foreground = addLayer(Rect(20, 20, 80, 80));
+    TestLayer& corner = addLayer(Rect(150, 150, 200, 200));
+    TestLayer& solidColorLayer = addLayer(Rect(0, 100, 100, 200));
+    solidColorLayer.layerFECompositionState.buffer = nullptr;
+
+    const std::vector<CachedSet> sets = {makeCachedSet({&background, &foreground}),
+                                         makeCachedSet({&corner}),
+                                         makeCachedSet({&solidColorLayer})};
+    CachedSet merged = sets[0];
+    merged.append(sets[1]);
+    merged.append(sets[2]);
+
+    EXPECT_DOUBLE_EQ(mCostModel.predictRenderLatency(merged).count(),
+                     mCostModel.predictRenderLatency(sets).count());
+    EXPECT_DOUBLE_EQ(mCostModel.predictDisplaySavings(merged).count(),
+                     mCostModel.predictDisplaySavings(sets).count());
+}
+
+} // namespace
+} // namespace android::compositionengine
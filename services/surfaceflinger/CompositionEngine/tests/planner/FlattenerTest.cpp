@@ -284,6 +284,76 @@ TEST_F(FlattenerTest, flattenLayers_basicFlatten) {
     expectAllLayersFlattened(layers);
 }
 
+TEST_F(FlattenerTest, flattenLayers_costModelFlattensOverlappingLayers) {
+    SET_FLAG_FOR_TEST(com::android::graphics::surfaceflinger::flags::flattener_cost_model, true);
+
+    std::vector<const LayerState*> layers;
+    for (size_t i = 0; i < 3; i++) {
+        auto& testLayer = mTestLayers[i];
+        testLayer->outputLayerCompositionState.displayFrame = Rect(0, 0, 100, 100);
+        testLayer->layerState->update(&testLayer->outputLayer);
+        layers.push_back(testLayer->layerState.get());
+    }
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+    expectAllLayersFlattened(layers);
+}
+
+TEST_F(FlattenerTest, flattenLayers_costModelFlattensNonOverlappingLayers) {
+    SET_FLAG_FOR_TEST(com::android::graphics::surfaceflinger::flags::flattener_cost_model, true);
+
+    // The layers are side by side, so flattening them only saves HWC from composing them
+    // separately.
+    std::vector<const LayerState*> layers;
+    for (size_t i = 0; i < 3; i++) {
+        auto& testLayer = mTestLayers[i];
+        const auto left = static_cast<int32_t>(i) * 100;
+        testLayer->outputLayerCompositionState.displayFrame = Rect(left, 0, left + 100, 100);
+        testLayer->layerState->update(&testLayer->outputLayer);
+        layers.push_back(testLayer->layerState.get());
+    }
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+    expectAllLayersFlattened(layers);
+}
+
+TEST_F(FlattenerTest, flattenLayers_costModelSkipsLayersLargerWhenFlattened) {
+    SET_FLAG_FOR_TEST(com::android::graphics::surfaceflinger::flags::flattener_cost_model, true);
+
+    // The layers are far apart along a diagonal, so the display would read many more pixels from
+    // a single buffer spanning them than from the layers themselves, which costs more than HWC
+    // composing them separately.
+    std::vector<const LayerState*> layers;
+    for (size_t i = 0; i < 3; i++) {
+        auto& testLayer = mTestLayers[i];
+        const auto pos = static_cast<int32_t>(i) * 2000;
+        testLayer->outputLayerCompositionState.displayFrame = Rect(pos, pos, pos + 1, pos + 1);
+        testLayer->layerState->update(&testLayer->outputLayer);
+        layers.push_back(testLayer->layerState.get());
+    }
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).Times(0);
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_FALSE(mFlattener->getNewCachedSetForTesting());
+
+    for (const auto layer : layers) {
+        EXPECT_EQ(nullptr, layer->getOutputLayer()->getState().overrideInfo.buffer);
+    }
+}
+
 TEST_F(FlattenerTest, flattenLayers_FlattenedLayersStayFlattenWhenNoUpdate) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -112,6 +112,7 @@ void PowerAdvisor::onBootFinished() {
 }
 
 void PowerAdvisor::setExpensiveRenderingExpected(DisplayId displayId, bool expected) {
+    std::lock_guard lock(mExpensiveRenderingMutex);
     if (!mHasExpensiveRendering) {
         ALOGV("Skipped sending EXPENSIVE_RENDERING because HAL doesn't support it");
         return;
@@ -330,6 +331,7 @@ bool PowerAdvisor::startPowerHintSession(std::vector<int32_t>&& threadIds) {
 }
 
 void PowerAdvisor::setGpuFenceTime(DisplayId displayId, std::unique_ptr<FenceTime>&& fenceTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     if (displayData.gpuEndFenceTime) {
         nsecs_t signalTime = displayData.gpuEndFenceTime->getSignalTime();
@@ -356,6 +358,7 @@ void PowerAdvisor::setGpuFenceTime(DisplayId displayId, std::unique_ptr<FenceTim
 
 void PowerAdvisor::setHwcValidateTiming(DisplayId displayId, TimePoint validateStartTime,
                                         TimePoint validateEndTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     displayData.hwcValidateStartTime = validateStartTime;
     displayData.hwcValidateEndTime = validateEndTime;
@@ -363,17 +366,20 @@ void PowerAdvisor::setHwcValidateTiming(DisplayId displayId, TimePoint validateS
 
 void PowerAdvisor::setHwcPresentTiming(DisplayId displayId, TimePoint presentStartTime,
                                        TimePoint presentEndTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     displayData.hwcPresentStartTime = presentStartTime;
     displayData.hwcPresentEndTime = presentEndTime;
 }
 
 void PowerAdvisor::setSkippedValidate(DisplayId displayId, bool skipped) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].skippedValidate = skipped;
 }
 
 void PowerAdvisor::setRequiresClientComposition(DisplayId displayId,
                                                 bool requiresClientComposition) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].usedClientComposition = requiresClientComposition;
 }
 
@@ -391,6 +397,7 @@ void PowerAdvisor::setFrameDelay(Duration frameDelayDuration) {
 }
 
 void PowerAdvisor::setHwcPresentDelayedTime(DisplayId displayId, TimePoint earliestFrameStartTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].hwcPresentDelayedTime = earliestFrameStartTime;
 }
 
@@ -429,6 +436,8 @@ std::optional<Duration> PowerAdvisor::estimateWorkDuration() {
         return std::nullopt;
     }
 
+    std::lock_guard lock(mDisplayTimingDataMutex);
+
     // Tracks when we finish presenting to hwc
     TimePoint estimatedHwcEndTime = mCommitStartTimes[0];
 
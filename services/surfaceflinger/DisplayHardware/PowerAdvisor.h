@@ -146,8 +146,10 @@ private:
     std::unique_ptr<power::PowerHalController> mPowerHal;
     std::atomic_bool mBootFinished = false;
 
-    std::unordered_set<DisplayId> mExpensiveDisplays;
-    bool mNotifiedExpensiveRendering = false;
+    // Displays may be composed and presented from several threads.
+    std::mutex mExpensiveRenderingMutex;
+    std::unordered_set<DisplayId> mExpensiveDisplays GUARDED_BY(mExpensiveRenderingMutex);
+    std::atomic_bool mNotifiedExpensiveRendering = false;
 
     SurfaceFlinger& mFlinger;
     std::atomic_bool mSendUpdateImminent = true;
@@ -217,8 +219,8 @@ private:
     };
 
     // Filter and sort the display ids by a given property
-    std::vector<DisplayId> getOrderedDisplayIds(
-            std::optional<TimePoint> DisplayTimingData::*sortBy);
+    std::vector<DisplayId> getOrderedDisplayIds(std::optional<TimePoint> DisplayTimingData::*sortBy)
+            REQUIRES(mDisplayTimingDataMutex);
     // Estimates a frame's total work duration including gpu time.
     std::optional<Duration> estimateWorkDuration();
     // There are two different targets and actual work durations we care about,
@@ -226,7 +228,10 @@ private:
     Duration combineTimingEstimates(Duration totalDuration, Duration flingerDuration);
 
     bool ensurePowerHintSessionRunning() REQUIRES(mHintSessionMutex);
-    std::unordered_map<DisplayId, DisplayTimingData> mDisplayTimingData;
+    // Set by each display as it is composed and presented, possibly from several threads.
+    std::mutex mDisplayTimingDataMutex;
+    std::unordered_map<DisplayId, DisplayTimingData> mDisplayTimingData
+            GUARDED_BY(mDisplayTimingDataMutex);
 
     // Current frame's delay
     Duration mFrameDelayDuration{0ns};
@@ -258,7 +263,7 @@ private:
             GUARDED_BY(mHintSessionMutex) = nullptr;
 
     // Initialize to true so we try to call, to check if it's supported
-    bool mHasExpensiveRendering = true;
+    bool mHasExpensiveRendering GUARDED_BY(mExpensiveRenderingMutex) = true;
     bool mHasDisplayUpdateImminent = true;
     // Queue of actual durations saved to report
     std::vector<aidl::android::hardware::power::WorkDuration> mHintSessionQueue;
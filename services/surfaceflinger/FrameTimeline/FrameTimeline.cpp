@@ -21,7 +21,9 @@
 #include "FrameTimeline.h"
 
 #include <android-base/stringprintf.h>
+#include <android-base/thread_annotations.h>
 #include <common/FlagManager.h>
+#include <pthread.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
@@ -809,7 +811,8 @@ std::optional<TimelineItem> TokenManager::getPredictionsForToken(int64_t token)
 }
 
 FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                             JankClassificationThresholds thresholds, bool useBootTimeClock)
+                             JankClassificationThresholds thresholds, bool useBootTimeClock,
+                             bool classifyJankAsync)
       : mUseBootTimeClock(useBootTimeClock),
         mMaxDisplayFrames(kDefaultMaxDisplayFrames),
         mTimeStats(std::move(timeStats)),
@@ -817,6 +820,23 @@ FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surface
         mJankClassificationThresholds(thresholds) {
     mCurrentDisplayFrame =
             std::make_shared<DisplayFrame>(mTimeStats, thresholds, &mTraceCookieCounter);
+    mQueuedPresentFences.reserve(kMaxQueuedPresentFences);
+    if (classifyJankAsync) {
+        mPresentThread = std::thread(&FrameTimeline::runPresentThread, this);
+        pthread_setname_np(mPresentThread.native_handle(), "FrameTimeline");
+    }
+}
+
+FrameTimeline::~FrameTimeline() {
+    if (!mPresentThread.joinable()) {
+        return;
+    }
+    {
+        std::scoped_lock lock(mPresentQueueMutex);
+        mPresentThreadDone = true;
+    }
+    mPresentQueuedCv.notify_one();
+    mPresentThread.join();
 }
 
 void FrameTimeline::onBootFinished() {
@@ -872,6 +892,7 @@ FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
 
 void FrameTimeline::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
     ATRACE_CALL();
+    MainThreadTimer timer(*this);
     std::scoped_lock lock(mMutex);
     mCurrentDisplayFrame->addSurfaceFrame(surfaceFrame);
 }
@@ -879,6 +900,7 @@ void FrameTimeline::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame)
 void FrameTimeline::setSfWakeUp(int64_t token, nsecs_t wakeUpTime, Fps refreshRate,
                                 Fps renderRate) {
     ATRACE_CALL();
+    MainThreadTimer timer(*this);
     std::scoped_lock lock(mMutex);
     mCurrentDisplayFrame->onSfWakeUp(token, refreshRate, renderRate,
                                      mTokenManager.getPredictionsForToken(token), wakeUpTime);
@@ -888,12 +910,86 @@ void FrameTimeline::setSfPresent(nsecs_t sfPresentTime,
                                  const std::shared_ptr<FenceTime>& presentFence,
                                  const std::shared_ptr<FenceTime>& gpuFence) {
     ATRACE_CALL();
-    std::scoped_lock lock(mMutex);
-    mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
-    mCurrentDisplayFrame->setGpuFence(gpuFence);
-    mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
-    flushPendingPresentFences();
-    finalizeCurrentDisplayFrame();
+    {
+        MainThreadTimer timer(*this);
+        PendingPresentFence pendingPresentFence;
+        {
+            std::scoped_lock lock(mMutex);
+            mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
+            mCurrentDisplayFrame->setGpuFence(gpuFence);
+            pendingPresentFence = std::make_pair(presentFence, mCurrentDisplayFrame);
+            finalizeCurrentDisplayFrame();
+        }
+
+        if (mPresentThread.joinable()) {
+            queuePresentFence(std::move(pendingPresentFence));
+        } else {
+            std::scoped_lock lock(mPresentMutex);
+            mPendingPresentFences.push_back(std::move(pendingPresentFence));
+            flushPendingPresentFences();
+        }
+    }
+    recordFrameMainThreadTime();
+}
+
+void FrameTimeline::queuePresentFence(PendingPresentFence presentFence) {
+    {
+        std::unique_lock lock(mPresentQueueMutex);
+        base::ScopedLockAssertion assumeLock(mPresentQueueMutex);
+        if (mQueuedPresentFences.size() >= kMaxQueuedPresentFences) {
+            ATRACE_NAME("waitForPresentThread");
+            mPresentDequeuedCv.wait(lock, [this]() REQUIRES(mPresentQueueMutex) {
+                return mQueuedPresentFences.size() < kMaxQueuedPresentFences;
+            });
+        }
+        mQueuedPresentFences.push_back(std::move(presentFence));
+    }
+    // Notified once unlocked, so that the present thread doesn't wake up only to wait for the lock.
+    mPresentQueuedCv.notify_one();
+}
+
+void FrameTimeline::runPresentThread() {
+    std::vector<PendingPresentFence> presentFences;
+    presentFences.reserve(kMaxQueuedPresentFences);
+    while (true) {
+        {
+            std::unique_lock lock(mPresentQueueMutex);
+            base::ScopedLockAssertion assumeLock(mPresentQueueMutex);
+            mPresentQueuedCv.wait(lock, [this]() REQUIRES(mPresentQueueMutex) {
+                return mPresentThreadDone || !mQueuedPresentFences.empty();
+            });
+            // The fences queued before the FrameTimeline is destroyed are still flushed.
+            if (mQueuedPresentFences.empty()) {
+                return;
+            }
+        }
+
+        ATRACE_NAME("FrameTimeline::flushPendingPresentFences");
+        std::scoped_lock lock(mPresentMutex);
+        {
+            // Taken under mPresentMutex, so that setMaxDisplayFrames can't clear the fences in
+            // between.
+            std::scoped_lock queueLock(mPresentQueueMutex);
+            presentFences.swap(mQueuedPresentFences);
+        }
+        mPresentDequeuedCv.notify_one();
+        mPendingPresentFences.insert(mPendingPresentFences.end(),
+                                     std::make_move_iterator(presentFences.begin()),
+                                     std::make_move_iterator(presentFences.end()));
+        presentFences.clear();
+        flushPendingPresentFences();
+    }
+}
+
+void FrameTimeline::recordFrameMainThreadTime() {
+    const nsecs_t frameTime = mFrameMainThreadTime.exchange(0, std::memory_order_relaxed);
+    ATRACE_INT64("FrameTimeline main thread time", frameTime);
+    mLastFrameMainThreadTime.store(frameTime, std::memory_order_relaxed);
+    if (frameTime > mMaxFrameMainThreadTime.load(std::memory_order_relaxed)) {
+        mMaxFrameMainThreadTime.store(frameTime, std::memory_order_relaxed);
+    }
+    mTotalMainThreadTime.fetch_add(frameTime, std::memory_order_relaxed);
+    mMainThreadFrameCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 void FrameTimeline::DisplayFrame::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
@@ -1253,6 +1349,7 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
     std::vector<nsecs_t> presentTimes;
     {
         std::scoped_lock lock(mMutex);
+        std::scoped_lock presentLock(mPresentMutex);
         presentTimes.reserve(mDisplayFrames.size());
         for (size_t i = 0; i < mDisplayFrames.size(); i++) {
             const auto& displayFrame = mDisplayFrames[i];
@@ -1438,6 +1535,18 @@ void FrameTimeline::DisplayFrame::dump(std::string& result, nsecs_t baseTime) co
 
 void FrameTimeline::dumpAll(std::string& result) {
     std::scoped_lock lock(mMutex);
+    std::scoped_lock presentLock(mPresentMutex);
+    const auto toMs = [](const std::atomic<nsecs_t>& time) {
+        return std::chrono::duration<double, std::milli>(
+                       std::chrono::nanoseconds(time.load(std::memory_order_relaxed)))
+                .count();
+    };
+    const uint64_t frameCount = mMainThreadFrameCount.load(std::memory_order_relaxed);
+    const double averageMs =
+            frameCount == 0 ? 0. : toMs(mTotalMainThreadTime) / static_cast<double>(frameCount);
+    StringAppendF(&result,
+                  "Main thread time per frame : last %.3fms, average %.3fms, max %.3fms\n",
+                  toMs(mLastFrameMainThreadTime), averageMs, toMs(mMaxFrameMainThreadTime));
     StringAppendF(&result, "Number of display frames : %d\n", (int)mDisplayFrames.size());
     nsecs_t baseTime = (mDisplayFrames.empty()) ? 0 : mDisplayFrames[0]->getBaseTime();
     for (size_t i = 0; i < mDisplayFrames.size(); i++) {
@@ -1448,6 +1557,7 @@ void FrameTimeline::dumpAll(std::string& result) {
 
 void FrameTimeline::dumpJank(std::string& result) {
     std::scoped_lock lock(mMutex);
+    std::scoped_lock presentLock(mPresentMutex);
     nsecs_t baseTime = (mDisplayFrames.empty()) ? 0 : mDisplayFrames[0]->getBaseTime();
     for (size_t i = 0; i < mDisplayFrames.size(); i++) {
         mDisplayFrames[i]->dumpJank(result, baseTime, static_cast<int>(i));
@@ -1470,10 +1580,16 @@ void FrameTimeline::parseArgs(const Vector<String16>& args, std::string& result)
 
 void FrameTimeline::setMaxDisplayFrames(uint32_t size) {
     std::scoped_lock lock(mMutex);
+    std::scoped_lock presentLock(mPresentMutex);
 
     // The size can either increase or decrease, clear everything, to be consistent
     mDisplayFrames.clear();
     mPendingPresentFences.clear();
+    {
+        std::scoped_lock queueLock(mPresentQueueMutex);
+        mQueuedPresentFences.clear();
+    }
+    mPresentDequeuedCv.notify_one();
     mMaxDisplayFrames = size;
 }
 
@@ -18,11 +18,14 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <gui/ISurfaceComposer.h>
 #include <gui/JankInfo.h>
@@ -366,7 +369,8 @@ public:
 
     /*
      * DisplayFrame should be used only internally within FrameTimeline. All members and methods are
-     * guarded by FrameTimeline's mMutex.
+     * guarded by FrameTimeline's mMutex until the DisplayFrame is presented, and by its
+     * mPresentMutex afterwards.
      */
     class DisplayFrame {
     public:
@@ -460,9 +464,13 @@ public:
         TraceCookieCounter& mTraceCookieCounter;
     };
 
+    // If classifyJankAsync is set, the present fences are handed to a worker thread, which looks
+    // for the signaled ones on every present, classifies the jank of their DisplayFrames and traces
+    // them. Otherwise that happens on the thread that calls setSfPresent.
     FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                  JankClassificationThresholds thresholds = {}, bool useBootTimeClock = true);
-    ~FrameTimeline() = default;
+                  JankClassificationThresholds thresholds = {}, bool useBootTimeClock = true,
+                  bool classifyJankAsync = false);
+    ~FrameTimeline();
 
     frametimeline::TokenManager* getTokenManager() override { return &mTokenManager; }
     std::shared_ptr<SurfaceFrame> createSurfaceFrameForToken(
@@ -490,27 +498,72 @@ private:
     // Friend class for testing
     friend class android::frametimeline::FrameTimelineTest;
 
-    void flushPendingPresentFences() REQUIRES(mMutex);
-    std::optional<size_t> getFirstSignalFenceIndex() const REQUIRES(mMutex);
+    using PendingPresentFence =
+            std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>;
+
+    // Measures the time spent by SurfaceFlinger's main thread in FrameTimeline for the current
+    // frame.
+    class MainThreadTimer {
+    public:
+        explicit MainThreadTimer(FrameTimeline& frameTimeline)
+              : mFrameTimeline(frameTimeline), mStartTime(systemTime()) {}
+        ~MainThreadTimer() {
+            mFrameTimeline.mFrameMainThreadTime.fetch_add(systemTime() - mStartTime,
+                                                          std::memory_order_relaxed);
+        }
+
+    private:
+        FrameTimeline& mFrameTimeline;
+        const nsecs_t mStartTime;
+    };
+
+    void flushPendingPresentFences() REQUIRES(mPresentMutex);
+    std::optional<size_t> getFirstSignalFenceIndex() const REQUIRES(mPresentMutex);
     void finalizeCurrentDisplayFrame() REQUIRES(mMutex);
+    void queuePresentFence(PendingPresentFence presentFence) EXCLUDES(mPresentQueueMutex);
+    void runPresentThread() EXCLUDES(mPresentMutex, mPresentQueueMutex);
+    void recordFrameMainThreadTime();
     void dumpAll(std::string& result);
     void dumpJank(std::string& result);
 
     // Sliding window of display frames. TODO(b/168072834): compare perf with fixed size array
     std::deque<std::shared_ptr<DisplayFrame>> mDisplayFrames GUARDED_BY(mMutex);
-    std::vector<std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>>
-            mPendingPresentFences GUARDED_BY(mMutex);
     std::shared_ptr<DisplayFrame> mCurrentDisplayFrame GUARDED_BY(mMutex);
     TokenManager mTokenManager;
     TraceCookieCounter mTraceCookieCounter;
+    // Guards the frames that are being built. Locked before mPresentMutex if both are needed.
     mutable std::mutex mMutex;
+
+    // Guards the frames that were handed over to be presented, which is where they get their jank
+    // classified, whether on the present thread or on the caller of setSfPresent.
+    std::vector<PendingPresentFence> mPendingPresentFences GUARDED_BY(mPresentMutex);
+    nsecs_t mPreviousPresentTime GUARDED_BY(mPresentMutex) = 0;
+    mutable std::mutex mPresentMutex;
+
+    // The present fences waiting for the present thread, if there is one. setSfPresent blocks when
+    // the queue is full, so that a present thread that cannot keep up slows down SurfaceFlinger
+    // rather than letting the frames pile up.
+    std::vector<PendingPresentFence> mQueuedPresentFences GUARDED_BY(mPresentQueueMutex);
+    bool mPresentThreadDone GUARDED_BY(mPresentQueueMutex) = false;
+    std::condition_variable mPresentQueuedCv;
+    std::condition_variable mPresentDequeuedCv;
+    std::mutex mPresentQueueMutex;
+    std::thread mPresentThread;
+
+    // Time spent by the main thread in FrameTimeline so far in the current frame, and over the
+    // frames since boot.
+    std::atomic<nsecs_t> mFrameMainThreadTime = 0;
+    std::atomic<nsecs_t> mLastFrameMainThreadTime = 0;
+    std::atomic<nsecs_t> mMaxFrameMainThreadTime = 0;
+    std::atomic<nsecs_t> mTotalMainThreadTime = 0;
+    std::atomic<uint64_t> mMainThreadFrameCount = 0;
     const bool mUseBootTimeClock;
     uint32_t mMaxDisplayFrames;
     std::shared_ptr<TimeStats> mTimeStats;
     const pid_t mSurfaceFlingerPid;
-    nsecs_t mPreviousPresentTime = 0;
     const JankClassificationThresholds mJankClassificationThresholds;
     static constexpr uint32_t kDefaultMaxDisplayFrames = 64;
+    static constexpr size_t kMaxQueuedPresentFences = 8;
     // The initial container size for the vector<SurfaceFrames> inside display frame. Although
     // this number doesn't represent any bounds on the number of surface frames that can go in a
     // display frame, this is a good starting size for the vector so that we can avoid the
@@ -313,6 +313,18 @@ void updateMetadata(LayerSnapshot& snapshot, const RequestedLayerState& requeste
     }
 }
 
+// Snapshot changes that are inherited by child snapshots.
+constexpr ftl::Flags<RequestedLayerState::Changes> kChangesAffectingChildren =
+        RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
+        RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
+        RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
+        RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode;
+
+bool changesAffectChildren(const LayerSnapshot& snapshot) {
+    return snapshot.changes.any(kChangesAffectingChildren) ||
+            (snapshot.clientChanges & layer_state_t::AFFECTS_CHILDREN);
+}
+
 void clearChanges(LayerSnapshot& snapshot) {
     snapshot.changes.clear();
     snapshot.clientChanges = 0;
@@ -433,9 +445,18 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         rootSnapshot.clientChanges |= layer_state_t::eReparent;
     }
 
-    for (auto& snapshot : mSnapshots) {
-        if (snapshot->reachablilty == LayerSnapshot::Reachablilty::Reachable) {
-            snapshot->reachablilty = LayerSnapshot::Reachablilty::Unreachable;
+    // Without hierarchy changes, reachability cannot change and snapshots in subtrees without
+    // any pending changes are already up to date, so only the dirty subtrees are visited.
+    mSkipCleanSubtrees = args.forceUpdate == ForceUpdateFlags::NONE && !args.displayChanges &&
+            !args.parentCrop &&
+            !args.layerLifecycleManager.getGlobalChanges().test(
+                    RequestedLayerState::Changes::Hierarchy);
+    mDirtySubtrees.clear();
+    if (!mSkipCleanSubtrees) {
+        for (auto& snapshot : mSnapshots) {
+            if (snapshot->reachablilty == LayerSnapshot::Reachablilty::Reachable) {
+                snapshot->reachablilty = LayerSnapshot::Reachablilty::Unreachable;
+            }
         }
     }
 
@@ -454,6 +475,7 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
             updateSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0);
         }
     }
+    mDirtySubtrees.clear();
 
     // Update touchable region crops outside the main update pass. This is because a layer could be
     // cropped by any other layer and it requires both snapshots to be updated.
@@ -531,6 +553,10 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         snapshot->merge(*layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
                         primaryDisplayRotationFlags);
         snapshot->changes |= RequestedLayerState::Changes::Created;
+    } else if (mSkipCleanSubtrees && !changesAffectChildren(parentSnapshot) &&
+               !isSubtreeDirty(hierarchy, depth)) {
+        // Nothing in this subtree or inherited from its parent has changed since the last update.
+        return *snapshot;
     }
 
     if (traversalPath.isRelative()) {
@@ -556,6 +582,26 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
     return *snapshot;
 }
 
+bool LayerSnapshotBuilder::isSubtreeDirty(const LayerHierarchy& hierarchy, int depth) {
+    // Treat pathologically deep hierarchies as dirty and let the full update handle them.
+    if (depth > 50) {
+        return true;
+    }
+    auto [it, inserted] = mDirtySubtrees.try_emplace(&hierarchy, false);
+    if (!inserted) {
+        return it->second;
+    }
+
+    const RequestedLayerState* layer = hierarchy.getLayer();
+    bool dirty = layer && (layer->changes.get() != 0 || layer->what != 0);
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        if (dirty) break;
+        dirty = isSubtreeDirty(*childHierarchy, depth + 1);
+    }
+    mDirtySubtrees[&hierarchy] = dirty;
+    return dirty;
+}
+
 LayerSnapshot* LayerSnapshotBuilder::getSnapshot(uint32_t layerId) const {
     if (layerId == UNASSIGNED_LAYER_ID) {
         return nullptr;
@@ -705,11 +751,8 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
                                           const LayerSnapshot& parentSnapshot,
                                           const LayerHierarchy::TraversalPath& path) {
     // Always update flags and visibility
-    ftl::Flags<RequestedLayerState::Changes> parentChanges = parentSnapshot.changes &
-            (RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
-             RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
-             RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
-             RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode);
+    ftl::Flags<RequestedLayerState::Changes> parentChanges =
+            parentSnapshot.changes & kChangesAffectingChildren;
     snapshot.changes |= parentChanges;
     if (args.displayChanges) snapshot.changes |= RequestedLayerState::Changes::Geometry;
     snapshot.reachablilty = LayerSnapshot::Reachablilty::Reachable;
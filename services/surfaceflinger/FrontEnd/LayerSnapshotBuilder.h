@@ -101,6 +101,9 @@ private:
     const LayerSnapshot& updateSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
                                                     LayerHierarchy::TraversalPath& traversalPath,
                                                     const LayerSnapshot& parentSnapshot, int depth);
+    // Returns true if the layer or any layer reachable from it has pending changes. Results are
+    // memoized for the duration of a single update since mirrored hierarchies are shared.
+    bool isSubtreeDirty(const LayerHierarchy& hierarchy, int depth);
     void updateSnapshot(LayerSnapshot&, const Args&, const RequestedLayerState&,
                         const LayerSnapshot& parentSnapshot, const LayerHierarchy::TraversalPath&);
     static void updateRelativeState(LayerSnapshot& snapshot, const LayerSnapshot& parentSnapshot,
@@ -134,6 +137,10 @@ private:
             mNeedsTouchableRegionCrop;
     std::vector<std::unique_ptr<LayerSnapshot>> mSnapshots;
     bool mResortSnapshots = false;
+    // Set during an update that has no hierarchy, display or forced changes. Subtrees without
+    // pending changes are then skipped instead of being walked and recomputed.
+    bool mSkipCleanSubtrees = false;
+    std::unordered_map<const LayerHierarchy*, bool> mDirtySubtrees;
     int mNumInterestingSnapshots = 0;
 };
 
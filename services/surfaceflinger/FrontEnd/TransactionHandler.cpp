@@ -35,14 +35,9 @@ void TransactionHandler::queueTransaction(TransactionState&& state) {
 }
 
 void TransactionHandler::collectTransactions() {
-    while (!mLocklessTransactionQueue.isEmpty()) {
-        auto maybeTransaction = mLocklessTransactionQueue.pop();
-        if (!maybeTransaction.has_value()) {
-            break;
-        }
-        auto transaction = maybeTransaction.value();
+    mLocklessTransactionQueue.drain([this](TransactionState&& transaction) {
         mPendingTransactionQueues[transaction.applyToken].emplace(std::move(transaction));
-    }
+    });
 }
 
 std::vector<TransactionState> TransactionHandler::flushTransactions() {
@@ -16,9 +16,13 @@
 
 #pragma once
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <utility>
 
-template <typename T>
+template <typename T, size_t PoolSize = 64>
 // Single consumer multi producer stack. We can understand the two operations independently to see
 // why they are without race condition.
 //
@@ -36,47 +40,139 @@ template <typename T>
 // then store the list and pop one element.
 //
 // If we already had something in the pop list we just pop directly.
+//
+// Values are only ever moved in and out of the queue, and the entries holding them are recycled.
+// The queue owns PoolSize entries, which the consumer puts back on a free list once their value is
+// popped, and push takes an entry from that list before falling back to the heap. Since several
+// producers take from the free list at once, its head is an entry index tagged with a counter
+// that changes on every update, so that a producer that read an entry which was taken and put
+// back in the meantime fails its compare_exchange rather than corrupting the list.
 class LocklessQueue {
 public:
-    class Entry {
-    public:
-        T mValue;
-        std::atomic<Entry*> mNext;
-        Entry(T value) : mValue(value) {}
-    };
-    std::atomic<Entry*> mPush = nullptr;
-    std::atomic<Entry*> mPop = nullptr;
-    bool isEmpty() { return (mPush.load() == nullptr) && (mPop.load() == nullptr); }
+    LocklessQueue() : mPool(std::make_unique<Entry[]>(PoolSize)) {
+        for (uint32_t i = 0; i < PoolSize; i++) {
+            mPool[i].mPoolIndex = i;
+            mPool[i].mNextFree = i + 1 < PoolSize ? i + 1 : NO_ENTRY;
+        }
+        mFree = pack(0, PoolSize > 0 ? 0 : NO_ENTRY);
+    }
+
+    ~LocklessQueue() { drain([](T&&) {}); }
 
-    void push(T value) {
-        Entry* entry = new Entry(value);
-        Entry* previousHead = mPush.load(/*std::memory_order_relaxed*/);
+    LocklessQueue(const LocklessQueue&) = delete;
+    LocklessQueue& operator=(const LocklessQueue&) = delete;
+
+    bool isEmpty() const {
+        return (mPush.load(std::memory_order_acquire) == nullptr) &&
+                (mPop.load(std::memory_order_acquire) == nullptr);
+    }
+
+    void push(T&& value) {
+        Entry* entry = allocate();
+        entry->mValue.emplace(std::move(value));
+        Entry* previousHead = mPush.load(std::memory_order_relaxed);
         do {
             entry->mNext = previousHead;
-        } while (!mPush.compare_exchange_weak(previousHead, entry)); /*std::memory_order_release*/
+        } while (!mPush.compare_exchange_weak(previousHead, entry, std::memory_order_release,
+                                              std::memory_order_relaxed));
     }
+
     std::optional<T> pop() {
-        Entry* popped = mPop.load(/*std::memory_order_acquire*/);
-        if (popped) {
-            // Single consumer so this is fine
-            mPop.store(popped->mNext /* , std::memory_order_release */);
-            auto value = popped->mValue;
-            delete popped;
-            return std::move(value);
-        } else {
-            Entry* grabbedList = mPush.exchange(nullptr /* , std::memory_order_acquire */);
-            if (!grabbedList) return std::nullopt;
-            // Reverse the list
-            while (grabbedList->mNext) {
-                Entry* next = grabbedList->mNext;
-                grabbedList->mNext = popped;
-                popped = grabbedList;
-                grabbedList = next;
+        Entry* popped = mPop.load(std::memory_order_relaxed);
+        if (!popped) {
+            popped = reverse(mPush.exchange(nullptr, std::memory_order_acquire));
+            if (!popped) return std::nullopt;
+        }
+        // Single consumer so this is fine
+        mPop.store(popped->mNext, std::memory_order_release);
+        std::optional<T> value = std::move(popped->mValue);
+        recycle(popped);
+        return value;
+    }
+
+    // Pops every value pushed so far, oldest first, and hands it to consume. Returns the number of
+    // values popped. Like pop, this must only be called from the consumer.
+    template <typename F>
+    size_t drain(F&& consume) {
+        size_t count = drainList(mPop.exchange(nullptr, std::memory_order_relaxed), consume);
+        count += drainList(reverse(mPush.exchange(nullptr, std::memory_order_acquire)), consume);
+        return count;
+    }
+
+private:
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+    struct Entry {
+        std::optional<T> mValue;
+        Entry* mNext = nullptr;
+        // Index in mPool, or NO_ENTRY if the entry came from the heap.
+        uint32_t mPoolIndex = NO_ENTRY;
+        std::atomic<uint32_t> mNextFree = NO_ENTRY;
+    };
+
+    // The free list head is an index in mPool in the low bits and a tag in the high bits.
+    static uint64_t pack(uint32_t tag, uint32_t index) {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+    static uint32_t tagOf(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+    static uint32_t indexOf(uint64_t head) { return static_cast<uint32_t>(head); }
+
+    Entry* allocate() {
+        uint64_t head = mFree.load(std::memory_order_acquire);
+        while (indexOf(head) != NO_ENTRY) {
+            Entry& entry = mPool[indexOf(head)];
+            const uint64_t next =
+                    pack(tagOf(head) + 1, entry.mNextFree.load(std::memory_order_relaxed));
+            if (mFree.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return &entry;
             }
-            mPop.store(popped /* , std::memory_order_release */);
-            auto value = grabbedList->mValue;
-            delete grabbedList;
-            return std::move(value);
         }
+        return new Entry();
     }
+
+    void recycle(Entry* entry) {
+        entry->mValue.reset();
+        if (entry->mPoolIndex == NO_ENTRY) {
+            delete entry;
+            return;
+        }
+        uint64_t head = mFree.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            entry->mNextFree.store(indexOf(head), std::memory_order_relaxed);
+            next = pack(tagOf(head) + 1, entry->mPoolIndex);
+        } while (!mFree.compare_exchange_weak(head, next, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    // Turns the push list, newest first, into a pop list, oldest first.
+    static Entry* reverse(Entry* list) {
+        Entry* reversed = nullptr;
+        while (list) {
+            Entry* next = list->mNext;
+            list->mNext = reversed;
+            reversed = list;
+            list = next;
+        }
+        return reversed;
+    }
+
+    template <typename F>
+    size_t drainList(Entry* list, F& consume) {
+        size_t count = 0;
+        while (list) {
+            Entry* next = list->mNext;
+            consume(std::move(*list->mValue));
+            recycle(list);
+            list = next;
+            count++;
+        }
+        return count;
+    }
+
+    std::atomic<Entry*> mPush = nullptr;
+    std::atomic<Entry*> mPop = nullptr;
+    std::unique_ptr<Entry[]> mPool;
+    std::atomic<uint64_t> mFree;
 };
@@ -36,6 +36,9 @@
 #include <ui/DisplayStatInfo.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <cstring>
+#include <optional>
 #include <string>
 
 #include "DisplayDevice.h"
@@ -63,6 +66,10 @@ constexpr auto defaultRegionSamplingWorkDuration = 3ms;
 constexpr auto defaultRegionSamplingPeriod = 100ms;
 constexpr auto defaultRegionSamplingTimerTimeout = 100ms;
 constexpr auto maxRegionSamplingDelay = 100ms;
+// Regions at least this large are split into horizontal bands that are sampled concurrently;
+// below it, waking the workers costs about as much as sampling the region.
+constexpr uint64_t kParallelSamplingMinPixels = 1024 * 1024;
+constexpr int32_t kMaxSamplingBands = 4;
 // TODO: (b/127403193) duration to string conversion could probably be constexpr
 template <typename Rep, typename Per>
 inline std::string toNsString(std::chrono::duration<Rep, Per> t) {
@@ -104,7 +111,10 @@ RegionSamplingThread::RegionSamplingThread(SurfaceFlinger& flinger, const Timing
                 std::chrono::duration_cast<std::chrono::milliseconds>(
                         mTunables.mSamplingTimerTimeout),
                 [] {}, [this] { checkForStaleLuma(); }),
-        mLastSampleTime(0ns) {
+        mLastSampleTime(0ns),
+        mSamplingWorkers(std::clamp(static_cast<int32_t>(std::thread::hardware_concurrency()),
+                                    1, kMaxSamplingBands) -
+                         1) {
     mThread = std::thread([this]() { threadMain(); });
     pthread_setname_np(mThread.native_handle(), "RegionSampling");
     mIdleTimer.start();
@@ -196,32 +206,207 @@ void RegionSamplingThread::binderDied(const wp<IBinder>& who) {
     mDescriptors.erase(who);
 }
 
-float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
-                 uint32_t orientation, const Rect& sample_area) {
-    if (!sample_area.isValid() || (sample_area.getWidth() > width) ||
-        (sample_area.getHeight() > height)) {
-        ALOGE("invalid sampling region requested");
-        return 0.0f;
+namespace {
+
+// Portable SIMD vector type; the compiler lowers operations on it to NEON on arm and SSE/AVX on
+// x86.
+constexpr int32_t kPixelVectorLanes = 8;
+using PixelVector = uint32_t __attribute__((vector_size(kPixelVectorLanes * sizeof(uint32_t))));
+
+// Returns the sum of the approximate Rec. 709 luma of |count| consecutive RGBA pixels, each
+// scaled to [0, 255].
+uint64_t sumLuma(const uint32_t* pixels, int32_t count) {
+    int32_t i = 0;
+    PixelVector accumulated = {};
+    for (; i + kPixelVectorLanes <= count; i += kPixelVectorLanes) {
+        PixelVector pixel;
+        memcpy(&pixel, pixels + i, sizeof(pixel));
+        const PixelVector r = pixel & 0xFF;
+        const PixelVector g = (pixel >> 8) & 0xFF;
+        const PixelVector b = (pixel >> 16) & 0xFF;
+        accumulated += (r * 7 + b * 2 + g * 23) >> 5;
     }
 
-    const uint32_t pixelCount =
-            (sample_area.bottom - sample_area.top) * (sample_area.right - sample_area.left);
-    uint32_t accumulatedLuma = 0;
+    uint64_t sum = 0;
+    for (int32_t lane = 0; lane < kPixelVectorLanes; ++lane) {
+        sum += accumulated[lane];
+    }
+    for (; i < count; ++i) {
+        const uint32_t pixel = pixels[i];
+        const uint32_t r = pixel & 0xFF;
+        const uint32_t g = (pixel >> 8) & 0xFF;
+        const uint32_t b = (pixel >> 16) & 0xFF;
+        sum += (r * 7 + b * 2 + g * 23) >> 5;
+    }
+    return sum;
+}
+
+// Accumulates into |sums| the luma of every area in rows [top, bottom). The rows are split into
+// spans at every area's left and right edge, so each pixel is read once even when areas overlap.
+void accumulateLuma(const uint32_t* data, int32_t stride, const std::vector<Rect>& areas,
+                    const std::vector<int32_t>& edges, int32_t top, int32_t bottom,
+                    std::vector<uint64_t>& sums) {
+    std::vector<size_t> activeAreas;
+    activeAreas.reserve(areas.size());
+    for (int32_t row = top; row < bottom; ++row) {
+        activeAreas.clear();
+        for (size_t i = 0; i < areas.size(); ++i) {
+            if (areas[i].top <= row && row < areas[i].bottom) {
+                activeAreas.push_back(i);
+            }
+        }
+        if (activeAreas.empty()) continue;
 
-    // Calculates luma with approximation of Rec. 709 primaries
-    for (int32_t row = sample_area.top; row < sample_area.bottom; ++row) {
         const uint32_t* rowBase = data + row * stride;
-        for (int32_t column = sample_area.left; column < sample_area.right; ++column) {
-            uint32_t pixel = rowBase[column];
-            const uint32_t r = pixel & 0xFF;
-            const uint32_t g = (pixel >> 8) & 0xFF;
-            const uint32_t b = (pixel >> 16) & 0xFF;
-            const uint32_t luma = (r * 7 + b * 2 + g * 23) >> 5;
-            accumulatedLuma += luma;
+        for (size_t e = 0; e + 1 < edges.size(); ++e) {
+            const int32_t left = edges[e];
+            const int32_t right = edges[e + 1];
+            std::optional<uint64_t> spanLuma;
+            for (const size_t i : activeAreas) {
+                if (areas[i].left <= left && right <= areas[i].right) {
+                    if (!spanLuma) {
+                        spanLuma = sumLuma(rowBase + left, right - left);
+                    }
+                    sums[i] += *spanLuma;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+SamplingWorkers::SamplingWorkers(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back([this, i]() { threadMain(i); });
+        pthread_setname_np(mThreads.back().native_handle(), "RegionSampling+");
+    }
+}
+
+SamplingWorkers::~SamplingWorkers() {
+    {
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+        mWorkCondition.notify_all();
+    }
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void SamplingWorkers::run(size_t count, const std::function<void(size_t)>& task)
+        NO_THREAD_SAFETY_ANALYSIS {
+    LOG_ALWAYS_FATAL_IF(count > mThreads.size(), "%zu sampling tasks for %zu workers", count,
+                        mThreads.size());
+    if (count > 0) {
+        std::lock_guard lock(mMutex);
+        mTask = &task;
+        mTaskCount = count;
+        mPendingCount = count;
+        mGeneration++;
+        mWorkCondition.notify_all();
+    }
+    task(0);
+    if (count > 0) {
+        std::unique_lock lock(mMutex);
+        mDoneCondition.wait(lock, [this]() { return mPendingCount == 0; });
+        mTask = nullptr;
+    }
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void SamplingWorkers::threadMain(size_t index) NO_THREAD_SAFETY_ANALYSIS {
+    uint64_t generation = 0;
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWorkCondition.wait(lock, [&]() { return !mRunning || mGeneration != generation; });
+        if (!mRunning) {
+            return;
+        }
+        generation = mGeneration;
+        if (index >= mTaskCount) {
+            continue;
+        }
+        const auto& task = *mTask;
+        lock.unlock();
+        task(index + 1);
+        lock.lock();
+        if (--mPendingCount == 0) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
+                 uint32_t orientation, const Rect& sample_area) {
+    return sampleAreas(data, width, height, stride, orientation, {sample_area}).front();
+}
+
+std::vector<float> sampleAreas(const uint32_t* data, int32_t width, int32_t height,
+                               int32_t stride, uint32_t orientation,
+                               const std::vector<Rect>& areas, SamplingWorkers* workers) {
+    std::vector<Rect> validAreas;
+    std::vector<size_t> validIndices;
+    for (size_t i = 0; i < areas.size(); ++i) {
+        const Rect& area = areas[i];
+        if (!area.isValid() || (area.getWidth() > width) || (area.getHeight() > height)) {
+            ALOGE("invalid sampling region requested");
+            continue;
         }
+        validAreas.push_back(area);
+        validIndices.push_back(i);
+    }
+
+    std::vector<float> lumas(areas.size(), 0.0f);
+    if (validAreas.empty()) {
+        return lumas;
     }
 
-    return accumulatedLuma / (255.0f * pixelCount);
+    std::vector<int32_t> edges;
+    Rect bounds = validAreas.front();
+    for (const Rect& area : validAreas) {
+        edges.push_back(area.left);
+        edges.push_back(area.right);
+        bounds.top = std::min(bounds.top, area.top);
+        bounds.bottom = std::max(bounds.bottom, area.bottom);
+        bounds.left = std::min(bounds.left, area.left);
+        bounds.right = std::max(bounds.right, area.right);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Large regions are sampled in bands on the workers, with the calling thread taking the
+    // first band. Each band accumulates into its own sums, which are merged once all are done.
+    const uint64_t boundsPixels = static_cast<uint64_t>(bounds.getWidth()) * bounds.getHeight();
+    const int32_t bandCount = !workers || boundsPixels < kParallelSamplingMinPixels
+            ? 1
+            : std::min(static_cast<int32_t>(workers->size()) + 1, bounds.getHeight());
+    const int32_t bandHeight = (bounds.getHeight() + bandCount - 1) / bandCount;
+
+    std::vector<std::vector<uint64_t>> bandSums(bandCount,
+                                                std::vector<uint64_t>(validAreas.size(), 0));
+    const auto sampleBand = [&](size_t band) {
+        const int32_t top = bounds.top + static_cast<int32_t>(band) * bandHeight;
+        const int32_t bottom = std::min(top + bandHeight, bounds.bottom);
+        accumulateLuma(data, stride, validAreas, edges, top, bottom, bandSums[band]);
+    };
+    if (bandCount == 1) {
+        sampleBand(0);
+    } else {
+        workers->run(static_cast<size_t>(bandCount - 1), sampleBand);
+    }
+
+    for (size_t i = 0; i < validAreas.size(); ++i) {
+        uint64_t accumulatedLuma = 0;
+        for (const auto& sums : bandSums) {
+            accumulatedLuma += sums[i];
+        }
+        const uint64_t pixelCount =
+                static_cast<uint64_t>(validAreas[i].getWidth()) * validAreas[i].getHeight();
+        lumas[validIndices[i]] = accumulatedLuma / (255.0f * pixelCount);
+    }
+    return lumas;
 }
 
 std::vector<float> RegionSamplingThread::sampleBuffer(
@@ -236,13 +421,10 @@ std::vector<float> RegionSamplingThread::sampleBuffer(
     const int32_t width = buffer->getWidth();
     const int32_t height = buffer->getHeight();
     const int32_t stride = buffer->getStride();
-    std::vector<float> lumas(descriptors.size());
-    std::transform(descriptors.begin(), descriptors.end(), lumas.begin(),
-                   [&](auto const& descriptor) {
-                       return sampleArea(data.get(), width, height, stride, orientation,
-                                         descriptor.area - leftTop);
-                   });
-    return lumas;
+    std::vector<Rect> areas(descriptors.size());
+    std::transform(descriptors.begin(), descriptors.end(), areas.begin(),
+                   [&](auto const& descriptor) { return descriptor.area - leftTop; });
+    return sampleAreas(data.get(), width, height, stride, orientation, areas, &mSamplingWorkers);
 }
 
 void RegionSamplingThread::captureSample() {
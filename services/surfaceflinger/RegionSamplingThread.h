@@ -27,9 +27,11 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "Scheduler/OneShotTimer.h"
 #include "WpHash.h"
@@ -45,6 +47,43 @@ using gui::IRegionSamplingListener;
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
                  uint32_t orientation, const Rect& area);
 
+// Helper threads that sample bands of large regions alongside the thread that requested the
+// sample. They are started once and reused for every sample. Not reentrant: run() must only be
+// called from one thread at a time.
+class SamplingWorkers {
+public:
+    explicit SamplingWorkers(size_t threadCount);
+    ~SamplingWorkers();
+
+    size_t size() const { return mThreads.size(); }
+
+    // Runs task(0) on the calling thread and task(1) to task(count) on the workers, and returns
+    // once all of them have finished. count must not exceed size().
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void threadMain(size_t index);
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mDoneCondition;
+    const std::function<void(size_t)>* mTask GUARDED_BY(mMutex) = nullptr;
+    size_t mTaskCount GUARDED_BY(mMutex) = 0;
+    size_t mPendingCount GUARDED_BY(mMutex) = 0;
+    uint64_t mGeneration GUARDED_BY(mMutex) = 0;
+    bool mRunning GUARDED_BY(mMutex) = true;
+    std::vector<std::thread> mThreads;
+};
+
+// Samples several areas in a single pass over the pixels covered by their union, so that
+// overlapping areas share the work for their common pixels. Returns one luma per area, in order;
+// invalid areas report 0. Large regions are split into bands sampled concurrently by |workers|,
+// if given.
+std::vector<float> sampleAreas(const uint32_t* data, int32_t width, int32_t height,
+                               int32_t stride, uint32_t orientation,
+                               const std::vector<Rect>& areas,
+                               SamplingWorkers* workers = nullptr);
+
 class RegionSamplingThread : public IBinder::DeathRecipient {
 public:
     struct TimingTunables {
@@ -120,6 +159,8 @@ private:
     std::unordered_map<wp<IBinder>, Descriptor, WpHash> mDescriptors GUARDED_BY(mSamplingMutex);
     std::shared_ptr<renderengine::ExternalTexture> mCachedBuffer GUARDED_BY(mSamplingMutex) =
             nullptr;
+    // Only used from the sampling thread, while it holds mSamplingMutex.
+    SamplingWorkers mSamplingWorkers;
 };
 
 } // namespace android
@@ -467,6 +467,28 @@ float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& lay
             kNonExactMatchingPenalty;
 }
 
+auto RefreshRateSelector::getLayerScoresLocked(const LayerRequirement& layer) const
+        -> const std::vector<LayerScore>& {
+    const LayerVote layerVote{.vote = layer.vote,
+                              .desiredRefreshRate = layer.desiredRefreshRate,
+                              .frameRateCategory = layer.frameRateCategory};
+    if (const auto it = mLayerScoresCache.find(layerVote); it != mLayerScoresCache.end()) {
+        return it->second;
+    }
+
+    if (mLayerScoresCache.size() >= kMaxCachedLayerScores) {
+        mLayerScoresCache.clear();
+    }
+
+    std::vector<LayerScore> layerScores;
+    layerScores.reserve(mAppRequestFrameRates.size());
+    for (const FrameRateMode& mode : mAppRequestFrameRates) {
+        layerScores.push_back({.seamless = calculateLayerScoreLocked(layer, mode.fps, true),
+                               .seamed = calculateLayerScoreLocked(layer, mode.fps, false)});
+    }
+    return mLayerScoresCache.emplace(layerVote, std::move(layerScores)).first->second;
+}
+
 auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement>& layers,
                                               GlobalSignals signals) const -> RankedFrameRates {
     std::lock_guard lock(mLock);
@@ -619,8 +641,33 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
     std::vector<RefreshRateScore> scores;
     scores.reserve(mAppRequestFrameRates.size());
 
+    // What the layers check about each frame rate, which doesn't depend on the layers.
+    struct FrameRateModeInfo {
+        bool isSeamlessSwitch;
+        bool isInPolicyForDefault;
+        bool isActiveMode;
+        bool isInPrimaryRange;
+        bool isAboveThreshold;
+    };
+    std::vector<FrameRateModeInfo> modeInfos;
+    modeInfos.reserve(mAppRequestFrameRates.size());
+
     for (const FrameRateMode& it : mAppRequestFrameRates) {
         scores.emplace_back(RefreshRateScore{it, 0.0f});
+
+        const auto& [fps, modePtr] = it;
+        const bool inPrimaryPhysicalRange =
+                policy->primaryRanges.physical.includes(modePtr->getPeakFps());
+        const bool inPrimaryRenderRange = policy->primaryRanges.render.includes(fps);
+        modeInfos.push_back(
+                {.isSeamlessSwitch = modePtr->getGroup() == activeMode.getGroup(),
+                 .isInPolicyForDefault = modePtr->getGroup() == anchorGroup,
+                 .isActiveMode = modePtr->getId() == activeModeId,
+                 .isInPrimaryRange =
+                         !(policy->primaryRangeIsSingleRate() && !inPrimaryPhysicalRange) &&
+                         inPrimaryRenderRange,
+                 .isAboveThreshold = modePtr->getPeakFps() >=
+                         Fps::fromValue(mConfig.frameRateMultipleThreshold)});
     }
 
     for (const auto& layer : layers) {
@@ -634,10 +681,38 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
         }
 
         const auto weight = layer.weight;
+        const auto& layerScores = getLayerScoresLocked(layer);
+
+        // Layer with fixed source has a special consideration which depends on the
+        // mConfig.frameRateMultipleThreshold. We don't want these layers to score
+        // refresh rates above the threshold, but we also don't want to favor the lower
+        // ones by having a greater number of layers scoring them. Instead, we calculate
+        // the score independently for these layers and later decide which
+        // refresh rates to add it. For example, desired 24 fps with 120 Hz threshold should not
+        // score 120 Hz, but desired 60 fps should contribute to the score.
+        const bool fixedSourceLayer = [](LayerVoteType vote) {
+            switch (vote) {
+                case LayerVoteType::ExplicitExactOrMultiple:
+                case LayerVoteType::Heuristic:
+                    return true;
+                case LayerVoteType::NoVote:
+                case LayerVoteType::Min:
+                case LayerVoteType::Max:
+                case LayerVoteType::ExplicitDefault:
+                case LayerVoteType::ExplicitExact:
+                case LayerVoteType::ExplicitGte:
+                case LayerVoteType::ExplicitCategory:
+                    return false;
+            }
+        }(layer.vote);
+        const bool layerBelowThreshold = mConfig.frameRateMultipleThreshold != 0 &&
+                layer.desiredRefreshRate < Fps::fromValue(mConfig.frameRateMultipleThreshold / 2);
 
-        for (auto& [mode, overallScore, fixedRateBelowThresholdLayersScore] : scores) {
+        for (size_t i = 0; i < scores.size(); i++) {
+            auto& [mode, overallScore, fixedRateBelowThresholdLayersScore] = scores[i];
             const auto& [fps, modePtr] = mode;
-            const bool isSeamlessSwitch = modePtr->getGroup() == activeMode.getGroup();
+            const FrameRateModeInfo& modeInfo = modeInfos[i];
+            const bool isSeamlessSwitch = modeInfo.isSeamlessSwitch;
 
             if (layer.seamlessness == Seamlessness::OnlySeamless && !isSeamlessSwitch) {
                 ALOGV("%s ignores %s to avoid non-seamless switch. Current mode = %s",
@@ -655,7 +730,7 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
                 continue;
             }
 
-            if (smoothSwitchOnly && modePtr->getId() != activeModeId) {
+            if (smoothSwitchOnly && !modeInfo.isActiveMode) {
                 ALOGV("%s ignores %s because it's non-VRR and smooth switch only."
                       " Current mode = %s",
                       formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
@@ -668,18 +743,13 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
             // mode group otherwise. In second case, if the current mode group is different
             // from the default, this means a layer with seamlessness=SeamedAndSeamless has just
             // disappeared.
-            const bool isInPolicyForDefault = modePtr->getGroup() == anchorGroup;
-            if (layer.seamlessness == Seamlessness::Default && !isInPolicyForDefault) {
+            if (layer.seamlessness == Seamlessness::Default && !modeInfo.isInPolicyForDefault) {
                 ALOGV("%s ignores %s. Current mode = %s", formatLayerInfo(layer, weight).c_str(),
                       to_string(*modePtr).c_str(), to_string(activeMode).c_str());
                 continue;
             }
 
-            const bool inPrimaryPhysicalRange =
-                    policy->primaryRanges.physical.includes(modePtr->getPeakFps());
-            const bool inPrimaryRenderRange = policy->primaryRanges.render.includes(fps);
-            if (((policy->primaryRangeIsSingleRate() && !inPrimaryPhysicalRange) ||
-                 !inPrimaryRenderRange) &&
+            if (!modeInfo.isInPrimaryRange &&
                 !(layer.focused &&
                   (layer.vote == LayerVoteType::ExplicitDefault ||
                    layer.vote == LayerVoteType::ExplicitExact))) {
@@ -688,38 +758,12 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
                 continue;
             }
 
-            const float layerScore = calculateLayerScoreLocked(layer, fps, isSeamlessSwitch);
+            const float layerScore =
+                    isSeamlessSwitch ? layerScores[i].seamless : layerScores[i].seamed;
             const float weightedLayerScore = weight * layerScore;
 
-            // Layer with fixed source has a special consideration which depends on the
-            // mConfig.frameRateMultipleThreshold. We don't want these layers to score
-            // refresh rates above the threshold, but we also don't want to favor the lower
-            // ones by having a greater number of layers scoring them. Instead, we calculate
-            // the score independently for these layers and later decide which
-            // refresh rates to add it. For example, desired 24 fps with 120 Hz threshold should not
-            // score 120 Hz, but desired 60 fps should contribute to the score.
-            const bool fixedSourceLayer = [](LayerVoteType vote) {
-                switch (vote) {
-                    case LayerVoteType::ExplicitExactOrMultiple:
-                    case LayerVoteType::Heuristic:
-                        return true;
-                    case LayerVoteType::NoVote:
-                    case LayerVoteType::Min:
-                    case LayerVoteType::Max:
-                    case LayerVoteType::ExplicitDefault:
-                    case LayerVoteType::ExplicitExact:
-                    case LayerVoteType::ExplicitGte:
-                    case LayerVoteType::ExplicitCategory:
-                        return false;
-                }
-            }(layer.vote);
-            const bool layerBelowThreshold = mConfig.frameRateMultipleThreshold != 0 &&
-                    layer.desiredRefreshRate <
-                            Fps::fromValue(mConfig.frameRateMultipleThreshold / 2);
             if (fixedSourceLayer && layerBelowThreshold) {
-                const bool modeAboveThreshold =
-                        modePtr->getPeakFps() >= Fps::fromValue(mConfig.frameRateMultipleThreshold);
-                if (modeAboveThreshold) {
+                if (modeInfo.isAboveThreshold) {
                     ALOGV("%s gives %s (%s(%s)) fixed source (above threshold) score of %.4f",
                           formatLayerInfo(layer, weight).c_str(), to_string(fps).c_str(),
                           to_string(modePtr->getPeakFps()).c_str(),
@@ -1387,6 +1431,9 @@ void RefreshRateSelector::constructAvailableRefreshRates() {
 
     mPrimaryFrameRates = filterRefreshRates(policy->primaryRanges, "primary");
     mAppRequestFrameRates = filterRefreshRates(policy->appRequestRanges, "app request");
+
+    // The cached layer scores are indexed by app request frame rate.
+    mLayerScoresCache.clear();
 }
 
 Fps RefreshRateSelector::findClosestKnownFrameRate(Fps frameRate) const {
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include <ftl/concat.h>
 #include <ftl/optional.h>
@@ -472,6 +474,38 @@ private:
                                                            nsecs_t layerPeriod) const
             REQUIRES(mLock);
 
+    // The score of a layer for one of mAppRequestFrameRates, with and without a seamless switch.
+    struct LayerScore {
+        float seamless;
+        float seamed;
+    };
+
+    // The part of a LayerRequirement that calculateLayerScoreLocked depends on.
+    struct LayerVote {
+        LayerVoteType vote;
+        Fps desiredRefreshRate;
+        FrameRateCategory frameRateCategory;
+
+        bool operator==(const LayerVote& other) const {
+            return vote == other.vote &&
+                    desiredRefreshRate.getValue() == other.desiredRefreshRate.getValue() &&
+                    frameRateCategory == other.frameRateCategory;
+        }
+    };
+
+    struct LayerVoteHash {
+        size_t operator()(const LayerVote& vote) const {
+            return std::hash<float>{}(vote.desiredRefreshRate.getValue()) ^
+                    (static_cast<size_t>(vote.vote) << 8) ^
+                    (static_cast<size_t>(vote.frameRateCategory) << 16);
+        }
+    };
+
+    // Returns the scores of the layer for each of mAppRequestFrameRates, in the same order. They
+    // are only calculated for the votes that weren't seen since mAppRequestFrameRates changed.
+    const std::vector<LayerScore>& getLayerScoresLocked(const LayerRequirement&) const
+            REQUIRES(mLock);
+
     void updateDisplayModes(DisplayModes, DisplayModeId activeModeId) EXCLUDES(mLock)
             REQUIRES(kMainThreadContext);
 
@@ -540,6 +574,12 @@ private:
     };
     mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
 
+    // Scores of the layer votes seen since mAppRequestFrameRates last changed, so that only the
+    // layers whose vote changed are scored again when the ranking is not cached.
+    mutable std::unordered_map<LayerVote, std::vector<LayerScore>, LayerVoteHash> mLayerScoresCache
+            GUARDED_BY(mLock);
+    static constexpr size_t kMaxCachedLayerScores = 64;
+
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
     std::optional<IdleTimerCallbacks> mIdleTimerCallbacks GUARDED_BY(mIdleTimerCallbacksMutex);
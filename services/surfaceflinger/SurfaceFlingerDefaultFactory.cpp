@@ -101,7 +101,12 @@ std::unique_ptr<FrameTracer> DefaultFactory::createFrameTracer() {
 
 std::unique_ptr<frametimeline::FrameTimeline> DefaultFactory::createFrameTimeline(
         std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid) {
-    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid);
+    const frametimeline::JankClassificationThresholds thresholds;
+    constexpr bool kUseBootTimeClock = true;
+    constexpr bool kClassifyJankAsync = true;
+    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid,
+                                                                thresholds, kUseBootTimeClock,
+                                                                kClassifyJankAsync);
 }
 
 } // namespace android::surfaceflinger
@@ -19,15 +19,19 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <android-base/stringprintf.h>
+#include <ftl/match.h>
 #include <log/log.h>
 #include <timestatsatomsproto/TimeStatsAtomsProtoHeader.h>
 #include <utils/String8.h>
 #include <utils/Timers.h>
 #include <utils/Trace.h>
 
+#include <pthread.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <thread>
 #include <unordered_map>
 
 #include "TimeStats.h"
@@ -93,6 +97,7 @@ SurfaceflingerStatsLayerInfo_SetFrameRateVote frameRateVoteToProto(
 
 bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    flushLayerEventsLocked();
 
     if (mTimeStats.statsStartLegacy == 0) {
         return false;
@@ -146,6 +151,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
 
 bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    flushLayerEventsLocked();
 
     std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
     uint32_t numLayers = 0;
@@ -242,10 +248,100 @@ bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     return atomList.SerializeToArray(pulledData->data(), atomList.ByteSizeLong());
 }
 
+struct TimeStats::LayerEvent {
+    struct PostTime {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::string layerName;
+        uid_t uid;
+        nsecs_t postTime;
+        GameMode gameMode;
+    };
+    struct LatchTime {
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t latchTime;
+    };
+    struct LatchSkipped {
+        int32_t layerId;
+        LatchSkipReason reason;
+    };
+    struct BadDesiredPresent {
+        int32_t layerId;
+    };
+    struct DesiredTime {
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t desiredTime;
+    };
+    struct AcquireTime {
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t acquireTime;
+    };
+    struct AcquireFence {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::shared_ptr<FenceTime> acquireFence;
+    };
+    struct PresentTime {
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t presentTime;
+        Fps displayRefreshRate;
+        std::optional<Fps> renderRate;
+        SetFrameRateVote frameRateVote;
+        GameMode gameMode;
+    };
+    struct PresentFence {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::shared_ptr<FenceTime> presentFence;
+        Fps displayRefreshRate;
+        std::optional<Fps> renderRate;
+        SetFrameRateVote frameRateVote;
+        GameMode gameMode;
+    };
+    struct JankyFrames {
+        JankyFramesInfo info;
+    };
+    struct RemoveTimeRecord {
+        int32_t layerId;
+        uint64_t frameNumber;
+    };
+
+    std::variant<PostTime, LatchTime, LatchSkipped, BadDesiredPresent, DesiredTime, AcquireTime,
+                 AcquireFence, PresentTime, PresentFence, JankyFrames, RemoveTimeRecord>
+            event;
+};
+
+// A ring of the events recorded by one thread. Only that thread adds events, and only the thread
+// that holds mMutex takes them out, so each index is only ever written by one side. When the
+// thread exits, the ring passes to the next thread that needs one, after the events left in it
+// are applied.
+struct TimeStats::LayerEventShard {
+    std::thread::id threadId = std::this_thread::get_id();
+    // Cleared by the recording thread as it exits.
+    std::atomic<bool> owned = true;
+    // Set by the recording thread before it adds its first janky frames.
+    std::atomic<bool> recordsJankyFrames = false;
+    // Allocated by the recording thread once it has an event to add, and grown by it when full.
+    // Both happen under mMutex.
+    std::unique_ptr<LayerEvent[]> events;
+    size_t capacity = 0;
+    // Number of events taken out so far.
+    std::atomic<size_t> begin = 0;
+    // Number of events added so far.
+    std::atomic<size_t> end = 0;
+};
+
+static std::atomic<uint64_t> sNextTimeStatsId = 1;
+
 TimeStats::TimeStats() : TimeStats(std::nullopt, std::nullopt) {}
 
 TimeStats::TimeStats(std::optional<size_t> maxPulledLayers,
-                     std::optional<size_t> maxPulledHistogramBuckets) {
+                     std::optional<size_t> maxPulledHistogramBuckets)
+      : mId(sNextTimeStatsId.fetch_add(1, std::memory_order_relaxed)) {
     if (maxPulledLayers) {
         mMaxPulledLayers = *maxPulledLayers;
     }
@@ -253,6 +349,228 @@ TimeStats::TimeStats(std::optional<size_t> maxPulledLayers,
     if (maxPulledHistogramBuckets) {
         mMaxPulledHistogramBuckets = *maxPulledHistogramBuckets;
     }
+
+    mLayerEventsDrainThread = std::thread(&TimeStats::runLayerEventsDrainThread, this);
+    pthread_setname_np(mLayerEventsDrainThread.native_handle(), "TimeStats");
+}
+
+TimeStats::~TimeStats() {
+    {
+        std::scoped_lock lock(mLayerEventsDrainMutex);
+        mLayerEventsDrainThreadDone = true;
+    }
+    mLayerEventsDrainCv.notify_one();
+    mLayerEventsDrainThread.join();
+}
+
+TimeStats::LayerEventShard* TimeStats::layerEventShard() {
+    thread_local struct ThreadShards {
+        ~ThreadShards() {
+            for (const auto& weakShard : shards) {
+                if (const auto shard = weakShard.lock()) {
+                    shard->owned.store(false, std::memory_order_release);
+                }
+            }
+        }
+
+        uint64_t timeStatsId = 0;
+        LayerEventShard* shard = nullptr;
+        // The shards this thread has taken, from any instance.
+        std::vector<std::weak_ptr<LayerEventShard>> shards;
+    } tShards;
+    if (tShards.timeStatsId == mId) {
+        return tShards.shard;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto threadId = std::this_thread::get_id();
+    auto it = std::find_if(mLayerEventShards.begin(), mLayerEventShards.end(),
+                           [threadId](const auto& shard) {
+                               return shard->owned.load(std::memory_order_relaxed) &&
+                                       shard->threadId == threadId;
+                           });
+    if (it == mLayerEventShards.end()) {
+        it = std::find_if(mLayerEventShards.begin(), mLayerEventShards.end(),
+                          [](const auto& shard) {
+                              return !shard->owned.load(std::memory_order_acquire);
+                          });
+        if (it != mLayerEventShards.end()) {
+            // The thread that had this shard has exited. Apply what it left before taking over.
+            flushLayerEventsLocked();
+            (*it)->threadId = threadId;
+            (*it)->recordsJankyFrames.store(false, std::memory_order_relaxed);
+            (*it)->owned.store(true, std::memory_order_relaxed);
+        } else if (mLayerEventShards.size() < MAX_NUM_LAYER_EVENT_SHARDS) {
+            it = mLayerEventShards.insert(mLayerEventShards.end(),
+                                          std::make_shared<LayerEventShard>());
+        }
+        if (it != mLayerEventShards.end()) {
+            tShards.shards.erase(std::remove_if(tShards.shards.begin(), tShards.shards.end(),
+                                                [](const auto& weakShard) {
+                                                    return weakShard.expired();
+                                                }),
+                                 tShards.shards.end());
+            tShards.shards.push_back(*it);
+        }
+    }
+
+    LayerEventShard* shard = it != mLayerEventShards.end() ? it->get() : nullptr;
+    tShards.timeStatsId = mId;
+    tShards.shard = shard;
+    return shard;
+}
+
+void TimeStats::recordLayerEvent(LayerEvent&& layerEvent) {
+    LayerEventShard* shard = layerEventShard();
+    if (!shard) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Keep the event after the ones that were buffered before it.
+        flushLayerEventsLocked();
+        applyLayerEventLocked(layerEvent);
+        return;
+    }
+
+    if (std::holds_alternative<LayerEvent::JankyFrames>(layerEvent.event) &&
+        !shard->recordsJankyFrames.load(std::memory_order_relaxed)) {
+        shard->recordsJankyFrames.store(true, std::memory_order_relaxed);
+    }
+
+    const size_t end = shard->end.load(std::memory_order_relaxed);
+    const size_t pending = end - shard->begin.load(std::memory_order_acquire);
+    if (pending == shard->capacity) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (shard->capacity < MAX_NUM_PENDING_LAYER_EVENTS_PER_THREAD) {
+            growLayerEventShardLocked(*shard);
+        } else {
+            // The drain thread has fallen behind. Apply the events here rather than drop them.
+            flushLayerEventsLocked();
+        }
+    }
+    shard->events[end % shard->capacity] = std::move(layerEvent);
+    shard->end.store(end + 1, std::memory_order_release);
+
+    if (pending + 1 == LAYER_EVENTS_DRAIN_THRESHOLD) {
+        requestLayerEventsDrain();
+    }
+}
+
+void TimeStats::growLayerEventShardLocked(LayerEventShard& shard) {
+    const size_t capacity = shard.capacity == 0 ? MIN_NUM_PENDING_LAYER_EVENTS_PER_THREAD
+                                                : shard.capacity * 2;
+    auto events = std::make_unique<LayerEvent[]>(capacity);
+    // Nothing takes events out while mMutex is held, so the pending ones can move over.
+    const size_t end = shard.end.load(std::memory_order_relaxed);
+    for (size_t i = shard.begin.load(std::memory_order_relaxed); i != end; i++) {
+        events[i % capacity] = std::move(shard.events[i % shard.capacity]);
+    }
+    shard.events = std::move(events);
+    shard.capacity = capacity;
+}
+
+void TimeStats::applyLayerEventsLocked(LayerEventShard& shard, size_t end) {
+    for (size_t i = shard.begin.load(std::memory_order_relaxed); i != end; i++) {
+        // Moving the event out releases the fences it holds.
+        const LayerEvent layerEvent = std::move(shard.events[i % shard.capacity]);
+        applyLayerEventLocked(layerEvent);
+    }
+    shard.begin.store(end, std::memory_order_release);
+}
+
+void TimeStats::flushLayerEventsLocked() {
+    ATRACE_CALL();
+
+    // The janky frames of a present fence are recorded after the presents of its layers, so
+    // reading how far the buffers with janky frames go before reading the others is enough to
+    // have those presents. Then apply the presents first.
+    const size_t numShards = mLayerEventShards.size();
+    std::array<bool, MAX_NUM_LAYER_EVENT_SHARDS> recordsJankyFrames;
+    std::array<size_t, MAX_NUM_LAYER_EVENT_SHARDS> ends;
+    for (size_t i = 0; i < numShards; i++) {
+        recordsJankyFrames[i] =
+                mLayerEventShards[i]->recordsJankyFrames.load(std::memory_order_relaxed);
+        if (recordsJankyFrames[i]) {
+            ends[i] = mLayerEventShards[i]->end.load(std::memory_order_acquire);
+        }
+    }
+    for (size_t i = 0; i < numShards; i++) {
+        if (!recordsJankyFrames[i]) {
+            ends[i] = mLayerEventShards[i]->end.load(std::memory_order_acquire);
+            applyLayerEventsLocked(*mLayerEventShards[i], ends[i]);
+        }
+    }
+    for (size_t i = 0; i < numShards; i++) {
+        if (recordsJankyFrames[i]) {
+            applyLayerEventsLocked(*mLayerEventShards[i], ends[i]);
+        }
+    }
+}
+
+void TimeStats::requestLayerEventsDrain() {
+    {
+        std::scoped_lock lock(mLayerEventsDrainMutex);
+        mLayerEventsDrainRequested = true;
+    }
+    mLayerEventsDrainCv.notify_one();
+}
+
+void TimeStats::runLayerEventsDrainThread() {
+    while (true) {
+        {
+            std::unique_lock lock(mLayerEventsDrainMutex);
+            mLayerEventsDrainCv.wait(lock, [this] {
+                return mLayerEventsDrainThreadDone || mLayerEventsDrainRequested;
+            });
+            if (mLayerEventsDrainThreadDone) {
+                return;
+            }
+            mLayerEventsDrainRequested = false;
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        flushLayerEventsLocked();
+    }
+}
+
+void TimeStats::applyLayerEventLocked(const LayerEvent& layerEvent) {
+    ftl::match(
+            layerEvent.event,
+            [this](const LayerEvent::PostTime& e) {
+                setPostTimeLocked(e.layerId, e.frameNumber, e.layerName, e.uid,
+                                  e.postTime, e.gameMode);
+            },
+            [this](const LayerEvent::LatchTime& e) {
+                setLatchTimeLocked(e.layerId, e.frameNumber, e.latchTime);
+            },
+            [this](const LayerEvent::LatchSkipped& e) {
+                incrementLatchSkippedLocked(e.layerId, e.reason);
+            },
+            [this](const LayerEvent::BadDesiredPresent& e) {
+                incrementBadDesiredPresentLocked(e.layerId);
+            },
+            [this](const LayerEvent::DesiredTime& e) {
+                setDesiredTimeLocked(e.layerId, e.frameNumber, e.desiredTime);
+            },
+            [this](const LayerEvent::AcquireTime& e) {
+                setAcquireTimeLocked(e.layerId, e.frameNumber, e.acquireTime);
+            },
+            [this](const LayerEvent::AcquireFence& e) {
+                setAcquireFenceLocked(e.layerId, e.frameNumber, e.acquireFence);
+            },
+            [this](const LayerEvent::PresentTime& e) {
+                setPresentTimeLocked(e.layerId, e.frameNumber, e.presentTime,
+                                     e.displayRefreshRate, e.renderRate, e.frameRateVote,
+                                     e.gameMode);
+            },
+            [this](const LayerEvent::PresentFence& e) {
+                setPresentFenceLocked(e.layerId, e.frameNumber, e.presentFence,
+                                      e.displayRefreshRate, e.renderRate,
+                                      e.frameRateVote, e.gameMode);
+            },
+            [this](const LayerEvent::JankyFrames& e) {
+                incrementJankyFramesLocked(e.info);
+            },
+            [this](const LayerEvent::RemoveTimeRecord& e) {
+                removeTimeRecordLocked(e.layerId, e.frameNumber);
+            });
 }
 
 bool TimeStats::onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) {
@@ -308,6 +626,7 @@ std::string TimeStats::miniDump() {
 
     std::string result = "TimeStats miniDump:\n";
     std::lock_guard<std::mutex> lock(mMutex);
+    flushLayerEventsLocked();
     android::base::StringAppendF(&result, "Number of layers currently being tracked is %zu\n",
                                  mTimeStatsTracker.size());
     android::base::StringAppendF(&result, "Number of layers in the stats pool is %zu\n",
@@ -441,6 +760,33 @@ static int32_t clampToNearestBucket(Fps fps, size_t bucketWidth) {
     return std::round(fps.getValue() / bucketWidth) * bucketWidth;
 }
 
+TimeStats::LayerStats& TimeStats::layerStatsLocked(
+        LayerRecord& layerRecord, const TimeStatsHelper::TimelineStatsKey& timelineKey,
+        GameMode gameMode) {
+    LayerStats& layerStats = layerRecord.stats;
+    if (layerStats.layer && layerStats.timelineKey == timelineKey &&
+        layerStats.gameMode == gameMode) {
+        return layerStats;
+    }
+
+    TimeStatsHelper::TimelineStats& displayStats = mTimeStats.stats[timelineKey];
+    displayStats.key = timelineKey;
+
+    const auto [it, inserted] =
+            displayStats.stats.try_emplace({layerRecord.uid, layerRecord.layerName, gameMode});
+    TimeStatsHelper::TimeStatsLayer& timeStatsLayer = it->second;
+    if (inserted) {
+        timeStatsLayer.displayRefreshRateBucket = timelineKey.displayRefreshRateBucket;
+        timeStatsLayer.renderRateBucket = timelineKey.renderRateBucket;
+        timeStatsLayer.uid = layerRecord.uid;
+        timeStatsLayer.layerName = layerRecord.layerName;
+        timeStatsLayer.gameMode = gameMode;
+    }
+
+    layerStats = {.timelineKey = timelineKey, .gameMode = gameMode, .layer = &timeStatsLayer};
+    return layerStats;
+}
+
 void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
                                                    std::optional<Fps> renderRate,
                                                    SetFrameRateVote frameRateVote,
@@ -463,27 +809,12 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
               timeRecords[0].frameTime.frameNumber, timeRecords[0].frameTime.presentTime);
 
         if (prevTimeRecord.ready) {
-            uid_t uid = layerRecord.uid;
-            const std::string& layerName = layerRecord.layerName;
-            TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
-            if (!mTimeStats.stats.count(timelineKey)) {
-                mTimeStats.stats[timelineKey].key = timelineKey;
-            }
-
-            TimeStatsHelper::TimelineStats& displayStats = mTimeStats.stats[timelineKey];
-
-            TimeStatsHelper::LayerStatsKey layerKey = {uid, layerName, gameMode};
-            if (!displayStats.stats.count(layerKey)) {
-                displayStats.stats[layerKey].displayRefreshRateBucket = refreshRateBucket;
-                displayStats.stats[layerKey].renderRateBucket = renderRateBucket;
-                displayStats.stats[layerKey].uid = uid;
-                displayStats.stats[layerKey].layerName = layerName;
-                displayStats.stats[layerKey].gameMode = gameMode;
-            }
+            LayerStats& layerStats =
+                    layerStatsLocked(layerRecord, {refreshRateBucket, renderRateBucket}, gameMode);
+            TimeStatsHelper::TimeStatsLayer& timeStatsLayer = *layerStats.layer;
             if (frameRateVote.frameRate > 0.0f) {
-                displayStats.stats[layerKey].setFrameRateVote = frameRateVote;
+                timeStatsLayer.setFrameRateVote = frameRateVote;
             }
-            TimeStatsHelper::TimeStatsLayer& timeStatsLayer = displayStats.stats[layerKey];
             timeStatsLayer.totalFrames++;
             timeStatsLayer.droppedFrames += layerRecord.droppedFrames;
             timeStatsLayer.lateAcquireFrames += layerRecord.lateAcquireFrames;
@@ -497,41 +828,45 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
                                                       timeRecords[0].frameTime.acquireTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2acquire[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, postToAcquireMs);
-            timeStatsLayer.deltas["post2acquire"].insert(postToAcquireMs);
+            layerStats.delta(&LayerStats::postToAcquire, "post2acquire").insert(postToAcquireMs);
 
             const int32_t postToPresentMs = msBetween(timeRecords[0].frameTime.postTime,
                                                       timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, postToPresentMs);
-            timeStatsLayer.deltas["post2present"].insert(postToPresentMs);
+            layerStats.delta(&LayerStats::postToPresent, "post2present").insert(postToPresentMs);
 
             const int32_t acquireToPresentMs = msBetween(timeRecords[0].frameTime.acquireTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-acquire2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, acquireToPresentMs);
-            timeStatsLayer.deltas["acquire2present"].insert(acquireToPresentMs);
+            layerStats.delta(&LayerStats::acquireToPresent, "acquire2present")
+                    .insert(acquireToPresentMs);
 
             const int32_t latchToPresentMs = msBetween(timeRecords[0].frameTime.latchTime,
                                                        timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-latch2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, latchToPresentMs);
-            timeStatsLayer.deltas["latch2present"].insert(latchToPresentMs);
+            layerStats.delta(&LayerStats::latchToPresent, "latch2present").insert(latchToPresentMs);
 
             const int32_t desiredToPresentMs = msBetween(timeRecords[0].frameTime.desiredTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-desired2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, desiredToPresentMs);
-            timeStatsLayer.deltas["desired2present"].insert(desiredToPresentMs);
+            layerStats.delta(&LayerStats::desiredToPresent, "desired2present")
+                    .insert(desiredToPresentMs);
 
             const int32_t presentToPresentMs = msBetween(prevTimeRecord.frameTime.presentTime,
                                                          timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-present2present[%d]", layerId,
                   timeRecords[0].frameTime.frameNumber, presentToPresentMs);
-            timeStatsLayer.deltas["present2present"].insert(presentToPresentMs);
+            layerStats.delta(&LayerStats::presentToPresent, "present2present")
+                    .insert(presentToPresentMs);
             if (prevPresentToPresentMs) {
                 const int32_t presentToPresentDeltaMs =
                         std::abs(presentToPresentMs - *prevPresentToPresentMs);
-                timeStatsLayer.deltas["present2presentDelta"].insert(presentToPresentDeltaMs);
+                layerStats.delta(&LayerStats::presentToPresentDelta, "present2presentDelta")
+                        .insert(presentToPresentDeltaMs);
             }
             prevPresentToPresentMs = presentToPresentMs;
         }
@@ -554,14 +889,17 @@ bool TimeStats::canAddNewAggregatedStats(uid_t uid, const std::string& layerName
                                          GameMode gameMode) {
     uint32_t layerRecords = 0;
     for (const auto& record : mTimeStats.stats) {
-        if (record.second.stats.count({uid, layerName, gameMode}) > 0) {
-            return true;
-        }
-
         layerRecords += record.second.stats.size();
     }
+    if (layerRecords < MAX_NUM_LAYER_STATS) {
+        return true;
+    }
 
-    return layerRecords < MAX_NUM_LAYER_STATS;
+    // Only look for the layer once the stats are full, as that copies its name.
+    const TimeStatsHelper::LayerStatsKey layerKey = {uid, layerName, gameMode};
+    return std::any_of(mTimeStats.stats.begin(), mTimeStats.stats.end(), [&](const auto& record) {
+        return record.second.stats.count(layerKey) > 0;
+    });
 }
 
 void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::string& layerName,
@@ -569,25 +907,34 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::PostTime{layerId, frameNumber, layerName, uid, postTime,
+                                           gameMode}});
+}
+
+void TimeStats::setPostTimeLocked(int32_t layerId, uint64_t frameNumber,
+                                  const std::string& layerName, uid_t uid, nsecs_t postTime,
+                                  GameMode gameMode) {
     ALOGV("[%d]-[%" PRIu64 "]-[%s]-PostTime[%" PRId64 "]", layerId, frameNumber, layerName.c_str(),
           postTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
         return;
     }
-    if (!mTimeStatsTracker.count(layerId) && mTimeStatsTracker.size() < MAX_NUM_LAYER_RECORDS &&
-        layerNameIsValid(layerName)) {
-        mTimeStatsTracker[layerId].uid = uid;
-        mTimeStatsTracker[layerId].layerName = layerName;
-        mTimeStatsTracker[layerId].gameMode = gameMode;
+    auto it = mTimeStatsTracker.find(layerId);
+    if (it == mTimeStatsTracker.end()) {
+        if (mTimeStatsTracker.size() == MAX_NUM_LAYER_RECORDS || !layerNameIsValid(layerName)) {
+            return;
+        }
+        it = mTimeStatsTracker.try_emplace(layerId).first;
+        it->second.uid = uid;
+        it->second.layerName = layerName;
+        it->second.gameMode = gameMode;
     }
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.timeRecords.size() == MAX_NUM_TIME_RECORDS) {
         ALOGE("[%d]-[%s]-timeRecords is at its maximum size[%zu]. Ignore this when unittesting.",
               layerId, layerRecord.layerName.c_str(), MAX_NUM_TIME_RECORDS);
-        mTimeStatsTracker.erase(layerId);
+        mTimeStatsTracker.erase(it);
         return;
     }
     // For most media content, the acquireFence is invalid because the buffer is
@@ -613,9 +960,12 @@ void TimeStats::setLatchTime(int32_t layerId, uint64_t frameNumber, nsecs_t latc
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::LatchTime{layerId, frameNumber, latchTime}});
+}
+
+void TimeStats::setLatchTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t latchTime) {
     ALOGV("[%d]-[%" PRIu64 "]-LatchTime[%" PRId64 "]", layerId, frameNumber, latchTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -631,10 +981,13 @@ void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::LatchSkipped{layerId, reason}});
+}
+
+void TimeStats::incrementLatchSkippedLocked(int32_t layerId, LatchSkipReason reason) {
     ALOGV("[%d]-LatchSkipped-Reason[%d]", layerId,
           static_cast<std::underlying_type<LatchSkipReason>::type>(reason));
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
 
@@ -649,9 +1002,12 @@ void TimeStats::incrementBadDesiredPresent(int32_t layerId) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::BadDesiredPresent{layerId}});
+}
+
+void TimeStats::incrementBadDesiredPresentLocked(int32_t layerId) {
     ALOGV("[%d]-BadDesiredPresent", layerId);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     layerRecord.badDesiredPresentFrames++;
@@ -661,9 +1017,13 @@ void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t de
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::DesiredTime{layerId, frameNumber, desiredTime}});
+}
+
+void TimeStats::setDesiredTimeLocked(int32_t layerId, uint64_t frameNumber,
+                                     nsecs_t desiredTime) {
     ALOGV("[%d]-[%" PRIu64 "]-DesiredTime[%" PRId64 "]", layerId, frameNumber, desiredTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -679,9 +1039,13 @@ void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t ac
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::AcquireTime{layerId, frameNumber, acquireTime}});
+}
+
+void TimeStats::setAcquireTimeLocked(int32_t layerId, uint64_t frameNumber,
+                                     nsecs_t acquireTime) {
     ALOGV("[%d]-[%" PRIu64 "]-AcquireTime[%" PRId64 "]", layerId, frameNumber, acquireTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -698,10 +1062,14 @@ void TimeStats::setAcquireFence(int32_t layerId, uint64_t frameNumber,
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::AcquireFence{layerId, frameNumber, acquireFence}});
+}
+
+void TimeStats::setAcquireFenceLocked(int32_t layerId, uint64_t frameNumber,
+                                      const std::shared_ptr<FenceTime>& acquireFence) {
     ALOGV("[%d]-[%" PRIu64 "]-AcquireFenceTime[%" PRId64 "]", layerId, frameNumber,
           acquireFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -719,9 +1087,16 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::PresentTime{layerId, frameNumber, presentTime,
+                                              displayRefreshRate, renderRate, frameRateVote,
+                                              gameMode}});
+}
+
+void TimeStats::setPresentTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t presentTime,
+                                     Fps displayRefreshRate, std::optional<Fps> renderRate,
+                                     SetFrameRateVote frameRateVote, GameMode gameMode) {
     ALOGV("[%d]-[%" PRIu64 "]-PresentTime[%" PRId64 "]", layerId, frameNumber, presentTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -745,10 +1120,18 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::PresentFence{layerId, frameNumber, presentFence,
+                                               displayRefreshRate, renderRate, frameRateVote,
+                                               gameMode}});
+}
+
+void TimeStats::setPresentFenceLocked(int32_t layerId, uint64_t frameNumber,
+                                      const std::shared_ptr<FenceTime>& presentFence,
+                                      Fps displayRefreshRate, std::optional<Fps> renderRate,
+                                      SetFrameRateVote frameRateVote, GameMode gameMode) {
     ALOGV("[%d]-[%" PRIu64 "]-PresentFenceTime[%" PRId64 "]", layerId, frameNumber,
           presentFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     if (layerRecord.waitData < 0 ||
@@ -806,8 +1189,10 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
+    recordLayerEvent({LayerEvent::JankyFrames{info}});
+}
 
+void TimeStats::incrementJankyFramesLocked(const JankyFramesInfo& info) {
     // Only update layer stats if we're already tracking the layer in TimeStats.
     // Otherwise, continue tracking the statistic but use a default layer name instead.
     // As an implementation detail, we do this because this method is expected to be
@@ -829,25 +1214,22 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
                                  RENDER_RATE_BUCKET_WIDTH);
     const TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
 
-    if (!mTimeStats.stats.count(timelineKey)) {
-        mTimeStats.stats[timelineKey].key = timelineKey;
-    }
-
     TimeStatsHelper::TimelineStats& timelineStats = mTimeStats.stats[timelineKey];
+    timelineStats.key = timelineKey;
 
     updateJankPayload<TimeStatsHelper::TimelineStats>(timelineStats, info.reasons);
 
-    TimeStatsHelper::LayerStatsKey layerKey = {info.uid, info.layerName, info.gameMode};
-    if (!timelineStats.stats.count(layerKey)) {
-        layerKey = {info.uid, kDefaultLayerName, kDefaultGameMode};
-        timelineStats.stats[layerKey].displayRefreshRateBucket = refreshRateBucket;
-        timelineStats.stats[layerKey].renderRateBucket = renderRateBucket;
-        timelineStats.stats[layerKey].uid = info.uid;
-        timelineStats.stats[layerKey].layerName = kDefaultLayerName;
-        timelineStats.stats[layerKey].gameMode = kDefaultGameMode;
+    auto it = timelineStats.stats.find({info.uid, info.layerName, info.gameMode});
+    if (it == timelineStats.stats.end()) {
+        it = timelineStats.stats.try_emplace({info.uid, kDefaultLayerName, kDefaultGameMode}).first;
+        it->second.displayRefreshRateBucket = refreshRateBucket;
+        it->second.renderRateBucket = renderRateBucket;
+        it->second.uid = info.uid;
+        it->second.layerName = kDefaultLayerName;
+        it->second.gameMode = kDefaultGameMode;
     }
 
-    TimeStatsHelper::TimeStatsLayer& timeStatsLayer = timelineStats.stats[layerKey];
+    TimeStatsHelper::TimeStatsLayer& timeStatsLayer = it->second;
     updateJankPayload<TimeStatsHelper::TimeStatsLayer>(timeStatsLayer, info.reasons);
 
     if (info.reasons & kValidJankyReason) {
@@ -864,6 +1246,8 @@ void TimeStats::onDestroy(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-onDestroy", layerId);
     std::lock_guard<std::mutex> lock(mMutex);
+    // Apply the events of the layer first, so that they don't add its record back.
+    flushLayerEventsLocked();
     mTimeStatsTracker.erase(layerId);
 }
 
@@ -871,9 +1255,12 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
+    recordLayerEvent({LayerEvent::RemoveTimeRecord{layerId, frameNumber}});
+}
+
+void TimeStats::removeTimeRecordLocked(int32_t layerId, uint64_t frameNumber) {
     ALOGV("[%d]-[%" PRIu64 "]-removeTimeRecord", layerId, frameNumber);
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     size_t removeAt = 0;
@@ -1045,6 +1432,7 @@ void TimeStats::disable() {
 
 void TimeStats::clearAll() {
     std::lock_guard<std::mutex> lock(mMutex);
+    flushLayerEventsLocked();
     mTimeStats.stats.clear();
     clearGlobalLocked();
     clearLayersLocked();
@@ -1096,6 +1484,7 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
     ATRACE_CALL();
 
     std::lock_guard<std::mutex> lock(mMutex);
+    flushLayerEventsLocked();
     if (mTimeStats.statsStartLegacy == 0) {
         return;
     }
@@ -16,12 +16,16 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include <android/hardware/graphics/composer/2.4/IComposerClient.h>
 #include <gui/JankInfo.h>
@@ -204,6 +208,30 @@ class TimeStats : public android::TimeStats {
         std::shared_ptr<FenceTime> presentFence;
     };
 
+    // The stats that the frames of a layer were last added to, so that they are not looked up
+    // again for every frame. Layer stats are only ever removed along with the layer records.
+    struct LayerStats {
+        TimeStatsHelper::TimelineStatsKey timelineKey;
+        GameMode gameMode = GameMode::Unsupported;
+        TimeStatsHelper::TimeStatsLayer* layer = nullptr;
+        // Histograms of layer->deltas, added on first use.
+        TimeStatsHelper::Histogram* postToAcquire = nullptr;
+        TimeStatsHelper::Histogram* postToPresent = nullptr;
+        TimeStatsHelper::Histogram* acquireToPresent = nullptr;
+        TimeStatsHelper::Histogram* latchToPresent = nullptr;
+        TimeStatsHelper::Histogram* desiredToPresent = nullptr;
+        TimeStatsHelper::Histogram* presentToPresent = nullptr;
+        TimeStatsHelper::Histogram* presentToPresentDelta = nullptr;
+
+        TimeStatsHelper::Histogram& delta(TimeStatsHelper::Histogram* LayerStats::*histogram,
+                                          const char* name) {
+            if (!(this->*histogram)) {
+                this->*histogram = &layer->deltas[name];
+            }
+            return *(this->*histogram);
+        }
+    };
+
     struct LayerRecord {
         uid_t uid;
         std::string layerName;
@@ -218,6 +246,7 @@ class TimeStats : public android::TimeStats {
         TimeRecord prevTimeRecord;
         std::optional<int32_t> prevPresentToPresentMs;
         std::deque<TimeRecord> timeRecords;
+        LayerStats stats;
     };
 
     struct PowerTime {
@@ -241,6 +270,7 @@ public:
     // For testing only for injecting custom dependencies.
     TimeStats(std::optional<size_t> maxPulledLayers,
               std::optional<size_t> maxPulledHistogramBuckets);
+    ~TimeStats() override;
 
     bool onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) override;
     void parseArgs(bool asProto, const Vector<String16>& args, std::string& result) override;
@@ -289,9 +319,61 @@ public:
     static const size_t MAX_NUM_TIME_RECORDS = 64;
 
 private:
+    // Layer events are recorded without taking mMutex, into a buffer that belongs to the recording
+    // thread. A drain thread applies them to mTimeStatsTracker under mMutex once a buffer holds
+    // LAYER_EVENTS_DRAIN_THRESHOLD events, and the stats readers apply what is left before reading.
+    // The main thread records about six events per layer per frame, so with a hundred layers it
+    // wakes the drain thread a couple of times per frame, and does not aggregate anything itself.
+    //
+    // Buffers start small and grow while their thread records many events between reads. At most
+    // MAX_NUM_LAYER_EVENT_SHARDS threads have one at a time. Any other thread applies its events
+    // right away, under mMutex, after the events buffered so far. The buffer of a thread that exits
+    // goes to the next thread that needs one. A thread whose buffer is full because the drain
+    // thread fell behind applies the pending events itself, rather than drop them.
+    //
+    // Events from a given thread are applied in the order they were recorded. Across threads,
+    // only janky frames need an order: FrameTimeline may report them from its present thread, once
+    // the present fence of the frame has signaled, and they are filed under the layer only if its
+    // present has been applied by then. So the buffers of threads that report janky frames are
+    // applied after the others.
+    struct LayerEvent;
+    struct LayerEventShard;
+
+    // Returns null if the calling thread has no buffer.
+    LayerEventShard* layerEventShard();
+    void recordLayerEvent(LayerEvent&& layerEvent);
+    void growLayerEventShardLocked(LayerEventShard& shard);
+    void applyLayerEventLocked(const LayerEvent& layerEvent);
+    void applyLayerEventsLocked(LayerEventShard& shard, size_t end);
+    void flushLayerEventsLocked();
+    void requestLayerEventsDrain();
+    void runLayerEventsDrainThread();
+
+    void setPostTimeLocked(int32_t layerId, uint64_t frameNumber, const std::string& layerName,
+                           uid_t uid, nsecs_t postTime, GameMode);
+    void setLatchTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t latchTime);
+    void incrementLatchSkippedLocked(int32_t layerId, LatchSkipReason reason);
+    void incrementBadDesiredPresentLocked(int32_t layerId);
+    void setDesiredTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t desiredTime);
+    void setAcquireTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t acquireTime);
+    void setAcquireFenceLocked(int32_t layerId, uint64_t frameNumber,
+                               const std::shared_ptr<FenceTime>& acquireFence);
+    void setPresentTimeLocked(int32_t layerId, uint64_t frameNumber, nsecs_t presentTime,
+                              Fps displayRefreshRate, std::optional<Fps> renderRate,
+                              SetFrameRateVote, GameMode);
+    void setPresentFenceLocked(int32_t layerId, uint64_t frameNumber,
+                               const std::shared_ptr<FenceTime>& presentFence,
+                               Fps displayRefreshRate, std::optional<Fps> renderRate,
+                               SetFrameRateVote, GameMode);
+    void incrementJankyFramesLocked(const JankyFramesInfo& info);
+    void removeTimeRecordLocked(int32_t layerId, uint64_t frameNumber);
+
     bool populateGlobalAtom(std::vector<uint8_t>* pulledData);
     bool populateLayerAtom(std::vector<uint8_t>* pulledData);
     bool recordReadyLocked(int32_t layerId, TimeRecord* timeRecord);
+    LayerStats& layerStatsLocked(
+            LayerRecord& layerRecord, const TimeStatsHelper::TimelineStatsKey& timelineKey,
+            GameMode gameMode);
     void flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
                                             std::optional<Fps> renderRate, SetFrameRateVote,
                                             GameMode);
@@ -307,14 +389,27 @@ private:
     void dump(bool asProto, std::optional<uint32_t> maxLayers, std::string& result);
 
     std::atomic<bool> mEnabled = false;
+    // Tells instances apart in the per-thread lookup of layer event shards.
+    const uint64_t mId;
     std::mutex mMutex;
     TimeStatsHelper::TimeStatsGlobal mTimeStats;
     // Hashmap for LayerRecord with layerId as the hash key
     std::unordered_map<int32_t, LayerRecord> mTimeStatsTracker;
     PowerTime mPowerTime;
     GlobalRecord mGlobalRecord;
+    std::vector<std::shared_ptr<LayerEventShard>> mLayerEventShards;
+
+    std::mutex mLayerEventsDrainMutex;
+    std::condition_variable mLayerEventsDrainCv;
+    bool mLayerEventsDrainRequested = false;
+    bool mLayerEventsDrainThreadDone = false;
+    std::thread mLayerEventsDrainThread;
 
     static const size_t MAX_NUM_LAYER_RECORDS = 200;
+    static const size_t MIN_NUM_PENDING_LAYER_EVENTS_PER_THREAD = 16;
+    static const size_t MAX_NUM_PENDING_LAYER_EVENTS_PER_THREAD = 512;
+    static const size_t MAX_NUM_LAYER_EVENT_SHARDS = 4;
+    static const size_t LAYER_EVENTS_DRAIN_THRESHOLD = MAX_NUM_PENDING_LAYER_EVENTS_PER_THREAD / 2;
 
     static const size_t REFRESH_RATE_BUCKET_WIDTH = 30;
     static const size_t RENDER_RATE_BUCKET_WIDTH = REFRESH_RATE_BUCKET_WIDTH;
@@ -24,36 +24,78 @@
 #include <utils/Timers.h>
 #include <utils/Trace.h>
 #include <chrono>
+#include <cstring>
 #include <fstream>
-#include <queue>
+#include <memory>
+#include <string_view>
 
 namespace android {
 
 class SurfaceFlinger;
 
+/*
+ * Keeps the most recent serialized trace entries in a single preallocated block of memory.
+ *
+ * Each entry is stored as a fixed-size header followed by the serialized proto, and entries are
+ * written one after the other, wrapping around to the start of the block when they reach its
+ * end. When there is no room left for a new entry, the oldest entries are overwritten. The headers
+ * carry the vsync id and timestamp of the entries, so that they can be looked at without parsing
+ * the protos, which only happens when the buffer is written out.
+ */
 template <typename FileProto, typename EntryProto>
 class TransactionRingBuffer {
 public:
+    struct EntryHeader {
+        // Size of the serialized proto that follows, or WRAP_MARKER if the next entry is at the
+        // start of the block.
+        uint32_t size;
+        uint32_t reserved;
+        int64_t vsyncId;
+        int64_t timestamp;
+    };
+
     size_t size() const { return mSizeInBytes; }
     size_t used() const { return mUsedInBytes; }
-    size_t frameCount() const { return mStorage.size(); }
-    void setSize(size_t newSize) { mSizeInBytes = newSize; }
-    const std::string& front() const { return mStorage.front(); }
-    const std::string& back() const { return mStorage.back(); }
+    size_t frameCount() const { return mFrameCount; }
+    std::string front() const { return std::string(payload(mFrontOffset)); }
+    std::string back() const { return std::string(payload(mBackOffset)); }
+    int64_t backVsyncId() const { return header(mBackOffset).vsyncId; }
+
+    // Resizes the buffer, keeping as many of the most recent entries as fit. The entries that
+    // don't are passed to onEvicted, oldest first.
+    template <typename F>
+    void setSize(size_t newSize, F&& onEvicted) {
+        newSize -= newSize % ALIGNMENT;
+        if (newSize == mSizeInBytes) {
+            return;
+        }
+        TransactionRingBuffer resized;
+        resized.mSizeInBytes = newSize;
+        forEachEntry([&](const EntryHeader& entryHeader, std::string_view entry) {
+            resized.append(entryHeader, entry, onEvicted);
+        });
+        *this = std::move(resized);
+    }
+    void setSize(size_t newSize) {
+        setSize(newSize, [](const EntryProto&) {});
+    }
 
     void reset() {
-        // use the swap trick to make sure memory is released
-        std::deque<std::string>().swap(mStorage);
+        mStorage.reset();
         mUsedInBytes = 0U;
+        mFrameCount = 0U;
+        mFrontOffset = 0U;
+        mBackOffset = 0U;
+        mEndOffset = 0U;
     }
 
     void writeToProto(FileProto& fileProto) const {
-        fileProto.mutable_entry()->Reserve(static_cast<int>(mStorage.size()) +
+        fileProto.mutable_entry()->Reserve(static_cast<int>(mFrameCount) +
                                            fileProto.entry().size());
-        for (const std::string& entry : mStorage) {
+        forEachEntry([&](const EntryHeader&, std::string_view entry) {
             EntryProto* entryProto = fileProto.add_entry();
-            entryProto->ParseFromString(entry);
-        }
+            entryProto->ParseFromArray(entry.data(), static_cast<int>(entry.size()));
+        });
     }
 
     status_t appendToStream(FileProto& fileProto, std::ofstream& out) {
@@ -69,35 +111,32 @@ public:
         return NO_ERROR;
     }
 
-    std::vector<std::string> emplace(std::string&& serializedProto) {
-        std::vector<std::string> replacedEntries;
-        size_t protoSize = static_cast<size_t>(serializedProto.size());
-        while (mUsedInBytes + protoSize > mSizeInBytes) {
-            if (mStorage.empty()) {
-                return {};
-            }
-            mUsedInBytes -= static_cast<size_t>(mStorage.front().size());
-            replacedEntries.emplace_back(mStorage.front());
-            mStorage.pop_front();
+    // Serializes the proto into the buffer, overwriting the oldest entries if needed. The entries
+    // that get overwritten are passed to onEvicted, oldest first. Returns the serialized proto as
+    // stored in the buffer, which stays valid until the buffer is next modified, or an empty view
+    // if the proto is larger than the whole buffer. Such a proto evicts every entry, and is then
+    // passed to onEvicted itself.
+    template <typename F>
+    std::string_view emplace(const EntryProto& proto, F&& onEvicted) {
+        const size_t protoSize = proto.ByteSizeLong();
+        const EntryHeader entryHeader{.size = static_cast<uint32_t>(protoSize),
+                                      .reserved = 0,
+                                      .vsyncId = proto.vsync_id(),
+                                      .timestamp = proto.elapsed_realtime_nanos()};
+        uint8_t* data = reserve(entryHeader, onEvicted);
+        if (data == nullptr) {
+            onEvicted(proto);
+            return {};
         }
-        mUsedInBytes += protoSize;
-        mStorage.emplace_back(serializedProto);
-        return replacedEntries;
-    }
-
-    std::vector<std::string> emplace(EntryProto&& proto) {
-        std::string serializedProto;
-        proto.SerializeToString(&serializedProto);
-        return emplace(std::move(serializedProto));
+        proto.SerializeWithCachedSizesToArray(data);
+        return {reinterpret_cast<const char*>(data), protoSize};
     }
 
     void dump(std::string& result) const {
         std::chrono::milliseconds duration(0);
         if (frameCount() > 0) {
-            EntryProto entry;
-            entry.ParseFromString(mStorage.front());
             duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::nanoseconds(systemTime() - entry.elapsed_realtime_nanos()));
+                    std::chrono::nanoseconds(systemTime() - header(mFrontOffset).timestamp));
         }
         const int64_t durationCount = duration.count();
         base::StringAppendF(&result,
@@ -107,9 +146,133 @@ public:
     }
 
 private:
+    static constexpr uint32_t WRAP_MARKER = UINT32_MAX;
+    static constexpr size_t ALIGNMENT = alignof(EntryHeader);
+
+    static size_t entrySize(const EntryHeader& entryHeader) {
+        const size_t size = sizeof(EntryHeader) + entryHeader.size;
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    const EntryHeader& header(size_t offset) const {
+        return *reinterpret_cast<const EntryHeader*>(mStorage.get() + offset);
+    }
+
+    std::string_view payload(size_t offset) const {
+        return {reinterpret_cast<const char*>(mStorage.get() + offset + sizeof(EntryHeader)),
+                header(offset).size};
+    }
+
+    // Entries that would run past the end of the block start at its beginning instead, either
+    // because there is no room left for a header or because a wrap marker says so.
+    size_t wrap(size_t offset) const {
+        if (mSizeInBytes - offset < sizeof(EntryHeader) || header(offset).size == WRAP_MARKER) {
+            return 0;
+        }
+        return offset;
+    }
+
+    template <typename F>
+    void forEachEntry(F&& f) const {
+        size_t offset = mFrontOffset;
+        for (size_t i = 0; i < mFrameCount; i++) {
+            offset = wrap(offset);
+            f(header(offset), payload(offset));
+            offset += entrySize(header(offset));
+        }
+    }
+
+    template <typename F>
+    void evictFront(F& onEvicted) {
+        const EntryHeader& entryHeader = header(mFrontOffset);
+        EntryProto entry;
+        entry.ParseFromArray(mStorage.get() + mFrontOffset + sizeof(EntryHeader),
+                             static_cast<int>(entryHeader.size));
+        onEvicted(entry);
+
+        mUsedInBytes -= entrySize(entryHeader);
+        mFrontOffset += entrySize(entryHeader);
+        if (--mFrameCount == 0) {
+            mFrontOffset = mBackOffset = mEndOffset = 0U;
+        } else {
+            mFrontOffset = wrap(mFrontOffset);
+        }
+    }
+
+    // Makes room for an entry and writes its header. Returns where its payload goes, or null if
+    // the entry is larger than the whole buffer. The entry is then evicted by the caller, after
+    // all of the older entries, so that onEvicted still sees every entry in order.
+    template <typename F>
+    uint8_t* reserve(const EntryHeader& entryHeader, F& onEvicted) {
+        const size_t size = entrySize(entryHeader);
+        if (size > mSizeInBytes) {
+            while (mFrameCount > 0) {
+                evictFront(onEvicted);
+            }
+            return nullptr;
+        }
+        if (!mStorage) {
+            mStorage.reset(new uint8_t[mSizeInBytes]);
+        }
+
+        size_t offset;
+        while (true) {
+            if (mFrameCount == 0) {
+                offset = 0;
+                break;
+            }
+            const bool wrapped = mFrontOffset >= mEndOffset;
+            if (!wrapped && mEndOffset + size <= mSizeInBytes) {
+                offset = mEndOffset;
+                break;
+            }
+            if (!wrapped && size <= mFrontOffset) {
+                if (mSizeInBytes - mEndOffset >= sizeof(EntryHeader)) {
+                    reinterpret_cast<EntryHeader*>(mStorage.get() + mEndOffset)->size =
+                            WRAP_MARKER;
+                }
+                offset = 0;
+                break;
+            }
+            if (wrapped && mEndOffset + size <= mFrontOffset) {
+                offset = mEndOffset;
+                break;
+            }
+            evictFront(onEvicted);
+        }
+
+        if (mFrameCount == 0) {
+            mFrontOffset = offset;
+        }
+        std::memcpy(mStorage.get() + offset, &entryHeader, sizeof(EntryHeader));
+        mBackOffset = offset;
+        mEndOffset = offset + size;
+        mUsedInBytes += size;
+        mFrameCount++;
+        return mStorage.get() + offset + sizeof(EntryHeader);
+    }
+
+    template <typename F>
+    void append(const EntryHeader& entryHeader, std::string_view entry, F& onEvicted) {
+        if (uint8_t* data = reserve(entryHeader, onEvicted)) {
+            std::memcpy(data, entry.data(), entry.size());
+        } else {
+            EntryProto evicted;
+            evicted.ParseFromArray(entry.data(), static_cast<int>(entry.size()));
+            onEvicted(evicted);
+        }
+    }
+
     size_t mUsedInBytes = 0U;
     size_t mSizeInBytes = 0U;
-    std::deque<std::string> mStorage;
+    size_t mFrameCount = 0U;
+    // Offsets in mStorage of the oldest and newest entries, and of the end of the newest one.
+    size_t mFrontOffset = 0U;
+    size_t mBackOffset = 0U;
+    size_t mEndOffset = 0U;
+    // Allocated when the first entry is added, and not initialized, so that pages only become
+    // resident as the buffer fills up.
+    std::unique_ptr<uint8_t[]> mStorage;
 };
 
 } // namespace android
@@ -144,7 +144,10 @@ perfetto::protos::TransactionTraceFile TransactionTracing::writeToProto() {
 
 void TransactionTracing::setBufferSize(size_t bufferSizeInBytes) {
     std::scoped_lock lock(mTraceLock);
-    mBuffer.setSize(bufferSizeInBytes);
+    mBuffer.setSize(bufferSizeInBytes, [this](const auto& removedEntry) {
+        base::ScopedLockAssertion assumeLocked(mTraceLock);
+        updateStartingStateLocked(removedEntry);
+    });
 }
 
 perfetto::protos::TransactionTraceFile TransactionTracing::createTraceFileProto() const {
@@ -229,12 +232,11 @@ void TransactionTracing::loop() {
 void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committedUpdates,
                                   const std::vector<uint32_t>& destroyedLayers) {
     std::scoped_lock lock(mTraceLock);
-    std::vector<std::string> removedEntries;
     perfetto::protos::TransactionTraceEntry entryProto;
 
     while (auto incomingTransaction = mTransactionQueue.pop()) {
-        auto transaction = *incomingTransaction;
-        mQueuedTransactions[incomingTransaction->transaction_id()] = transaction;
+        mQueuedTransactions[incomingTransaction->transaction_id()] =
+                std::move(*incomingTransaction);
         delete incomingTransaction;
     }
     for (const CommittedUpdates& update : committedUpdates) {
@@ -280,8 +282,19 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
             }
         }
 
-        std::string serializedProto;
-        entryProto.SerializeToString(&serializedProto);
+        // Serialize the entry straight into the ring buffer. An entry that is too large for the
+        // whole buffer goes straight to the starting state, after everything in the buffer, and
+        // needs a copy of its own to still be written to perfetto.
+        std::string_view serializedProto =
+                mBuffer.emplace(entryProto, [this](const auto& removedEntry) {
+                    base::ScopedLockAssertion assumeLocked(mTraceLock);
+                    updateStartingStateLocked(removedEntry);
+                });
+        std::string oversizedProto;
+        if (serializedProto.empty()) {
+            entryProto.SerializeToString(&oversizedProto);
+            serializedProto = oversizedProto;
+        }
 
         TransactionDataSource::Trace([&](TransactionDataSource::TraceContext context) {
             // In "active" mode write each committed transaction to perfetto.
@@ -304,20 +317,9 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
             }
         });
 
-        std::vector<std::string> entries = mBuffer.emplace(std::move(serializedProto));
-        removedEntries.reserve(removedEntries.size() + entries.size());
-        removedEntries.insert(removedEntries.end(), std::make_move_iterator(entries.begin()),
-                              std::make_move_iterator(entries.end()));
-
         entryProto.Clear();
     }
 
-    perfetto::protos::TransactionTraceEntry removedEntryProto;
-    for (const std::string& removedEntry : removedEntries) {
-        removedEntryProto.ParseFromString(removedEntry);
-        updateStartingStateLocked(removedEntryProto);
-        removedEntryProto.Clear();
-    }
     mTransactionsAddedToBufferCv.notify_one();
 }
 
@@ -337,12 +339,9 @@ void TransactionTracing::flush() {
     base::ScopedLockAssertion assumeLocked(mTraceLock);
     mTransactionsAddedToBufferCv.wait_for(lock, std::chrono::milliseconds(100),
                                           [&]() REQUIRES(mTraceLock) {
-                                              perfetto::protos::TransactionTraceEntry entry;
-                                              if (mBuffer.used() > 0) {
-                                                  entry.ParseFromString(mBuffer.back());
-                                              }
-                                              return mBuffer.used() > 0 &&
-                                                      entry.vsync_id() >= mLastUpdatedVsyncId;
+                                              return mBuffer.frameCount() > 0 &&
+                                                      mBuffer.backVsyncId() >=
+                                                      mLastUpdatedVsyncId;
                                           });
 }
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ui/ShadowSettings.h>
+
+#include <memory>
+#include <vector>
+
+#include "Client.h" // temporarily needed for LayerCreationArgs
+#include "FrontEnd/LayerCreationArgs.h"
+#include "FrontEnd/LayerHierarchy.h"
+#include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/LayerSnapshotBuilder.h"
+#include "TransactionState.h"
+
+namespace android::surfaceflinger::frontend {
+namespace {
+
+constexpr uint32_t kLayersPerTask = 10;
+constexpr size_t kTraceFrames = 120;
+
+// Builds a desktop-like hierarchy of task roots with kLayersPerTask children each, and replays a
+// trace where every frame moves one leaf layer, which is what a window drag or an animating view
+// looks like to the builder.
+class SnapshotBuilderReplay {
+public:
+    explicit SnapshotBuilderReplay(uint32_t layerCount) {
+        std::vector<std::unique_ptr<RequestedLayerState>> layers;
+        uint32_t id = 1;
+        for (uint32_t task = 0; task < layerCount / kLayersPerTask; task++) {
+            const uint32_t taskId = id++;
+            layers.emplace_back(createLayer(taskId, /*canBeRoot=*/true, UNASSIGNED_LAYER_ID));
+            for (uint32_t child = 1; child < kLayersPerTask; child++) {
+                const uint32_t childId = id++;
+                layers.emplace_back(createLayer(childId, /*canBeRoot=*/false, taskId));
+                mLeafIds.push_back(childId);
+            }
+        }
+        mLifecycleManager.addLayers(std::move(layers));
+        mHierarchyBuilder.update(mLifecycleManager.getLayers(),
+                                 mLifecycleManager.getDestroyedLayers());
+        mSnapshotBuilder.update(makeArgs(LayerSnapshotBuilder::ForceUpdateFlags::ALL));
+        mLifecycleManager.commitChanges();
+
+        for (size_t frame = 0; frame < kTraceFrames; frame++) {
+            TransactionState transaction;
+            transaction.states.push_back({});
+            auto& state = transaction.states.back();
+            state.layerId = mLeafIds[(frame * 7) % mLeafIds.size()];
+            state.state.what = layer_state_t::ePositionChanged;
+            state.state.x = static_cast<float>(frame);
+            state.state.y = static_cast<float>(frame);
+            mTrace.push_back({transaction});
+        }
+    }
+
+    // Applies the next frame of the trace and returns the args for the builder update.
+    LayerSnapshotBuilder::Args nextFrame(LayerSnapshotBuilder::ForceUpdateFlags forceUpdate) {
+        mLifecycleManager.applyTransactions(mTrace[mFrame++ % mTrace.size()]);
+        return makeArgs(forceUpdate);
+    }
+
+    void commit() { mLifecycleManager.commitChanges(); }
+
+    LayerSnapshotBuilder& builder() { return mSnapshotBuilder; }
+
+private:
+    static std::unique_ptr<RequestedLayerState> createLayer(uint32_t id, bool canBeRoot,
+                                                            uint32_t parentId) {
+        LayerCreationArgs args(std::make_optional(id));
+        args.name = "benchmarklayer";
+        args.addToRoot = canBeRoot;
+        args.parentId = parentId;
+        return std::make_unique<RequestedLayerState>(args);
+    }
+
+    LayerSnapshotBuilder::Args makeArgs(LayerSnapshotBuilder::ForceUpdateFlags forceUpdate) {
+        return {.root = mHierarchyBuilder.getHierarchy(),
+                .layerLifecycleManager = mLifecycleManager,
+                .forceUpdate = forceUpdate,
+                .includeMetadata = false,
+                .displays = mDisplayInfos,
+                .globalShadowSettings = mShadowSettings,
+                .supportsBlur = true,
+                .supportedLayerGenericMetadata = {},
+                .genericLayerMetadataKeyMap = {}};
+    }
+
+    LayerLifecycleManager mLifecycleManager;
+    LayerHierarchyBuilder mHierarchyBuilder{{}};
+    LayerSnapshotBuilder mSnapshotBuilder;
+    DisplayInfos mDisplayInfos;
+    ShadowSettings mShadowSettings;
+    std::vector<uint32_t> mLeafIds;
+    std::vector<std::vector<TransactionState>> mTrace;
+    size_t mFrame = 0;
+};
+
+void replayTrace(benchmark::State& state, LayerSnapshotBuilder::ForceUpdateFlags forceUpdate) {
+    SnapshotBuilderReplay replay(static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto args = replay.nextFrame(forceUpdate);
+        state.ResumeTiming();
+
+        replay.builder().update(args);
+
+        state.PauseTiming();
+        replay.commit();
+        state.ResumeTiming();
+    }
+}
+
+// Per-frame builder cost when only the changed subtree is updated.
+void BM_LayerSnapshotBuilder_incrementalUpdate(benchmark::State& state) {
+    replayTrace(state, LayerSnapshotBuilder::ForceUpdateFlags::NONE);
+}
+
+// Per-frame builder cost when every snapshot is recomputed, for comparison.
+void BM_LayerSnapshotBuilder_fullUpdate(benchmark::State& state) {
+    replayTrace(state, LayerSnapshotBuilder::ForceUpdateFlags::ALL);
+}
+
+BENCHMARK(BM_LayerSnapshotBuilder_incrementalUpdate)->Arg(50)->Arg(150)->Arg(300)->Arg(600);
+BENCHMARK(BM_LayerSnapshotBuilder_fullUpdate)->Arg(50)->Arg(150)->Arg(300)->Arg(600);
+
+} // namespace
+} // namespace android::surfaceflinger::frontend
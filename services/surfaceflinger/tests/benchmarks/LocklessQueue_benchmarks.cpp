@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <optional>
+#include <vector>
+
+#include "LocklessQueue.h"
+#include "TransactionState.h"
+
+namespace android {
+namespace {
+
+constexpr size_t kStatesPerTransaction = 4;
+
+// The queue as it was before it recycled its entries: one heap entry per push, and the value is
+// copied both into and out of it.
+template <typename T>
+class HeapLocklessQueue {
+public:
+    struct Entry {
+        T mValue;
+        std::atomic<Entry*> mNext;
+        Entry(T value) : mValue(value) {}
+    };
+    std::atomic<Entry*> mPush = nullptr;
+    std::atomic<Entry*> mPop = nullptr;
+    bool isEmpty() { return (mPush.load() == nullptr) && (mPop.load() == nullptr); }
+
+    void push(T value) {
+        Entry* entry = new Entry(value);
+        Entry* previousHead = mPush.load();
+        do {
+            entry->mNext = previousHead;
+        } while (!mPush.compare_exchange_weak(previousHead, entry));
+    }
+    std::optional<T> pop() {
+        Entry* popped = mPop.load();
+        if (popped) {
+            mPop.store(popped->mNext);
+            auto value = popped->mValue;
+            delete popped;
+            return value;
+        }
+        Entry* grabbedList = mPush.exchange(nullptr);
+        if (!grabbedList) return std::nullopt;
+        while (grabbedList->mNext) {
+            Entry* next = grabbedList->mNext;
+            grabbedList->mNext = popped;
+            popped = grabbedList;
+            grabbedList = next;
+        }
+        mPop.store(popped);
+        auto value = grabbedList->mValue;
+        delete grabbedList;
+        return value;
+    }
+};
+
+// What a client typically sends in setTransactionState: a few layer changes and a completion
+// callback.
+TransactionState createTransaction() {
+    TransactionState transaction;
+    for (size_t i = 0; i < kStatesPerTransaction; i++) {
+        transaction.states.emplace_back();
+        transaction.states.back().layerId = static_cast<uint32_t>(i + 1);
+        transaction.states.back().state.what = layer_state_t::ePositionChanged;
+    }
+    transaction.listenerCallbacks.emplace_back(nullptr,
+                                               std::vector<CallbackId>{
+                                                       {1, CallbackId::Type::ON_COMPLETE}});
+    transaction.mergedTransactionIds = {1, 2, 3};
+    return transaction;
+}
+
+// Every benchmark thread stands for a binder thread queueing transactions, and the first one also
+// collects them, like the main thread does once per frame.
+void BM_LocklessQueue_heap(benchmark::State& state) {
+    static HeapLocklessQueue<TransactionState> queue;
+    const TransactionState transaction = createTransaction();
+    for (auto _ : state) {
+        queue.push(TransactionState(transaction));
+        if (state.thread_index() == 0) {
+            while (!queue.isEmpty()) {
+                auto maybeTransaction = queue.pop();
+                if (!maybeTransaction.has_value()) {
+                    break;
+                }
+                auto collected = maybeTransaction.value();
+                benchmark::DoNotOptimize(collected);
+            }
+        }
+    }
+}
+
+void BM_LocklessQueue_pooled(benchmark::State& state) {
+    static LocklessQueue<TransactionState> queue;
+    const TransactionState transaction = createTransaction();
+    for (auto _ : state) {
+        queue.push(TransactionState(transaction));
+        if (state.thread_index() == 0) {
+            queue.drain([](TransactionState&& collected) { benchmark::DoNotOptimize(collected); });
+        }
+    }
+}
+
+BENCHMARK(BM_LocklessQueue_heap)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LocklessQueue_pooled)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+} // namespace android
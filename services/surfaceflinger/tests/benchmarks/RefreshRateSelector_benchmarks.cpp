@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "DisplayHardware/DisplayMode.h"
+#include "Scheduler/RefreshRateSelector.h"
+
+namespace android::scheduler {
+namespace {
+
+using Config = RefreshRateSelector::Config;
+using LayerRequirement = RefreshRateSelector::LayerRequirement;
+using LayerVoteType = RefreshRateSelector::LayerVoteType;
+
+constexpr Fps kRefreshRates[] = {30_Hz, 45_Hz, 48_Hz, 60_Hz, 72_Hz, 90_Hz, 96_Hz, 120_Hz, 144_Hz};
+
+// A panel with many refresh rates, each of which can also be used at its divisors once frame rate
+// overrides are enabled, so that every layer is scored against several dozen frame rates.
+DisplayModes createDisplayModes() {
+    DisplayModes modes;
+    int32_t id = 0;
+    for (const Fps fps : kRefreshRates) {
+        const auto mode = DisplayMode::Builder(hal::HWConfigId(id))
+                                  .setId(DisplayModeId(id))
+                                  .setPhysicalDisplayId(PhysicalDisplayId::fromPort(0))
+                                  .setVsyncPeriod(fps.getPeriodNsecs())
+                                  .setGroup(0)
+                                  .setResolution(ui::Size(1920, 1080))
+                                  .build();
+        modes.try_emplace(mode->getId(), mode);
+        id++;
+    }
+    return modes;
+}
+
+// What LayerHistory typically reports: most layers keep their vote from frame to frame, and a
+// different one changes its weight every frame.
+std::vector<LayerRequirement> createLayers(int layerCount) {
+    static const LayerRequirement kVotes[] = {
+            {.vote = LayerVoteType::Heuristic, .desiredRefreshRate = 60_Hz},
+            {.vote = LayerVoteType::ExplicitExactOrMultiple, .desiredRefreshRate = 24_Hz},
+            {.vote = LayerVoteType::ExplicitDefault, .desiredRefreshRate = 30_Hz},
+            {.vote = LayerVoteType::ExplicitCategory,
+             .frameRateCategory = FrameRateCategory::Normal},
+            {.vote = LayerVoteType::Heuristic, .desiredRefreshRate = 48_Hz},
+            {.vote = LayerVoteType::ExplicitCategory, .frameRateCategory = FrameRateCategory::Low},
+    };
+    std::vector<LayerRequirement> layers;
+    for (int i = 0; i < layerCount; i++) {
+        LayerRequirement layer = kVotes[i % std::size(kVotes)];
+        layer.name = "com.example.app/com.example.app.Activity#" + std::to_string(i);
+        layer.weight = 1.f;
+        layers.push_back(std::move(layer));
+    }
+    return layers;
+}
+
+void BM_RefreshRateSelector_getRankedFrameRates(benchmark::State& state) {
+    const int layerCount = static_cast<int>(state.range(0));
+    RefreshRateSelector selector(createDisplayModes(), DisplayModeId(3),
+                                 {.enableFrameRateOverride = Config::FrameRateOverride::Enabled,
+                                  .frameRateMultipleThreshold = 120});
+    std::vector<LayerRequirement> layers = createLayers(layerCount);
+
+    size_t frame = 0;
+    for (auto _ : state) {
+        // Changing a weight makes the layers differ from the previous call, so the ranking is
+        // computed again rather than returned as is.
+        LayerRequirement& changed = layers[frame % layers.size()];
+        changed.weight = changed.weight == 1.f ? 0.5f : 1.f;
+        frame++;
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(layers, {}));
+    }
+    state.SetItemsProcessed(state.iterations() * layerCount);
+}
+BENCHMARK(BM_RefreshRateSelector_getRankedFrameRates)->Arg(4)->Arg(16)->Arg(64);
+
+} // namespace
+} // namespace android::scheduler
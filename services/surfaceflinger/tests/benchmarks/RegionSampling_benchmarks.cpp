@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ui/Transform.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "RegionSamplingThread.h"
+
+namespace android {
+namespace {
+
+constexpr int32_t kWidth = 1080;
+constexpr int32_t kHeight = 2400;
+constexpr int32_t kStride = 1088;
+constexpr uint32_t kOrientation = ui::Transform::ROT_0;
+
+std::vector<uint32_t> makeBuffer() {
+    std::vector<uint32_t> buffer(kStride * kHeight);
+    std::mt19937 generator(0);
+    for (auto& pixel : buffer) {
+        pixel = generator();
+    }
+    return buffer;
+}
+
+// A status bar, a navigation bar and a launcher hotseat sampling overlapping parts of the screen.
+std::vector<Rect> makeAreas(int32_t count) {
+    const std::vector<Rect> candidates = {{0, 0, kWidth, 120},
+                                          {0, kHeight - 160, kWidth, kHeight},
+                                          {0, kHeight - 480, kWidth, kHeight - 80},
+                                          {kWidth / 4, 0, kWidth * 3 / 4, 200},
+                                          {0, 0, kWidth, kHeight}};
+    return {candidates.begin(), candidates.begin() + count};
+}
+
+// The per-descriptor scalar loop that sampleAreas replaces.
+float sampleAreaScalar(const uint32_t* data, int32_t stride, const Rect& area) {
+    uint32_t accumulatedLuma = 0;
+    for (int32_t row = area.top; row < area.bottom; ++row) {
+        const uint32_t* rowBase = data + row * stride;
+        for (int32_t column = area.left; column < area.right; ++column) {
+            const uint32_t pixel = rowBase[column];
+            const uint32_t r = pixel & 0xFF;
+            const uint32_t g = (pixel >> 8) & 0xFF;
+            const uint32_t b = (pixel >> 16) & 0xFF;
+            accumulatedLuma += (r * 7 + b * 2 + g * 23) >> 5;
+        }
+    }
+    return accumulatedLuma / (255.0f * area.getWidth() * area.getHeight());
+}
+
+void BM_sampleAreasScalar(benchmark::State& state) {
+    const auto buffer = makeBuffer();
+    const auto areas = makeAreas(static_cast<int32_t>(state.range(0)));
+    for (auto _ : state) {
+        for (const auto& area : areas) {
+            benchmark::DoNotOptimize(sampleAreaScalar(buffer.data(), kStride, area));
+        }
+    }
+}
+
+void BM_sampleAreas(benchmark::State& state) {
+    const auto buffer = makeBuffer();
+    const auto areas = makeAreas(static_cast<int32_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+                sampleAreas(buffer.data(), kWidth, kHeight, kStride, kOrientation, areas));
+    }
+}
+
+void BM_sampleAreasWithWorkers(benchmark::State& state) {
+    const auto buffer = makeBuffer();
+    const auto areas = makeAreas(static_cast<int32_t>(state.range(0)));
+    SamplingWorkers workers(3);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sampleAreas(buffer.data(), kWidth, kHeight, kStride,
+                                             kOrientation, areas, &workers));
+    }
+}
+
+BENCHMARK(BM_sampleAreasScalar)->DenseRange(1, 5);
+BENCHMARK(BM_sampleAreas)->DenseRange(1, 5);
+BENCHMARK(BM_sampleAreasWithWorkers)->DenseRange(1, 5);
+
+} // namespace
+} // namespace android
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TimeStats/TimeStats.h"
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr nsecs_t kVsyncPeriod = std::chrono::nanoseconds(16ms).count();
+constexpr Fps kRefreshRate = 60_Hz;
+constexpr uid_t kUid = 10123;
+
+// What the main thread reports to TimeStats for every layer that presents a buffer in a frame.
+void BM_TimeStats_layersPerFrame(benchmark::State& state) {
+    const int32_t layerCount = static_cast<int32_t>(state.range(0));
+    std::vector<std::string> layerNames;
+    for (int32_t layerId = 0; layerId < layerCount; layerId++) {
+        layerNames.push_back("com.example.app/com.example.app.Activity#" + std::to_string(layerId));
+    }
+
+    impl::TimeStats timeStats;
+    std::vector<uint8_t> pulledData;
+    // The first pull enables TimeStats.
+    timeStats.onPullAtom(10063 /* SURFACEFLINGER_STATS_LAYER_INFO */, &pulledData);
+
+    uint64_t frameNumber = 0;
+    for (auto _ : state) {
+        frameNumber++;
+        const nsecs_t postTime = static_cast<nsecs_t>(frameNumber) * kVsyncPeriod;
+        for (int32_t layerId = 0; layerId < layerCount; layerId++) {
+            timeStats.setPostTime(layerId, frameNumber, layerNames[layerId], kUid, postTime,
+                                  GameMode::Unsupported);
+            timeStats.setAcquireFence(layerId, frameNumber,
+                                      std::make_shared<FenceTime>(postTime + kVsyncPeriod / 4));
+            timeStats.setDesiredTime(layerId, frameNumber, postTime);
+            timeStats.setLatchTime(layerId, frameNumber, postTime + kVsyncPeriod / 2);
+            timeStats.setPresentFence(layerId, frameNumber,
+                                      std::make_shared<FenceTime>(postTime + kVsyncPeriod),
+                                      kRefreshRate, std::nullopt, {}, GameMode::Unsupported);
+            timeStats.incrementJankyFrames({kRefreshRate, std::nullopt, kUid, layerNames[layerId],
+                                            GameMode::Unsupported, JankType::None, 0, 0, 0});
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * layerCount);
+}
+BENCHMARK(BM_TimeStats_layersPerFrame)->Arg(10)->Arg(100);
+
+} // namespace
+} // namespace android
@@ -341,6 +341,49 @@ TEST_F(FrameTimelineTest, presentFenceSignaled_presentedFramesUpdated) {
     EXPECT_NE(surfaceFrame2->getJankSeverityType(), std::nullopt);
 }
 
+TEST_F(FrameTimelineTest, presentFenceSignaled_presentThreadUpdatesPresentedFrames) {
+    constexpr bool kUseBootTimeClock = true;
+    constexpr bool kClassifyJankAsync = true;
+    auto frameTimeline =
+            std::make_unique<impl::FrameTimeline>(mTimeStats, kSurfaceFlingerPid, kTestThresholds,
+                                                  !kUseBootTimeClock, kClassifyJankAsync);
+    // Global increment
+    EXPECT_CALL(*mTimeStats, incrementJankyFrames(_));
+    // Layer specific increment
+    EXPECT_CALL(*mTimeStats, incrementJankyFrames(_)).Times(2);
+    auto presentFence1 = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    auto* tokenManager = frameTimeline->getTokenManager();
+    int64_t surfaceFrameToken1 = tokenManager->generateTokenForPredictions({10, 20, 30});
+    int64_t sfToken1 = tokenManager->generateTokenForPredictions({22, 26, 30});
+    FrameTimelineInfo ftInfo;
+    ftInfo.vsyncId = surfaceFrameToken1;
+    ftInfo.inputEventId = sInputEventId;
+    auto surfaceFrame1 =
+            frameTimeline->createSurfaceFrameForToken(ftInfo, sPidOne, sUidOne, sLayerIdOne,
+                                                      sLayerNameOne, sLayerNameOne,
+                                                      /*isBuffer*/ true, sGameMode);
+    auto surfaceFrame2 =
+            frameTimeline->createSurfaceFrameForToken(ftInfo, sPidOne, sUidOne, sLayerIdTwo,
+                                                      sLayerNameTwo, sLayerNameTwo,
+                                                      /*isBuffer*/ true, sGameMode);
+    frameTimeline->setSfWakeUp(sfToken1, 22, RR_11, RR_11);
+    surfaceFrame1->setPresentState(SurfaceFrame::PresentState::Presented);
+    frameTimeline->addSurfaceFrame(surfaceFrame1);
+    surfaceFrame2->setPresentState(SurfaceFrame::PresentState::Presented);
+    frameTimeline->addSurfaceFrame(surfaceFrame2);
+    frameTimeline->setSfPresent(26, presentFence1);
+    presentFence1->signalForTest(42);
+    frameTimeline->setSfPresent(2500, fenceFactory.createFenceTimeForTest(Fence::NO_FENCE));
+
+    // Destroying the FrameTimeline waits for the present thread to flush the queued fences.
+    frameTimeline.reset();
+
+    EXPECT_EQ(surfaceFrame1->getActuals().presentTime, 42);
+    EXPECT_EQ(surfaceFrame2->getActuals().presentTime, 42);
+    EXPECT_NE(surfaceFrame1->getJankType(), std::nullopt);
+    EXPECT_NE(surfaceFrame2->getJankType(), std::nullopt);
+}
+
 TEST_F(FrameTimelineTest, displayFramesSlidingWindowMovesAfterLimit) {
     // Insert kMaxDisplayFrames' count of DisplayFrames to fill the deque
     int frameTimeFactor = 0;
@@ -236,6 +236,38 @@ TEST_F(LayerSnapshotTest, UpdateClearsPreviousChangeStates) {
     EXPECT_FALSE(getSnapshot(11)->changes.test(RequestedLayerState::Changes::Geometry));
 }
 
+TEST_F(LayerSnapshotTest, UpdateOnlyVisitsChangedSubtrees) {
+    setAlpha(1, 0.5);
+    setCrop(2, Rect(1, 2, 3, 4));
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+
+    setCrop(1221, Rect(0, 0, 10, 10));
+    setAlpha(13, 0.5);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_TRUE(getSnapshot(1221)->changes.test(RequestedLayerState::Changes::Geometry));
+    EXPECT_EQ(getSnapshot(13)->alpha, 0.25f);
+    EXPECT_EQ(getSnapshot(111)->changes.get(), 0u);
+    EXPECT_EQ(getSnapshot(2)->changes.get(), 0u);
+
+    // Snapshots in skipped subtrees must match the ones built from scratch.
+    LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                    .layerLifecycleManager = mLifecycleManager,
+                                    .includeMetadata = false,
+                                    .displays = mFrontEndDisplayInfos,
+                                    .globalShadowSettings = globalShadowSettings,
+                                    .supportedLayerGenericMetadata = {},
+                                    .genericLayerMetadataKeyMap = {}};
+    LayerSnapshotBuilder expectedBuilder(args);
+    for (uint32_t id : STARTING_ZORDER) {
+        const LayerSnapshot* expected = expectedBuilder.getSnapshot(id);
+        ASSERT_NE(expected, nullptr);
+        EXPECT_EQ(getSnapshot(id)->alpha, expected->alpha) << id;
+        EXPECT_EQ(getSnapshot(id)->geomLayerBounds, expected->geomLayerBounds) << id;
+        EXPECT_EQ(getSnapshot(id)->reachablilty, expected->reachablilty) << id;
+        EXPECT_EQ(getSnapshot(id)->isHiddenByPolicy(), expected->isHiddenByPolicy()) << id;
+    }
+}
+
 TEST_F(LayerSnapshotTest, FastPathClearsPreviousChangeStates) {
     setColor(11, {1._hf, 0._hf, 0._hf});
     UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "LocklessQueue.h"
+
+namespace android {
+namespace {
+
+using Value = std::unique_ptr<int>;
+
+TEST(LocklessQueueTest, popsInPushOrder) {
+    LocklessQueue<Value> queue;
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop().has_value());
+
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+    EXPECT_FALSE(queue.isEmpty());
+    EXPECT_EQ(1, **queue.pop());
+
+    queue.push(std::make_unique<int>(3));
+    EXPECT_EQ(2, **queue.pop());
+    EXPECT_EQ(3, **queue.pop());
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(LocklessQueueTest, drainsInPushOrder) {
+    LocklessQueue<Value> queue;
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+    EXPECT_EQ(1, **queue.pop());
+    queue.push(std::make_unique<int>(3));
+
+    std::vector<int> values;
+    EXPECT_EQ(2u, queue.drain([&values](Value&& value) { values.push_back(*value); }));
+    EXPECT_EQ((std::vector<int>{2, 3}), values);
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(0u, queue.drain([](Value&&) { FAIL(); }));
+}
+
+TEST(LocklessQueueTest, outgrowsPool) {
+    LocklessQueue<Value, 2> queue;
+    for (int i = 0; i < 5; i++) {
+        queue.push(std::make_unique<int>(i));
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i, **queue.pop());
+    }
+    for (int i = 0; i < 3; i++) {
+        queue.push(std::make_unique<int>(i));
+    }
+    std::vector<int> values;
+    queue.drain([&values](Value&& value) { values.push_back(*value); });
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), values);
+}
+
+TEST(LocklessQueueTest, releasesValuesOnDestruction) {
+    auto shared = std::make_shared<int>(0);
+    {
+        LocklessQueue<std::shared_ptr<int>, 1> queue;
+        queue.push(std::shared_ptr<int>(shared));
+        queue.push(std::shared_ptr<int>(shared));
+        EXPECT_EQ(3, shared.use_count());
+    }
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(LocklessQueueTest, multipleProducers) {
+    constexpr int kProducers = 4;
+    constexpr int kValuesPerProducer = 10000;
+    LocklessQueue<Value, 8> queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push(std::make_unique<int>(p * kValuesPerProducer + i));
+            }
+        });
+    }
+
+    // Values from the same producer must come out in the order they went in.
+    std::vector<int> lastValues(kProducers, -1);
+    int count = 0;
+    const auto consume = [&](Value&& value) {
+        const int producer = *value / kValuesPerProducer;
+        EXPECT_LT(lastValues[producer], *value);
+        lastValues[producer] = *value;
+        count++;
+    };
+    while (count < kProducers * kValuesPerProducer) {
+        if (count % 2 == 0) {
+            if (auto value = queue.pop()) {
+                consume(std::move(*value));
+            }
+        } else {
+            queue.drain(consume);
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+} // namespace
+} // namespace android
@@ -137,7 +137,33 @@ struct TestableRefreshRateSelector : RefreshRateSelector {
         return setPolicy(policy);
     }
 
+    void updateDisplayModes(DisplayModes modes, DisplayModeId activeModeId) {
+        ftl::FakeGuard guard(kMainThreadContext);
+        RefreshRateSelector::updateDisplayModes(std::move(modes), activeModeId);
+    }
+
     const auto& getPrimaryFrameRates() const { return mPrimaryFrameRates; }
+
+    // Expects the cached scores of each layer to match those calculated directly, for each of the
+    // current app request frame rates.
+    void expectCachedLayerScoresMatchCalculated(const std::vector<LayerRequirement>& layers) const {
+        std::lock_guard lock(mLock);
+        for (const auto& layer : layers) {
+            const auto it = mLayerScoresCache.find({.vote = layer.vote,
+                                                    .desiredRefreshRate = layer.desiredRefreshRate,
+                                                    .frameRateCategory = layer.frameRateCategory});
+            ASSERT_NE(mLayerScoresCache.end(), it) << "No cached scores for " << layer.name;
+            const auto& layerScores = it->second;
+            ASSERT_EQ(mAppRequestFrameRates.size(), layerScores.size());
+            for (size_t i = 0; i < layerScores.size(); i++) {
+                const Fps fps = mAppRequestFrameRates[i].fps;
+                EXPECT_EQ(calculateLayerScoreLocked(layer, fps, true), layerScores[i].seamless)
+                        << layer.name << " at " << to_string(fps);
+                EXPECT_EQ(calculateLayerScoreLocked(layer, fps, false), layerScores[i].seamed)
+                        << layer.name << " at " << to_string(fps);
+            }
+        }
+    }
 };
 
 class RefreshRateSelectorTest : public testing::TestWithParam<Config::FrameRateOverride> {
@@ -2665,6 +2691,62 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     EXPECT_EQ(cache->result, result);
 }
 
+TEST_P(RefreshRateSelectorTest, getRankedFrameRates_layerScoresCacheMatchesCalculated) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    std::vector<LayerRequirement> layers = {
+            {.name = "heuristic",
+             .vote = LayerVoteType::Heuristic,
+             .desiredRefreshRate = 45_Hz,
+             .weight = 1.f},
+            {.name = "exact or multiple",
+             .vote = LayerVoteType::ExplicitExactOrMultiple,
+             .desiredRefreshRate = 24_Hz,
+             .weight = 1.f},
+            {.name = "category",
+             .vote = LayerVoteType::ExplicitCategory,
+             .frameRateCategory = FrameRateCategory::Normal,
+             .weight = 0.5f},
+    };
+
+    // Each cached score must match one calculated directly against the current frame rates, and
+    // the ranking must match that of a fresh selector, which has not cached any scores yet. Every
+    // ranked mode must also still be allowed, i.e. no scores for stale frame rates were reused.
+    const auto expectSameAsCalculated = [&](TestableRefreshRateSelector& fresh) {
+        const auto result = selector.getRankedFrameRates(layers, {});
+        selector.expectCachedLayerScoresMatchCalculated(layers);
+        EXPECT_EQ(fresh.getRankedFrameRates(layers, {}), result);
+        for (const auto& scoredFrameRate : result.ranking) {
+            EXPECT_TRUE(selector.isModeAllowed(scoredFrameRate.frameRateMode));
+        }
+    };
+
+    // Changing only a weight misses the cached ranking, but keeps the votes, whose scores are
+    // then reused.
+    selector.getRankedFrameRates(layers, {});
+    layers[0].weight = 0.5f;
+    {
+        auto fresh = createSelector(kModes_30_60_72_90_120, kModeId60);
+        expectSameAsCalculated(fresh);
+    }
+
+    // The same votes after the policy changed the frame rates they are scored against.
+    const RefreshRateSelector::DisplayManagerPolicy policy{kModeId60, {60_Hz, 90_Hz}};
+    EXPECT_EQ(SetPolicyResult::Changed, selector.setDisplayManagerPolicy(policy));
+    {
+        auto fresh = createSelector(kModes_30_60_72_90_120, kModeId60);
+        EXPECT_EQ(SetPolicyResult::Changed, fresh.setDisplayManagerPolicy(policy));
+        expectSameAsCalculated(fresh);
+    }
+
+    // And after the display modes changed.
+    selector.updateDisplayModes(kModes_60_90, kModeId90);
+    {
+        auto fresh = createSelector(kModes_60_90, kModeId90);
+        expectSameAsCalculated(fresh);
+    }
+}
+
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
     auto selector = createSelector(kModes_60_120, kModeId60);
 
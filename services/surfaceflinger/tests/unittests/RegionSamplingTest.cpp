@@ -25,13 +25,39 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <array>
 #include <limits>
+#include <vector>
 
 #include "RegionSamplingThread.h"
 
 namespace android {
 
+namespace {
+
+// The luma of an area, one pixel at a time, as sampleArea computed it before it was vectorized.
+float referenceLuma(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
+                    const Rect& area) {
+    if (!area.isValid() || area.getWidth() > width || area.getHeight() > height) {
+        return 0.0f;
+    }
+
+    uint32_t accumulatedLuma = 0;
+    for (int32_t row = area.top; row < area.bottom; ++row) {
+        for (int32_t column = area.left; column < area.right; ++column) {
+            uint32_t const pixel = data[row * stride + column];
+            uint32_t const r = pixel & 0xFF;
+            uint32_t const g = (pixel >> 8) & 0xFF;
+            uint32_t const b = (pixel >> 16) & 0xFF;
+            accumulatedLuma += (r * 7 + b * 2 + g * 23) >> 5;
+        }
+    }
+    return accumulatedLuma / (255.0f * area.getWidth() * area.getHeight());
+}
+
+} // namespace
+
 struct RegionSamplingTest : testing::Test {
 public:
     static uint32_t constexpr kBlack = 0;
@@ -106,6 +132,55 @@ TEST_F(RegionSamplingTest, bounds_checking) {
                 testing::Eq(0.0));
 }
 
+TEST_F(RegionSamplingTest, overlapping_areas_match_individual_samples) {
+    std::generate(buffer.begin(), buffer.end(), [n = 0]() mutable {
+        uint32_t const pixel = (n % std::numeric_limits<uint8_t>::max()) << ((n % 3) * CHAR_BIT);
+        n++;
+        return pixel;
+    });
+
+    std::vector<Rect> const areas = {whole_area,
+                                     {5, 2, 40, 20},
+                                     {30, 10, 97, 28},
+                                     {30, 10, 31, 11},
+                                     {0, 0, 4, kHeight + 1}};
+    auto const lumas = sampleAreas(buffer.data(), kWidth, kHeight, kStride, kOrientation, areas);
+    ASSERT_EQ(areas.size(), lumas.size());
+    for (size_t i = 0; i < areas.size(); ++i) {
+        EXPECT_THAT(lumas[i],
+                    testing::FloatEq(referenceLuma(buffer.data(), kWidth, kHeight, kStride,
+                                                   areas[i])))
+                << "area " << i;
+    }
+    EXPECT_THAT(lumas.back(), testing::Eq(0.0));
+}
+
+TEST(RegionSamplingWorkersTest, bands_match_single_pass) {
+    // Large enough to be split into bands.
+    constexpr int kLargeWidth = 1080;
+    constexpr int kLargeStride = 1088;
+    constexpr int kLargeHeight = 1200;
+    std::vector<uint32_t> largeBuffer(kLargeStride * kLargeHeight);
+    std::generate(largeBuffer.begin(), largeBuffer.end(), [n = 0]() mutable {
+        uint32_t const pixel = (n % std::numeric_limits<uint8_t>::max()) << ((n % 3) * CHAR_BIT);
+        n++;
+        return pixel;
+    });
+    std::vector<Rect> const areas = {{0, 0, kLargeWidth, kLargeHeight},
+                                     {0, 0, kLargeWidth, 120},
+                                     {100, 1000, 900, kLargeHeight}};
+
+    auto const expected = sampleAreas(largeBuffer.data(), kLargeWidth, kLargeHeight,
+                                      kLargeStride, ui::Transform::ROT_0, areas);
+    SamplingWorkers workers(3);
+    // The workers are reused from one sample to the next.
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(expected,
+                  sampleAreas(largeBuffer.data(), kLargeWidth, kLargeHeight, kLargeStride,
+                              ui::Transform::ROT_0, areas, &workers));
+    }
+}
+
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -31,7 +31,11 @@
 #include <utils/Vector.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 #include "libsurfaceflinger_unittest_main.h"
@@ -742,6 +746,115 @@ TEST_F(TimeStatsTest, canInsertMultipleLayersTimeStats) {
     EXPECT_EQ(2, globalProto.stats_size());
 }
 
+TEST_F(TimeStatsTest, canInsertLayerTimeStatsFromSeveralThreads) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_0, 1, 1000000);
+    std::thread thread([this] {
+        insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_1, 1, 1000000);
+        insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_1, 2, 2000000);
+    });
+    thread.join();
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_0, 2, 2000000);
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(2, globalProto.stats_size());
+    for (const SFTimeStatsLayerProto& layerProto : globalProto.stats()) {
+        ASSERT_TRUE(layerProto.has_total_frames());
+        EXPECT_EQ(1, layerProto.total_frames());
+    }
+}
+
+TEST_F(TimeStatsTest, canInsertLayerTimeStatsFromMoreThreadsThanBuffers) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    // Only some of the threads get a buffer of their own, and the others record directly. Keep
+    // every thread alive until all of them have recorded, so that none can give its buffer back.
+    constexpr int32_t kNumThreads = 8;
+    std::mutex mutex;
+    std::condition_variable cv;
+    int32_t numRecorded = 0;
+    std::vector<std::thread> threads;
+    for (int32_t layerId = 0; layerId < kNumThreads; layerId++) {
+        threads.emplace_back([&, layerId] {
+            insertTimeRecord(NORMAL_SEQUENCE, layerId, 1, 1000000);
+            insertTimeRecord(NORMAL_SEQUENCE, layerId, 2, 2000000);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            numRecorded++;
+            cv.notify_all();
+            cv.wait(lock, [&] { return numRecorded == kNumThreads; });
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(kNumThreads, globalProto.stats_size());
+    for (const SFTimeStatsLayerProto& layerProto : globalProto.stats()) {
+        ASSERT_TRUE(layerProto.has_total_frames());
+        EXPECT_EQ(1, layerProto.total_frames());
+    }
+}
+
+TEST_F(TimeStatsTest, canInsertLayerTimeStatsFromThreadsThatExit) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    // Each thread exits before the next starts, leaving its events in a buffer that the next
+    // thread takes over.
+    constexpr int32_t kNumThreads = 8;
+    for (int32_t layerId = 0; layerId < kNumThreads; layerId++) {
+        std::thread thread([this, layerId] {
+            insertTimeRecord(NORMAL_SEQUENCE, layerId, 1, 1000000);
+            insertTimeRecord(NORMAL_SEQUENCE, layerId, 2, 2000000);
+        });
+        thread.join();
+    }
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(kNumThreads, globalProto.stats_size());
+    for (const SFTimeStatsLayerProto& layerProto : globalProto.stats()) {
+        ASSERT_TRUE(layerProto.has_total_frames());
+        EXPECT_EQ(1, layerProto.total_frames());
+    }
+}
+
+TEST_F(TimeStatsTest, jankyFramesFromAnotherThreadGoToTheirLayer) {
+    // this stat is not in the proto so verify by checking the string dump
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    // FrameTimeline reports janky frames from a thread of its own, after the presents of the
+    // frame were recorded on the main thread. Have that thread take a buffer first, so that its
+    // buffer comes before the one of the main thread.
+    std::promise<void> bufferTaken;
+    std::promise<void> presented;
+    std::thread frameTimelineThread([&] {
+        mTimeStats->incrementLatchSkipped(LAYER_ID_1, TimeStats::LatchSkipReason::LateAcquire);
+        bufferTaken.set_value();
+        presented.get_future().wait();
+        mTimeStats->incrementJankyFrames({kRefreshRate0, kRenderRate0, UID_0,
+                                          genLayerName(LAYER_ID_0), kGameMode,
+                                          JankType::AppDeadlineMissed, 1, 2, 3});
+    });
+    bufferTaken.get_future().wait();
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_0, 1, 1000000);
+    insertTimeRecord(NORMAL_SEQUENCE_2, LAYER_ID_0, 2, 2000000);
+    presented.set_value();
+    frameTimelineThread.join();
+
+    const std::string result(inputCommand(InputCommand::DUMP_ALL, FMT_STRING));
+    EXPECT_THAT(result, HasSubstr("layerName = " + genLayerName(LAYER_ID_0)));
+    EXPECT_THAT(result, HasSubstr("appUnattributedJankyFrames = 1"));
+    EXPECT_THAT(result, Not(HasSubstr("layerName = none")));
+}
+
 TEST_F(TimeStatsTest, canInsertUnorderedLayerTimeStats) {
     EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
 
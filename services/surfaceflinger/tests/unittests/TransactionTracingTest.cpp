@@ -318,6 +318,77 @@ TEST_F(TransactionTracingMirrorLayerTest, canAddMirrorLayers) {
     EXPECT_EQ(proto.entry(0).transactions(0).layer_changes(1).z(), 43);
 }
 
+TEST(TransactionRingBufferTest, overwritesOldestEntries) {
+    TransactionRingBuffer<perfetto::protos::TransactionTraceFile,
+                          perfetto::protos::TransactionTraceEntry>
+            buffer;
+    buffer.setSize(1024);
+
+    std::vector<int64_t> evictedVsyncIds;
+    const auto onEvicted = [&](const perfetto::protos::TransactionTraceEntry& entry) {
+        evictedVsyncIds.push_back(entry.vsync_id());
+    };
+    for (int64_t vsyncId = 0; vsyncId < 100; vsyncId++) {
+        perfetto::protos::TransactionTraceEntry entry;
+        entry.set_vsync_id(vsyncId);
+        entry.set_elapsed_realtime_nanos(vsyncId);
+        entry.add_destroyed_layers(static_cast<uint32_t>(vsyncId));
+        EXPECT_FALSE(buffer.emplace(entry, onEvicted).empty());
+        EXPECT_EQ(buffer.backVsyncId(), vsyncId);
+        EXPECT_LE(buffer.used(), buffer.size());
+    }
+
+    // Entries were evicted oldest first, and the buffer holds all of the others.
+    perfetto::protos::TransactionTraceFile proto;
+    buffer.writeToProto(proto);
+    ASSERT_EQ(evictedVsyncIds.size() + static_cast<size_t>(proto.entry().size()), 100u);
+    for (size_t i = 0; i < evictedVsyncIds.size(); i++) {
+        EXPECT_EQ(evictedVsyncIds[i], static_cast<int64_t>(i));
+    }
+    for (int i = 0; i < proto.entry().size(); i++) {
+        const int64_t vsyncId = static_cast<int64_t>(evictedVsyncIds.size()) + i;
+        EXPECT_EQ(proto.entry(i).vsync_id(), vsyncId);
+        EXPECT_EQ(proto.entry(i).destroyed_layers(0), static_cast<uint32_t>(vsyncId));
+    }
+
+    // Shrinking the buffer evicts the oldest of the remaining entries.
+    evictedVsyncIds.clear();
+    buffer.setSize(128, onEvicted);
+    ASSERT_FALSE(evictedVsyncIds.empty());
+    EXPECT_EQ(evictedVsyncIds.front(), proto.entry(0).vsync_id());
+    EXPECT_EQ(buffer.backVsyncId(), 99);
+
+    // An entry larger than the whole buffer is not kept. It is newer than the entries in the
+    // buffer, so they are evicted before it.
+    evictedVsyncIds.clear();
+    const size_t keptEntries = buffer.frameCount();
+    ASSERT_GT(keptEntries, 0u);
+    perfetto::protos::TransactionTraceEntry largeEntry;
+    largeEntry.set_vsync_id(100);
+    for (uint32_t i = 0; i < 100; i++) {
+        largeEntry.add_destroyed_layers(1000 + i);
+    }
+    EXPECT_TRUE(buffer.emplace(largeEntry, onEvicted).empty());
+    ASSERT_EQ(evictedVsyncIds.size(), keptEntries + 1);
+    for (size_t i = 0; i < keptEntries; i++) {
+        EXPECT_EQ(evictedVsyncIds[i], static_cast<int64_t>(100 - keptEntries + i));
+    }
+    EXPECT_EQ(evictedVsyncIds.back(), 100);
+    EXPECT_EQ(buffer.frameCount(), 0u);
+
+    // Likewise for an entry which no longer fits once the buffer shrinks.
+    evictedVsyncIds.clear();
+    buffer.setSize(1024, onEvicted);
+    perfetto::protos::TransactionTraceEntry smallEntry;
+    smallEntry.set_vsync_id(101);
+    EXPECT_FALSE(buffer.emplace(smallEntry, onEvicted).empty());
+    largeEntry.set_vsync_id(102);
+    EXPECT_FALSE(buffer.emplace(largeEntry, onEvicted).empty());
+    buffer.setSize(128, onEvicted);
+    EXPECT_EQ(evictedVsyncIds, (std::vector<int64_t>{101, 102}));
+    EXPECT_EQ(buffer.frameCount(), 0u);
+}
+
 // Verify we can write the layers traces by entry to reduce mem pressure
 // on the system when generating large traces.
 TEST(LayerTraceTest, canStreamLayersTrace) {